@@ -344,7 +344,8 @@ extern "C" {
 #endif
 #if defined (__GNUC__) /* ARM GCC */
     #define IAR_SECTION(section)
-    #define __RAMFUNC
+    /* long_call: RAM is out of BL range from Flash, noinline: keep the body out of Flash callers */
+    #define __RAMFUNC __attribute__((section("EXECUTABLE_MEMORY_SECTION"), long_call, noinline))
 #endif
 
 
@@ -882,6 +882,12 @@
     #define configUSE_POSIX_ERRNO    0
 #endif
 
+#ifndef configUSE_PORT_ATOMICS
+    /* Use the lock-free atomic.h implementation if the port provides
+     * exclusive access primitives. */
+    #define configUSE_PORT_ATOMICS    1
+#endif
+
 #ifndef portTICK_TYPE_IS_ATOMIC
     #define portTICK_TYPE_IS_ATOMIC    0
 #endif
@@ -1325,7 +1331,7 @@ typedef struct xSTATIC_TIMER
  */
 typedef struct xSTATIC_STREAM_BUFFER
 {
-    size_t uxDummy1[ 4 ];
+    size_t uxDummy1[ 5 ];
     void * pvDummy2[ 3 ];
     uint8_t ucDummy3;
     #if ( configUSE_TRACE_FACILITY == 1 )
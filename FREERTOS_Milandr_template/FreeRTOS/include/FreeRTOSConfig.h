@@ -54,12 +54,12 @@ extern uint32_t SystemCoreClock;
  * @note значение configCPU_CLOCK_HZ совпадает со значением переменной SystemCoreClock
  *       из библиотеки драйверов SPL MDR32FxQI.
  */
-#define configCPU_CLOCK_HZ                    ( ( uint32_t ) 80000000 ) // MCU speed 8 MHz
+#define configCPU_CLOCK_HZ                    ( SystemCoreClock ) // меняется на ходу, см. CLK_SetFrequency
 
 #define configTICK_RATE_HZ                    ((TickType_t)1000)
-#define configTOTAL_HEAP_SIZE                 ((size_t)(10 * 1024))
+// configTOTAL_HEAP_SIZE не нужен: куча - все свободное ОЗУ (heap.h)
 #define configMINIMAL_STACK_SIZE              ((unsigned short)130)
-#define configCHECK_FOR_STACK_OVERFLOW        0
+#define configCHECK_FOR_STACK_OVERFLOW        2
 #define configMAX_PRIORITIES                  (5)
 #define configUSE_PREEMPTION                  1
 #define configIDLE_SHOULD_YIELD               1
@@ -75,11 +75,37 @@ extern uint32_t SystemCoreClock;
 #define configUSE_RECURSIVE_MUTEXES           1
 #define configUSE_COUNTING_SEMAPHORES         1
 #define configUSE_QUEUE_SETS                  1
+/* Ячейка 1 - ожидание записи во FLASH (flash.h), 2 - завершение DMAM_Memcpy (dma.h),
+   3 - место/данные в кольцах консоли (console.h), 4 - HRT_SleepUntil (hrt.h),
+   5 - конец потока PWMSEQ_Wait (pwmseq.h), 6 - подъем нижней границы частоты (dfs.h) */
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES 7
 #define configUSE_IDLE_HOOK                   1
-#define configUSE_TICK_HOOK                   0
+#define configUSE_TICK_HOOK                   1
 #define configUSE_MALLOC_FAILED_HOOK          0
 #define configUSE_16_BIT_TICKS                0
 
+/* Загрузка для губернатора частоты (dfs.c): время в мкс, не зависит от частоты CPU */
+uint32_t CLK_GetTimeUs(void);
+#define configGENERATE_RUN_TIME_STATS         1
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE()      CLK_GetTimeUs()
+/* atomic.h на LDREX/STREX вместо критических секций */
+#define configUSE_PORT_ATOMICS                1
+
+/* _reent newlib только у задач, вызвавших CONSOLE_AttachTask (console.c), вместо
+   configUSE_NEWLIB_REENTRANT с полным _reent в каждом TCB */
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS 1
+#define CONSOLE_TLS_INDEX                     0
+void CONSOLE_SwitchedIn(void *reent);
+#define traceTASK_SWITCHED_IN()               CONSOLE_SwitchedIn(pxCurrentTCB->pvThreadLocalStoragePointers[CONSOLE_TLS_INDEX])
+
+/* Профилировщик кучи (heap.h): подсистема выделения - тег задачи FreeRTOS.
+   0 - профилировщика и поля тега в TCB нет */
+#ifndef HEAP_PROFILE
+#define HEAP_PROFILE                          0
+#endif
+#define configUSE_APPLICATION_TASK_TAG        HEAP_PROFILE
+
 /* Set the following definitions to 1 to include the API function, or zero
 to exclude the API function. */
 #define INCLUDE_vTaskPrioritySet              1
@@ -89,6 +115,8 @@ to exclude the API function. */
 #define INCLUDE_vTaskDelayUntil               1
 #define INCLUDE_vTaskDelay                    1
 #define INCLUDE_eTaskGetState                 1
+#define INCLUDE_uxTaskGetStackHighWaterMark   1
+#define INCLUDE_xTaskGetIdleTaskHandle        1
 
 /* Cortex-M specific definitions. */
 #ifdef __NVIC_PRIO_BITS
@@ -122,7 +150,7 @@ header file. */
 /* Map the FreeRTOS port interrupt handlers to their CMSIS standard names. */
 #define xPortPendSVHandler                    PendSV_Handler
 #define vPortSVCHandler                       SVC_Handler
-#define xPortSysTickHandler                   SysTick_Handler
+/* SysTick_Handler - в uptime.c: снимок времени, затем xPortSysTickHandler */
 
 
 
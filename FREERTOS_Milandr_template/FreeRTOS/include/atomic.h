@@ -29,8 +29,9 @@
  * @brief FreeRTOS atomic operation support.
  *
  * This file implements atomic functions by disabling interrupts globally.
- * Implementations with architecture specific atomic instructions can be
- * provided under each compiler directory.
+ * Ports that define portHAS_EXCLUSIVE_ACCESS (ARMv7-M LDREX/STREX) get
+ * lock-free implementations of the same functions instead, see
+ * atomicUSE_EXCLUSIVE_ACCESS below.
  */
 
 #ifndef ATOMIC_H
@@ -85,6 +86,19 @@
     #define portFORCE_INLINE
 #endif
 
+/*
+ * Lock-free implementation on top of the port exclusive access primitives
+ * (ulPortLoadExclusive(), ulPortStoreExclusive(), vPortClearExclusive()).  The
+ * read-modify-write is retried until the exclusive store succeeds, interrupts
+ * are never masked.  Set configUSE_PORT_ATOMICS to 0 to force the critical
+ * section implementation.
+ */
+#if defined( portHAS_EXCLUSIVE_ACCESS ) && ( configUSE_PORT_ATOMICS == 1 )
+    #define atomicUSE_EXCLUSIVE_ACCESS    1
+#else
+    #define atomicUSE_EXCLUSIVE_ACCESS    0
+#endif
+
 #define ATOMIC_COMPARE_AND_SWAP_SUCCESS    0x1U     /**< Compare and swap succeeded, swapped. */
 #define ATOMIC_COMPARE_AND_SWAP_FAILURE    0x0U     /**< Compare and swap failed, did not swap. */
 
@@ -111,19 +125,41 @@ static portFORCE_INLINE uint32_t Atomic_CompareAndSwap_u32( uint32_t volatile *
 {
     uint32_t ulReturnValue;
 
-    ATOMIC_ENTER_CRITICAL();
+    #if ( atomicUSE_EXCLUSIVE_ACCESS == 1 )
     {
-        if( *pulDestination == ulComparand )
+        for( ; ; )
         {
-            *pulDestination = ulExchange;
-            ulReturnValue = ATOMIC_COMPARE_AND_SWAP_SUCCESS;
+            if( ulPortLoadExclusive( pulDestination ) != ulComparand )
+            {
+                vPortClearExclusive();
+                ulReturnValue = ATOMIC_COMPARE_AND_SWAP_FAILURE;
+                break;
+            }
+
+            if( ulPortStoreExclusive( pulDestination, ulExchange ) == 0U )
+            {
+                ulReturnValue = ATOMIC_COMPARE_AND_SWAP_SUCCESS;
+                break;
+            }
         }
-        else
+    }
+    #else /* atomicUSE_EXCLUSIVE_ACCESS */
+    {
+        ATOMIC_ENTER_CRITICAL();
         {
-            ulReturnValue = ATOMIC_COMPARE_AND_SWAP_FAILURE;
+            if( *pulDestination == ulComparand )
+            {
+                *pulDestination = ulExchange;
+                ulReturnValue = ATOMIC_COMPARE_AND_SWAP_SUCCESS;
+            }
+            else
+            {
+                ulReturnValue = ATOMIC_COMPARE_AND_SWAP_FAILURE;
+            }
         }
+        ATOMIC_EXIT_CRITICAL();
     }
-    ATOMIC_EXIT_CRITICAL();
+    #endif /* atomicUSE_EXCLUSIVE_ACCESS */
 
     return ulReturnValue;
 }
@@ -146,12 +182,23 @@ static portFORCE_INLINE void * Atomic_SwapPointers_p32( void * volatile * ppvDes
 {
     void * pReturnValue;
 
-    ATOMIC_ENTER_CRITICAL();
+    #if ( atomicUSE_EXCLUSIVE_ACCESS == 1 )
     {
-        pReturnValue = *ppvDestination;
-        *ppvDestination = pvExchange;
+        do
+        {
+            pReturnValue = ( void * ) ulPortLoadExclusive( ( volatile uint32_t * ) ppvDestination );
+        } while( ulPortStoreExclusive( ( volatile uint32_t * ) ppvDestination, ( uint32_t ) pvExchange ) != 0U );
     }
-    ATOMIC_EXIT_CRITICAL();
+    #else /* atomicUSE_EXCLUSIVE_ACCESS */
+    {
+        ATOMIC_ENTER_CRITICAL();
+        {
+            pReturnValue = *ppvDestination;
+            *ppvDestination = pvExchange;
+        }
+        ATOMIC_EXIT_CRITICAL();
+    }
+    #endif /* atomicUSE_EXCLUSIVE_ACCESS */
 
     return pReturnValue;
 }
@@ -179,15 +226,36 @@ static portFORCE_INLINE uint32_t Atomic_CompareAndSwapPointers_p32( void * volat
 {
     uint32_t ulReturnValue = ATOMIC_COMPARE_AND_SWAP_FAILURE;
 
-    ATOMIC_ENTER_CRITICAL();
+    #if ( atomicUSE_EXCLUSIVE_ACCESS == 1 )
     {
-        if( *ppvDestination == pvComparand )
+        for( ; ; )
         {
-            *ppvDestination = pvExchange;
-            ulReturnValue = ATOMIC_COMPARE_AND_SWAP_SUCCESS;
+            if( ulPortLoadExclusive( ( volatile uint32_t * ) ppvDestination ) != ( uint32_t ) pvComparand )
+            {
+                vPortClearExclusive();
+                break;
+            }
+
+            if( ulPortStoreExclusive( ( volatile uint32_t * ) ppvDestination, ( uint32_t ) pvExchange ) == 0U )
+            {
+                ulReturnValue = ATOMIC_COMPARE_AND_SWAP_SUCCESS;
+                break;
+            }
         }
     }
-    ATOMIC_EXIT_CRITICAL();
+    #else /* atomicUSE_EXCLUSIVE_ACCESS */
+    {
+        ATOMIC_ENTER_CRITICAL();
+        {
+            if( *ppvDestination == pvComparand )
+            {
+                *ppvDestination = pvExchange;
+                ulReturnValue = ATOMIC_COMPARE_AND_SWAP_SUCCESS;
+            }
+        }
+        ATOMIC_EXIT_CRITICAL();
+    }
+    #endif /* atomicUSE_EXCLUSIVE_ACCESS */
 
     return ulReturnValue;
 }
@@ -211,12 +279,23 @@ static portFORCE_INLINE uint32_t Atomic_Add_u32( uint32_t volatile * pulAddend,
 {
     uint32_t ulCurrent;
 
-    ATOMIC_ENTER_CRITICAL();
+    #if ( atomicUSE_EXCLUSIVE_ACCESS == 1 )
     {
-        ulCurrent = *pulAddend;
-        *pulAddend += ulCount;
+        do
+        {
+            ulCurrent = ulPortLoadExclusive( pulAddend );
+        } while( ulPortStoreExclusive( pulAddend, ulCurrent + ulCount ) != 0U );
+    }
+    #else /* atomicUSE_EXCLUSIVE_ACCESS */
+    {
+        ATOMIC_ENTER_CRITICAL();
+        {
+            ulCurrent = *pulAddend;
+            *pulAddend += ulCount;
+        }
+        ATOMIC_EXIT_CRITICAL();
     }
-    ATOMIC_EXIT_CRITICAL();
+    #endif /* atomicUSE_EXCLUSIVE_ACCESS */
 
     return ulCurrent;
 }
@@ -239,12 +318,23 @@ static portFORCE_INLINE uint32_t Atomic_Subtract_u32( uint32_t volatile * pulAdd
 {
     uint32_t ulCurrent;
 
-    ATOMIC_ENTER_CRITICAL();
+    #if ( atomicUSE_EXCLUSIVE_ACCESS == 1 )
     {
-        ulCurrent = *pulAddend;
-        *pulAddend -= ulCount;
+        do
+        {
+            ulCurrent = ulPortLoadExclusive( pulAddend );
+        } while( ulPortStoreExclusive( pulAddend, ulCurrent - ulCount ) != 0U );
     }
-    ATOMIC_EXIT_CRITICAL();
+    #else /* atomicUSE_EXCLUSIVE_ACCESS */
+    {
+        ATOMIC_ENTER_CRITICAL();
+        {
+            ulCurrent = *pulAddend;
+            *pulAddend -= ulCount;
+        }
+        ATOMIC_EXIT_CRITICAL();
+    }
+    #endif /* atomicUSE_EXCLUSIVE_ACCESS */
 
     return ulCurrent;
 }
@@ -264,12 +354,23 @@ static portFORCE_INLINE uint32_t Atomic_Increment_u32( uint32_t volatile * pulAd
 {
     uint32_t ulCurrent;
 
-    ATOMIC_ENTER_CRITICAL();
+    #if ( atomicUSE_EXCLUSIVE_ACCESS == 1 )
+    {
+        do
+        {
+            ulCurrent = ulPortLoadExclusive( pulAddend );
+        } while( ulPortStoreExclusive( pulAddend, ulCurrent + 1U ) != 0U );
+    }
+    #else /* atomicUSE_EXCLUSIVE_ACCESS */
     {
-        ulCurrent = *pulAddend;
-        *pulAddend += 1;
+        ATOMIC_ENTER_CRITICAL();
+        {
+            ulCurrent = *pulAddend;
+            *pulAddend += 1;
+        }
+        ATOMIC_EXIT_CRITICAL();
     }
-    ATOMIC_EXIT_CRITICAL();
+    #endif /* atomicUSE_EXCLUSIVE_ACCESS */
 
     return ulCurrent;
 }
@@ -289,12 +390,23 @@ static portFORCE_INLINE uint32_t Atomic_Decrement_u32( uint32_t volatile * pulAd
 {
     uint32_t ulCurrent;
 
-    ATOMIC_ENTER_CRITICAL();
+    #if ( atomicUSE_EXCLUSIVE_ACCESS == 1 )
     {
-        ulCurrent = *pulAddend;
-        *pulAddend -= 1;
+        do
+        {
+            ulCurrent = ulPortLoadExclusive( pulAddend );
+        } while( ulPortStoreExclusive( pulAddend, ulCurrent - 1U ) != 0U );
     }
-    ATOMIC_EXIT_CRITICAL();
+    #else /* atomicUSE_EXCLUSIVE_ACCESS */
+    {
+        ATOMIC_ENTER_CRITICAL();
+        {
+            ulCurrent = *pulAddend;
+            *pulAddend -= 1;
+        }
+        ATOMIC_EXIT_CRITICAL();
+    }
+    #endif /* atomicUSE_EXCLUSIVE_ACCESS */
 
     return ulCurrent;
 }
@@ -317,12 +429,23 @@ static portFORCE_INLINE uint32_t Atomic_OR_u32( uint32_t volatile * pulDestinati
 {
     uint32_t ulCurrent;
 
-    ATOMIC_ENTER_CRITICAL();
+    #if ( atomicUSE_EXCLUSIVE_ACCESS == 1 )
     {
-        ulCurrent = *pulDestination;
-        *pulDestination |= ulValue;
+        do
+        {
+            ulCurrent = ulPortLoadExclusive( pulDestination );
+        } while( ulPortStoreExclusive( pulDestination, ulCurrent | ulValue ) != 0U );
     }
-    ATOMIC_EXIT_CRITICAL();
+    #else /* atomicUSE_EXCLUSIVE_ACCESS */
+    {
+        ATOMIC_ENTER_CRITICAL();
+        {
+            ulCurrent = *pulDestination;
+            *pulDestination |= ulValue;
+        }
+        ATOMIC_EXIT_CRITICAL();
+    }
+    #endif /* atomicUSE_EXCLUSIVE_ACCESS */
 
     return ulCurrent;
 }
@@ -344,12 +467,23 @@ static portFORCE_INLINE uint32_t Atomic_AND_u32( uint32_t volatile * pulDestinat
 {
     uint32_t ulCurrent;
 
-    ATOMIC_ENTER_CRITICAL();
+    #if ( atomicUSE_EXCLUSIVE_ACCESS == 1 )
     {
-        ulCurrent = *pulDestination;
-        *pulDestination &= ulValue;
+        do
+        {
+            ulCurrent = ulPortLoadExclusive( pulDestination );
+        } while( ulPortStoreExclusive( pulDestination, ulCurrent & ulValue ) != 0U );
     }
-    ATOMIC_EXIT_CRITICAL();
+    #else /* atomicUSE_EXCLUSIVE_ACCESS */
+    {
+        ATOMIC_ENTER_CRITICAL();
+        {
+            ulCurrent = *pulDestination;
+            *pulDestination &= ulValue;
+        }
+        ATOMIC_EXIT_CRITICAL();
+    }
+    #endif /* atomicUSE_EXCLUSIVE_ACCESS */
 
     return ulCurrent;
 }
@@ -371,12 +505,23 @@ static portFORCE_INLINE uint32_t Atomic_NAND_u32( uint32_t volatile * pulDestina
 {
     uint32_t ulCurrent;
 
-    ATOMIC_ENTER_CRITICAL();
+    #if ( atomicUSE_EXCLUSIVE_ACCESS == 1 )
+    {
+        do
+        {
+            ulCurrent = ulPortLoadExclusive( pulDestination );
+        } while( ulPortStoreExclusive( pulDestination, ~( ulCurrent & ulValue ) ) != 0U );
+    }
+    #else /* atomicUSE_EXCLUSIVE_ACCESS */
     {
-        ulCurrent = *pulDestination;
-        *pulDestination = ~( ulCurrent & ulValue );
+        ATOMIC_ENTER_CRITICAL();
+        {
+            ulCurrent = *pulDestination;
+            *pulDestination = ~( ulCurrent & ulValue );
+        }
+        ATOMIC_EXIT_CRITICAL();
     }
-    ATOMIC_EXIT_CRITICAL();
+    #endif /* atomicUSE_EXCLUSIVE_ACCESS */
 
     return ulCurrent;
 }
@@ -398,12 +543,23 @@ static portFORCE_INLINE uint32_t Atomic_XOR_u32( uint32_t volatile * pulDestinat
 {
     uint32_t ulCurrent;
 
-    ATOMIC_ENTER_CRITICAL();
+    #if ( atomicUSE_EXCLUSIVE_ACCESS == 1 )
     {
-        ulCurrent = *pulDestination;
-        *pulDestination ^= ulValue;
+        do
+        {
+            ulCurrent = ulPortLoadExclusive( pulDestination );
+        } while( ulPortStoreExclusive( pulDestination, ulCurrent ^ ulValue ) != 0U );
+    }
+    #else /* atomicUSE_EXCLUSIVE_ACCESS */
+    {
+        ATOMIC_ENTER_CRITICAL();
+        {
+            ulCurrent = *pulDestination;
+            *pulDestination ^= ulValue;
+        }
+        ATOMIC_EXIT_CRITICAL();
     }
-    ATOMIC_EXIT_CRITICAL();
+    #endif /* atomicUSE_EXCLUSIVE_ACCESS */
 
     return ulCurrent;
 }
@@ -812,6 +812,42 @@ typedef void * MessageBufferHandle_t;
 #define xMessageBufferReceiveCompletedFromISR( xMessageBuffer, pxHigherPriorityTaskWoken ) \
     xStreamBufferReceiveCompletedFromISR( ( StreamBufferHandle_t ) xMessageBuffer, pxHigherPriorityTaskWoken )
 
+/**
+ * message_buffer.h
+ *
+ * Zero copy message access, see xStreamBufferSendReserve(),
+ * xStreamBufferSendCommit(), xStreamBufferReceivePeek() and
+ * xStreamBufferReceiveConsume() in stream_buffer.h.  A reservation covers the
+ * whole message or nothing, the committed length becomes the message length,
+ * and a peek returns the payload of the next message only.
+ *
+ * \defgroup xMessageBufferSendReserve xMessageBufferSendReserve
+ * \ingroup MessageBufferManagement
+ */
+#define xMessageBufferSendReserve( xMessageBuffer, xDataLengthBytes, pxSpans, xTicksToWait ) \
+    xStreamBufferSendReserve( ( StreamBufferHandle_t ) xMessageBuffer, xDataLengthBytes, pxSpans, xTicksToWait )
+
+#define xMessageBufferSendReserveFromISR( xMessageBuffer, xDataLengthBytes, pxSpans ) \
+    xStreamBufferSendReserveFromISR( ( StreamBufferHandle_t ) xMessageBuffer, xDataLengthBytes, pxSpans )
+
+#define xMessageBufferSendCommit( xMessageBuffer, xBytesWritten ) \
+    xStreamBufferSendCommit( ( StreamBufferHandle_t ) xMessageBuffer, xBytesWritten )
+
+#define xMessageBufferSendCommitFromISR( xMessageBuffer, xBytesWritten, pxHigherPriorityTaskWoken ) \
+    xStreamBufferSendCommitFromISR( ( StreamBufferHandle_t ) xMessageBuffer, xBytesWritten, pxHigherPriorityTaskWoken )
+
+#define xMessageBufferReceivePeek( xMessageBuffer, pxSpans, xTicksToWait ) \
+    xStreamBufferReceivePeek( ( StreamBufferHandle_t ) xMessageBuffer, pxSpans, xTicksToWait )
+
+#define xMessageBufferReceivePeekFromISR( xMessageBuffer, pxSpans ) \
+    xStreamBufferReceivePeekFromISR( ( StreamBufferHandle_t ) xMessageBuffer, pxSpans )
+
+#define xMessageBufferReceiveConsume( xMessageBuffer ) \
+    xStreamBufferReceiveConsume( ( StreamBufferHandle_t ) xMessageBuffer, 0 )
+
+#define xMessageBufferReceiveConsumeFromISR( xMessageBuffer, pxHigherPriorityTaskWoken ) \
+    xStreamBufferReceiveConsumeFromISR( ( StreamBufferHandle_t ) xMessageBuffer, 0, pxHigherPriorityTaskWoken )
+
 /* *INDENT-OFF* */
 #if defined( __cplusplus )
     } /* extern "C" */
@@ -1416,6 +1416,119 @@ BaseType_t xQueueReceiveFromISR( QueueHandle_t xQueue,
                                  void * const pvBuffer,
                                  BaseType_t * const pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
 
+/**
+ * queue. h
+ * <pre>
+ * UBaseType_t uxQueueSendBatch(
+ *                               QueueHandle_t xQueue,
+ *                               const void * const pvItems,
+ *                               UBaseType_t uxCount,
+ *                               TickType_t xTicksToWait
+ *                           );
+ * </pre>
+ *
+ * Post up to uxCount items, stored back to back at pvItems, to the back of a
+ * queue.  All the items that fit are copied inside one critical section and
+ * waiting receivers are unblocked once per call rather than once per item.
+ *
+ * If the queue is full the call blocks, as xQueueSendToBack() does, until the
+ * first item can be posted, then posts as many of the rest as fit without
+ * blocking again.  Interrupts are masked for the time it takes to copy the
+ * items that fit, so bound uxCount where interrupt latency matters.
+ *
+ * Not for use with semaphores or mutexes.
+ *
+ * @param xQueue The handle to the queue on which the items are to be posted.
+ *
+ * @param pvItems Pointer to the first of the items to be queued.
+ *
+ * @param uxCount The number of items at pvItems.
+ *
+ * @param xTicksToWait The maximum amount of time the task should block
+ * waiting for space to become available on the queue.
+ *
+ * @return The number of items posted, from 0 to uxCount.
+ *
+ * \defgroup uxQueueSendBatch uxQueueSendBatch
+ * \ingroup QueueManagement
+ */
+UBaseType_t uxQueueSendBatch( QueueHandle_t xQueue,
+                              const void * const pvItems,
+                              UBaseType_t uxCount,
+                              TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/**
+ * queue. h
+ * <pre>
+ * UBaseType_t uxQueueSendBatchFromISR(
+ *                                      QueueHandle_t xQueue,
+ *                                      const void * const pvItems,
+ *                                      UBaseType_t uxCount,
+ *                                      BaseType_t *pxHigherPriorityTaskWoken
+ *                                  );
+ * </pre>
+ *
+ * Interrupt safe version of uxQueueSendBatch().  Posts as many items as fit
+ * and returns immediately.  *pxHigherPriorityTaskWoken is set to pdTRUE if a
+ * context switch should be requested before the interrupt is exited.
+ *
+ * \defgroup uxQueueSendBatchFromISR uxQueueSendBatchFromISR
+ * \ingroup QueueManagement
+ */
+UBaseType_t uxQueueSendBatchFromISR( QueueHandle_t xQueue,
+                                     const void * const pvItems,
+                                     UBaseType_t uxCount,
+                                     BaseType_t * const pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+
+/**
+ * queue. h
+ * <pre>
+ * UBaseType_t uxQueueReceiveBatch(
+ *                                  QueueHandle_t xQueue,
+ *                                  void * const pvBuffer,
+ *                                  UBaseType_t uxCount,
+ *                                  TickType_t xTicksToWait
+ *                              );
+ * </pre>
+ *
+ * Receive up to uxCount items from a queue into pvBuffer, which must have room
+ * for uxCount items.  All the items available are copied inside one critical
+ * section and waiting senders are unblocked once per call.
+ *
+ * If the queue is empty the call blocks, as xQueueReceive() does, until one
+ * item arrives, then drains whatever else is available without blocking again.
+ *
+ * @return The number of items received, from 0 to uxCount.
+ *
+ * \defgroup uxQueueReceiveBatch uxQueueReceiveBatch
+ * \ingroup QueueManagement
+ */
+UBaseType_t uxQueueReceiveBatch( QueueHandle_t xQueue,
+                                 void * const pvBuffer,
+                                 UBaseType_t uxCount,
+                                 TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/**
+ * queue. h
+ * <pre>
+ * UBaseType_t uxQueueReceiveBatchFromISR(
+ *                                         QueueHandle_t xQueue,
+ *                                         void * const pvBuffer,
+ *                                         UBaseType_t uxCount,
+ *                                         BaseType_t *pxHigherPriorityTaskWoken
+ *                                     );
+ * </pre>
+ *
+ * Interrupt safe version of uxQueueReceiveBatch(), never blocks.
+ *
+ * \defgroup uxQueueReceiveBatchFromISR uxQueueReceiveBatchFromISR
+ * \ingroup QueueManagement
+ */
+UBaseType_t uxQueueReceiveBatchFromISR( QueueHandle_t xQueue,
+                                        void * const pvBuffer,
+                                        UBaseType_t uxCount,
+                                        BaseType_t * const pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+
 /*
  * Utilities to query queues that are safe to use from an ISR.  These utilities
  * should be used only from witin an ISR, or within a critical section.
@@ -69,6 +69,17 @@
 struct StreamBufferDef_t;
 typedef struct StreamBufferDef_t * StreamBufferHandle_t;
 
+/**
+ * A contiguous region of a stream buffer's storage area, as handed out by the
+ * zero copy functions xStreamBufferSendReserve() and xStreamBufferReceivePeek().
+ * Data that wraps around the end of the storage area is described by two spans.
+ */
+typedef struct StreamBufferSpan_t
+{
+    uint8_t * pucData; /* Start of the region. */
+    size_t xLength;    /* Number of bytes in the region, may be 0. */
+} StreamBufferSpan_t;
+
 
 /**
  * message_buffer.h
@@ -838,6 +849,164 @@ BaseType_t xStreamBufferSendCompletedFromISR( StreamBufferHandle_t xStreamBuffer
 BaseType_t xStreamBufferReceiveCompletedFromISR( StreamBufferHandle_t xStreamBuffer,
                                                  BaseType_t * pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
 
+/**
+ * stream_buffer.h
+ *
+ * <pre>
+ * size_t xStreamBufferSendReserve( StreamBufferHandle_t xStreamBuffer,
+ *                                  size_t xDataLengthBytes,
+ *                                  StreamBufferSpan_t pxSpans[ 2 ],
+ *                                  TickType_t xTicksToWait );
+ * </pre>
+ *
+ * Zero copy alternative to xStreamBufferSend().  Instead of copying data into
+ * the buffer, returns up to two spans of the buffer's own storage that the
+ * caller (a DMA channel, a parser, ...) writes directly.  Nothing becomes
+ * visible to the reader until xStreamBufferSendCommit() is called.
+ *
+ * For a stream buffer as many bytes as are free (up to xDataLengthBytes) are
+ * reserved.  For a message buffer either the whole message is reserved or
+ * nothing is - the space for the message length is accounted for internally
+ * and is not part of the spans.
+ *
+ * The same single writer rule as xStreamBufferSend() applies, and there must be
+ * only one outstanding reservation at a time.
+ *
+ * @param xStreamBuffer The handle of the stream buffer to write to.
+ *
+ * @param xDataLengthBytes The number of bytes the caller wants to write.
+ *
+ * @param pxSpans Filled with the reserved regions.  pxSpans[ 1 ].xLength is
+ * non-zero only when the reservation wraps around the end of the storage.
+ *
+ * @param xTicksToWait The maximum time to wait for enough space, as for
+ * xStreamBufferSend().
+ *
+ * @return The number of bytes reserved, the sum of the two span lengths.
+ *
+ * \defgroup xStreamBufferSendReserve xStreamBufferSendReserve
+ * \ingroup StreamBufferManagement
+ */
+size_t xStreamBufferSendReserve( StreamBufferHandle_t xStreamBuffer,
+                                 size_t xDataLengthBytes,
+                                 StreamBufferSpan_t pxSpans[ 2 ],
+                                 TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/**
+ * stream_buffer.h
+ *
+ * Interrupt safe version of xStreamBufferSendReserve(), never blocks.
+ *
+ * \defgroup xStreamBufferSendReserveFromISR xStreamBufferSendReserveFromISR
+ * \ingroup StreamBufferManagement
+ */
+size_t xStreamBufferSendReserveFromISR( StreamBufferHandle_t xStreamBuffer,
+                                        size_t xDataLengthBytes,
+                                        StreamBufferSpan_t pxSpans[ 2 ] ) PRIVILEGED_FUNCTION;
+
+/**
+ * stream_buffer.h
+ *
+ * <pre>
+ * size_t xStreamBufferSendCommit( StreamBufferHandle_t xStreamBuffer, size_t xBytesWritten );
+ * </pre>
+ *
+ * Publishes the first xBytesWritten bytes of the last reservation to the
+ * reader and unblocks it if the trigger level is reached.  xBytesWritten may be
+ * less than was reserved; for a message buffer it becomes the message length.
+ * Committing more than the matching reserve returned fails configASSERT(), and
+ * a reservation can be committed only once.
+ *
+ * @return xBytesWritten.
+ *
+ * \defgroup xStreamBufferSendCommit xStreamBufferSendCommit
+ * \ingroup StreamBufferManagement
+ */
+size_t xStreamBufferSendCommit( StreamBufferHandle_t xStreamBuffer,
+                                size_t xBytesWritten ) PRIVILEGED_FUNCTION;
+
+/**
+ * stream_buffer.h
+ *
+ * Interrupt safe version of xStreamBufferSendCommit().  pxHigherPriorityTaskWoken
+ * has the same meaning as for xStreamBufferSendFromISR().
+ *
+ * \defgroup xStreamBufferSendCommitFromISR xStreamBufferSendCommitFromISR
+ * \ingroup StreamBufferManagement
+ */
+size_t xStreamBufferSendCommitFromISR( StreamBufferHandle_t xStreamBuffer,
+                                       size_t xBytesWritten,
+                                       BaseType_t * const pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+
+/**
+ * stream_buffer.h
+ *
+ * <pre>
+ * size_t xStreamBufferReceivePeek( StreamBufferHandle_t xStreamBuffer,
+ *                                  StreamBufferSpan_t pxSpans[ 2 ],
+ *                                  TickType_t xTicksToWait );
+ * </pre>
+ *
+ * Zero copy alternative to xStreamBufferReceive().  Returns spans over the data
+ * held in the buffer without removing it.  For a stream buffer that is all the
+ * bytes available, for a message buffer it is the payload of the next message.
+ * The data stays valid until xStreamBufferReceiveConsume() is called.
+ *
+ * @param xTicksToWait The maximum time to wait for data, as for
+ * xStreamBufferReceive().
+ *
+ * @return The number of bytes described by the spans.
+ *
+ * \defgroup xStreamBufferReceivePeek xStreamBufferReceivePeek
+ * \ingroup StreamBufferManagement
+ */
+size_t xStreamBufferReceivePeek( StreamBufferHandle_t xStreamBuffer,
+                                 StreamBufferSpan_t pxSpans[ 2 ],
+                                 TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/**
+ * stream_buffer.h
+ *
+ * Interrupt safe version of xStreamBufferReceivePeek(), never blocks.
+ *
+ * \defgroup xStreamBufferReceivePeekFromISR xStreamBufferReceivePeekFromISR
+ * \ingroup StreamBufferManagement
+ */
+size_t xStreamBufferReceivePeekFromISR( StreamBufferHandle_t xStreamBuffer,
+                                        StreamBufferSpan_t pxSpans[ 2 ] ) PRIVILEGED_FUNCTION;
+
+/**
+ * stream_buffer.h
+ *
+ * <pre>
+ * size_t xStreamBufferReceiveConsume( StreamBufferHandle_t xStreamBuffer, size_t xBytesRead );
+ * </pre>
+ *
+ * Removes data previously returned by xStreamBufferReceivePeek() and unblocks a
+ * writer waiting for space.  A stream buffer drops xBytesRead bytes (a parser
+ * may consume less than it peeked), a message buffer always drops the whole
+ * next message and xBytesRead is ignored.
+ *
+ * @return The number of bytes removed, not counting the message length.
+ *
+ * \defgroup xStreamBufferReceiveConsume xStreamBufferReceiveConsume
+ * \ingroup StreamBufferManagement
+ */
+size_t xStreamBufferReceiveConsume( StreamBufferHandle_t xStreamBuffer,
+                                    size_t xBytesRead ) PRIVILEGED_FUNCTION;
+
+/**
+ * stream_buffer.h
+ *
+ * Interrupt safe version of xStreamBufferReceiveConsume().
+ *
+ * \defgroup xStreamBufferReceiveConsumeFromISR xStreamBufferReceiveConsumeFromISR
+ * \ingroup StreamBufferManagement
+ */
+size_t xStreamBufferReceiveConsumeFromISR( StreamBufferHandle_t xStreamBuffer,
+                                           size_t xBytesRead,
+                                           BaseType_t * const pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+
 /* Functions below here are not part of the public API. */
 StreamBufferHandle_t xStreamBufferGenericCreate( size_t xBufferSizeBytes,
                                                  size_t xTriggerLevelBytes,
@@ -237,6 +237,39 @@
     }
 /*-----------------------------------------------------------*/
 
+/* Exclusive access primitives used by atomic.h.  The local monitor is cleared
+ * by the hardware on every exception entry and return, so a STREX that follows
+ * a preemption always fails and the read-modify-write is retried. */
+    #define portHAS_EXCLUSIVE_ACCESS    1
+
+    portFORCE_INLINE static uint32_t ulPortLoadExclusive( volatile uint32_t * pulAddress )
+    {
+        uint32_t ulValue;
+
+        __asm volatile ( "ldrex %0, [%1]" : "=r" ( ulValue ) : "r" ( pulAddress ) : "memory" );
+
+        return ulValue;
+    }
+/*-----------------------------------------------------------*/
+
+/* Returns 0 if the store succeeded, 1 if the exclusive access was lost. */
+    portFORCE_INLINE static uint32_t ulPortStoreExclusive( volatile uint32_t * pulAddress,
+                                                           uint32_t ulValue )
+    {
+        uint32_t ulFailed;
+
+        __asm volatile ( "strex %0, %2, [%1]" : "=&r" ( ulFailed ) : "r" ( pulAddress ), "r" ( ulValue ) : "memory" );
+
+        return ulFailed;
+    }
+/*-----------------------------------------------------------*/
+
+    portFORCE_INLINE static void vPortClearExclusive( void )
+    {
+        __asm volatile ( "clrex" ::: "memory" );
+    }
+/*-----------------------------------------------------------*/
+
     #define portMEMORY_BARRIER()    __asm volatile ( "" ::: "memory" )
 
     #ifdef __cplusplus
@@ -201,6 +201,30 @@ static BaseType_t prvCopyDataToQueue( Queue_t * const pxQueue,
 static void prvCopyDataFromQueue( Queue_t * const pxQueue,
                                   void * const pvBuffer ) PRIVILEGED_FUNCTION;
 
+/*
+ * Batch counterparts of prvCopyDataToQueue() and prvCopyDataFromQueue().  Copy
+ * uxCount items to the back of / from the front of the queue with at most two
+ * memcpy() calls each.  The caller checks there is enough space or data.
+ */
+static void prvCopyBatchToQueue( Queue_t * const pxQueue,
+                                 const void * pvItems,
+                                 UBaseType_t uxCount ) PRIVILEGED_FUNCTION;
+
+static void prvCopyBatchFromQueue( Queue_t * const pxQueue,
+                                   void * const pvBuffer,
+                                   UBaseType_t uxCount ) PRIVILEGED_FUNCTION;
+
+/*
+ * Unblock the tasks that can make progress now uxCount items have been added
+ * to or removed from the queue.  Called with interrupts masked and the queue
+ * unlocked.  Returns pdTRUE if a higher priority task was unblocked.
+ */
+static BaseType_t prvUnblockAfterBatchSend( Queue_t * const pxQueue,
+                                            UBaseType_t uxCount ) PRIVILEGED_FUNCTION;
+
+static BaseType_t prvUnblockAfterBatchReceive( Queue_t * const pxQueue,
+                                               UBaseType_t uxCount ) PRIVILEGED_FUNCTION;
+
 #if ( configUSE_QUEUE_SETS == 1 )
 
 /*
@@ -261,6 +285,36 @@ static void prvInitialiseNewQueue( const UBaseType_t uxQueueLength,
     taskEXIT_CRITICAL()
 /*-----------------------------------------------------------*/
 
+/*
+ * Macros to count items batch-sent to or batch-received from a locked queue
+ * from an ISR.  prvUnlockQueue() wakes at most one task per count, so, as
+ * upstream prvIncrementQueueTxLock() does, there is no point counting past the
+ * number of tasks in the system, and capping keeps a large batch from
+ * overflowing the int8_t lock.
+ */
+#define prvIncrementQueueTxLock( pxQueue, cTxLock, uxItems )                                     \
+    do {                                                                                         \
+        const UBaseType_t uxNumberOfTasks = uxTaskGetNumberOfTasks();                            \
+        if( ( UBaseType_t ) ( cTxLock ) < uxNumberOfTasks )                                      \
+        {                                                                                        \
+            const UBaseType_t uxIncrement = configMIN( ( uxItems ), uxNumberOfTasks - ( UBaseType_t ) ( cTxLock ) ); \
+            configASSERT( ( ( UBaseType_t ) ( cTxLock ) + uxIncrement ) <= ( UBaseType_t ) queueINT8_MAX ); \
+            ( pxQueue )->cTxLock = ( int8_t ) ( ( cTxLock ) + ( int8_t ) uxIncrement );          \
+        }                                                                                        \
+    } while( 0 )
+
+#define prvIncrementQueueRxLock( pxQueue, cRxLock, uxItems )                                     \
+    do {                                                                                         \
+        const UBaseType_t uxNumberOfTasks = uxTaskGetNumberOfTasks();                            \
+        if( ( UBaseType_t ) ( cRxLock ) < uxNumberOfTasks )                                      \
+        {                                                                                        \
+            const UBaseType_t uxIncrement = configMIN( ( uxItems ), uxNumberOfTasks - ( UBaseType_t ) ( cRxLock ) ); \
+            configASSERT( ( ( UBaseType_t ) ( cRxLock ) + uxIncrement ) <= ( UBaseType_t ) queueINT8_MAX ); \
+            ( pxQueue )->cRxLock = ( int8_t ) ( ( cRxLock ) + ( int8_t ) uxIncrement );          \
+        }                                                                                        \
+    } while( 0 )
+/*-----------------------------------------------------------*/
+
 BaseType_t xQueueGenericReset( QueueHandle_t xQueue,
                                BaseType_t xNewQueue )
 {
@@ -1923,6 +1977,228 @@ BaseType_t xQueueReceiveFromISR( QueueHandle_t xQueue,
 }
 /*-----------------------------------------------------------*/
 
+UBaseType_t uxQueueSendBatch( QueueHandle_t xQueue,
+                              const void * const pvItems,
+                              UBaseType_t uxCount,
+                              TickType_t xTicksToWait )
+{
+    UBaseType_t uxSent;
+    BaseType_t xYieldRequired = pdFALSE;
+    Queue_t * const pxQueue = xQueue;
+
+    configASSERT( pxQueue );
+    configASSERT( pvItems );
+    configASSERT( pxQueue->uxItemSize != ( UBaseType_t ) 0U );
+
+    taskENTER_CRITICAL();
+    {
+        uxSent = configMIN( uxCount, pxQueue->uxLength - pxQueue->uxMessagesWaiting );
+
+        if( uxSent > ( UBaseType_t ) 0 )
+        {
+            traceQUEUE_SEND( pxQueue );
+            prvCopyBatchToQueue( pxQueue, pvItems, uxSent );
+            xYieldRequired = prvUnblockAfterBatchSend( pxQueue, uxSent );
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if( ( uxSent == ( UBaseType_t ) 0 ) && ( uxCount > ( UBaseType_t ) 0 ) && ( xTicksToWait != ( TickType_t ) 0 ) )
+    {
+        /* The queue is full.  Block for the first item the usual way, then put
+         * in as many of the rest as fit without blocking again. */
+        if( xQueueGenericSend( xQueue, pvItems, xTicksToWait, queueSEND_TO_BACK ) == pdPASS )
+        {
+            uxSent = ( UBaseType_t ) 1 + uxQueueSendBatch( xQueue, ( const int8_t * ) pvItems + pxQueue->uxItemSize, uxCount - ( UBaseType_t ) 1, 0 );
+        }
+        else
+        {
+            traceQUEUE_SEND_FAILED( pxQueue );
+        }
+    }
+    else if( xYieldRequired != pdFALSE )
+    {
+        queueYIELD_IF_USING_PREEMPTION();
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    return uxSent;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxQueueSendBatchFromISR( QueueHandle_t xQueue,
+                                     const void * const pvItems,
+                                     UBaseType_t uxCount,
+                                     BaseType_t * const pxHigherPriorityTaskWoken )
+{
+    UBaseType_t uxSent;
+    UBaseType_t uxSavedInterruptStatus;
+    Queue_t * const pxQueue = xQueue;
+
+    configASSERT( pxQueue );
+    configASSERT( pvItems );
+    configASSERT( pxQueue->uxItemSize != ( UBaseType_t ) 0U );
+
+    /* See xQueueGenericSendFromISR(). */
+    portASSERT_IF_INTERRUPT_PRIORITY_INVALID();
+
+    uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+    {
+        uxSent = configMIN( uxCount, pxQueue->uxLength - pxQueue->uxMessagesWaiting );
+
+        if( uxSent > ( UBaseType_t ) 0 )
+        {
+            const int8_t cTxLock = pxQueue->cTxLock;
+
+            traceQUEUE_SEND_FROM_ISR( pxQueue );
+            prvCopyBatchToQueue( pxQueue, pvItems, uxSent );
+
+            if( cTxLock == queueUNLOCKED )
+            {
+                if( ( prvUnblockAfterBatchSend( pxQueue, uxSent ) != pdFALSE ) && ( pxHigherPriorityTaskWoken != NULL ) )
+                {
+                    *pxHigherPriorityTaskWoken = pdTRUE;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+            else
+            {
+                /* Same as uxSent calls to xQueueSendFromISR() would do. */
+                prvIncrementQueueTxLock( pxQueue, cTxLock, uxSent );
+            }
+        }
+        else
+        {
+            traceQUEUE_SEND_FROM_ISR_FAILED( pxQueue );
+        }
+    }
+    portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+    return uxSent;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxQueueReceiveBatch( QueueHandle_t xQueue,
+                                 void * const pvBuffer,
+                                 UBaseType_t uxCount,
+                                 TickType_t xTicksToWait )
+{
+    UBaseType_t uxReceived;
+    BaseType_t xYieldRequired = pdFALSE;
+    Queue_t * const pxQueue = xQueue;
+
+    configASSERT( pxQueue );
+    configASSERT( pvBuffer );
+    configASSERT( pxQueue->uxItemSize != ( UBaseType_t ) 0U );
+
+    taskENTER_CRITICAL();
+    {
+        uxReceived = configMIN( uxCount, pxQueue->uxMessagesWaiting );
+
+        if( uxReceived > ( UBaseType_t ) 0 )
+        {
+            prvCopyBatchFromQueue( pxQueue, pvBuffer, uxReceived );
+            traceQUEUE_RECEIVE( pxQueue );
+            xYieldRequired = prvUnblockAfterBatchReceive( pxQueue, uxReceived );
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if( ( uxReceived == ( UBaseType_t ) 0 ) && ( uxCount > ( UBaseType_t ) 0 ) && ( xTicksToWait != ( TickType_t ) 0 ) )
+    {
+        /* The queue is empty.  Block for the first item the usual way, then
+         * drain whatever else arrived meanwhile without blocking again. */
+        if( xQueueReceive( xQueue, pvBuffer, xTicksToWait ) == pdPASS )
+        {
+            uxReceived = ( UBaseType_t ) 1 + uxQueueReceiveBatch( xQueue, ( int8_t * ) pvBuffer + pxQueue->uxItemSize, uxCount - ( UBaseType_t ) 1, 0 );
+        }
+        else
+        {
+            traceQUEUE_RECEIVE_FAILED( pxQueue );
+        }
+    }
+    else if( xYieldRequired != pdFALSE )
+    {
+        queueYIELD_IF_USING_PREEMPTION();
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    return uxReceived;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxQueueReceiveBatchFromISR( QueueHandle_t xQueue,
+                                        void * const pvBuffer,
+                                        UBaseType_t uxCount,
+                                        BaseType_t * const pxHigherPriorityTaskWoken )
+{
+    UBaseType_t uxReceived;
+    UBaseType_t uxSavedInterruptStatus;
+    Queue_t * const pxQueue = xQueue;
+
+    configASSERT( pxQueue );
+    configASSERT( pvBuffer );
+    configASSERT( pxQueue->uxItemSize != ( UBaseType_t ) 0U );
+
+    /* See xQueueGenericSendFromISR(). */
+    portASSERT_IF_INTERRUPT_PRIORITY_INVALID();
+
+    uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+    {
+        uxReceived = configMIN( uxCount, pxQueue->uxMessagesWaiting );
+
+        if( uxReceived > ( UBaseType_t ) 0 )
+        {
+            const int8_t cRxLock = pxQueue->cRxLock;
+
+            traceQUEUE_RECEIVE_FROM_ISR( pxQueue );
+            prvCopyBatchFromQueue( pxQueue, pvBuffer, uxReceived );
+
+            if( cRxLock == queueUNLOCKED )
+            {
+                if( ( prvUnblockAfterBatchReceive( pxQueue, uxReceived ) != pdFALSE ) && ( pxHigherPriorityTaskWoken != NULL ) )
+                {
+                    *pxHigherPriorityTaskWoken = pdTRUE;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+            else
+            {
+                /* Same as uxReceived calls to xQueueReceiveFromISR() would do. */
+                prvIncrementQueueRxLock( pxQueue, cRxLock, uxReceived );
+            }
+        }
+        else
+        {
+            traceQUEUE_RECEIVE_FROM_ISR_FAILED( pxQueue );
+        }
+    }
+    portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+    return uxReceived;
+}
+/*-----------------------------------------------------------*/
+
 BaseType_t xQueuePeekFromISR( QueueHandle_t xQueue,
                               void * const pvBuffer )
 {
@@ -2227,6 +2503,144 @@ static void prvCopyDataFromQueue( Queue_t * const pxQueue,
 }
 /*-----------------------------------------------------------*/
 
+static void prvCopyBatchToQueue( Queue_t * const pxQueue,
+                                 const void * pvItems,
+                                 UBaseType_t uxCount )
+{
+    size_t xBytes = ( size_t ) uxCount * ( size_t ) pxQueue->uxItemSize;
+    size_t xFirstBytes = configMIN( xBytes, ( size_t ) ( pxQueue->u.xQueue.pcTail - pxQueue->pcWriteTo ) );
+
+    /* This function is called from a critical section. */
+
+    ( void ) memcpy( ( void * ) pxQueue->pcWriteTo, pvItems, xFirstBytes );
+    pxQueue->pcWriteTo += xFirstBytes;
+
+    if( xBytes > xFirstBytes )
+    {
+        ( void ) memcpy( ( void * ) pxQueue->pcHead, ( const int8_t * ) pvItems + xFirstBytes, xBytes - xFirstBytes );
+        pxQueue->pcWriteTo = pxQueue->pcHead + ( xBytes - xFirstBytes );
+    }
+    else if( pxQueue->pcWriteTo >= pxQueue->u.xQueue.pcTail )
+    {
+        pxQueue->pcWriteTo = pxQueue->pcHead;
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    pxQueue->uxMessagesWaiting += uxCount;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCopyBatchFromQueue( Queue_t * const pxQueue,
+                                   void * const pvBuffer,
+                                   UBaseType_t uxCount )
+{
+    size_t xBytes = ( size_t ) uxCount * ( size_t ) pxQueue->uxItemSize;
+    size_t xFirstBytes;
+    int8_t * pcFirstItem;
+
+    /* This function is called from a critical section.  pcReadFrom points at
+     * the last item read, so the next item follows it. */
+
+    pcFirstItem = pxQueue->u.xQueue.pcReadFrom + pxQueue->uxItemSize;
+
+    if( pcFirstItem >= pxQueue->u.xQueue.pcTail )
+    {
+        pcFirstItem = pxQueue->pcHead;
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    xFirstBytes = configMIN( xBytes, ( size_t ) ( pxQueue->u.xQueue.pcTail - pcFirstItem ) );
+    ( void ) memcpy( pvBuffer, ( void * ) pcFirstItem, xFirstBytes );
+
+    if( xBytes > xFirstBytes )
+    {
+        ( void ) memcpy( ( int8_t * ) pvBuffer + xFirstBytes, ( void * ) pxQueue->pcHead, xBytes - xFirstBytes );
+        pxQueue->u.xQueue.pcReadFrom = pxQueue->pcHead + ( xBytes - xFirstBytes ) - pxQueue->uxItemSize;
+    }
+    else
+    {
+        pxQueue->u.xQueue.pcReadFrom = pcFirstItem + xFirstBytes - pxQueue->uxItemSize;
+    }
+
+    pxQueue->uxMessagesWaiting -= uxCount;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvUnblockAfterBatchSend( Queue_t * const pxQueue,
+                                            UBaseType_t uxCount )
+{
+    BaseType_t xReturn = pdFALSE;
+
+    #if ( configUSE_QUEUE_SETS == 1 )
+        if( pxQueue->pxQueueSetContainer != NULL )
+        {
+            /* The set holds one handle per item, as for single sends. */
+            while( uxCount > ( UBaseType_t ) 0 )
+            {
+                if( prvNotifyQueueSetContainer( pxQueue ) != pdFALSE )
+                {
+                    xReturn = pdTRUE;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+
+                --uxCount;
+            }
+        }
+        else
+    #endif /* configUSE_QUEUE_SETS */
+    {
+        /* One waiting receiver per item, stop as soon as nobody is left. */
+        while( ( uxCount > ( UBaseType_t ) 0 ) && ( listLIST_IS_EMPTY( &( pxQueue->xTasksWaitingToReceive ) ) == pdFALSE ) )
+        {
+            if( xTaskRemoveFromEventList( &( pxQueue->xTasksWaitingToReceive ) ) != pdFALSE )
+            {
+                xReturn = pdTRUE;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+
+            --uxCount;
+        }
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvUnblockAfterBatchReceive( Queue_t * const pxQueue,
+                                               UBaseType_t uxCount )
+{
+    BaseType_t xReturn = pdFALSE;
+
+    while( ( uxCount > ( UBaseType_t ) 0 ) && ( listLIST_IS_EMPTY( &( pxQueue->xTasksWaitingToSend ) ) == pdFALSE ) )
+    {
+        if( xTaskRemoveFromEventList( &( pxQueue->xTasksWaitingToSend ) ) != pdFALSE )
+        {
+            xReturn = pdTRUE;
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        --uxCount;
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
 static void prvUnlockQueue( Queue_t * const pxQueue )
 {
     /* THIS FUNCTION MUST BE CALLED WITH THE SCHEDULER SUSPENDED. */
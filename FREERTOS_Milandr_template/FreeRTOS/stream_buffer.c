@@ -143,6 +143,7 @@ typedef struct StreamBufferDef_t                 /*lint !e9058 Style convention
     volatile size_t xHead;                       /* Index to the next item to write within the buffer. */
     size_t xLength;                              /* The length of the buffer pointed to by pucBuffer. */
     size_t xTriggerLevelBytes;                   /* The number of bytes that must be in the stream buffer before a task that is waiting for data is unblocked. */
+    size_t xReserved;                            /* Bytes handed out by the last xStreamBufferSendReserve(), the most the matching commit may publish. */
     volatile TaskHandle_t xTaskWaitingToReceive; /* Holds the handle of a task waiting for data, or NULL if no tasks are waiting. */
     volatile TaskHandle_t xTaskWaitingToSend;    /* Holds the handle of a task waiting to send data to a message buffer that is full. */
     uint8_t * pucBuffer;                         /* Points to the buffer itself - that is - the RAM that stores the data passed through the buffer. */
@@ -213,6 +214,53 @@ static void prvInitialiseNewStreamBuffer( StreamBuffer_t * const pxStreamBuffer,
                                           size_t xTriggerLevelBytes,
                                           uint8_t ucFlags ) PRIVILEGED_FUNCTION;
 
+/*
+ * Fill pxSpans with the one or two contiguous regions of the buffer storage
+ * that hold xCount bytes starting at index xIndex.  The second span is only
+ * non-empty if the region wraps around the end of the storage area.
+ */
+static void prvGetSpans( const StreamBuffer_t * const pxStreamBuffer,
+                         size_t xIndex,
+                         size_t xCount,
+                         StreamBufferSpan_t pxSpans[ 2 ] ) PRIVILEGED_FUNCTION;
+
+/*
+ * Block the calling task until at least xRequiredSpace bytes are free in the
+ * buffer or xTicksToWait expires.  Returns the free space.
+ */
+static size_t prvWaitForSpace( StreamBuffer_t * const pxStreamBuffer,
+                               size_t xRequiredSpace,
+                               TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/*
+ * Block the calling task until more than xBytesToStoreMessageLength bytes are
+ * in the buffer or xTicksToWait expires.  Returns the bytes in the buffer.
+ */
+static size_t prvWaitForData( StreamBuffer_t * const pxStreamBuffer,
+                              size_t xBytesToStoreMessageLength,
+                              TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/*
+ * The zero copy counterparts of prvWriteMessageToBuffer() and
+ * prvReadMessageFromBuffer().  Reserve and peek only describe the storage, the
+ * head and tail indexes are moved by commit and consume.
+ */
+static size_t prvReserveMessage( StreamBuffer_t * const pxStreamBuffer,
+                                 size_t xDataLengthBytes,
+                                 size_t xSpace,
+                                 StreamBufferSpan_t pxSpans[ 2 ] ) PRIVILEGED_FUNCTION;
+
+static size_t prvCommitMessage( StreamBuffer_t * const pxStreamBuffer,
+                                size_t xBytesWritten ) PRIVILEGED_FUNCTION;
+
+static size_t prvPeekMessage( StreamBuffer_t * const pxStreamBuffer,
+                              size_t xBytesAvailable,
+                              StreamBufferSpan_t pxSpans[ 2 ] ) PRIVILEGED_FUNCTION;
+
+static size_t prvConsumeMessage( StreamBuffer_t * const pxStreamBuffer,
+                                 size_t xBytesRead,
+                                 size_t xBytesAvailable ) PRIVILEGED_FUNCTION;
+
 /*-----------------------------------------------------------*/
 
 #if ( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
@@ -1128,6 +1176,504 @@ BaseType_t xStreamBufferReceiveCompletedFromISR( StreamBufferHandle_t xStreamBuf
 }
 /*-----------------------------------------------------------*/
 
+size_t xStreamBufferSendReserve( StreamBufferHandle_t xStreamBuffer,
+                                 size_t xDataLengthBytes,
+                                 StreamBufferSpan_t pxSpans[ 2 ],
+                                 TickType_t xTicksToWait )
+{
+    StreamBuffer_t * const pxStreamBuffer = xStreamBuffer;
+    size_t xSpace;
+    size_t xRequiredSpace = xDataLengthBytes;
+    const size_t xMaxReportedSpace = pxStreamBuffer->xLength - ( size_t ) 1;
+
+    configASSERT( pxSpans );
+    configASSERT( pxStreamBuffer );
+
+    /* Same space rules as xStreamBufferSend(): a message buffer needs room for
+     * the whole message plus its length, a stream buffer accepts a partial
+     * reservation. */
+    if( ( pxStreamBuffer->ucFlags & sbFLAGS_IS_MESSAGE_BUFFER ) != ( uint8_t ) 0 )
+    {
+        xRequiredSpace += sbBYTES_TO_STORE_MESSAGE_LENGTH;
+        configASSERT( xRequiredSpace > xDataLengthBytes );
+
+        if( xRequiredSpace > xMaxReportedSpace )
+        {
+            xTicksToWait = ( TickType_t ) 0;
+        }
+    }
+    else if( xRequiredSpace > xMaxReportedSpace )
+    {
+        xRequiredSpace = xMaxReportedSpace;
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    if( xTicksToWait != ( TickType_t ) 0 )
+    {
+        xSpace = prvWaitForSpace( pxStreamBuffer, xRequiredSpace, xTicksToWait );
+    }
+    else
+    {
+        xSpace = xStreamBufferSpacesAvailable( pxStreamBuffer );
+    }
+
+    return prvReserveMessage( pxStreamBuffer, xDataLengthBytes, xSpace, pxSpans );
+}
+/*-----------------------------------------------------------*/
+
+size_t xStreamBufferSendReserveFromISR( StreamBufferHandle_t xStreamBuffer,
+                                        size_t xDataLengthBytes,
+                                        StreamBufferSpan_t pxSpans[ 2 ] )
+{
+    StreamBuffer_t * const pxStreamBuffer = xStreamBuffer;
+
+    configASSERT( pxSpans );
+    configASSERT( pxStreamBuffer );
+
+    return prvReserveMessage( pxStreamBuffer, xDataLengthBytes, xStreamBufferSpacesAvailable( pxStreamBuffer ), pxSpans );
+}
+/*-----------------------------------------------------------*/
+
+size_t xStreamBufferSendCommit( StreamBufferHandle_t xStreamBuffer,
+                                size_t xBytesWritten )
+{
+    StreamBuffer_t * const pxStreamBuffer = xStreamBuffer;
+    size_t xReturn;
+
+    configASSERT( pxStreamBuffer );
+
+    xReturn = prvCommitMessage( pxStreamBuffer, xBytesWritten );
+
+    if( xReturn > ( size_t ) 0 )
+    {
+        traceSTREAM_BUFFER_SEND( xStreamBuffer, xReturn );
+
+        if( prvBytesInBuffer( pxStreamBuffer ) >= pxStreamBuffer->xTriggerLevelBytes )
+        {
+            sbSEND_COMPLETED( pxStreamBuffer );
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+size_t xStreamBufferSendCommitFromISR( StreamBufferHandle_t xStreamBuffer,
+                                       size_t xBytesWritten,
+                                       BaseType_t * const pxHigherPriorityTaskWoken )
+{
+    StreamBuffer_t * const pxStreamBuffer = xStreamBuffer;
+    size_t xReturn;
+
+    configASSERT( pxStreamBuffer );
+
+    xReturn = prvCommitMessage( pxStreamBuffer, xBytesWritten );
+
+    if( xReturn > ( size_t ) 0 )
+    {
+        if( prvBytesInBuffer( pxStreamBuffer ) >= pxStreamBuffer->xTriggerLevelBytes )
+        {
+            sbSEND_COMPLETE_FROM_ISR( pxStreamBuffer, pxHigherPriorityTaskWoken );
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    traceSTREAM_BUFFER_SEND_FROM_ISR( xStreamBuffer, xReturn );
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+size_t xStreamBufferReceivePeek( StreamBufferHandle_t xStreamBuffer,
+                                 StreamBufferSpan_t pxSpans[ 2 ],
+                                 TickType_t xTicksToWait )
+{
+    StreamBuffer_t * const pxStreamBuffer = xStreamBuffer;
+    size_t xBytesAvailable, xBytesToStoreMessageLength;
+
+    configASSERT( pxSpans );
+    configASSERT( pxStreamBuffer );
+
+    if( ( pxStreamBuffer->ucFlags & sbFLAGS_IS_MESSAGE_BUFFER ) != ( uint8_t ) 0 )
+    {
+        xBytesToStoreMessageLength = sbBYTES_TO_STORE_MESSAGE_LENGTH;
+    }
+    else
+    {
+        xBytesToStoreMessageLength = 0;
+    }
+
+    if( xTicksToWait != ( TickType_t ) 0 )
+    {
+        xBytesAvailable = prvWaitForData( pxStreamBuffer, xBytesToStoreMessageLength, xTicksToWait );
+    }
+    else
+    {
+        xBytesAvailable = prvBytesInBuffer( pxStreamBuffer );
+    }
+
+    return prvPeekMessage( pxStreamBuffer, xBytesAvailable, pxSpans );
+}
+/*-----------------------------------------------------------*/
+
+size_t xStreamBufferReceivePeekFromISR( StreamBufferHandle_t xStreamBuffer,
+                                        StreamBufferSpan_t pxSpans[ 2 ] )
+{
+    StreamBuffer_t * const pxStreamBuffer = xStreamBuffer;
+
+    configASSERT( pxSpans );
+    configASSERT( pxStreamBuffer );
+
+    return prvPeekMessage( pxStreamBuffer, prvBytesInBuffer( pxStreamBuffer ), pxSpans );
+}
+/*-----------------------------------------------------------*/
+
+size_t xStreamBufferReceiveConsume( StreamBufferHandle_t xStreamBuffer,
+                                    size_t xBytesRead )
+{
+    StreamBuffer_t * const pxStreamBuffer = xStreamBuffer;
+    size_t xReceivedLength;
+
+    configASSERT( pxStreamBuffer );
+
+    xReceivedLength = prvConsumeMessage( pxStreamBuffer, xBytesRead, prvBytesInBuffer( pxStreamBuffer ) );
+
+    if( xReceivedLength != ( size_t ) 0 )
+    {
+        traceSTREAM_BUFFER_RECEIVE( xStreamBuffer, xReceivedLength );
+        sbRECEIVE_COMPLETED( pxStreamBuffer );
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    return xReceivedLength;
+}
+/*-----------------------------------------------------------*/
+
+size_t xStreamBufferReceiveConsumeFromISR( StreamBufferHandle_t xStreamBuffer,
+                                           size_t xBytesRead,
+                                           BaseType_t * const pxHigherPriorityTaskWoken )
+{
+    StreamBuffer_t * const pxStreamBuffer = xStreamBuffer;
+    size_t xReceivedLength;
+
+    configASSERT( pxStreamBuffer );
+
+    xReceivedLength = prvConsumeMessage( pxStreamBuffer, xBytesRead, prvBytesInBuffer( pxStreamBuffer ) );
+
+    if( xReceivedLength != ( size_t ) 0 )
+    {
+        sbRECEIVE_COMPLETED_FROM_ISR( pxStreamBuffer, pxHigherPriorityTaskWoken );
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    traceSTREAM_BUFFER_RECEIVE_FROM_ISR( xStreamBuffer, xReceivedLength );
+
+    return xReceivedLength;
+}
+/*-----------------------------------------------------------*/
+
+static void prvGetSpans( const StreamBuffer_t * const pxStreamBuffer,
+                         size_t xIndex,
+                         size_t xCount,
+                         StreamBufferSpan_t pxSpans[ 2 ] )
+{
+    size_t xFirstLength;
+
+    if( xIndex >= pxStreamBuffer->xLength )
+    {
+        xIndex -= pxStreamBuffer->xLength;
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    xFirstLength = configMIN( pxStreamBuffer->xLength - xIndex, xCount );
+
+    pxSpans[ 0 ].pucData = &( pxStreamBuffer->pucBuffer[ xIndex ] );
+    pxSpans[ 0 ].xLength = xFirstLength;
+    pxSpans[ 1 ].pucData = pxStreamBuffer->pucBuffer;
+    pxSpans[ 1 ].xLength = xCount - xFirstLength;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvWaitForSpace( StreamBuffer_t * const pxStreamBuffer,
+                               size_t xRequiredSpace,
+                               TickType_t xTicksToWait )
+{
+    size_t xSpace = 0;
+    TimeOut_t xTimeOut;
+
+    vTaskSetTimeOutState( &xTimeOut );
+
+    do
+    {
+        taskENTER_CRITICAL();
+        {
+            xSpace = xStreamBufferSpacesAvailable( pxStreamBuffer );
+
+            if( xSpace < xRequiredSpace )
+            {
+                ( void ) xTaskNotifyStateClear( NULL );
+
+                /* Should only be one writer. */
+                configASSERT( pxStreamBuffer->xTaskWaitingToSend == NULL );
+                pxStreamBuffer->xTaskWaitingToSend = xTaskGetCurrentTaskHandle();
+            }
+            else
+            {
+                taskEXIT_CRITICAL();
+                break;
+            }
+        }
+        taskEXIT_CRITICAL();
+
+        traceBLOCKING_ON_STREAM_BUFFER_SEND( pxStreamBuffer );
+        ( void ) xTaskNotifyWait( ( uint32_t ) 0, ( uint32_t ) 0, NULL, xTicksToWait );
+        pxStreamBuffer->xTaskWaitingToSend = NULL;
+        xSpace = xStreamBufferSpacesAvailable( pxStreamBuffer );
+    } while( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) == pdFALSE );
+
+    return xSpace;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvWaitForData( StreamBuffer_t * const pxStreamBuffer,
+                              size_t xBytesToStoreMessageLength,
+                              TickType_t xTicksToWait )
+{
+    size_t xBytesAvailable;
+
+    taskENTER_CRITICAL();
+    {
+        xBytesAvailable = prvBytesInBuffer( pxStreamBuffer );
+
+        if( xBytesAvailable <= xBytesToStoreMessageLength )
+        {
+            ( void ) xTaskNotifyStateClear( NULL );
+
+            /* Should only be one reader. */
+            configASSERT( pxStreamBuffer->xTaskWaitingToReceive == NULL );
+            pxStreamBuffer->xTaskWaitingToReceive = xTaskGetCurrentTaskHandle();
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if( xBytesAvailable <= xBytesToStoreMessageLength )
+    {
+        traceBLOCKING_ON_STREAM_BUFFER_RECEIVE( pxStreamBuffer );
+        ( void ) xTaskNotifyWait( ( uint32_t ) 0, ( uint32_t ) 0, NULL, xTicksToWait );
+        pxStreamBuffer->xTaskWaitingToReceive = NULL;
+
+        xBytesAvailable = prvBytesInBuffer( pxStreamBuffer );
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    return xBytesAvailable;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvReserveMessage( StreamBuffer_t * const pxStreamBuffer,
+                                 size_t xDataLengthBytes,
+                                 size_t xSpace,
+                                 StreamBufferSpan_t pxSpans[ 2 ] )
+{
+    size_t xOffset = 0;
+
+    if( ( pxStreamBuffer->ucFlags & sbFLAGS_IS_MESSAGE_BUFFER ) == ( uint8_t ) 0 )
+    {
+        xDataLengthBytes = configMIN( xDataLengthBytes, xSpace );
+    }
+    else if( xSpace >= ( xDataLengthBytes + sbBYTES_TO_STORE_MESSAGE_LENGTH ) )
+    {
+        /* The length is written by commit, hand out the storage after it. */
+        xOffset = sbBYTES_TO_STORE_MESSAGE_LENGTH;
+    }
+    else
+    {
+        xDataLengthBytes = 0;
+    }
+
+    prvGetSpans( pxStreamBuffer, pxStreamBuffer->xHead + xOffset, xDataLengthBytes, pxSpans );
+    pxStreamBuffer->xReserved = xDataLengthBytes;
+
+    return xDataLengthBytes;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvCommitMessage( StreamBuffer_t * const pxStreamBuffer,
+                                size_t xBytesWritten )
+{
+    size_t xNextHead, xTotal = xBytesWritten;
+    StreamBufferSpan_t xSpans[ 2 ];
+
+    /* Only bytes the writer was given can be published, and each reservation
+     * is committed once. */
+    configASSERT( xBytesWritten <= pxStreamBuffer->xReserved );
+    pxStreamBuffer->xReserved = 0;
+
+    if( xBytesWritten == ( size_t ) 0 )
+    {
+        /* Nothing was written, and an empty message is not a message. */
+        xTotal = 0;
+    }
+    else if( ( pxStreamBuffer->ucFlags & sbFLAGS_IS_MESSAGE_BUFFER ) != ( uint8_t ) 0 )
+    {
+        /* The length may straddle the end of the storage area. */
+        xTotal += sbBYTES_TO_STORE_MESSAGE_LENGTH;
+        prvGetSpans( pxStreamBuffer, pxStreamBuffer->xHead, sbBYTES_TO_STORE_MESSAGE_LENGTH, xSpans );
+        ( void ) memcpy( ( void * ) xSpans[ 0 ].pucData, ( const void * ) &xBytesWritten, xSpans[ 0 ].xLength );
+        ( void ) memcpy( ( void * ) xSpans[ 1 ].pucData, ( const void * ) &( ( ( const uint8_t * ) &xBytesWritten )[ xSpans[ 0 ].xLength ] ), xSpans[ 1 ].xLength );
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    /* The reader never takes space away, so a reservation still fits. */
+    configASSERT( xTotal <= xStreamBufferSpacesAvailable( pxStreamBuffer ) );
+
+    if( xTotal > ( size_t ) 0 )
+    {
+        xNextHead = pxStreamBuffer->xHead + xTotal;
+
+        if( xNextHead >= pxStreamBuffer->xLength )
+        {
+            xNextHead -= pxStreamBuffer->xLength;
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        /* The data written through the spans must be in memory before the
+         * reader can see the new head. */
+        portMEMORY_BARRIER();
+        pxStreamBuffer->xHead = xNextHead;
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    return xBytesWritten;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvPeekMessage( StreamBuffer_t * const pxStreamBuffer,
+                              size_t xBytesAvailable,
+                              StreamBufferSpan_t pxSpans[ 2 ] )
+{
+    size_t xOffset = 0;
+    size_t xOriginalTail;
+    configMESSAGE_BUFFER_LENGTH_TYPE xTempNextMessageLength;
+
+    if( ( pxStreamBuffer->ucFlags & sbFLAGS_IS_MESSAGE_BUFFER ) != ( uint8_t ) 0 )
+    {
+        if( xBytesAvailable > sbBYTES_TO_STORE_MESSAGE_LENGTH )
+        {
+            /* Read the length without removing it, as
+             * xStreamBufferNextMessageLengthBytes() does. */
+            xOriginalTail = pxStreamBuffer->xTail;
+            ( void ) prvReadBytesFromBuffer( pxStreamBuffer, ( uint8_t * ) &xTempNextMessageLength, sbBYTES_TO_STORE_MESSAGE_LENGTH, xBytesAvailable );
+            pxStreamBuffer->xTail = xOriginalTail;
+
+            xOffset = sbBYTES_TO_STORE_MESSAGE_LENGTH;
+            xBytesAvailable = ( size_t ) xTempNextMessageLength;
+        }
+        else
+        {
+            xBytesAvailable = 0;
+        }
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    prvGetSpans( pxStreamBuffer, pxStreamBuffer->xTail + xOffset, xBytesAvailable, pxSpans );
+
+    return xBytesAvailable;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvConsumeMessage( StreamBuffer_t * const pxStreamBuffer,
+                                 size_t xBytesRead,
+                                 size_t xBytesAvailable )
+{
+    size_t xNextTail, xTotal;
+    StreamBufferSpan_t xSpans[ 2 ];
+
+    if( ( pxStreamBuffer->ucFlags & sbFLAGS_IS_MESSAGE_BUFFER ) != ( uint8_t ) 0 )
+    {
+        /* Messages are discrete, the whole message is always removed. */
+        xBytesRead = prvPeekMessage( pxStreamBuffer, xBytesAvailable, xSpans );
+        xTotal = ( xBytesRead != ( size_t ) 0 ) ? ( xBytesRead + sbBYTES_TO_STORE_MESSAGE_LENGTH ) : ( size_t ) 0;
+    }
+    else
+    {
+        xBytesRead = configMIN( xBytesRead, xBytesAvailable );
+        xTotal = xBytesRead;
+    }
+
+    if( xTotal > ( size_t ) 0 )
+    {
+        xNextTail = pxStreamBuffer->xTail + xTotal;
+
+        if( xNextTail >= pxStreamBuffer->xLength )
+        {
+            xNextTail -= pxStreamBuffer->xLength;
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        /* The reader must be done with the storage before the writer can
+         * reuse it. */
+        portMEMORY_BARRIER();
+        pxStreamBuffer->xTail = xNextTail;
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    return xBytesRead;
+}
+/*-----------------------------------------------------------*/
+
 static size_t prvWriteBytesToBuffer( StreamBuffer_t * const pxStreamBuffer,
                                      const uint8_t * pucData,
                                      size_t xCount )
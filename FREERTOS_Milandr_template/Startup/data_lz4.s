@@ -0,0 +1,119 @@
+.syntax unified
+.cpu cortex-m3
+.fpu softvfp
+.thumb
+
+/******************************************************************************
+ * Compressed .data image (cmake -DDATA_COMPRESS=ON, cmake/data-compress.cmake).
+ *
+ * After the link tools/data_pack.py replaces the .data load image at _sidata
+ * with DATA_LZ4_MAGIC followed by one LZ4 block. CopyData below overrides the
+ * weak default of the startup and expands the block into _sdata.._edata.
+ * An image without the magic (the ELF was not packed) is copied verbatim.
+ *
+ * Literals and matches are moved by words where possible (unaligned LDR/STR
+ * are allowed after reset, CCR.UNALIGN_TRP = 0), offset 1 matches (runs of a
+ * byte, zero fill included) are stored as replicated words.
+ ******************************************************************************/
+
+.equ DATA_LZ4_MAGIC, 0x44345A4C   /* "LZ4D" */
+
+/**
+ * @brief  Expands the .data image: r0 - destination, r1 - end of destination,
+ *         r2 - source. Clobbers r0-r7, r12.
+*/
+  .section .text.CopyData,"ax",%progbits
+  .global CopyData
+  .type CopyData, %function
+CopyData:
+  ldr r3, [r2]
+  ldr r12, =DATA_LZ4_MAGIC
+  cmp r3, r12
+  bne CopySection
+  adds r2, r2, #4
+
+Sequence:
+  ldrb r3, [r2], #1           /* token: literal length << 4 | match length - 4 */
+  lsrs r4, r3, #4
+  cmp r4, #15
+  bne Literals
+LiteralLength:
+  ldrb r5, [r2], #1
+  adds r4, r4, r5
+  cmp r5, #255
+  beq LiteralLength
+
+Literals:
+  subs r4, r4, #4
+  blo LiteralTail
+LiteralWords:
+  ldr r5, [r2], #4
+  str r5, [r0], #4
+  subs r4, r4, #4
+  bhs LiteralWords
+LiteralTail:
+  adds r4, r4, #4
+  beq Match
+LiteralBytes:
+  ldrb r5, [r2], #1
+  strb r5, [r0], #1
+  subs r4, r4, #1
+  bne LiteralBytes
+
+Match:
+  cmp r0, r1                  /* the last sequence has literals only */
+  bhs CopyDataDone
+  ldrb r6, [r2], #1           /* offset, little endian, unaligned */
+  ldrb r7, [r2], #1
+  orr r6, r6, r7, lsl #8
+  subs r5, r0, r6             /* match source */
+  and r4, r3, #15
+  cmp r4, #15
+  bne MatchLength
+MatchLengthExt:
+  ldrb r7, [r2], #1
+  adds r4, r4, r7
+  cmp r7, #255
+  beq MatchLengthExt
+MatchLength:
+  adds r4, r4, #4
+  cmp r6, #1
+  beq Fill
+  cmp r6, #4
+  blo MatchBytes              /* overlaps by less than a word */
+
+  subs r4, r4, #4
+MatchWords:
+  ldr r7, [r5], #4
+  str r7, [r0], #4
+  subs r4, r4, #4
+  bhs MatchWords
+  adds r4, r4, #4
+  beq Sequence
+MatchBytes:
+  ldrb r7, [r5], #1
+  strb r7, [r0], #1
+  subs r4, r4, #1
+  bne MatchBytes
+  b Sequence
+
+Fill:
+  ldrb r7, [r5]
+  orr r7, r7, r7, lsl #8
+  orr r7, r7, r7, lsl #16
+  subs r4, r4, #4
+FillWords:
+  str r7, [r0], #4
+  subs r4, r4, #4
+  bhs FillWords
+  adds r4, r4, #4
+  beq Sequence
+FillBytes:
+  strb r7, [r0], #1
+  subs r4, r4, #1
+  bne FillBytes
+  b Sequence
+
+CopyDataDone:
+  bx lr
+.size CopyData, .-CopyData
@@ -95,47 +95,103 @@ __Vectors:
   .type Reset_Handler, %function
 Reset_Handler:
 
+/* Start the DWT cycle counter for boot stage timestamps (boot.c) */
+  ldr r0, =0xE000EDFC         /* CoreDebug->DEMCR */
+  ldr r1, [r0]
+  orr r1, r1, #0x01000000     /* TRCENA */
+  str r1, [r0]
+  ldr r0, =0xE0001000         /* DWT->CTRL */
+  movs r1, #0
+  str r1, [r0, #4]            /* DWT->CYCCNT */
+  ldr r1, [r0]
+  orr r1, r1, #1              /* CYCCNTENA */
+  str r1, [r0]
+
+/* Copy the RAM code (.ramfunc) from flash to SRAM */
+  ldr r0, =_sramfunc
+  ldr r1, =_eramfunc
+  ldr r2, =_siramfunc
+  bl CopySection
+
 /* Call the clock system initialization function.*/
     bl  SystemInit
 
-/* Copy the data segment initializers from flash to SRAM */
+/* Copy the data segment initializers from flash to SRAM
+   (expanded by CopyData from data_lz4.s with DATA_COMPRESS) */
   ldr r0, =_sdata
   ldr r1, =_edata
   ldr r2, =_sidata
-  movs r3, #0
-  b LoopCopyDataInit
-
-CopyDataInit:
-  ldr r4, [r2, r3]
-  str r4, [r0, r3]
-  adds r3, r3, #4
-
-LoopCopyDataInit:
-  adds r4, r0, r3
-  cmp r4, r1
-  bcc CopyDataInit
-  
-/* Zero fill the bss segment. */
-  ldr r2, =_sbss
-  ldr r4, =_ebss
-  movs r3, #0
-  b LoopFillZerobss
+  bl CopyData
 
-FillZerobss:
-  str  r3, [r2]
-  adds r2, r2, #4
+/* Zero fill the bss segment, 16 bytes per iteration */
+  ldr r0, =_sbss
+  ldr r1, =_ebss
+  movs r4, #0
+  movs r5, #0
+  movs r6, #0
+  movs r7, #0
+  subs r3, r1, r0
 
 LoopFillZerobss:
-  cmp r2, r4
-  bcc FillZerobss
+  cmp r3, #16
+  blo LoopFillZerobssTail
+  stmia r0!, {r4-r7}
+  subs r3, r3, #16
+  b LoopFillZerobss
+
+LoopFillZerobssTail:
+  cbz r3, FillZerobssDone
+  str r4, [r0], #4
+  subs r3, r3, #4
+  b LoopFillZerobssTail
+
+FillZerobssDone:
+  movs r0, #0                 /* BOOT_STAGE_MEMORY */
+  bl BOOT_Mark
 
 /* Call static constructors */
     bl __libc_init_array
+  movs r0, #1                 /* BOOT_STAGE_MAIN */
+  bl BOOT_Mark
 /* Call the application's entry point.*/
   bl main
   bx lr
 .size Reset_Handler, .-Reset_Handler
 
+/**
+ * @brief  Copies a word aligned section: r0 - destination, r1 - end of
+ *         destination, r2 - source. 16 bytes per iteration, then by words.
+ *         Clobbers r0-r7.
+*/
+  .section .text.CopySection,"ax",%progbits
+  .global CopySection
+  .type CopySection, %function
+CopySection:
+  subs r3, r1, r0
+
+LoopCopySection:
+  cmp r3, #16
+  blo LoopCopySectionTail
+  ldmia r2!, {r4-r7}
+  stmia r0!, {r4-r7}
+  subs r3, r3, #16
+  b LoopCopySection
+
+LoopCopySectionTail:
+  cbz r3, CopySectionDone
+  ldr r4, [r2], #4
+  str r4, [r0], #4
+  subs r3, r3, #4
+  b LoopCopySectionTail
+
+CopySectionDone:
+  bx lr
+.size CopySection, .-CopySection
+
+/* The .data image is a plain copy unless Startup/data_lz4.s is linked in */
+  .weak CopyData
+  .thumb_set CopyData, CopySection
+
 
 /*******************************************************************************
  * @brief  This is the code that gets called when the processor receives an
@@ -5,10 +5,16 @@
 #include "MDR32FxQI_rst_clk.h"
 #include "MDR32FxQI_bkp.h"
 #include "MDR32FxQI_eeprom.h"
+#include "MDR32FxQI_uart.h"
+#include "MDR32FxQI_inline.h" // быстрые inline-версии частых вызовов SPL
 #include "K1986VE9xI_IT.h"
 
+// Области ОЗУ из MDR32F9Q2I.ld, стартап их не обнуляет
+#define __DMA_RAM __attribute__((section(".dma")))    // буферы DMA, за таблицей каналов
+#define __NOINIT  __attribute__((section(".noinit"))) // переживает сброс без снятия питания
+
 // Сишные библиотеки
-// #include <stdio.h> // раскомментировать syscalls.c в Drivers/CmakeLists.txt
+// #include <stdio.h> // stdio через UART - console.h
 
 // Написанное мною
 #include "clk.h"
@@ -18,5 +24,17 @@
 #include "FreeRTOS.h"
 #include "task.h"
 
+#include "mpsc.h"
+#include "flash.h"
+#include "dfs.h"
+#include "boot.h"
+#include "dma.h"
+#include "log.h"
+#include "console.h"
+#include "heap.h"
+#include "uptime.h"
+#include "hrt.h"
+#include "pwmseq.h"
+
 
 #endif /*_APP_H_*/
\ No newline at end of file
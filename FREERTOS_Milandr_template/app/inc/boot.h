@@ -0,0 +1,34 @@
+#pragma once
+#include "app.h"
+
+// Отметки этапов загрузки по счетчику тактов DWT (запускается первой инструкцией Reset_Handler).
+// Время копится в мкс с учетом частоты: интервал до отметки считается на частоте предыдущей
+// отметки, поэтому отметку ставят сразу после смены частоты. Если у ядра нет CYCCNT, все по нулям.
+
+// Бюджет от сброса до первой задачи, проверяется configASSERT. Обе цифры - оценки с
+// запасом, а не замер на плате: с быстрым стартом - копирование .data/.bss и main на
+// HSI 8 МГц, без него еще запуск кварца (единицы мс, зависит от кварца). Отказ HSE
+// без быстрого старта в бюджет не укладывается (CLK_Init ждет CLK_HSE_ATTEMPTS опросов
+// SPL) - под отладчиком assert здесь и покажет неисправный кварц
+#ifndef BOOT_BUDGET_US
+#if CLK_FAST_BOOT
+#define BOOT_BUDGET_US 1000
+#else
+#define BOOT_BUDGET_US 20000
+#endif
+#endif
+
+typedef enum
+{
+    BOOT_STAGE_MEMORY,     // .ramfunc, .data и .bss готовы (startup)
+    BOOT_STAGE_MAIN,       // конструкторы отработали, вход в main (startup)
+    BOOT_STAGE_CLOCK,      // тактирование настроено или запущено в фоне
+    BOOT_STAGE_SCHEDULER,  // перед vTaskStartScheduler
+    BOOT_STAGE_FIRST_TASK, // первая прикладная задача получила управление
+    BOOT_STAGE_PLL,        // переход на CPU_PLL после быстрого старта на HSI
+    BOOT_STAGES
+} BOOT_Stage_t;
+
+// Повторная отметка этапа игнорируется. Из задачи или до планировщика, не из прерываний
+void BOOT_Mark(BOOT_Stage_t stage);
+uint32_t BOOT_GetTimeUs(BOOT_Stage_t stage); // от сброса, 0 - этап не пройден
@@ -1,11 +1,81 @@
 #pragma once
 #include "app.h"
 
-// на моей плате кварц стоит на 16мгц поэтому нужен такой костыль. если у вас 8 - закомментировать блок ниже.
-#ifdef HSE_Value 
+#ifndef CLK_ASSERT
+#define CLK_ASSERT(expr) configASSERT(expr)
+#endif
+#include "clk_config.h"
+
+// HSE_Value из MDR32FxQI_config.h - 8 МГц, кварц платы задается CLK_HSE_HZ в CMakeLists.txt
+#ifdef HSE_Value
 #undef HSE_Value
-#define HSE_Value ((uint32_t)16000000) 
+#define HSE_Value ((uint32_t)CLK_HSE_HZ)
+#endif
+
+#define CLK_MAX_HZ       80000000 // предел CPU_CLK и выхода CPU_PLL
+#define CLK_MAX_NOTIFIERS 8
+#define CLK_PLL_ATTEMPTS  16 // опросов RST_CLK_CPU_PLLstatus (у каждого свой таймаут SPL) до отказа
+#define CLK_HSE_ATTEMPTS  16 // то же для RST_CLK_HSEstatus в CLK_Init
+
+// Быстрый старт: main сразу работает от HSI 8 МГц, HSE и PLL запускаются в фоне,
+// на CLK_CPU_HZ переходит CLK_PollStartup
+#ifndef CLK_FAST_BOOT
+#define CLK_FAST_BOOT 1
 #endif
+#define CLK_STARTUP_TIMEOUT_MS 100 // на запуск HSE и захват PLL, дальше остаемся на HSI
+
+typedef enum
+{
+    CLK_PRE_CHANGE,  // частота еще старая: дописать передачу, остановить таймеры
+    CLK_SWITCH,      // частота уже новая, SystemCoreClock тоже: только регистры, без FreeRTOS
+    CLK_POST_CHANGE, // частота новая: пересчитать делители бодрейта и предделители таймеров
+} CLK_Event_t;
+
+// PRE и POST - из задачи, сменившей частоту, вне критической секции. SWITCH - из ее
+// критической секции сразу после переключения: счетчики, которым нельзя отставать
+// от частоты ни на такт (SysTick, предделители таймеров). Пока захватывается PLL, ядро
+// работает от HSE / div: SWITCH приходит и на нее, тогда их два, и между ними
+// (захват PLL, вне критической секции) идут прерывания и задачи. hz - частота,
+// на которой ядро оказалось (после отказа PLL в SWITCH и POST - HSE, а не запрошенная)
+typedef void (*CLK_Notifier_t)(CLK_Event_t event, uint32_t hz);
+
+typedef enum
+{
+    CLK_STARTUP_DONE,   // ядро на CLK_CPU_HZ
+    CLK_STARTUP_BUSY,   // ждем HSE или PLL
+    CLK_STARTUP_FAILED, // HSE или PLL не запустились за CLK_STARTUP_TIMEOUT_MS, ядро на HSI (или HSE)
+} CLK_Startup_t;
+
+// HSE, PLL, латентность и регулятор по CLK_Config, ждет запуска HSE и PLL не дольше
+// CLK_HSE_ATTEMPTS и CLK_PLL_ATTEMPTS опросов. ERROR - не дождался: ядро на HSI (нет HSE)
+// или на HSE (нет PLL), SystemCoreClock - ее, CLK_PollStartup вернет CLK_STARTUP_FAILED
+ErrorStatus CLK_Init(void);
+// Делители и разрешения тактирования UART/SSP/CAN/TIMER по CLK_Config
+void CLK_InitPeripherals(void);
+// UART_Init без RST_CLK_GetClocksFreq и деления: IBRD/FBRD из CLK_Config,
+// init->UART_BaudRate должен совпадать с CLK_UARTn_BAUD. Если ядро не на CLK_CPU_HZ
+// (быстрый старт на HSI, губернатор), делитель считается от SystemCoreClock
+void CLK_UARTInit(MDR_UART_TypeDef *UARTx, const UART_InitTypeDef *init);
+// Для нотификатора драйвера UART, передающего по DMA: PRE снимает запросы DMA
+// передатчика и ждет, пока уйдет FIFO (до 16 байт на старом бодрейте), POST ставит
+// делитель под новую HCLK и возвращает запросы. Канал DMA тем временем ждет
+void CLK_UARTRetune(MDR_UART_TypeDef *UARTx, CLK_Event_t event, uint32_t hz);
+
+// Быстрый старт: включает HSE и возвращается, не дожидаясь его. Ядро остается на HSI.
+// Дальше CLK_PollStartup из задачи - раз в тик, пока не вернет не CLK_STARTUP_BUSY
+void CLK_StartAsync(void);
+CLK_Startup_t CLK_PollStartup(void);
 
+// Смена частоты CPU на ходу: HSE * mul / div, mul = 1 (PLL выключен) или 4..16, div = 2^n.
+// Латентность FLASH, режим регулятора и перезагрузка SysTick меняются вместе с частотой,
+// фаза текущего тика теряется (время uptime.h остается непрерывным).
+// Только из задачи и только из одной (губернатор dfs.c): захват PLL она ждет вне
+// критической секции, ядро в это время на HSE / div. ERROR - частота не собирается
+// из HSE или HSE еще не запущен (ядро там же), или PLL не захватился за
+// CLK_PLL_ATTEMPTS (ядро на HSE, SystemCoreClock - ее).
+ErrorStatus CLK_SetFrequency(uint32_t hz);
+// До запуска планировщика (драйверы - в своем Init). Зовутся в порядке регистрации
+void CLK_AddNotifier(CLK_Notifier_t notifier);
 
-void CLK_Init_80_mhz(void);
\ No newline at end of file
+// Младшие 32 бита UPTIME_GetUs. Счетчик run-time stats FreeRTOS
+uint32_t CLK_GetTimeUs(void);
@@ -0,0 +1,55 @@
+#pragma once
+#include "app.h"
+
+// stdio newlib (printf, puts, getchar...) через UART CONSOLE_UART.
+//
+// Вывод: _write кладет байты в кольцо, кольцо уходит в UART каналом DMA в фоне.
+// Задача при полном кольце ждет (уведомление CONSOLE_NOTIFY_INDEX), прерывание
+// и код при остановленном планировщике не ждут никогда - не влезло, отброшено
+// (CONSOLE_GetDropped). Прерывание процессора - одно на порцию до 1024 байт.
+// Ввод: прерывание приема UART в кольцо CONSOLE_RX_SIZE, _read ждет хотя бы байт.
+//
+// Блокировки newlib (__retarget_lock_*): FILE - рекурсивные мьютексы FreeRTOS,
+// внутренние (malloc, sinit, env...) - остановка планировщика.
+// configUSE_NEWLIB_REENTRANT не нужен: собственный _reent (~1 КиБ: errno, strtok,
+// буфер stdout) только у задач, вызвавших CONSOLE_AttachTask, остальные делят общий.
+// Из прерываний printf допустим только аварийно (FILE без блокировки) - для
+// прерываний есть журнал log.h.
+//
+// Модель test/test_console.c (оценки тактов, не замер; без форматирования vfprintf):
+// поток держит линию UART без пауз (115200 - 11.5 КБ/с), _write и прерывание DMA - ~10
+// тактов на байт строками по 64 против ожидания каждого байта в линии у побайтной
+// передачи (694 такта на 8 МГц, 6944 на 80 МГц при 115200). Прерывание под BASEPRI
+// ждет критическую секцию копирования (CONSOLE_CHUNK байт) или прерывание DMA: до ~180
+// тактов, 2.3 мкс на 80 МГц и 22 мкс на 8 МГц.
+
+#ifndef CONSOLE_UART
+#define CONSOLE_UART 2 // 1 - MDR_UART1, 2 - MDR_UART2
+#endif
+
+#ifndef CONSOLE_TX_SIZE
+#define CONSOLE_TX_SIZE 512 // степень двойки
+#endif
+#ifndef CONSOLE_RX_SIZE
+#define CONSOLE_RX_SIZE 64 // степень двойки
+#endif
+#ifndef CONSOLE_LINE_SIZE
+#define CONSOLE_LINE_SIZE 80 // буфер stdout задачи, сброс по '\n' или заполнению
+#endif
+
+#ifndef CONSOLE_IRQ_PRIORITY
+#define CONSOLE_IRQ_PRIORITY configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY
+#endif
+
+// Ячейка уведомлений задачи (0 - MPSC, 1 - FLASH, 2 - DMAM)
+#define CONSOLE_NOTIFY_INDEX 3
+
+// UART уже настроен (CLK_UARTInit, выводы). До планировщика, после DMAM_Init
+void CONSOLE_Init(void);
+
+// Из задачи: свой _reent и буфер stdout. До первого вызова stdio в задаче.
+// Перед vTaskDelete задачи - CONSOLE_DetachTask из нее самой
+void CONSOLE_AttachTask(void);
+void CONSOLE_DetachTask(void);
+
+uint32_t CONSOLE_GetDropped(void); // байт отброшено без ожидания
@@ -0,0 +1,36 @@
+#pragma once
+#include "app.h"
+
+// Губернатор частоты CPU по загрузке. Раз в DFS_PERIOD_MS считает долю времени вне idle
+// (run-time stats FreeRTOS на CLK_GetTimeUs) и выбирает из DFS_LEVELS наименьшую частоту,
+// на которой загрузка не превысит DFS_TARGET_LOAD. Скачок загрузки выше DFS_UP_LOAD
+// сразу поднимает частоту до максимума.
+// Драйверы, чьи сроки держатся только на частоте не ниже заданной (HRT, PWMSEQ), держат
+// нижнюю границу: пока держит хоть один, губернатор ниже нее не опускается, а если ядро
+// уже ниже - поднимает частоту сразу, не дожидаясь конца периода.
+
+#ifndef DFS_LEVELS
+#define DFS_LEVELS 8000000, 16000000, 40000000, 80000000 // по возрастанию, собираются из HSE 16 МГц
+#endif
+#define DFS_PERIOD_MS   100
+#define DFS_TARGET_LOAD 70 // %
+#define DFS_UP_LOAD     90 // %
+// Стек губернатора без статического анализа, слов. CLK_SetFrequency зовет нотификаторы
+// драйверов из этой задачи, минимального стека им мало
+#ifndef DFS_STACK_SIZE
+#define DFS_STACK_SIZE (configMINIMAL_STACK_SIZE * 2)
+#endif
+
+// Ячейка уведомлений задачи губернатора: поднята нижняя граница
+#define DFS_NOTIFY_INDEX 6
+
+void DFS_Start(UBaseType_t priority);
+uint32_t DFS_GetLoad(void); // загрузка за последний период, %
+
+// Из задачи или прерывания не выше configMAX_SYSCALL_INTERRUPT_PRIORITY, в том числе под
+// маской BASEPRI. hz округляется вверх до уровня DFS_LEVELS. Из задачи младше губернатора
+// возвращается уже на нужной частоте, если ядро на PLL (после быстрого старта - не раньше,
+// чем губернатор дождется PLL). Release частоту не снижает: это решит следующий период
+void DFS_Hold(uint32_t hz);
+void DFS_Release(uint32_t hz);
+uint32_t DFS_GetFloor(void); // нижняя граница сейчас, без удержаний - нижний уровень
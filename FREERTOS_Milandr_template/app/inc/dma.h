@@ -0,0 +1,79 @@
+#pragma once
+#include "app.h"
+#include "MDR32FxQI_dma.h"
+
+// Менеджер каналов DMA. Таблица управляющих структур (32 основные + альтернативные) одна
+// на контроллер и объявлена здесь под именем DMA_ControlTable - для GCC в SPL ее нет,
+// так что драйверы на DMA_Init из SPL работают с той же таблицей.
+// Канал занимается DMAM_Alloc: конкретный (запросы периферии) или любой свободный
+// программный (DMA_Channel_SW1..SW19). Флагов "канал завершил цикл" у контроллера нет,
+// общее прерывание DMA_IRQHandler опрашивает запущенные каналы:
+//  - basic/auto-request - цикл закончен, когда контроллер снял разрешение канала;
+//  - ping-pong - основная или альтернативная структура перешла в Stop. Обработчик канала
+//    обязан перезарядить ее (или DMAM_Stop), иначе будет вызываться на каждом прерывании DMA;
+//  - ошибка шины (ERR_CLR) - канал выключен посреди цикла. Обработчик вызывается, как на
+//    завершение, DMAM_Failed отличает одно от другого.
+//
+// DMAM_Memcpy/DMAM_Memset - копирование и заполнение ОЗУ каналом с программным запросом.
+// Вызов только запускает передачу, процессор свободен до DMAM_Wait (уведомление задаче).
+// FLASH контроллеру DMA недоступна, такие адреса (и короткие блоки) копирует процессор.
+
+#define DMAM_ANY (-1) // DMAM_Alloc: любой свободный программный канал
+
+// Ячейка уведомлений задачи для DMAM_Wait (0 - MPSC_Wait, 1 - FLASH_Wait)
+#define DMAM_NOTIFY_INDEX 2
+
+// Приоритет DMA_IRQHandler, обработчики каналов могут звать FromISR API
+#ifndef DMAM_IRQ_PRIORITY
+#define DMAM_IRQ_PRIORITY configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY
+#endif
+
+// Пороги DMAM_Memcpy и DMAM_Memset в байтах, короче - копирует процессор. Точка
+// безубыточности по тактам процессора из test/test_dma.c: запуск, прерывания порций,
+// засыпание и пробуждение ждущей задачи (оценки MODEL_*_CYCLES) против memcpy/memset
+// из cm3_string.S (модель тактов lib/test). Не замер: уточняется по DWT->CYCCNT
+#ifndef DMAM_MIN_SIZE
+#define DMAM_MIN_SIZE 896
+#endif
+#ifndef DMAM_MIN_FILL
+#define DMAM_MIN_FILL 1408
+#endif
+
+// Передач до переарбитража: память-память не должна надолго занимать контроллер
+// перед каналами периферии
+#ifndef DMAM_ARBITRATION
+#define DMAM_ARBITRATION DMA_Transfers_16
+#endif
+
+// Из прерывания DMA. pdTRUE - разбужена более приоритетная задача
+typedef BaseType_t (*DMAM_Callback_t)(uint32_t channel, void *arg);
+
+typedef struct
+{
+    uint8_t *dst;
+    const uint8_t *src;      // NULL - заполнение pattern
+    uint32_t left;           // байт, включая текущую порцию
+    uint32_t chunk;          // байт в текущей порции
+    uint32_t pattern;        // байт заполнения, размноженный на слово
+    uint32_t unit;           // 1, 2 или 4 байта за передачу
+    int32_t channel;         // -1 - скопировал процессор
+    TaskHandle_t waiter;
+    volatile BaseType_t busy;
+    volatile BaseType_t error; // ошибка шины или таймаут DMAM_Wait: dst дописан не весь
+} DMAM_Job_t;
+
+void DMAM_Init(void);
+int32_t DMAM_Alloc(int32_t channel, DMAM_Callback_t callback, void *arg); // номер канала или -1
+void DMAM_Free(uint32_t channel);
+DMA_CtrlDataTypeDef *DMAM_Control(uint32_t channel, DMA_Data_Struct_Selection select);
+void DMAM_Start(uint32_t channel); // структуры заполнены: разрешить канал и запросы периферии
+void DMAM_Stop(uint32_t channel);
+BaseType_t DMAM_Failed(uint32_t channel); // из обработчика канала: цикл прерван ошибкой шины
+
+// Из задачи. job живет до конца передачи, буферы не трогать до DMAM_Wait
+void DMAM_Memcpy(DMAM_Job_t *job, void *dst, const void *src, uint32_t size);
+void DMAM_Memset(DMAM_Job_t *job, void *dst, uint8_t value, uint32_t size);
+// Ждет задача, запустившая job. pdFALSE - ошибка шины или время вышло; по таймауту канал
+// остановлен и освобожден. Разрешение канала контроллер смотрит при арбитраже (TRM PL230):
+// начатую пачку до DMAM_ARBITRATION передач он дописывает, следующей уже не будет
+BaseType_t DMAM_Wait(DMAM_Job_t *job, TickType_t ticks);
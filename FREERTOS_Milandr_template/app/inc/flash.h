@@ -0,0 +1,47 @@
+#pragma once
+#include "app.h"
+
+// Запись во FLASH (основной банк EEPROM) без остановки системы на миллисекунды.
+// Стирание и программирование режутся на кванты: один сектор страницы при стирании,
+// до FLASH_SLICE_WORDS слов при записи. Пока идет квант, FLASH недоступна для чтения, поэтому:
+//  - прерывания с приоритетом FLASH_CRITICAL_PRIORITY и ниже маскируются через BASEPRI
+//    и ждут конца кванта, их задержка не больше FLASH_MAX_LATENCY_US;
+//  - более срочные прерывания обслуживаются как обычно. Таблица векторов на время кванта
+//    переключается на копию в ОЗУ, а их обработчики (и все, что они вызывают и читают,
+//    включая константы) должны лежать в ОЗУ: __RAMFUNC или ramfunc.txt. Проверяется
+//    configASSERT при запуске операции.
+// Кванты выполняет FLASH_Process - из idle hook (в простое) или из задачи с бюджетом времени.
+// Тики FreeRTOS, пропущенные за время стирания, досчитываются xTaskCatchUpTicks.
+
+// Прерывания с численно меньшим приоритетом работают во время записи из ОЗУ
+#ifndef FLASH_CRITICAL_PRIORITY
+#define FLASH_CRITICAL_PRIORITY configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY
+#endif
+
+// Слов за один квант записи, ~55 мкс на слово
+#ifndef FLASH_SLICE_WORDS
+#define FLASH_SLICE_WORDS 8
+#endif
+
+// Ячейка уведомлений задачи для FLASH_Wait, нулевая занята MPSC_Wait и прочими
+#define FLASH_NOTIFY_INDEX 1
+
+#define FLASH_PAGE_SIZE  4096
+#define FLASH_BANK_SIZE  (128 * 1024)
+
+// Длительность квантов в мкс (по таймингам SPL с запасом 25%)
+#define FLASH_ERASE_SLICE_US (EEPROM_TNVS_US + EEPROM_TERASE_US + EEPROM_TNVH_US + EEPROM_TRCV_US)
+#define FLASH_WORD_US        (EEPROM_TNVS_US + EEPROM_TPGS_US + EEPROM_TPROG_US + EEPROM_TNVH_US + EEPROM_TRCV_US)
+
+// Гарантированная задержка маскированных прерываний: последний сектор страницы
+// стирается вместе с ожиданием снятия высокого напряжения (THV), как в EEPROM_ErasePage.
+// 0.1% сверху: задержки SPL длиннее заказанных (делитель 1000000 / 1024 округлен вниз),
+// плюс код между ними
+#define FLASH_MAX_LATENCY_US ((FLASH_ERASE_SLICE_US + EEPROM_THV_US) * 1001 / 1000)
+
+void FLASH_Init(void);
+ErrorStatus FLASH_Erase(uint32_t address, uint32_t pages);                 // address кратен FLASH_PAGE_SIZE
+ErrorStatus FLASH_Write(uint32_t address, const uint32_t *data, uint32_t words); // data живет до конца записи
+BaseType_t FLASH_Process(uint32_t budgetUs); // минимум один квант; pdTRUE - работа еще осталась
+BaseType_t FLASH_IsBusy(void);
+BaseType_t FLASH_Wait(TickType_t ticks);     // из задачи, ждать может только одна
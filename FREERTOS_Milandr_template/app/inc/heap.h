@@ -0,0 +1,65 @@
+#pragma once
+#include "app.h"
+
+// Единая куча. malloc/free/realloc newlib и pvPortMalloc/vPortFree FreeRTOS - один
+// распределитель (malloc newlib) на все свободное ОЗУ: от конца .bss (_sheap) до
+// области .noinit (_eheap), границы считает MDR32F9Q2I.ld. Статического
+// массива configTOTAL_HEAP_SIZE (heap_4) больше нет, память задач и printf одна.
+//
+// Потокобезопасность: __malloc_lock - остановка планировщика, как в heap_4. Прерывания
+// не запрещаются, поэтому из обработчиков прерываний malloc и pvPortMalloc не вызывать.
+
+#ifndef HEAP_BENCHMARK
+#define HEAP_BENCHMARK 0 // 1 - HEAP_Benchmark
+#endif
+
+size_t HEAP_GetFree(void);      // свободно всего: списки malloc и не отданное _sbrk
+size_t HEAP_GetUntouched(void); // ни разу не отданное _sbrk - запас на худший случай
+
+// Такты pvPortMalloc/vPortFree по DWT->CYCCNT, результат - в журнал. Цифр пока нет: ни
+// тактов HEAP_Benchmark, ни размеров из --print-memory-usage до и после отказа от heap_4
+// (ARM-тулчейна и платы не было). Ожидаемое - минус ucHeap (10240 байт) из .bss, без замера
+void HEAP_Benchmark(void);
+
+// Профилировщик (HEAP_PROFILE в FreeRTOSConfig.h). Каждый pvPortMalloc записывается
+// в таблицу сбоку от кучи (указатель, размер, тег, тик выделения - 12 байт на блок),
+// vPortFree вычеркивает. По тегам - живые байты и блоки, пик, число выделений;
+// гистограммы размеров и времени жизни освобожденных блоков (степени двойки).
+// Тег - подсистема: тег задачи (HEAP_SetTaskTag), у кода до планировщика - HEAP_TAG_BOOT.
+// Выделения задачи, в том числе внутри xTaskCreate/xQueueCreate, идут на ее тег.
+// Запись - пара десятков тактов под уже взятой остановкой планировщика. При 0
+// ни кода, ни таблицы: pvPortMalloc - прямой вызов malloc.
+// malloc напрямую (буферы stdio newlib) не учитывается - только pvPortMalloc.
+
+#ifndef HEAP_PROFILE_SLOTS
+#define HEAP_PROFILE_SLOTS 64 // живых блоков в таблице, степень двойки
+#endif
+#ifndef HEAP_TAGS
+#define HEAP_TAGS 8
+#endif
+#define HEAP_HIST_BUCKETS 16 // корзина k: до 2^k байт (тиков), последняя - и больше
+
+#define HEAP_TAG_BOOT 0 // до планировщика и задачи без тега
+
+typedef struct
+{
+    uint32_t live;   // байт выделено сейчас
+    uint32_t blocks; // блоков сейчас
+    uint32_t peak;   // максимум live
+    uint32_t allocs; // выделений всего
+    uint32_t mark;   // live на HEAP_ProfileCheckpoint
+} HEAP_TagStats_t;
+
+#if HEAP_PROFILE
+void HEAP_SetTaskTag(TaskHandle_t task, uint32_t tag); // NULL - вызывающая задача
+void HEAP_ProfileCheckpoint(void); // запомнить live по тегам
+uint32_t HEAP_ProfileLeaks(void);  // маска тегов, у которых live вырос с контрольной точки
+const HEAP_TagStats_t *HEAP_GetTagStats(uint32_t tag);
+uint32_t HEAP_GetUntracked(void);  // выделений мимо полной таблицы
+void HEAP_ProfileReport(void);     // теги, гистограммы и старейший живой блок - в журнал
+#else
+#define HEAP_SetTaskTag(task, tag) ((void)(task), (void)(tag))
+#define HEAP_ProfileCheckpoint()   ((void)0)
+#define HEAP_ProfileLeaks()        (0UL)
+#define HEAP_ProfileReport()       ((void)0)
+#endif
@@ -0,0 +1,107 @@
+#pragma once
+#include "app.h"
+#include "MDR32FxQI_timer.h"
+
+// Таймеры с разрешением 1 мкс: однократные и периодические сроки, сколько угодно,
+// на каналах сравнения одного свободно бегущего 16-битного таймера (HRT_TIMER).
+// CNT считает мкс, переполнения достраивают время до 32 бит (HRT_GetTime).
+// У каждого канала свой список таймеров по возрастанию срока, в CCR - младшие 16 бит
+// срока первого. Новый таймер идет в самый короткий список: вставка дешевле вчетверо.
+// Срок дальше 65 мс канал проверяет на каждом круге CNT, пока тот не подойдет.
+// По сроку прерывание вызывает обработчик таймера или будит задачу (HRT_SleepUntil) -
+// без опроса и без привязки к тику FreeRTOS. DELAY_WaitUs из SPL ждет в цикле,
+// для задач ожидание - HRT_Sleep.
+// Частота счета держится при смене частоты ядра: PSG меняет нотификатор CLK_SWITCH.
+// Опоздание - вход в прерывание и разбор совпавших сроков, порядка сотни тактов на таймер:
+// единицы мкс на 40-80 МГц, на 8 МГц (нижний уровень DFS) - десятки. Поэтому, пока взведен
+// хоть один таймер, HRT держит частоту не ниже HRT_DFS_HZ (DFS_Hold). Первый таймер,
+// взведенный на меньшей частоте, может опоздать на время подъема частоты.
+// Модель test/test_hrt.c (такты - оценки по TRM, не замер на кристалле), опоздание вызова
+// обработчика от срока: 80 МГц - 0..1 мкс у одного таймера, до 5 мкс у 32 (98% - 0..1);
+// 40 МГц - 1..5 мкс; 8 МГц без удержания - 5..29 мкс. HRT_Arm - около 60 тактов, до 120
+// на длинном списке; прерывание - около 140 тактов на срабатывание; задача из
+// HRT_SleepUntil на 80 МГц - через 3..5 мкс
+// Списки меняются под BASEPRI (configMAX_SYSCALL_INTERRUPT_PRIORITY): прерывания старше
+// не задерживаются и на ожидании близкого срока.
+
+#ifndef HRT_TIMER
+#define HRT_TIMER 2 // 1..3, в clk_config.h CLK_TIMERn_HZ этого таймера - 0
+#endif
+#define HRT_HZ       1000000 // счет CNT; частота ядра не кратна - ближайший делитель, см. HRT_Prescaler
+#define HRT_CHANNELS 4
+#define HRT_GUARD_US 2       // срок ближе - в CCR не ставится, обработчик ждет его на месте
+
+#ifndef HRT_DFS_HZ
+#define HRT_DFS_HZ 40000000  // опоздание до 10 мкс; 0 - частоту не держать
+#endif
+
+// Обработчики таймеров зовут FromISR API
+#ifndef HRT_IRQ_PRIORITY
+#define HRT_IRQ_PRIORITY configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY
+#endif
+
+// Ячейка уведомлений задачи для HRT_SleepUntil
+#define HRT_NOTIFY_INDEX 4
+
+#ifndef HRT_BENCHMARK
+#define HRT_BENCHMARK 0 // 1 - HRT_GetStats и HRT_Benchmark
+#endif
+
+typedef struct HRT_Timer HRT_Timer_t;
+
+// Из прерывания HRT_TIMER. Периодический таймер к вызову уже перевзведен, однократный
+// снят - из обработчика можно взвести или снять любой таймер. pdTRUE - разбужена задача
+typedef BaseType_t (*HRT_Callback_t)(HRT_Timer_t *t, void *arg);
+
+#define HRT_IDLE 0xFF // HRT_Timer_t.channel: не взведен
+
+struct HRT_Timer
+{
+    HRT_Timer_t *next;
+    HRT_Callback_t callback;
+    void *arg;
+    uint32_t deadline;  // по HRT_GetTime
+    uint32_t period;    // мкс, 0 - однократный
+    uint32_t missed;    // периодов пропущено: обработчик опоздал больше чем на период
+    volatile uint8_t channel;
+};
+
+// После CLK_InitPeripherals: таймер, его тактирование и прерывание
+void HRT_Init(void);
+// Мкс по счету таймера, переполнение через 71 минуту. Из любого контекста
+uint32_t HRT_GetTime(void);
+
+void HRT_TimerInit(HRT_Timer_t *t, HRT_Callback_t callback, void *arg);
+// Срок - момент HRT_GetTime, не дальше 2^31 мкс; прошедший - сработает сразу.
+// Взведенный таймер перезапускается. Из задачи или прерывания не выше
+// configMAX_SYSCALL_INTERRUPT_PRIORITY
+void HRT_Arm(HRT_Timer_t *t, uint32_t deadline, uint32_t period);
+void HRT_Start(HRT_Timer_t *t, uint32_t us, uint32_t period); // через us от текущего момента
+void HRT_Cancel(HRT_Timer_t *t);
+
+// Из задачи: спит до срока. Проснется, как только планировщик отдаст ей ядро -
+// опоздание определяют задачи старше нее, а не тик
+void HRT_SleepUntil(uint32_t deadline);
+void HRT_Sleep(uint32_t us);
+
+#if HRT_BENCHMARK
+#define HRT_HIST_BINS 16 // по 1 мкс, последний - HRT_HIST_BINS - 1 и больше
+
+typedef struct
+{
+    uint32_t isrLate[HRT_HIST_BINS];  // опоздание вызова обработчика от срока, мкс
+    uint32_t taskLate[HRT_HIST_BINS]; // опоздание возврата из HRT_SleepUntil
+    uint32_t fired;
+    uint32_t arms;                    // вызовов HRT_Arm
+    uint64_t armCycles;               // в HRT_Arm: снятие, выбор канала, вставка
+    uint64_t isrCycles;               // в прерывании, включая обработчики
+    uint32_t maxLength;               // самый длинный список канала
+    uint32_t armAvgCycles;            // считает HRT_GetStats
+    uint32_t fireAvgCycles;           // прерывания на одно срабатывание
+} HRT_Stats_t;
+
+const HRT_Stats_t *HRT_GetStats(void);
+// Из задачи: timers периодических таймеров (до 32) с разными периодами 100..1000 мкс,
+// сама задача ms миллисекунд спит по HRT_SleepUntil с шагом 1 мс. Статистика с нуля
+const HRT_Stats_t *HRT_Benchmark(uint32_t timers, uint32_t ms);
+#endif
@@ -0,0 +1,151 @@
+#pragma once
+#include "app.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Журнал без форматирования на МК. LOG("fmt", ...) пишет в кольцо ОЗУ запись из слов:
+//   заголовок - 0xA в старшей тетраде, число аргументов, ID строки формата;
+//   DWT->CYCCNT;
+//   аргументы по слову.
+// Строка формата (с файлом и строкой исходника) лежит в секции .log_fmt, которая
+// не загружается в МК (INFO в MDR32F9Q2I.ld), ID - ее смещение в секции. Текст собирает
+// tools/log_decode.py по ELF прошивки.
+//
+// Запись из задач и прерываний любого приоритета, под PRIMASK на время копирования слов:
+// ~30 тактов на 2 аргумента - оценка по таблице TRM Cortex-M3 (вызов, PRIMASK, 4 слова
+// в кольцо), не замер. Такты snprintf newlib и LOG на кристалле дает LOG_Benchmark,
+// замеров пока нет. В UART запись - 8 + 4 * n байт независимо от текста: на смеси
+// сообщений test/test_log.c 22.2 байта против 17.2 у того же текста через printf - выигрыш
+// в тактах, а не в линии, если сообщения короче ~20 символов.
+// Кольцо полно - запись теряется, число потерянных уйдет отдельной записью.
+// Кольцо отправляется в UART каналом DMA (LOG_Init), дозапуск - из тика FreeRTOS.
+// Кольцо лежит в .noinit и переживает сброс: неотправленное до сброса уходит после.
+// CYCCNT считает такты HCLK, а частоту меняет DFS: LOG_Init и каждая смена частоты
+// (CLK_SWITCH) пишут запись LOG_ID_CLOCK с новой частотой, по ним декодер переводит
+// такты во время по участкам. До первой такой записи частота - --hz декодера.
+// Сразу после перепрошивки такие записи относятся к прежнему ELF.
+//
+// Аргументы - только 32-битные: целые, указатели, float/double (передается float).
+// %s - только строки во FLASH (константы), их декодер читает из ELF. 64-битные целые
+// обрезаются. Формат и аргументы проверяет -Wformat как у printf.
+
+#ifndef LOG_ENABLE
+#define LOG_ENABLE 1
+#endif
+
+#ifndef LOG_RING_WORDS
+#define LOG_RING_WORDS 512 // степень двойки
+#endif
+
+#ifndef LOG_BENCHMARK
+#define LOG_BENCHMARK 0 // 1 - LOG_Benchmark, тянет snprintf из newlib
+#endif
+
+#define LOG_SYNC       0xA0000000UL
+#define LOG_ID_DROPPED 0xFFFFFFUL // аргумент - число потерянных записей
+#define LOG_ID_CLOCK   0xFFFFFEUL // аргумент - частота CYCCNT, Гц, с метки этой записи
+#define LOG_MAX_ARGS   8
+
+// UARTx уже настроен (CLK_UARTInit, выводы). Без LOG_Init записи копятся в кольце
+void LOG_Init(MDR_UART_TypeDef *UARTx);
+void LOG_Kick(void); // из vApplicationTickHook: запустить DMA, если есть что слать
+
+void LOG_Write0(uint32_t header);
+void LOG_Write1(uint32_t header, uint32_t a);
+void LOG_Write2(uint32_t header, uint32_t a, uint32_t b);
+void LOG_Write3(uint32_t header, uint32_t a, uint32_t b, uint32_t c);
+void LOG_WriteN(uint32_t header, const uint32_t *args);
+
+void LOG_Benchmark(void); // замер LOG и snprintf по DWT->CYCCNT, результат - в журнал
+
+static inline __attribute__((format(printf, 1, 2))) void LOG_FormatCheck(const char *fmt, ...)
+{
+    (void)fmt;
+}
+
+static inline uint32_t LOG_FloatBits(float value)
+{
+    union
+    {
+        float f;
+        uint32_t u;
+    } bits = {value};
+    return bits.u;
+}
+
+#ifdef __cplusplus
+}
+
+inline uint32_t LOG_Arg(float value) { return LOG_FloatBits(value); }
+inline uint32_t LOG_Arg(double value) { return LOG_FloatBits((float)value); }
+template <typename T>
+inline uint32_t LOG_Arg(T value) { return (uint32_t)value; }
+#define LOG_ARG(x) LOG_Arg(x)
+#else
+// Вложенный _Generic - невыбранные ветки тоже должны компилироваться для любого типа x
+#define LOG_ARG(x) _Generic((x),                                                   \
+    float: LOG_FloatBits(_Generic((x), float: (x), default: 0.0f)),               \
+    double: LOG_FloatBits((float)_Generic((x), double: (x), default: 0.0)),       \
+    default: (uint32_t)(x))
+#endif
+
+#define LOG_STR_(x) #x
+#define LOG_STR(x) LOG_STR_(x)
+#define LOG_CAT_(a, b) a##b
+#define LOG_CAT(a, b) LOG_CAT_(a, b)
+// Формат идет первым аргументом - пустого __VA_ARGS__ не бывает (C11 и C++ без расширений)
+#define LOG_FORMAT_(fmt, ...) fmt
+#define LOG_FORMAT(...) LOG_FORMAT_(__VA_ARGS__, 0)
+#define LOG_NARGS_(fmt, _1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+#define LOG_NARGS(...) LOG_NARGS_(__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0, 0)
+
+// Адрес в секции .log_fmt плюс константа - одна загрузка из пула литералов
+#define LOG_HEADER(fmt, n) ((uint32_t)(fmt) + (LOG_SYNC | ((uint32_t)(n) << 24)))
+
+#define LOG_PUT_0(h, fmt) LOG_Write0(h)
+#define LOG_PUT_1(h, fmt, a) LOG_Write1(h, LOG_ARG(a))
+#define LOG_PUT_2(h, fmt, a, b) LOG_Write2(h, LOG_ARG(a), LOG_ARG(b))
+#define LOG_PUT_3(h, fmt, a, b, c) LOG_Write3(h, LOG_ARG(a), LOG_ARG(b), LOG_ARG(c))
+#define LOG_PUT_ARRAY(h, ...)                          \
+    do                                                 \
+    {                                                  \
+        const uint32_t logArgs_[] = {__VA_ARGS__};     \
+        LOG_WriteN(h, logArgs_);                       \
+    } while (0)
+#define LOG_PUT_4(h, fmt, a, b, c, d) \
+    LOG_PUT_ARRAY(h, LOG_ARG(a), LOG_ARG(b), LOG_ARG(c), LOG_ARG(d))
+#define LOG_PUT_5(h, fmt, a, b, c, d, e) \
+    LOG_PUT_ARRAY(h, LOG_ARG(a), LOG_ARG(b), LOG_ARG(c), LOG_ARG(d), LOG_ARG(e))
+#define LOG_PUT_6(h, fmt, a, b, c, d, e, f) \
+    LOG_PUT_ARRAY(h, LOG_ARG(a), LOG_ARG(b), LOG_ARG(c), LOG_ARG(d), LOG_ARG(e), LOG_ARG(f))
+#define LOG_PUT_7(h, fmt, a, b, c, d, e, f, g) \
+    LOG_PUT_ARRAY(h, LOG_ARG(a), LOG_ARG(b), LOG_ARG(c), LOG_ARG(d), LOG_ARG(e), LOG_ARG(f), LOG_ARG(g))
+#define LOG_PUT_8(h, fmt, a, b, c, d, e, f, g, k) \
+    LOG_PUT_ARRAY(h, LOG_ARG(a), LOG_ARG(b), LOG_ARG(c), LOG_ARG(d), LOG_ARG(e), LOG_ARG(f), LOG_ARG(g), LOG_ARG(k))
+
+#if LOG_ENABLE
+// Файл и строка, '\0', формат. Секция не занимает FLASH
+#define LOG(...)                                                                                   \
+    do                                                                                             \
+    {                                                                                              \
+        static const char logFmt_[] __attribute__((section(".log_fmt"), used)) =                   \
+            __FILE__ ":" LOG_STR(__LINE__) "\0" LOG_FORMAT(__VA_ARGS__);                          \
+        if (0)                                                                                     \
+        {                                                                                          \
+            LOG_FormatCheck(__VA_ARGS__);                                                          \
+        }                                                                                          \
+        LOG_CAT(LOG_PUT_, LOG_NARGS(__VA_ARGS__))(LOG_HEADER(logFmt_, LOG_NARGS(__VA_ARGS__)),     \
+                                                  __VA_ARGS__);                                    \
+    } while (0)
+#else
+#define LOG(...)                            \
+    do                                      \
+    {                                       \
+        if (0)                              \
+        {                                   \
+            LOG_FormatCheck(__VA_ARGS__);   \
+        }                                   \
+    } while (0)
+#endif
@@ -0,0 +1,40 @@
+#pragma once
+#include "app.h"
+
+// Очередь событий "много писателей - один читатель" без критических секций.
+// Писатели - прерывания любого приоритета (в том числе выше configMAX_SYSCALL_INTERRUPT_PRIORITY)
+// и задачи, читатель - одна задача. Вставка - LDREX/STREX, BASEPRI не трогается.
+// Очередь интрузивная: узел MPSC_Node_t встраивается в структуру события, память не копируется
+// и не выделяется. Узел нельзя отправлять повторно, пока читатель его не забрал.
+
+// Прерывание, через которое будится задача-читатель. Любое незанятое в проекте:
+// писатель выше syscall-приоритета не может звать FreeRTOS, поэтому он только
+// выставляет pending этому прерыванию, а оно уже шлет уведомление задаче.
+// Задаются оба макроса, по умолчанию - компаратор (с его драйвером - #error в mpsc.c)
+#ifndef MPSC_WAKEUP_IRQn
+#define MPSC_WAKEUP_IRQn        COMPARATOR_IRQn
+#define MPSC_WAKEUP_IRQHandler  COMPARATOR_IRQHandler
+#define MPSC_WAKEUP_DEFAULT
+#elif !defined(MPSC_WAKEUP_IRQHandler)
+#error "mpsc.h: MPSC_WAKEUP_IRQn задан без MPSC_WAKEUP_IRQHandler"
+#endif
+
+#define MPSC_MAX_QUEUES 4 // сколько очередей может будить одно прерывание
+
+typedef struct MPSC_Node
+{
+    struct MPSC_Node *next;
+} MPSC_Node_t;
+
+typedef struct
+{
+    MPSC_Node_t *volatile head; // стек свежих узлов (LIFO), сюда пишут писатели
+    MPSC_Node_t *pending;       // уже забранные читателем узлы в порядке FIFO
+    volatile uint32_t signal;   // писатель просит разбудить читателя
+    TaskHandle_t consumer;
+} MPSC_Queue_t;
+
+void MPSC_Init(MPSC_Queue_t *q, TaskHandle_t consumer);
+void MPSC_Post(MPSC_Queue_t *q, MPSC_Node_t *node); // из любого контекста
+MPSC_Node_t *MPSC_Take(MPSC_Queue_t *q);            // только читатель, не блокирует
+MPSC_Node_t *MPSC_Wait(MPSC_Queue_t *q, TickType_t ticks); // только читатель, блокирует без опроса
@@ -0,0 +1,125 @@
+#pragma once
+#include "app.h"
+#include "MDR32FxQI_timer.h"
+
+// Секвенсор ШИМ: длительности импульсов из ОЗУ в CCR по DMA, по одной на период таймера,
+// без прерывания на каждый период (лента WS2812, микрошаг, форма сигнала).
+// Запрос DMA - начало периода (CNT = 0), CCR перезагружается на CNT = 0: значение,
+// записанное в периоде k, действует в периоде k + 1. Буфер - две половины в режиме
+// ping-pong: пока DMA отдает одну, прерывание DMA заполняет другую функцией fill.
+// Поток бесконечен, пока fill не вернет меньше, чем просили. После него в CCR - idle.
+// Запрос таймера держится, пока флаг CNT_ZERO в STATUS не снят, поэтому на него работает
+// цепочка канала таймера (peripheral scatter-gather): программный запрос второму каналу,
+// который пишет в CCR следующее значение буфера, и снятие флага. Без снятия DMA выдал бы
+// весь буфер подряд, не дожидаясь периодов.
+// У K1986VE9x у таймера один запрос DMA, поэтому секвенсор - это таймер и один его канал.
+// Несколько выходов - секвенсоры на разных таймерах, PWMSEQ_Play запускает их вместе.
+// Пока секвенсоры заняты, частота ядра держится не ниже суммы их floor - частот, на которых
+// DMA успевает за периодом (DFS_Hold, PWMSEQ_DMA_CYCLES тактов HCLK на период). Контроллер
+// DMA один, сумма занятых не должна превышать CLK_MAX_HZ.
+// Вывод канала (CHx) настраивает вызывающий: PORT, функция таймера.
+// Частота счета держится при смене частоты ядра (нотификатор CLK_SWITCH меняет PSG), но
+// пока перестраивается PLL, периоды искажены: кадр ленты на смене частоты портится.
+
+#ifndef PWMSEQ_HZ
+#define PWMSEQ_HZ 8000000 // счет CNT, 125 нс. Делит все уровни DFS_LEVELS
+#endif
+#define PWMSEQ_MAX_HALF 1024 // значений в половине: n_minus_1 цикла DMA - 10 бит
+
+// Тактов HCLK на период: три задачи цепочки (копия задачи - 4 слова, сама передача,
+// чтение и запись управляющих слов) и передача значения в CCR. Оценка по циклам PL230
+// с запасом на ожидания APB, не замер: с ней считает модель test/test_pwmseq.c
+#ifndef PWMSEQ_DMA_CYCLES
+#define PWMSEQ_DMA_CYCLES 80
+#endif
+#define PWMSEQ_CHAIN_TASKS 3
+
+// Ячейка уведомлений задачи для PWMSEQ_Wait
+#define PWMSEQ_NOTIFY_INDEX 5
+
+#ifndef PWMSEQ_BENCHMARK
+#define PWMSEQ_BENCHMARK 0 // 1 - PWMSEQ_GetStats: такты в прерывании DMA на перезарядку
+#endif
+
+typedef struct PWMSEQ PWMSEQ_t;
+
+// Из прерывания DMA: записать в values до count следующих значений CCR (тактов PWMSEQ_HZ,
+// импульс в начале периода). Меньше count - поток кончился
+typedef uint32_t (*PWMSEQ_Fill_t)(PWMSEQ_t *seq, uint16_t *values, uint32_t count);
+
+struct PWMSEQ
+{
+    MDR_TIMER_TypeDef *timer;
+    volatile uint32_t *ccr;
+    uint16_t *buffer;         // 2 * half значений, в ОЗУ, доступной DMA
+    uint32_t half;
+    uint16_t idle;            // CCR вне потока
+    uint8_t dma;              // канал DMA_Channel_TIMn: цепочка на запрос таймера
+    uint8_t feed;             // программный канал: буфер -> CCR, по значению на запрос цепочки
+    volatile uint8_t busy;
+    uint8_t ending;           // последняя порция отдана DMA
+    uint32_t floor;           // доля в удержании DFS, пока busy
+    PWMSEQ_Fill_t fill;
+    void *arg;
+    uint32_t underruns;       // прерывание не успело заполнить половину - поток оборван
+    TaskHandle_t waiter;
+    DMA_CtrlDataTypeDef chain[PWMSEQ_CHAIN_TASKS]; // задачи канала dma, по кругу
+    uint32_t kick;            // 1 << feed, в CHNL_SW_REQUEST
+    uint32_t zero;            // в STATUS
+    uint32_t chainControl;    // основная структура канала dma, ее перезаряжает последняя задача
+#if PWMSEQ_BENCHMARK
+    uint32_t refills;
+    uint64_t values;
+    uint64_t cycles;          // в обработчике DMA: fill и перезарядка структуры
+    uint64_t since;           // UPTIME_GetCycles прошлого PWMSEQ_GetStats
+#endif
+};
+
+// timer 1..3 (не занятый CLK_Config и HRT), channel 1..4, period - тактов PWMSEQ_HZ.
+// ШИМ: выход 1, пока CNT < CCR. idle = 0 - постоянный 0. Каналы DMA: DMA_Channel_TIMn
+// и свободный программный
+void PWMSEQ_Init(PWMSEQ_t *seq, uint32_t timer, uint32_t channel, uint32_t period,
+                 uint16_t *buffer, uint32_t half, uint16_t idle, PWMSEQ_Fill_t fill, void *arg);
+
+// Из задачи. Поднимает частоту на floor секвенсоров (DFS_Hold), заполняет обе половины
+// и запускает count секвенсоров с общей фазой (счет стартует подряд, разница - такты
+// между записями CNTRL). Первые периоды - idle
+void PWMSEQ_Play(PWMSEQ_t *const seqs[], uint32_t count);
+// Ждет, пока последнее значение уйдет в CCR: до конца вывода остается период
+BaseType_t PWMSEQ_Wait(PWMSEQ_t *seq, TickType_t ticks);
+void PWMSEQ_Stop(PWMSEQ_t *seq); // обрывает поток, CCR = idle
+
+// Лента WS2812: бит - период 1.25 мкс, 0 - импульс 0.375 мкс, 1 - 0.75 мкс (на 8 МГц
+// счета), после кадра - пауза сброса. Из половины в 192 значения - 8 светодиодов.
+// На период в 1.25 мкс цепочке нужно 64 МГц, секвенсор держит 80 МГц. Две ленты сразу
+// не успевают - на разных таймерах их надо выводить по очереди
+#define PWMSEQ_WS2812_PERIOD (PWMSEQ_HZ / 800000)
+#define PWMSEQ_WS2812_T0H    (PWMSEQ_HZ * 3 / 8000000)
+#define PWMSEQ_WS2812_T1H    (PWMSEQ_HZ * 6 / 8000000)
+#define PWMSEQ_WS2812_RESET  240 // периодов, 300 мкс
+
+typedef struct
+{
+    const uint8_t *grb;       // по 3 байта на светодиод: G, R, B
+    uint32_t bytes;
+    uint32_t position;
+    uint32_t reset;           // периодов паузы осталось
+} PWMSEQ_Ws2812_t;
+
+// fill для PWMSEQ_Init, arg - PWMSEQ_Ws2812_t. half кратна 8
+uint32_t PWMSEQ_Ws2812Fill(PWMSEQ_t *seq, uint16_t *values, uint32_t count);
+// Из задачи: кадр из grb (не менять до PWMSEQ_Wait), секвенсор инициализирован
+// с PWMSEQ_WS2812_PERIOD, idle = 0, fill = PWMSEQ_Ws2812Fill и arg = strip
+void PWMSEQ_Ws2812(PWMSEQ_t *seq, const uint8_t *grb, uint32_t leds);
+
+#if PWMSEQ_BENCHMARK
+typedef struct
+{
+    uint32_t refills;
+    uint32_t cyclesPerRefill;
+    uint32_t cyclesPer100Values;
+    uint32_t loadPermille;    // обработчика DMA к UPTIME_GetCycles с прошлого вызова, 0.1%
+} PWMSEQ_Stats_t;
+
+void PWMSEQ_GetStats(PWMSEQ_t *seq, PWMSEQ_Stats_t *stats);
+#endif
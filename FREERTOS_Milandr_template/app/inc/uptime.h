@@ -0,0 +1,49 @@
+#pragma once
+#include "app.h"
+
+// Монотонное время с запуска планировщика: тики SysTick плюс текущее значение его счетчика.
+// 64 бита без разрывов из любого контекста - задачи, прерывания любого приоритета (в том
+// числе выше configMAX_SYSCALL_INTERRUPT_PRIORITY) - без запрета прерываний. Тик пишет
+// новый снимок в свободную из двух ячеек и меняет номер, чтение повторяется, если номер
+// сменился, пока оно шло. Перезагрузку SysTick, чей тик ждет снятия маски (PENDSTSET) или
+// вытеснен до публикации снимка (SYSTICKACT), чтение учитывает само. Условие: прерывания
+// не замаскированы дольше тика подряд.
+// Смена частоты (CLK_SetFrequency, событие CLK_SWITCH) время не рвет: такты и мкс
+// копятся по периодам SysTick.
+// Мкс поправляются на уход кварца, измеренный по RTC.
+
+#ifndef UPTIME_RTC_HZ
+#define UPTIME_RTC_HZ 32768 // RTC от LSE
+#endif
+#define UPTIME_RTC_EDGE_US 100 // RTC_DIV не сменился за это время - RTC стоит
+
+uint64_t UPTIME_GetUs(void);
+uint64_t UPTIME_GetCycles(void); // такты ядра, при смене частоты не пересчитываются
+uint64_t UPTIME_GetTicks(void);  // xTaskGetTickCount без переполнения
+
+// Калибровка по RTC: счетчик RTC уже идет от LSE (BKP_RTCclkSource(BKP_RTC_LSEclk)),
+// RTC_DIV считает 0..RTC_PRL-1. Между Start и Finish - от секунды, погрешность около
+// 1 мкс на интервал (10 с - 0.1 ppm). Каждая ждет фронт RTC_DIV с запрещенными
+// прерываниями, до 1 / UPTIME_RTC_HZ. Поправка применяется со следующего тика.
+ErrorStatus UPTIME_CalibrateStart(void);
+ErrorStatus UPTIME_CalibrateFinish(int32_t *ppm); // ppm - уход частоты ядра от номинала
+void UPTIME_SetPpm(int32_t ppm);                   // например, сохраненная в BKP
+
+#ifndef UPTIME_TORTURE
+#define UPTIME_TORTURE 0 // 1 - UPTIME_Torture
+#endif
+
+#if UPTIME_TORTURE
+typedef struct
+{
+    uint32_t reads;     // чтений в цикле
+    uint32_t isrReads;  // чтений из прерывания TIMER3
+    uint32_t backwards; // время пошло назад: должно быть 0
+    uint32_t maxStepUs; // наибольший шаг между соседними чтениями цикла
+} UPTIME_Torture_t;
+
+// Цикл чтений ms миллисекунд под прерываниями TIMER3 с приоритетом 0 и случайным
+// периодом: чтения попадают внутрь тика, в критические секции и в перезагрузку SysTick.
+// Для проверки смены частоты - параллельно с DFS_Task. TIMER3 не должен быть занят
+const UPTIME_Torture_t *UPTIME_Torture(uint32_t ms);
+#endif
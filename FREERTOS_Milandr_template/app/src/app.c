@@ -1,5 +1,24 @@
 #include "app.h"
 
+// Размеры стеков из статического анализа (cmake -DSTACK_USAGE=ON), иначе - по старинке.
+// Заголовок генерирует первая стадия сборки, к компиляции этого файла он уже свежий
+#if defined(STACK_USAGE_ENABLED) && !defined(STACK_USAGE_ANALYSIS)
+#include "stack_sizes.h"
+#endif
+#ifndef STACK_SIZE_exampleTask
+#define STACK_SIZE_exampleTask configMINIMAL_STACK_SIZE
+#define STACK_DEPTH_exampleTask (configMINIMAL_STACK_SIZE * sizeof(StackType_t))
+#endif
+
+// Сверка расчета с реальностью: стек закрашивается 0xA5 при создании задачи,
+// водяной знак показывает сколько слов так и не было затронуто.
+// Если задача съела больше, чем предсказал анализ, - анализ врет (косвенные вызовы и т.п.)
+static void stackCheck(UBaseType_t size, uint32_t depth)
+{
+  UBaseType_t used = size - uxTaskGetStackHighWaterMark(NULL);
+  configASSERT(used * sizeof(StackType_t) <= depth);
+}
+
 void vApplicationStackOverflowHook(TaskHandle_t pxTask, char *pcTaskName)
 {
   while (1)
@@ -9,28 +28,95 @@ void vApplicationStackOverflowHook(TaskHandle_t pxTask, char *pcTaskName)
 }
 void vApplicationIdleHook(void)
 {
-  while (1)
+  // Запись во FLASH идет квантами в простое. Хук не должен блокироваться,
+  // поэтому один квант за проход
+  FLASH_Process(0);
+}
+void vApplicationTickHook(void)
+{
+  // Дозапуск отправки журнала, если DMA стоит, а в кольце что-то есть
+  LOG_Kick();
+}
+
+#ifndef RAMFUNC_BENCHMARK
+#define RAMFUNC_BENCHMARK 0 // 1 - замер переключения контекста для сравнения сборок RAMFUNC
+#endif
+
+#if RAMFUNC_BENCHMARK
+#include <inttypes.h>
+
+// Круг "уведомил - уснул - разбудили" между двумя задачами одного приоритета: два
+// переключения (PendSV_Handler, vTaskSwitchContext из ramfunc.txt) и API уведомлений.
+// Сравнивать сборки -DRAMFUNC=ON и OFF на одной частоте
+#define RAMFUNC_BENCH_ROUNDS 1000
+
+static void ramfuncPeer(void *pvParameters)
+{
+  for (;;)
   {
-    __NOP();
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    xTaskNotifyGive((TaskHandle_t)pvParameters);
+  }
+}
+
+static void ramfuncBenchmark(void)
+{
+  TaskHandle_t peer;
+  uint32_t start;
+
+  xTaskCreate(ramfuncPeer, "bench", configMINIMAL_STACK_SIZE, xTaskGetCurrentTaskHandle(),
+              uxTaskPriorityGet(NULL), &peer);
+  start = DWT->CYCCNT;
+  for (uint32_t i = 0; i < RAMFUNC_BENCH_ROUNDS; i++)
+  {
+    xTaskNotifyGive(peer);
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
   }
+  start = DWT->CYCCNT - start;
+  vTaskDelete(peer);
+#ifdef RAMFUNC_ENABLED
+  LOG("switch round trip %" PRIu32 " cycles at %" PRIu32 " Hz, RAMFUNC on", start / RAMFUNC_BENCH_ROUNDS, SystemCoreClock);
+#else
+  LOG("switch round trip %" PRIu32 " cycles at %" PRIu32 " Hz, RAMFUNC off", start / RAMFUNC_BENCH_ROUNDS, SystemCoreClock);
+#endif
 }
+#endif
 
 void exampleTask(void *pvParameters)
 {
   (void) pvParameters; // убираем warning
+  BOOT_Mark(BOOT_STAGE_FIRST_TASK);
+#if RAMFUNC_BENCHMARK
+  ramfuncBenchmark();
+#endif
   for (;;)
   { 
     __NOP();       
     vTaskDelay(1);
+    stackCheck(STACK_SIZE_exampleTask, STACK_DEPTH_exampleTask);
   }
 }
 
 int main(void)
 {
-  CLK_Init_80_mhz();
+#if CLK_FAST_BOOT
+  CLK_StartAsync(); // на CLK_CPU_HZ переведет губернатор, см. DFS_Task
+#else
+  (void)CLK_Init(); // отказ HSE или PLL: работаем на HSI или HSE, губернатор это увидит
+#endif
+  CLK_InitPeripherals();
+  BOOT_Mark(BOOT_STAGE_CLOCK);
+  FLASH_Init();
+  DMAM_Init();
+  // HRT_Init();          // таймеры с разрешением 1 мкс на TIMER2 (hrt.h)
+  // PWMSEQ_Init(...);   // ШИМ с длительностями из ОЗУ по DMA (pwmseq.h), после DMAM_Init
+  // LOG_Init(MDR_UART1); // журнал в UART: после CLK_UARTInit и настройки выводов
+  // CONSOLE_Init();       // printf в CONSOLE_UART, так же после настройки UART
+  DFS_Start(configMAX_PRIORITIES - 1);
   
-  xTaskCreate(exampleTask, "exampleTask", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY + 1, NULL);
+  xTaskCreate(exampleTask, "exampleTask", STACK_SIZE_exampleTask, NULL, tskIDLE_PRIORITY + 1, NULL);
 
+  BOOT_Mark(BOOT_STAGE_SCHEDULER);
   vTaskStartScheduler();
   while (1)
   {
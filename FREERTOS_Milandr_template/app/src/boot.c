@@ -0,0 +1,45 @@
+#include "boot.h"
+
+static uint32_t stamps[BOOT_STAGES];
+static uint32_t lastCycles;
+static uint32_t lastUs;
+static uint32_t lastHz;
+
+void BOOT_Mark(BOOT_Stage_t stage)
+{
+    uint32_t primask;
+    uint32_t cycles;
+
+    if (DWT->CTRL & DWT_CTRL_NOCYCCNT_Msk)
+    {
+        return;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    cycles = DWT->CYCCNT;
+    if (stamps[stage] == 0)
+    {
+        // До первой отметки .bss еще не было, ядро шло от HSI (частота SystemCoreClock после SystemInit)
+        if (lastHz == 0)
+        {
+            lastHz = HSI_Value;
+        }
+        // Частоты кратны 1 МГц, остаток деления - доли мкс
+        lastUs += (cycles - lastCycles) / (lastHz / 1000000);
+        lastCycles = cycles;
+        lastHz = SystemCoreClock;
+        stamps[stage] = lastUs;
+    }
+    __set_PRIMASK(primask);
+
+    if (stage == BOOT_STAGE_FIRST_TASK)
+    {
+        configASSERT(stamps[stage] <= BOOT_BUDGET_US);
+    }
+}
+
+uint32_t BOOT_GetTimeUs(BOOT_Stage_t stage)
+{
+    return stamps[stage];
+}
@@ -1,41 +1,76 @@
 #include "clk.h"
 
+static CLK_Notifier_t notifiers[CLK_MAX_NOTIFIERS];
+static uint32_t notifiersCount;
+static CLK_Startup_t startup = CLK_STARTUP_DONE;
+static BaseType_t pllStarted;
 
-void CLK_Init_80_mhz(void)
+
+static void CLK_SetTiming(uint32_t hz);
+
+ErrorStatus CLK_Init(void)
 {
+    uint32_t i;
+
     RST_CLK_DeInit();
-  SystemCoreClockUpdate();
     /* Enable HSE (High Speed External) clock */
     RST_CLK_HSEconfig(RST_CLK_HSE_ON);
-    while(RST_CLK_HSEstatus() == ERROR) {}
+    for (i = 0; i < CLK_HSE_ATTEMPTS && RST_CLK_HSEstatus() == ERROR; i++) {}
+    if (i == CLK_HSE_ATTEMPTS)
+    {
+        // Кварц не запустился: остаемся на HSI, губернатору менять частоту не из чего
+        RST_CLK_HSEconfig(RST_CLK_HSE_OFF);
+        SystemCoreClock = HSI_Value;
+        CLK_SetTiming(HSI_Value);
+        startup = CLK_STARTUP_FAILED;
+        return ERROR;
+    }
 
-    /* Configures the CPU_PLL clock source (CPU_CLK = HSE_CLK * 5 = 16 MHz * 5 = 80 MHz) */
-    RST_CLK_CPU_PLLconfig(RST_CLK_CPU_PLLsrcHSEdiv1, RST_CLK_CPU_PLLmul5);
-    /* Enables the CPU_PLL */
-    RST_CLK_CPU_PLLcmd(ENABLE);
-    while(RST_CLK_CPU_PLLstatus() == ERROR) {}
+    /* CPU_C1 = HSE, CPU_C2 = CPU_C1 * pllMul (множитель и делитель посчитаны в clk_config.cpp) */
+    RST_CLK_CPUclkSelectionC1(RST_CLK_CPU_C1srcHSEdiv1);
+    if (CLK_Config.cpu.pllMul > 1)
+    {
+        RST_CLK_CPU_PLLconfig(RST_CLK_CPU_PLLsrcHSEdiv1, (RST_CLK_CPU_PLL_Multiplier)(CLK_Config.cpu.pllMul - 1));
+        /* Enables the CPU_PLL */
+        RST_CLK_CPU_PLLcmd(ENABLE);
+        for (i = 0; i < CLK_PLL_ATTEMPTS && RST_CLK_CPU_PLLstatus() == ERROR; i++) {}
+        if (i == CLK_PLL_ATTEMPTS)
+        {
+            // PLL не захватился: ядро на HSE без делителя, как после отказа в CLK_SetFrequency
+            RST_CLK_CPU_PLLcmd(DISABLE);
+            RST_CLK_CPUclkPrescaler(RST_CLK_CPUclkDIV1);
+            CLK_SetTiming(HSE_Value);
+            RST_CLK_CPUclkSelection(RST_CLK_CPUclkCPU_C3);
+            SystemCoreClock = HSE_Value;
+            startup = CLK_STARTUP_FAILED;
+            return ERROR;
+        }
 
-    /* Select the CPU_PLL output as input for CPU_C2_SEL */
-    RST_CLK_CPU_PLLuse(ENABLE);
-    /* Set CPUClk Prescaler (CPU_C3_SEL = CPU_C2) */
-    RST_CLK_CPUclkPrescaler(RST_CLK_CPUclkDIV1);
+        /* Select the CPU_PLL output as input for CPU_C2_SEL */
+        RST_CLK_CPU_PLLuse(ENABLE);
+    }
+    /* Set CPUClk Prescaler */
+    RST_CLK_CPUclkPrescaler(CLK_Config.cpu.c3Div);
 
     /* Enables the RST_CLK_PCLK_EEPROM */
     RST_CLK_PCLKcmd(RST_CLK_PCLK_EEPROM, ENABLE);
-    /* Sets the code latency value (CPU_CLK up to 100 MHz) */
-    EEPROM_SetLatency(EEPROM_Latency_3);
+    /* Sets the code latency value */
+    EEPROM_SetLatency(CLK_Config.cpu.latency);
     /* Disables the RST_CLK_PCLK_EEPROM */
     RST_CLK_PCLKcmd(RST_CLK_PCLK_EEPROM, DISABLE);
     
     /* Enables the RST_CLK_PCLK_BKP */
     RST_CLK_PCLKcmd(RST_CLK_PCLK_BKP, ENABLE);
-    /* Setting the parameters of the voltage regulator SelectRI and LOW in the BKP controller (CPU_CLK = 80 MHz) */
-    BKP_DUccMode(BKP_DUcc_upto_80MHz);
+    /* Setting the parameters of the voltage regulator SelectRI and LOW in the BKP controller */
+    BKP_DUccMode(CLK_Config.cpu.ducc);
 
     /* Select the CPU clock source */
     RST_CLK_CPUclkSelection(RST_CLK_CPUclkCPU_C3);
 
-    SystemCoreClockUpdate();
+    // SystemCoreClockUpdate считает от HSE_Value из MDR32FxQI_config.h, а не от CLK_HSE_HZ.
+    // От SystemCoreClock зависят SysTick (configCPU_CLOCK_HZ) и задержки записи FLASH
+    SystemCoreClock = CLK_Config.cpu.hz;
+    return SUCCESS;
     // MDR_RST_CLK->HS_CONTROL |= 0b01; //включить HSE
     // while(MDR_RST_CLK->CLOCK_STATUS & RST_CLK_CLOCK_STATUS_HSE_RDY != 1); //ждем запуска HSE
 
@@ -53,4 +88,251 @@ void CLK_Init_80_mhz(void)
     
 
     // MDR_RST_CLK->CPU_CLOCK |= 0b01 << RST_CLK_CPU_CLOCK_HCLK_SEL_Pos; // CPU_C3 - HCLK
-}
\ No newline at end of file
+}
+
+void CLK_InitPeripherals(void)
+{
+    MDR_RST_CLK->UART_CLOCK = CLK_Config.uartClock;
+    MDR_RST_CLK->SSP_CLOCK = CLK_Config.sspClock;
+    MDR_RST_CLK->CAN_CLOCK = CLK_Config.canClock;
+    MDR_RST_CLK->TIM_CLOCK = CLK_Config.timClock;
+}
+
+// IBRD/FBRD под частоту ядра hz. На CLK_CPU_HZ - готовые из CLK_Config, иначе то же, что
+// solveUart в clk_tree.hpp, но на ходу и с BRG из CLK_Config. hz >> brg не больше 80 МГц,
+// * 4 помещается в 32 бита
+static uint32_t CLK_UARTBrg(MDR_UART_TypeDef *UARTx)
+{
+    return (CLK_Config.uartClock >> (UARTx == MDR_UART1 ? 0 : RST_CLK_UART_CLOCK_UART2_BRG_Pos)) & RST_CLK_UART_CLOCK_UART1_BRG_Msk;
+}
+
+static void CLK_UARTSetDivisor(MDR_UART_TypeDef *UARTx, uint32_t hz)
+{
+    const CLK_UartConfig_t *config = &CLK_Config.uart[UARTx == MDR_UART1 ? 0 : 1];
+    uint32_t brg = CLK_UARTBrg(UARTx);
+    uint32_t div64;
+
+    if (hz == CLK_Config.cpu.hz)
+    {
+        UARTx->IBRD = config->ibrd;
+        UARTx->FBRD = config->fbrd;
+        return;
+    }
+    div64 = ((hz >> brg) * 4 + config->baud / 2) / config->baud;
+    CLK_ASSERT(div64 >= 64 && (div64 >> 6) <= 0xFFFF); // бодрейт не собирается на этой частоте
+    UARTx->IBRD = div64 >> 6;
+    UARTx->FBRD = div64 & 0x3F;
+}
+
+void CLK_UARTInit(MDR_UART_TypeDef *UARTx, const UART_InitTypeDef *init)
+{
+    const CLK_UartConfig_t *config = &CLK_Config.uart[UARTx == MDR_UART1 ? 0 : 1];
+
+    CLK_ASSERT(config->baud == init->UART_BaudRate); // делители посчитаны для config->baud
+    UARTx->CR = init->UART_HardwareFlowControl;
+    CLK_UARTSetDivisor(UARTx, SystemCoreClock);
+    // Запись LCR_H защелкивает IBRD/FBRD
+    UARTx->LCR_H = init->UART_WordLength | init->UART_StopBits | init->UART_Parity | init->UART_FIFOMode;
+}
+
+void CLK_UARTRetune(MDR_UART_TypeDef *UARTx, CLK_Event_t event, uint32_t hz)
+{
+    if (event == CLK_PRE_CHANGE)
+    {
+        // Байт, который уходит во время переключения, уйдет с неверным бодрейтом.
+        // С CTS передатчик может стоять сколько угодно: ждем не дольше 16 кадров по 12 бит
+        uint64_t end = UPTIME_GetCycles() + ((48 * (UARTx->IBRD * 64 + UARTx->FBRD)) << CLK_UARTBrg(UARTx));
+
+        UARTx->DMACR &= ~UART_DMA_TXE;
+        while ((UARTx->FR & UART_FR_BUSY) && UPTIME_GetCycles() < end) {}
+    }
+    else if (event == CLK_POST_CHANGE)
+    {
+        CLK_UARTSetDivisor(UARTx, hz);
+        UARTx->LCR_H = UARTx->LCR_H;
+        UARTx->DMACR |= UART_DMA_TXE;
+    }
+}
+
+void CLK_AddNotifier(CLK_Notifier_t notifier)
+{
+    configASSERT(notifiersCount < CLK_MAX_NOTIFIERS);
+    notifiers[notifiersCount] = notifier;
+    notifiersCount++;
+}
+
+static void CLK_Notify(CLK_Event_t event, uint32_t hz)
+{
+    for (uint32_t i = 0; i < notifiersCount; i++)
+    {
+        notifiers[i](event, hz);
+    }
+}
+
+// Латентность FLASH и режим регулятора под частоту
+static void CLK_SetTiming(uint32_t hz)
+{
+    // Тактирование контроллера EEPROM не выключаем - оно нужно flash.c
+    RST_CLK_PCLKcmd(RST_CLK_PCLK_EEPROM, ENABLE);
+    RST_CLK_PCLKcmd(RST_CLK_PCLK_BKP, ENABLE);
+    EEPROM_SetLatency(hz <= 25000000 ? EEPROM_Latency_0 :
+                      hz <= 50000000 ? EEPROM_Latency_1 :
+                      hz <= 75000000 ? EEPROM_Latency_2 : EEPROM_Latency_3);
+    BKP_DUccMode(hz <= 10000000 ? BKP_DUcc_upto_10MHz :
+                 hz <= 40000000 ? BKP_DUcc_upto_40MHz :
+                 hz <= 80000000 ? BKP_DUcc_upto_80MHz : BKP_DUcc_over_80MHz);
+}
+
+ErrorStatus CLK_SetFrequency(uint32_t hz)
+{
+    uint32_t mul = 0;
+    uint32_t div;
+    uint32_t old;
+    ErrorStatus status = SUCCESS;
+
+    // Наименьший делитель CPU_C3 - меньше и множитель PLL. Множители 2 и 3 у K1986VE9x запрещены
+    for (div = 0; div <= 8 && hz != 0 && hz <= ((uint32_t)CLK_MAX_HZ >> div); div++)
+    {
+        uint32_t pll = hz << div;
+        if (pll % HSE_Value == 0 && (pll / HSE_Value == 1 || pll / HSE_Value >= 4))
+        {
+            mul = pll / HSE_Value;
+            break;
+        }
+    }
+    if (mul == 0 || !(MDR_RST_CLK->CLOCK_STATUS & RST_CLK_CLOCK_STATUS_HSE_RDY))
+    {
+        return ERROR;
+    }
+    if (hz == SystemCoreClock)
+    {
+        return SUCCESS;
+    }
+
+    CLK_Notify(CLK_PRE_CHANGE, hz);
+
+    taskENTER_CRITICAL();
+    old = SystemCoreClock;
+
+    // Перед разгоном FLASH и регулятор переводятся на новую частоту заранее, при замедлении - после
+    if (hz > old)
+    {
+        CLK_SetTiming(hz);
+    }
+
+    // На время перестройки PLL ядро работает от HSE с новым делителем,
+    // HSE / div не превышает ни старую, ни новую частоту
+    RST_CLK_CPU_PLLuse(DISABLE);
+    RST_CLK_CPUclkSelectionC1(RST_CLK_CPU_C1srcHSEdiv1); // после быстрого старта ядро еще на HSI
+    RST_CLK_CPUclkPrescaler(div == 0 ? RST_CLK_CPUclkDIV1 : (RST_CLK_CPU_C3_Divisor)(RST_CLK_CPUclkDIV2 + div - 1));
+    // PLL, уже захваченный с этим множителем (CLK_PollStartup), не перезапускаем
+    if (mul > 1 &&
+        (!(MDR_RST_CLK->PLL_CONTROL & RST_CLK_PLL_CONTROL_PLL_CPU_ON) ||
+         ((MDR_RST_CLK->PLL_CONTROL & RST_CLK_PLL_CONTROL_PLL_CPU_MUL_Msk) >> RST_CLK_PLL_CONTROL_PLL_CPU_MUL_Pos) != mul - 1 ||
+         !(MDR_RST_CLK->CLOCK_STATUS & RST_CLK_CLOCK_STATUS_PLL_CPU_RDY)))
+    {
+        // Захват PLL - сотни мкс на HSE / div: время и таймеры идут по ней, а прерывания
+        // и старшие задачи на это время не блокируются - ждем вне критической секции
+        RST_CLK_CPUclkSelection(RST_CLK_CPUclkCPU_C3);
+        SystemCoreClock = HSE_Value >> div;
+        CLK_Notify(CLK_SWITCH, SystemCoreClock);
+        RST_CLK_CPU_PLLcmd(DISABLE);
+        RST_CLK_CPU_PLLconfig(RST_CLK_CPU_PLLsrcHSEdiv1, (RST_CLK_CPU_PLL_Multiplier)(mul - 1));
+        RST_CLK_CPU_PLLcmd(ENABLE);
+        taskEXIT_CRITICAL();
+
+        for (uint32_t i = 0; i < CLK_PLL_ATTEMPTS && RST_CLK_CPU_PLLstatus() == ERROR; i++) {}
+
+        taskENTER_CRITICAL();
+    }
+    if (mul > 1)
+    {
+        if (MDR_RST_CLK->CLOCK_STATUS & RST_CLK_CLOCK_STATUS_PLL_CPU_RDY)
+        {
+            RST_CLK_CPU_PLLuse(ENABLE);
+        }
+        else
+        {
+            // Остаемся на HSE / div, уже выбранной выше: она не быстрее ни старой, ни новой
+            RST_CLK_CPU_PLLcmd(DISABLE);
+            hz = HSE_Value >> div;
+            status = ERROR;
+        }
+    }
+    else
+    {
+        RST_CLK_CPU_PLLcmd(DISABLE);
+    }
+    RST_CLK_CPUclkSelection(RST_CLK_CPUclkCPU_C3);
+
+    if (hz < old)
+    {
+        CLK_SetTiming(hz);
+    }
+
+    // SysTick (uptime.c), предделители hrt.c и pwmseq.c
+    if (hz != SystemCoreClock)
+    {
+        SystemCoreClock = hz;
+        CLK_Notify(CLK_SWITCH, hz);
+    }
+    taskEXIT_CRITICAL();
+
+    CLK_Notify(CLK_POST_CHANGE, hz);
+    return status;
+}
+
+void CLK_StartAsync(void)
+{
+    // SystemInit уже вернул RST_CLK в исходное состояние: ядро на HSI, SystemCoreClock = HSI_Value
+    SystemCoreClock = HSI_Value;
+    CLK_SetTiming(HSI_Value);
+    RST_CLK_HSEconfig(RST_CLK_HSE_ON);
+    startup = CLK_STARTUP_BUSY;
+}
+
+CLK_Startup_t CLK_PollStartup(void)
+{
+    if (startup != CLK_STARTUP_BUSY)
+    {
+        return startup;
+    }
+
+    if (!pllStarted)
+    {
+        if (MDR_RST_CLK->CLOCK_STATUS & RST_CLK_CLOCK_STATUS_HSE_RDY)
+        {
+            if (CLK_Config.cpu.pllMul > 1)
+            {
+                RST_CLK_CPU_PLLconfig(RST_CLK_CPU_PLLsrcHSEdiv1, (RST_CLK_CPU_PLL_Multiplier)(CLK_Config.cpu.pllMul - 1));
+                RST_CLK_CPU_PLLcmd(ENABLE);
+            }
+            pllStarted = pdTRUE;
+        }
+    }
+    else if (CLK_Config.cpu.pllMul == 1 || (MDR_RST_CLK->CLOCK_STATUS & RST_CLK_CLOCK_STATUS_PLL_CPU_RDY))
+    {
+        if (CLK_SetFrequency(CLK_Config.cpu.hz) == ERROR)
+        {
+            startup = CLK_STARTUP_FAILED; // PLL не захватился, ядро на HSE
+            return startup;
+        }
+        startup = CLK_STARTUP_DONE;
+        BOOT_Mark(BOOT_STAGE_PLL);
+        return startup;
+    }
+
+    // Тики идут с запуска планировщика, до него опрос не нужен
+    if (xTaskGetTickCount() >= pdMS_TO_TICKS(CLK_STARTUP_TIMEOUT_MS))
+    {
+        RST_CLK_CPU_PLLcmd(DISABLE);
+        RST_CLK_HSEconfig(RST_CLK_HSE_OFF);
+        startup = CLK_STARTUP_FAILED;
+    }
+    return startup;
+}
+
+uint32_t CLK_GetTimeUs(void)
+{
+    return (uint32_t)UPTIME_GetUs();
+}
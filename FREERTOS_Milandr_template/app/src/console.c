@@ -0,0 +1,445 @@
+#include "console.h"
+#include "semphr.h"
+#include <stdio.h>
+#include <errno.h>
+#include <newlib.h>
+#include <reent.h>
+#include <sys/lock.h>
+
+#if (CONSOLE_TX_SIZE & (CONSOLE_TX_SIZE - 1)) != 0 || (CONSOLE_RX_SIZE & (CONSOLE_RX_SIZE - 1)) != 0
+#error "console.c: CONSOLE_TX_SIZE и CONSOLE_RX_SIZE - степени двойки"
+#endif
+#ifndef _RETARGETABLE_LOCKING
+#error "console.c: newlib собран без --enable-newlib-retargetable-locking"
+#endif
+#if configNUM_THREAD_LOCAL_STORAGE_POINTERS <= CONSOLE_TLS_INDEX
+#error "console.c: нужна ячейка CONSOLE_TLS_INDEX (FreeRTOSConfig.h)"
+#endif
+
+#if CONSOLE_UART == 1
+#define CONSOLE_UARTx          MDR_UART1
+#define CONSOLE_IRQn           UART1_IRQn
+#define CONSOLE_IRQHandler     UART1_IRQHandler
+#define CONSOLE_DMA_CHANNEL    DMA_Channel_UART1_TX
+#else
+#define CONSOLE_UARTx          MDR_UART2
+#define CONSOLE_IRQn           UART2_IRQn
+#define CONSOLE_IRQHandler     UART2_IRQHandler
+#define CONSOLE_DMA_CHANNEL    DMA_Channel_UART2_TX
+#endif
+
+#define CONSOLE_DMA_MAX  1024 // передач за цикл DMA
+#define CONSOLE_CHUNK    32   // байт за одну критическую секцию
+
+static struct
+{
+    uint8_t buffer[CONSOLE_TX_SIZE];
+    uint32_t head;          // пишут _write под критической секцией
+    volatile uint32_t tail; // двигает завершение DMA
+    uint32_t sending;       // байт в текущем цикле DMA, 0 - канал стоит
+    uint32_t dropped;
+    TaskHandle_t waiter;    // ждет места в кольце
+    SemaphoreHandle_t mutex; // один ждущий писатель из задач
+} tx;
+
+static struct
+{
+    uint8_t buffer[CONSOLE_RX_SIZE];
+    volatile uint32_t head; // пишет прерывание UART
+    uint32_t tail;
+    uint32_t dropped;
+    TaskHandle_t waiter;
+} rx;
+
+static int32_t channel = -1;
+
+static BaseType_t CONSOLE_CanWait(void)
+{
+    return __get_IPSR() == 0 && xTaskGetSchedulerState() == taskSCHEDULER_RUNNING;
+}
+
+// Передача: непрерывный кусок кольца от tail (как в log.c)
+static void CONSOLE_Kick(void)
+{
+    UBaseType_t mask;
+    uint32_t first, size;
+    DMA_CtrlDataTypeDef *ctrl;
+
+    mask = taskENTER_CRITICAL_FROM_ISR();
+    size = tx.head - tx.tail;
+    if (tx.sending != 0 || size == 0 || channel < 0)
+    {
+        taskEXIT_CRITICAL_FROM_ISR(mask);
+        return;
+    }
+    first = tx.tail & (CONSOLE_TX_SIZE - 1);
+    if (size > CONSOLE_TX_SIZE - first)
+    {
+        size = CONSOLE_TX_SIZE - first;
+    }
+    if (size > CONSOLE_DMA_MAX)
+    {
+        size = CONSOLE_DMA_MAX;
+    }
+    tx.sending = size;
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+
+    ctrl = DMAM_Control(channel, DMA_CTRL_DATA_PRIMARY);
+    ctrl->DMA_SourceEndAddr = (uint32_t)&tx.buffer[first + size - 1];
+    ctrl->DMA_DestEndAddr = (uint32_t)&CONSOLE_UARTx->DR;
+    ctrl->DMA_Control = ((uint32_t)DMA_DestIncNo << 30) | ((uint32_t)DMA_SourceIncByte << 26) | DMA_MemoryDataSize_Byte |
+                        DMA_Transfers_1 | ((size - 1) << 4) | DMA_Mode_Basic;
+    DMAM_Start(channel);
+}
+
+static BaseType_t CONSOLE_DmaDone(uint32_t ch, void *arg)
+{
+    BaseType_t woken = pdFALSE;
+    TaskHandle_t waiter;
+
+    (void)ch;
+    (void)arg;
+    tx.tail += tx.sending;
+    tx.sending = 0;
+    CONSOLE_Kick();
+
+    waiter = tx.waiter;
+    if (waiter != NULL)
+    {
+        vTaskNotifyGiveIndexedFromISR(waiter, CONSOLE_NOTIFY_INDEX, &woken);
+    }
+    return woken;
+}
+
+// Сколько байт поместилось, без ожидания
+static uint32_t CONSOLE_Put(const uint8_t *data, uint32_t size)
+{
+    UBaseType_t mask;
+    uint32_t done = 0;
+
+    while (done < size)
+    {
+        uint32_t n = size - done;
+        uint32_t free;
+
+        if (n > CONSOLE_CHUNK)
+        {
+            n = CONSOLE_CHUNK;
+        }
+        mask = taskENTER_CRITICAL_FROM_ISR();
+        free = CONSOLE_TX_SIZE - (tx.head - tx.tail);
+        if (n > free)
+        {
+            n = free;
+        }
+        for (uint32_t i = 0; i < n; i++)
+        {
+            tx.buffer[(tx.head + i) & (CONSOLE_TX_SIZE - 1)] = data[done + i];
+        }
+        tx.head += n;
+        taskEXIT_CRITICAL_FROM_ISR(mask);
+
+        if (n == 0)
+        {
+            break;
+        }
+        done += n;
+    }
+    CONSOLE_Kick();
+    return done;
+}
+
+int _write(int file, char *ptr, int len)
+{
+    const uint8_t *data = (const uint8_t *)ptr;
+    uint32_t done;
+
+    if (file != 1 && file != 2)
+    {
+        errno = EBADF;
+        return -1;
+    }
+
+    if (!CONSOLE_CanWait() || tx.mutex == NULL)
+    {
+        done = CONSOLE_Put(data, len);
+        tx.dropped += len - done;
+        return len;
+    }
+
+    xSemaphoreTake(tx.mutex, portMAX_DELAY);
+    tx.waiter = xTaskGetCurrentTaskHandle();
+    done = 0;
+    for (;;)
+    {
+        done += CONSOLE_Put(data + done, len - done);
+        if (done == (uint32_t)len)
+        {
+            break;
+        }
+        // Место освобождает завершение цикла DMA
+        ulTaskNotifyTakeIndexed(CONSOLE_NOTIFY_INDEX, pdTRUE, portMAX_DELAY);
+    }
+    tx.waiter = NULL;
+    xSemaphoreGive(tx.mutex);
+    return len;
+}
+
+int _read(int file, char *ptr, int len)
+{
+    int count = 0;
+
+    if (file != 0)
+    {
+        errno = EBADF;
+        return -1;
+    }
+
+    rx.waiter = xTaskGetCurrentTaskHandle();
+    while (rx.head == rx.tail)
+    {
+        if (!CONSOLE_CanWait())
+        {
+            rx.waiter = NULL;
+            return 0;
+        }
+        ulTaskNotifyTakeIndexed(CONSOLE_NOTIFY_INDEX, pdTRUE, portMAX_DELAY);
+    }
+    rx.waiter = NULL;
+
+    while (count < len && rx.head != rx.tail)
+    {
+        ptr[count++] = rx.buffer[rx.tail & (CONSOLE_RX_SIZE - 1)];
+        rx.tail++;
+    }
+    return count;
+}
+
+void CONSOLE_IRQHandler(void)
+{
+    BaseType_t woken = pdFALSE;
+    uint32_t head = rx.head;
+
+    while (UART_GetFlagStatus_Inline(CONSOLE_UARTx, UART_FLAG_RXFE) == RESET)
+    {
+        uint8_t byte = (uint8_t)UART_ReceiveData_Inline(CONSOLE_UARTx);
+
+        if (head - rx.tail < CONSOLE_RX_SIZE)
+        {
+            rx.buffer[head & (CONSOLE_RX_SIZE - 1)] = byte;
+            head++;
+        }
+        else
+        {
+            rx.dropped++;
+        }
+    }
+    CONSOLE_UARTx->ICR = UART_ICR_RXIC | UART_ICR_RTIC;
+    rx.head = head;
+
+    if (rx.waiter != NULL)
+    {
+        vTaskNotifyGiveIndexedFromISR(rx.waiter, CONSOLE_NOTIFY_INDEX, &woken);
+    }
+    portYIELD_FROM_ISR(woken);
+}
+
+// Бодрейт считается от HCLK: на смене частоты передача встает на паузу
+static void CONSOLE_ClockChanged(CLK_Event_t event, uint32_t hz)
+{
+    CLK_UARTRetune(CONSOLE_UARTx, event, hz);
+}
+
+void CONSOLE_Init(void)
+{
+    static char line[CONSOLE_LINE_SIZE];
+
+    tx.mutex = xSemaphoreCreateMutex();
+    configASSERT(tx.mutex != NULL);
+
+    channel = DMAM_Alloc(CONSOLE_DMA_CHANNEL, CONSOLE_DmaDone, NULL);
+    configASSERT(channel >= 0);
+
+    CONSOLE_UARTx->DMACR |= UART_DMA_TXE;
+    CONSOLE_UARTx->IMSC |= UART_IMSC_RXIM | UART_IMSC_RTIM;
+    CONSOLE_UARTx->CR |= UART_CR_UARTEN | UART_CR_TXE | UART_CR_RXE;
+    NVIC_SetPriority(CONSOLE_IRQn, CONSOLE_IRQ_PRIORITY);
+    NVIC_EnableIRQ(CONSOLE_IRQn);
+    CLK_AddNotifier(CONSOLE_ClockChanged);
+
+    // Общий _reent: строчная буферизация без malloc
+    setvbuf(stdout, line, _IOLBF, sizeof(line));
+}
+
+uint32_t CONSOLE_GetDropped(void)
+{
+    return tx.dropped;
+}
+
+// _reent задачи
+
+void CONSOLE_SwitchedIn(void *reent)
+{
+    _impure_ptr = reent != NULL ? reent : _global_impure_ptr;
+}
+
+void CONSOLE_AttachTask(void)
+{
+    struct _reent *reent = pvPortMalloc(sizeof(struct _reent));
+
+    configASSERT(reent != NULL);
+    _REENT_INIT_PTR(reent);
+    taskENTER_CRITICAL();
+    vTaskSetThreadLocalStoragePointer(NULL, CONSOLE_TLS_INDEX, reent);
+    _impure_ptr = reent;
+    taskEXIT_CRITICAL();
+
+    // Буфер stdout задачи - из общей кучи (heap.h) при первом выводе
+    setvbuf(stdout, NULL, _IOLBF, CONSOLE_LINE_SIZE);
+}
+
+void CONSOLE_DetachTask(void)
+{
+    struct _reent *reent = pvTaskGetThreadLocalStoragePointer(NULL, CONSOLE_TLS_INDEX);
+
+    if (reent == NULL)
+    {
+        return;
+    }
+    fflush(stdout);
+    _reclaim_reent(reent);
+    taskENTER_CRITICAL();
+    vTaskSetThreadLocalStoragePointer(NULL, CONSOLE_TLS_INDEX, NULL);
+    _impure_ptr = _global_impure_ptr;
+    taskEXIT_CRITICAL();
+    vPortFree(reent);
+}
+
+// Блокировки newlib. Статические (malloc, sfp, env...) держатся коротко и без ожидания -
+// остановка планировщика, вложенная сама по себе. Блокировки FILE держатся и на время
+// _write, которая может ждать DMA, - рекурсивные мьютексы, создаются при открытии потока.
+
+struct __lock
+{
+    SemaphoreHandle_t mutex; // NULL - статическая блокировка
+};
+
+struct __lock __lock___sinit_recursive_mutex;
+struct __lock __lock___sfp_recursive_mutex;
+struct __lock __lock___atexit_recursive_mutex;
+struct __lock __lock___at_quick_exit_mutex;
+struct __lock __lock___malloc_recursive_mutex;
+struct __lock __lock___env_recursive_mutex;
+struct __lock __lock___tz_mutex;
+struct __lock __lock___dd_hash_mutex;
+struct __lock __lock___arc4random_mutex;
+
+static void CONSOLE_LockCreate(_LOCK_T *lock, BaseType_t recursive)
+{
+    struct __lock *created = pvPortMalloc(sizeof(struct __lock));
+
+    configASSERT(created != NULL);
+    created->mutex = recursive ? xSemaphoreCreateRecursiveMutex() : xSemaphoreCreateMutex();
+    configASSERT(created->mutex != NULL);
+    *lock = created;
+}
+
+static void CONSOLE_LockDelete(_LOCK_T lock)
+{
+    vSemaphoreDelete(lock->mutex);
+    vPortFree(lock);
+}
+
+static BaseType_t CONSOLE_LockTake(_LOCK_T lock, BaseType_t recursive, TickType_t ticks)
+{
+    // До планировщика поток один, из прерываний ждать нельзя
+    if (__get_IPSR() != 0 || xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED)
+    {
+        return pdTRUE;
+    }
+    if (lock->mutex == NULL)
+    {
+        vTaskSuspendAll();
+        return pdTRUE;
+    }
+    if (xTaskGetSchedulerState() == taskSCHEDULER_SUSPENDED)
+    {
+        return pdTRUE;
+    }
+    return recursive ? xSemaphoreTakeRecursive(lock->mutex, ticks) : xSemaphoreTake(lock->mutex, ticks);
+}
+
+static void CONSOLE_LockGive(_LOCK_T lock, BaseType_t recursive)
+{
+    if (__get_IPSR() != 0 || xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED)
+    {
+        return;
+    }
+    if (lock->mutex == NULL)
+    {
+        xTaskResumeAll();
+        return;
+    }
+    if (xTaskGetSchedulerState() == taskSCHEDULER_SUSPENDED)
+    {
+        return;
+    }
+    if (recursive)
+    {
+        xSemaphoreGiveRecursive(lock->mutex);
+    }
+    else
+    {
+        xSemaphoreGive(lock->mutex);
+    }
+}
+
+void __retarget_lock_init(_LOCK_T *lock)
+{
+    CONSOLE_LockCreate(lock, pdFALSE);
+}
+
+void __retarget_lock_init_recursive(_LOCK_T *lock)
+{
+    CONSOLE_LockCreate(lock, pdTRUE);
+}
+
+void __retarget_lock_close(_LOCK_T lock)
+{
+    CONSOLE_LockDelete(lock);
+}
+
+void __retarget_lock_close_recursive(_LOCK_T lock)
+{
+    CONSOLE_LockDelete(lock);
+}
+
+void __retarget_lock_acquire(_LOCK_T lock)
+{
+    CONSOLE_LockTake(lock, pdFALSE, portMAX_DELAY);
+}
+
+void __retarget_lock_acquire_recursive(_LOCK_T lock)
+{
+    CONSOLE_LockTake(lock, pdTRUE, portMAX_DELAY);
+}
+
+int __retarget_lock_try_acquire(_LOCK_T lock)
+{
+    return CONSOLE_LockTake(lock, pdFALSE, 0);
+}
+
+int __retarget_lock_try_acquire_recursive(_LOCK_T lock)
+{
+    return CONSOLE_LockTake(lock, pdTRUE, 0);
+}
+
+void __retarget_lock_release(_LOCK_T lock)
+{
+    CONSOLE_LockGive(lock, pdFALSE);
+}
+
+void __retarget_lock_release_recursive(_LOCK_T lock)
+{
+    CONSOLE_LockGive(lock, pdTRUE);
+}
@@ -0,0 +1,176 @@
+#include "dfs.h"
+
+// Размер стека из статического анализа (cmake -DSTACK_USAGE=ON, DFS_Task в
+// STACK_USAGE_TASKS), иначе DFS_STACK_SIZE
+#if defined(STACK_USAGE_ENABLED) && !defined(STACK_USAGE_ANALYSIS)
+#include "stack_sizes.h"
+#endif
+#ifndef STACK_SIZE_DFS_Task
+#define STACK_SIZE_DFS_Task DFS_STACK_SIZE
+#endif
+
+static const uint32_t levels[] = {DFS_LEVELS};
+#define DFS_LEVELS_COUNT (sizeof(levels) / sizeof(levels[0]))
+
+#if configTASK_NOTIFICATION_ARRAY_ENTRIES <= DFS_NOTIFY_INDEX
+#error "dfs.c: нужна ячейка DFS_NOTIFY_INDEX (FreeRTOSConfig.h)"
+#endif
+
+static volatile uint32_t load;
+static uint16_t holds[DFS_LEVELS_COUNT]; // удержаний на уровень, меняются под BASEPRI
+static TaskHandle_t governor;            // ядро на PLL, губернатор поднимает частоту по DFS_Hold
+
+static uint32_t DFS_Level(uint32_t hz)
+{
+    uint32_t i = 0;
+
+    while (i < DFS_LEVELS_COUNT - 1 && levels[i] < hz)
+    {
+        i++;
+    }
+    configASSERT(levels[i] >= hz);
+    return i;
+}
+
+uint32_t DFS_GetFloor(void)
+{
+    uint32_t i = DFS_LEVELS_COUNT - 1;
+
+    while (i > 0 && holds[i] == 0)
+    {
+        i--;
+    }
+    return levels[i];
+}
+
+void DFS_Hold(uint32_t hz)
+{
+    UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+    BaseType_t woken = pdFALSE;
+    uint32_t i = DFS_Level(hz);
+
+    configASSERT(holds[i] != UINT16_MAX);
+    holds[i]++;
+    if (SystemCoreClock < levels[i] && governor != NULL)
+    {
+        vTaskNotifyGiveIndexedFromISR(governor, DFS_NOTIFY_INDEX, &woken);
+    }
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+    // Под маской PendSV дождется ее снятия
+    portYIELD_FROM_ISR(woken);
+}
+
+void DFS_Release(uint32_t hz)
+{
+    UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+    uint32_t i = DFS_Level(hz);
+
+    configASSERT(holds[i] != 0);
+    holds[i]--;
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+static uint32_t DFS_Select(uint32_t hz, uint32_t busy)
+{
+    if (busy >= DFS_UP_LOAD)
+    {
+        return levels[DFS_LEVELS_COUNT - 1];
+    }
+
+    // Сколько тактов в секунду реально занято и сколько нужно, чтобы это было DFS_TARGET_LOAD %
+    uint32_t needed = (hz / 100) * busy / DFS_TARGET_LOAD * 100;
+    for (uint32_t i = 0; i < DFS_LEVELS_COUNT; i++)
+    {
+        if (levels[i] >= needed)
+        {
+            return levels[i];
+        }
+    }
+    return levels[DFS_LEVELS_COUNT - 1];
+}
+
+// Частота hz, но не ниже границы
+static void DFS_Apply(uint32_t hz)
+{
+    for (;;)
+    {
+        uint32_t floor = DFS_GetFloor();
+
+        if (hz < floor)
+        {
+            hz = floor;
+        }
+        if (hz == SystemCoreClock || CLK_SetFrequency(hz) == ERROR)
+        {
+            // ERROR - PLL не захватился и ядро на HSE, через период попробуем снова
+            // (или уровень не собирается из HSE - ошибка DFS_LEVELS)
+            return;
+        }
+        // DFS_Hold во время смены видел старую частоту и губернатор не будил
+        hz = SystemCoreClock;
+    }
+}
+
+static void DFS_Task(void *pvParameters)
+{
+    (void) pvParameters;
+    uint32_t lastTime, lastIdle, now, idle;
+    CLK_Startup_t startup;
+
+    // После быстрого старта первым делом переводим ядро на PLL, раз в тик - губернатор
+    // старше рабочих задач и переключит частоту не позже чем через тик после захвата PLL
+    while ((startup = CLK_PollStartup()) == CLK_STARTUP_BUSY)
+    {
+        vTaskDelay(1);
+    }
+    if (startup == CLK_STARTUP_FAILED)
+    {
+        // Без HSE частоту менять не из чего
+        vTaskDelete(NULL);
+    }
+    governor = xTaskGetCurrentTaskHandle();
+    DFS_Apply(SystemCoreClock); // удержания, взятые до PLL
+
+    taskENTER_CRITICAL();
+    lastTime = CLK_GetTimeUs();
+    taskEXIT_CRITICAL();
+    lastIdle = ulTaskGetIdleRunTimeCounter();
+
+    for (;;)
+    {
+        if (ulTaskNotifyTakeIndexed(DFS_NOTIFY_INDEX, pdTRUE, pdMS_TO_TICKS(DFS_PERIOD_MS)) != 0)
+        {
+            // Подняли нижнюю границу. Загрузка - по полному периоду, он продолжается
+            DFS_Apply(SystemCoreClock);
+            continue;
+        }
+
+        taskENTER_CRITICAL();
+        now = CLK_GetTimeUs();
+        taskEXIT_CRITICAL();
+        idle = ulTaskGetIdleRunTimeCounter();
+
+        uint32_t total = now - lastTime;
+        uint32_t idleDelta = idle - lastIdle;
+        lastTime = now;
+        lastIdle = idle;
+        if (total == 0 || idleDelta > total)
+        {
+            continue;
+        }
+        load = 100 - idleDelta * 100 / total;
+
+        DFS_Apply(DFS_Select(SystemCoreClock, load));
+    }
+}
+
+void DFS_Start(UBaseType_t priority)
+{
+    // Приоритет выше рабочих задач, иначе под нагрузкой губернатор не успеет поднять частоту
+    xTaskCreate(DFS_Task, "dfs", STACK_SIZE_DFS_Task, NULL, priority, NULL);
+}
+
+uint32_t DFS_GetLoad(void)
+{
+    return load;
+}
@@ -0,0 +1,337 @@
+#include "dma.h"
+#include <string.h>
+
+#if (DMA_AlternateData != 1) || (DMA_Channels_Number != 32)
+#error "dma.c: нужны все 32 канала и альтернативные структуры (MDR32FxQI_config.h)"
+#endif
+
+#define DMAM_CHANNELS       32
+#define DMAM_SW_CHANNELS    (0xFFFFFFFFUL << DMA_Channel_SW1)
+#define DMAM_CYCLE_CTRL_Msk 0x7UL // режим в слове управления, 0 - Stop
+#define DMAM_MAX_TRANSFERS  1024  // n_minus_1 - 10 бит
+#define DMAM_RAM_SIZE       (32 * 1024)
+
+// Основные структуры каналов 0..31, за ними альтернативные (ALT_CTRL_BASE_PTR = база + 0x200).
+// Контроллер требует выравнивания базы на размер таблицы - первой в области .dma сразу
+// за стеком, без дыры (MDR32F9Q2I.ld). Область не обнуляется, обнуляет DMAM_Init
+DMA_CtrlDataTypeDef DMA_ControlTable[(32 * DMA_AlternateData) + DMA_Channels_Number]
+    __attribute__((section(".dma.table"), aligned(1024)));
+
+static struct
+{
+    DMAM_Callback_t callback;
+    void *arg;
+} channels[DMAM_CHANNELS];
+
+static uint32_t allocated;         // занятые каналы
+static volatile uint32_t armed;    // запущены и ждут завершения цикла
+static volatile uint32_t pingPong; // запущены в режиме ping-pong
+static volatile uint32_t failed;   // цикл прерван ошибкой шины, до следующего DMAM_Start
+
+void DMAM_Init(void)
+{
+    RST_CLK_PCLKcmd(RST_CLK_PCLK_DMA, ENABLE);
+
+    MDR_DMA->CFG = 0;
+    // Запросы периферии пропускаются только у запущенных каналов: запрос SSP/UART
+    // на выключенном канале иначе тоже поднимает DMA_IRQ
+    MDR_DMA->CHNL_REQ_MASK_SET = 0xFFFFFFFF;
+    MDR_DMA->CHNL_ENABLE_CLR = 0xFFFFFFFF;
+    MDR_DMA->CHNL_USEBURST_CLR = 0xFFFFFFFF;
+    MDR_DMA->CHNL_PRI_ALT_CLR = 0xFFFFFFFF;
+    MDR_DMA->CHNL_PRIORITY_CLR = 0xFFFFFFFF;
+    MDR_DMA->ERR_CLR = 1;
+    memset(DMA_ControlTable, 0, sizeof(DMA_ControlTable));
+    MDR_DMA->CTRL_BASE_PTR = (uint32_t)DMA_ControlTable;
+    MDR_DMA->CFG = DMA_CFG_MASTER_ENABLE;
+
+    NVIC_ClearPendingIRQ(DMA_IRQn);
+    NVIC_SetPriority(DMA_IRQn, DMAM_IRQ_PRIORITY);
+    NVIC_EnableIRQ(DMA_IRQn);
+}
+
+int32_t DMAM_Alloc(int32_t channel, DMAM_Callback_t callback, void *arg)
+{
+    uint32_t free;
+
+    configASSERT(channel == DMAM_ANY || (channel >= 0 && channel < DMAM_CHANNELS));
+
+    taskENTER_CRITICAL();
+    free = ~allocated & (channel == DMAM_ANY ? DMAM_SW_CHANNELS : 1UL << channel);
+    if (free != 0)
+    {
+        channel = __CLZ(__RBIT(free)); // младший свободный
+        channels[channel].callback = callback;
+        channels[channel].arg = arg;
+        allocated |= 1UL << channel;
+    }
+    else
+    {
+        channel = -1;
+    }
+    taskEXIT_CRITICAL();
+
+    return channel;
+}
+
+DMA_CtrlDataTypeDef *DMAM_Control(uint32_t channel, DMA_Data_Struct_Selection select)
+{
+    return &DMA_ControlTable[channel + (select == DMA_CTRL_DATA_ALTERNATE ? DMAM_CHANNELS : 0)];
+}
+
+// Из задачи и из обработчика канала
+void DMAM_Start(uint32_t channel)
+{
+    uint32_t bit = 1UL << channel;
+    uint32_t mode = DMA_ControlTable[channel].DMA_Control & DMAM_CYCLE_CTRL_Msk;
+    UBaseType_t mask;
+
+    mask = taskENTER_CRITICAL_FROM_ISR();
+    if (mode == DMA_Mode_PingPong)
+    {
+        pingPong |= bit;
+    }
+    else
+    {
+        pingPong &= ~bit;
+    }
+    armed |= bit;
+    failed &= ~bit;
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+
+    __DMB(); // структура в ОЗУ записана раньше, чем контроллер ее прочитает
+    MDR_DMA->CHNL_PRI_ALT_CLR = bit;
+    MDR_DMA->CHNL_ENABLE_SET = bit;
+    MDR_DMA->CHNL_REQ_MASK_CLR = bit;
+}
+
+void DMAM_Stop(uint32_t channel)
+{
+    uint32_t bit = 1UL << channel;
+    UBaseType_t mask;
+
+    MDR_DMA->CHNL_REQ_MASK_SET = bit;
+    MDR_DMA->CHNL_ENABLE_CLR = bit;
+
+    mask = taskENTER_CRITICAL_FROM_ISR();
+    armed &= ~bit;
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+void DMAM_Free(uint32_t channel)
+{
+    UBaseType_t mask;
+
+    DMAM_Stop(channel);
+
+    mask = taskENTER_CRITICAL_FROM_ISR();
+    allocated &= ~(1UL << channel);
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+BaseType_t DMAM_Failed(uint32_t channel)
+{
+    return (failed & (1UL << channel)) != 0;
+}
+
+static BaseType_t DMAM_Stopped(uint32_t index)
+{
+    return (DMA_ControlTable[index].DMA_Control & DMAM_CYCLE_CTRL_Msk) == DMA_Mode_Stop;
+}
+
+void DMA_IRQHandler(void)
+{
+    BaseType_t woken = pdFALSE;
+    uint32_t enabled = MDR_DMA->CHNL_ENABLE_SET;
+    uint32_t pending = armed;
+    BaseType_t error = (MDR_DMA->ERR_CLR & 1) != 0;
+
+    if (error)
+    {
+        MDR_DMA->ERR_CLR = 1;
+    }
+
+    while (pending != 0)
+    {
+        uint32_t channel = 31 - __CLZ(pending);
+        uint32_t bit = 1UL << channel;
+        BaseType_t done;
+
+        pending &= ~bit;
+        // Ошибка шины: контроллер снимает разрешение канала, не дойдя до Stop, флаг один на
+        // все каналы. Канал - выключенный, у которого ни одна структура не в Stop
+        if (error && (enabled & bit) == 0 && !DMAM_Stopped(channel) &&
+            (!(pingPong & bit) || !DMAM_Stopped(channel + DMAM_CHANNELS)))
+        {
+            armed &= ~bit;
+            failed |= bit;
+            MDR_DMA->CHNL_REQ_MASK_SET = bit;
+            done = pdTRUE;
+        }
+        else if (pingPong & bit)
+        {
+            done = DMAM_Stopped(channel) || DMAM_Stopped(channel + DMAM_CHANNELS);
+        }
+        else
+        {
+            // Цикл закончен - контроллер сам снимает разрешение канала
+            done = (enabled & bit) == 0;
+            if (done)
+            {
+                armed &= ~bit;
+                MDR_DMA->CHNL_REQ_MASK_SET = bit;
+            }
+        }
+
+        if (done && channels[channel].callback != NULL)
+        {
+            woken |= channels[channel].callback(channel, channels[channel].arg);
+        }
+    }
+
+    portYIELD_FROM_ISR(woken);
+}
+
+// Копирование и заполнение. Порция - до 1024 передач auto-request, следующая запускается
+// из прерывания завершения предыдущей.
+
+static BaseType_t DMAM_JobDone(uint32_t channel, void *arg);
+
+static void DMAM_JobChunk(DMAM_Job_t *job, uint32_t channel)
+{
+    DMA_CtrlDataTypeDef *ctrl = &DMA_ControlTable[channel];
+    uint32_t shift = job->unit >> 1; // 1, 2, 4 байта -> 0, 1, 2 (DMA_DestIncByte/Halfword/Word)
+    uint32_t count = job->left >> shift;
+    uint32_t sourceInc = shift;
+
+    if (count > DMAM_MAX_TRANSFERS)
+    {
+        count = DMAM_MAX_TRANSFERS;
+    }
+    job->chunk = count << shift;
+
+    // Контроллеру нужны адреса последней передачи, а не начала
+    ctrl->DMA_DestEndAddr = (uint32_t)job->dst + job->chunk - job->unit;
+    if (job->src != NULL)
+    {
+        ctrl->DMA_SourceEndAddr = (uint32_t)job->src + job->chunk - job->unit;
+    }
+    else
+    {
+        ctrl->DMA_SourceEndAddr = (uint32_t)&job->pattern;
+        sourceInc = DMA_SourceIncNo;
+    }
+    ctrl->DMA_Control = (shift << 30) | (sourceInc << 26) | ((shift * 0x11) << 24) |
+                        DMAM_ARBITRATION | ((count - 1) << 4) | DMA_Mode_AutoRequest;
+
+    DMAM_Start(channel);
+    MDR_DMA->CHNL_SW_REQUEST = 1UL << channel;
+}
+
+static BaseType_t DMAM_JobDone(uint32_t channel, void *arg)
+{
+    DMAM_Job_t *job = arg;
+    BaseType_t woken = pdFALSE;
+
+    if (DMAM_Failed(channel))
+    {
+        job->error = pdTRUE;
+        job->left = job->chunk; // дальше не копируем
+    }
+    job->dst += job->chunk;
+    if (job->src != NULL)
+    {
+        job->src += job->chunk;
+    }
+    job->left -= job->chunk;
+
+    if (job->left != 0)
+    {
+        DMAM_JobChunk(job, channel);
+        return pdFALSE;
+    }
+
+    DMAM_Free(channel);
+    job->busy = pdFALSE;
+    if (job->waiter != NULL)
+    {
+        vTaskNotifyGiveIndexedFromISR(job->waiter, DMAM_NOTIFY_INDEX, &woken);
+    }
+    return woken;
+}
+
+static BaseType_t DMAM_IsRam(const void *address, uint32_t size)
+{
+    return (uint32_t)address >= RAM_AHB_BASE && (uint32_t)address - RAM_AHB_BASE + size <= DMAM_RAM_SIZE;
+}
+
+static void DMAM_JobStart(DMAM_Job_t *job, void *dst, const void *src, uint8_t value, uint32_t size)
+{
+    int32_t channel = -1;
+    uint32_t align = (uint32_t)dst | (uint32_t)src | size;
+
+    job->dst = dst;
+    job->src = src;
+    job->left = size;
+    job->pattern = value * 0x01010101UL;
+    job->unit = (align & 1) ? 1 : (align & 2) ? 2 : 4;
+    job->waiter = xTaskGetCurrentTaskHandle();
+    job->error = pdFALSE;
+    job->busy = pdTRUE;
+
+    if (size >= (src != NULL ? DMAM_MIN_SIZE : DMAM_MIN_FILL) && DMAM_IsRam(dst, size) && (src == NULL || DMAM_IsRam(src, size)))
+    {
+        channel = DMAM_Alloc(DMAM_ANY, DMAM_JobDone, job);
+    }
+
+    if (channel < 0)
+    {
+        // Короткий блок, FLASH или все программные каналы заняты
+        if (src != NULL)
+        {
+            memcpy(dst, src, size);
+        }
+        else
+        {
+            memset(dst, value, size);
+        }
+        job->channel = -1;
+        job->busy = pdFALSE;
+        return;
+    }
+
+    job->channel = channel;
+    DMAM_JobChunk(job, channel);
+}
+
+void DMAM_Memcpy(DMAM_Job_t *job, void *dst, const void *src, uint32_t size)
+{
+    DMAM_JobStart(job, dst, src, 0, size);
+}
+
+void DMAM_Memset(DMAM_Job_t *job, void *dst, uint8_t value, uint32_t size)
+{
+    DMAM_JobStart(job, dst, NULL, value, size);
+}
+
+BaseType_t DMAM_Wait(DMAM_Job_t *job, TickType_t ticks)
+{
+    // Уведомление могло остаться от другой передачи этой же задачи - проверяем busy
+    while (job->busy)
+    {
+        if (ulTaskNotifyTakeIndexed(DMAM_NOTIFY_INDEX, pdTRUE, ticks) == 0)
+        {
+            // Время вышло, а канал еще пишет в dst: останавливаем, пока буферы у вызывающего.
+            // Завершение, пришедшее раньше секции, остается завершением
+            taskENTER_CRITICAL();
+            if (job->busy)
+            {
+                DMAM_Free((uint32_t)job->channel);
+                job->error = pdTRUE;
+                job->busy = pdFALSE;
+            }
+            taskEXIT_CRITICAL();
+        }
+    }
+    return job->error ? pdFALSE : pdTRUE;
+}
@@ -0,0 +1,324 @@
+#include "flash.h"
+#include "MDR32FxQI_utils.h"
+
+#define FLASH_KEY     ((uint32_t)0x8AAA5551) // EEPROM_REG_ACCESS_KEY, в SPL объявлен внутри .c
+#define FLASH_SECTORS 4                      // страница чередуется по 4 секторам, биты 2-3 адреса
+#define FLASH_VECTORS (16 + 32)              // системные исключения + прерывания K1986VE9x
+#define FLASH_BASEPRI (FLASH_CRITICAL_PRIORITY << (8 - configPRIO_BITS))
+
+// Копия таблицы векторов. VTOR требует выравнивания на степень двойки не меньше размера таблицы
+static uint32_t ramVectors[FLASH_VECTORS] __attribute__((aligned(256)));
+
+// Задержки в итерациях DELAY_PROGRAM_WaitLoopsAsm, считаются перед каждым квантом:
+// частоту могли сменить (CLK_SetFrequency), а в ОЗУ-коде нельзя звать __aeabi_uidiv из FLASH
+typedef struct
+{
+    uint32_t nvs, pgs, prog, nvh, rcv, erase, hv;
+} FLASH_Loops_t;
+
+static struct
+{
+    uint32_t address;
+    const uint32_t *data; // NULL - стирание
+    uint32_t total;       // слов или секторов
+    volatile uint32_t step;
+    TaskHandle_t waiter;
+} job;
+
+// Кванты. Исполняются из ОЗУ с замаскированными прерываниями FLASH_CRITICAL_PRIORITY и ниже,
+// последовательности команд повторяют EEPROM_ErasePage/EEPROM_ProgramWord из SPL.
+
+__RAMFUNC static void FLASH_EraseSector(uint32_t address, const FLASH_Loops_t *loops, uint32_t last)
+{
+    uint32_t command;
+
+    MDR_EEPROM->KEY = FLASH_KEY;
+    command = (MDR_EEPROM->CMD & EEPROM_CMD_DELAY_Msk) | EEPROM_CMD_CON;
+    MDR_EEPROM->CMD = command;
+
+    MDR_EEPROM->ADR = address;
+    MDR_EEPROM->DI = 0;
+    command |= EEPROM_CMD_XE | EEPROM_CMD_ERASE;
+    MDR_EEPROM->CMD = command;
+    DELAY_PROGRAM_WaitLoopsAsm(loops->nvs);
+    command |= EEPROM_CMD_NVSTR;
+    MDR_EEPROM->CMD = command;
+    DELAY_PROGRAM_WaitLoopsAsm(loops->erase);
+    command &= ~EEPROM_CMD_ERASE;
+    MDR_EEPROM->CMD = command;
+    DELAY_PROGRAM_WaitLoopsAsm(loops->nvh);
+    command &= ~(EEPROM_CMD_XE | EEPROM_CMD_NVSTR);
+    MDR_EEPROM->CMD = command;
+    DELAY_PROGRAM_WaitLoopsAsm(loops->rcv);
+
+    MDR_EEPROM->CMD = command & EEPROM_CMD_DELAY_Msk;
+    MDR_EEPROM->KEY = 0;
+
+    if (last)
+    {
+        DELAY_PROGRAM_WaitLoopsAsm(loops->hv);
+    }
+}
+
+__RAMFUNC static void FLASH_ProgramWords(uint32_t address, const uint32_t *data, uint32_t words, const FLASH_Loops_t *loops)
+{
+    uint32_t command;
+
+    MDR_EEPROM->KEY = FLASH_KEY;
+    command = (MDR_EEPROM->CMD & EEPROM_CMD_DELAY_Msk) | EEPROM_CMD_CON;
+    MDR_EEPROM->CMD = command;
+
+    for (uint32_t i = 0; i < words; i++)
+    {
+        MDR_EEPROM->ADR = address;
+        MDR_EEPROM->DI = data[i];
+        command |= EEPROM_CMD_XE | EEPROM_CMD_PROG;
+        MDR_EEPROM->CMD = command;
+        DELAY_PROGRAM_WaitLoopsAsm(loops->nvs);
+        command |= EEPROM_CMD_NVSTR;
+        MDR_EEPROM->CMD = command;
+        DELAY_PROGRAM_WaitLoopsAsm(loops->pgs);
+        command |= EEPROM_CMD_YE;
+        MDR_EEPROM->CMD = command;
+        DELAY_PROGRAM_WaitLoopsAsm(loops->prog);
+        command &= ~EEPROM_CMD_YE;
+        MDR_EEPROM->CMD = command;
+        command &= ~EEPROM_CMD_PROG;
+        MDR_EEPROM->CMD = command;
+        DELAY_PROGRAM_WaitLoopsAsm(loops->nvh);
+        command &= ~(EEPROM_CMD_XE | EEPROM_CMD_NVSTR);
+        MDR_EEPROM->CMD = command;
+        DELAY_PROGRAM_WaitLoopsAsm(loops->rcv);
+        address += 4;
+    }
+
+    MDR_EEPROM->CMD = command & EEPROM_CMD_DELAY_Msk;
+    MDR_EEPROM->KEY = 0;
+}
+
+void FLASH_Init(void)
+{
+    const uint32_t *vectors = (const uint32_t *)SCB->VTOR;
+
+    for (uint32_t i = 0; i < FLASH_VECTORS; i++)
+    {
+        ramVectors[i] = vectors[i];
+    }
+
+    // clk.c выключает тактирование контроллера после установки латентности
+    RST_CLK_PCLKcmd(RST_CLK_PCLK_EEPROM, ENABLE);
+}
+
+// Прерывания, которые не маскируются на время кванта, обязаны исполняться из ОЗУ
+static void FLASH_CheckVectors(void)
+{
+    for (uint32_t irq = 0; irq < FLASH_VECTORS - 16; irq++)
+    {
+        if ((NVIC->ISER[0] & (1UL << irq)) && NVIC_GetPriority((IRQn_Type)irq) < FLASH_CRITICAL_PRIORITY)
+        {
+            uint32_t handler = ramVectors[16 + irq];
+            configASSERT(handler >= RAM_AHB_BASE && handler < RAM_AHB_BASE + 32 * 1024);
+        }
+    }
+}
+
+static ErrorStatus FLASH_Start(uint32_t address, const uint32_t *data, uint32_t total)
+{
+    ErrorStatus status = ERROR;
+
+    FLASH_CheckVectors();
+
+    taskENTER_CRITICAL();
+    if (job.step == job.total)
+    {
+        job.address = address;
+        job.data = data;
+        job.total = total;
+        job.step = 0;
+        status = SUCCESS;
+    }
+    taskEXIT_CRITICAL();
+
+    return status;
+}
+
+ErrorStatus FLASH_Erase(uint32_t address, uint32_t pages)
+{
+    if (address % FLASH_PAGE_SIZE != 0 || address < EEPROM_BASE || pages == 0 ||
+        address - EEPROM_BASE + pages * FLASH_PAGE_SIZE > FLASH_BANK_SIZE)
+    {
+        return ERROR;
+    }
+    return FLASH_Start(address, NULL, pages * FLASH_SECTORS);
+}
+
+ErrorStatus FLASH_Write(uint32_t address, const uint32_t *data, uint32_t words)
+{
+    if (address % 4 != 0 || address < EEPROM_BASE || data == NULL || words == 0 ||
+        address - EEPROM_BASE + words * 4 > FLASH_BANK_SIZE)
+    {
+        return ERROR;
+    }
+    return FLASH_Start(address, data, words);
+}
+
+BaseType_t FLASH_IsBusy(void)
+{
+    return job.step != job.total;
+}
+
+static uint32_t FLASH_SliceUs(uint32_t step)
+{
+    if (job.data == NULL)
+    {
+        return FLASH_ERASE_SLICE_US + (step + 1 == job.total ? EEPROM_THV_US : 0);
+    }
+    uint32_t words = job.total - step;
+    return (words < FLASH_SLICE_WORDS ? words : FLASH_SLICE_WORDS) * FLASH_WORD_US;
+}
+
+// Один квант, возвращает его длительность в мкс
+static uint32_t FLASH_Slice(void)
+{
+    uint32_t buffer[FLASH_SLICE_WORDS];
+    uint32_t step = job.step;
+    uint32_t words = 0;
+    uint32_t us = FLASH_SliceUs(step);
+    uint32_t basepri, vtor;
+    uint32_t delayConst = DELAY_PROGRAM_GET_CONST_US(SystemCoreClock);
+    FLASH_Loops_t loops = {
+        .nvs = DELAY_PROGRAM_GET_US_LOOPS(EEPROM_TNVS_US, delayConst),
+        .pgs = DELAY_PROGRAM_GET_US_LOOPS(EEPROM_TPGS_US, delayConst),
+        .prog = DELAY_PROGRAM_GET_US_LOOPS(EEPROM_TPROG_US, delayConst),
+        .nvh = DELAY_PROGRAM_GET_US_LOOPS(EEPROM_TNVH_US, delayConst),
+        .rcv = DELAY_PROGRAM_GET_US_LOOPS(EEPROM_TRCV_US, delayConst),
+        .erase = DELAY_PROGRAM_GET_US_LOOPS(EEPROM_TERASE_US, delayConst),
+        .hv = DELAY_PROGRAM_GET_US_LOOPS(EEPROM_THV_US, delayConst),
+    };
+
+    if (job.data != NULL)
+    {
+        // Источник может лежать во FLASH, а во время кванта она не читается
+        words = job.total - step < FLASH_SLICE_WORDS ? job.total - step : FLASH_SLICE_WORDS;
+        for (uint32_t i = 0; i < words; i++)
+        {
+            buffer[i] = job.data[step + i];
+        }
+    }
+
+    basepri = __get_BASEPRI();
+    configASSERT(basepri == 0); // не из критической секции: восстановление BASEPRI снимет ее маску
+    __set_BASEPRI(FLASH_BASEPRI);
+    __ISB();
+    vtor = SCB->VTOR;
+    SCB->VTOR = (uint32_t)ramVectors;
+    __DSB();
+
+    if (job.data == NULL)
+    {
+        uint32_t page = job.address + (step / FLASH_SECTORS) * FLASH_PAGE_SIZE;
+        uint32_t sector = step % FLASH_SECTORS;
+        FLASH_EraseSector(page | (sector << 2), &loops, step + 1 == job.total);
+        step++;
+    }
+    else
+    {
+        FLASH_ProgramWords(job.address + step * 4, buffer, words, &loops);
+        step += words;
+    }
+
+    SCB->VTOR = vtor;
+    __DSB();
+    job.step = step;
+    __set_BASEPRI(basepri);
+    __ISB(); // отложенные за квант прерывания обслуживаются здесь
+
+    return us;
+}
+
+BaseType_t FLASH_Process(uint32_t budgetUs)
+{
+    uint32_t spent = 0;
+    uint32_t lostTicks = 0;
+    BaseType_t finished = pdFALSE;
+    TaskHandle_t waiter = NULL;
+
+    if (!FLASH_IsBusy())
+    {
+        return pdFALSE; // idle hook зовет на каждом проходе простоя
+    }
+
+    // Квант готовится без маски (копия данных), а шаг двигается под маской -
+    // два вызова из разных задач не должны выполнить один квант дважды
+    vTaskSuspendAll();
+    while (FLASH_IsBusy() && (spent == 0 || spent + FLASH_SliceUs(job.step) <= budgetUs))
+    {
+        uint32_t us = FLASH_Slice();
+        // За квант SysTick взводится только один раз, остальные тики теряются
+        uint32_t ticks = us / (1000000 / configTICK_RATE_HZ);
+        if (ticks > 1)
+        {
+            lostTicks += ticks - 1;
+        }
+        spent += us;
+    }
+    (void)xTaskResumeAll();
+
+    if (lostTicks != 0)
+    {
+        (void)xTaskCatchUpTicks(lostTicks);
+    }
+
+    taskENTER_CRITICAL();
+    if (spent != 0 && !FLASH_IsBusy())
+    {
+        finished = pdTRUE;
+        waiter = job.waiter;
+        job.waiter = NULL;
+    }
+    taskEXIT_CRITICAL();
+
+    if (finished)
+    {
+        EEPROM_UpdateDCache(); // в кэше данных могут остаться старые значения
+        if (waiter != NULL)
+        {
+            xTaskNotifyGiveIndexed(waiter, FLASH_NOTIFY_INDEX);
+        }
+    }
+
+    return FLASH_IsBusy();
+}
+
+BaseType_t FLASH_Wait(TickType_t ticks)
+{
+    for (;;)
+    {
+        // Регистрация и проверка под одной критической секцией с FLASH_Process,
+        // иначе завершение между ними потеряет уведомление
+        taskENTER_CRITICAL();
+        BaseType_t busy = FLASH_IsBusy();
+        if (busy)
+        {
+            job.waiter = xTaskGetCurrentTaskHandle();
+        }
+        taskEXIT_CRITICAL();
+
+        if (!busy)
+        {
+            return pdTRUE;
+        }
+        if (ulTaskNotifyTakeIndexed(FLASH_NOTIFY_INDEX, pdTRUE, ticks) == 0)
+        {
+            // Снятие тоже под секцией: FLASH_Process мог уже забрать регистрацию и
+            // уведомить после таймаута. Такое уведомление следующий FLASH_Wait
+            // примет за ложное пробуждение и перепроверит работу
+            taskENTER_CRITICAL();
+            job.waiter = NULL;
+            busy = FLASH_IsBusy();
+            taskEXIT_CRITICAL();
+
+            return busy ? pdFALSE : pdTRUE;
+        }
+    }
+}
@@ -0,0 +1,330 @@
+#include "heap.h"
+#include <errno.h>
+#include <malloc.h>
+#include <reent.h>
+#include <stdlib.h>
+#include <inttypes.h>
+
+#if HEAP_PROFILE && (HEAP_PROFILE_SLOTS & (HEAP_PROFILE_SLOTS - 1)) != 0
+#error "heap.c: HEAP_PROFILE_SLOTS - степень двойки"
+#endif
+
+extern uint8_t _sheap; // MDR32F9Q2I.ld
+extern uint8_t _eheap;
+
+static uint8_t *heapEnd = &_sheap;
+static uint8_t *heapPeak = &_sheap;
+
+// Рост кучи newlib, вызывается из malloc под __malloc_lock
+void *_sbrk(ptrdiff_t incr)
+{
+    uint8_t *prev = heapEnd;
+
+    if (incr > &_eheap - heapEnd || incr < &_sheap - heapEnd)
+    {
+        errno = ENOMEM;
+        return (void *)-1;
+    }
+    heapEnd += incr;
+    if (heapEnd > heapPeak)
+    {
+        heapPeak = heapEnd;
+    }
+    return prev;
+}
+
+void __malloc_lock(struct _reent *reent)
+{
+    (void)reent;
+    configASSERT(__get_IPSR() == 0);
+    vTaskSuspendAll();
+}
+
+void __malloc_unlock(struct _reent *reent)
+{
+    (void)reent;
+    (void)xTaskResumeAll();
+}
+
+#if HEAP_PROFILE
+#define HEAP_SLOT_MASK (HEAP_PROFILE_SLOTS - 1)
+
+// Открытая адресация по указателю, удаление со сдвигом - без "надгробий"
+static struct
+{
+    void *ptr; // NULL - ячейка свободна
+    uint32_t size : 24;
+    uint32_t tag : 8;
+    TickType_t born;
+} slots[HEAP_PROFILE_SLOTS];
+
+static HEAP_TagStats_t tags[HEAP_TAGS];
+static uint32_t sizeHist[HEAP_HIST_BUCKETS];
+static uint32_t lifeHist[HEAP_HIST_BUCKETS];
+static uint32_t untracked;
+
+static inline uint32_t HEAP_Hash(const void *ptr)
+{
+    return ((((uint32_t)(uintptr_t)ptr >> 3) * 0x9E3779B1UL) >> 16) & HEAP_SLOT_MASK;
+}
+
+// Корзина k: значения 2^(k-1)+1 .. 2^k
+static inline uint32_t HEAP_Bucket(uint32_t value)
+{
+    uint32_t bucket = value <= 1 ? 0 : 32 - __CLZ(value - 1);
+
+    return bucket < HEAP_HIST_BUCKETS ? bucket : HEAP_HIST_BUCKETS - 1;
+}
+
+// Вызовы - под остановкой планировщика
+static void HEAP_Track(void *block, size_t size)
+{
+    uint32_t tag = HEAP_TAG_BOOT;
+    uint32_t i = HEAP_Hash(block);
+    HEAP_TagStats_t *stats;
+
+    sizeHist[HEAP_Bucket(size)]++;
+    for (uint32_t n = 0; slots[i].ptr != NULL; n++, i = (i + 1) & HEAP_SLOT_MASK)
+    {
+        if (n == HEAP_PROFILE_SLOTS)
+        {
+            untracked++;
+            return;
+        }
+    }
+    if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED)
+    {
+        tag = (uint32_t)(uintptr_t)xTaskGetApplicationTaskTag(NULL);
+    }
+    slots[i].ptr = block;
+    slots[i].size = size;
+    slots[i].tag = tag;
+    slots[i].born = xTaskGetTickCount();
+
+    stats = &tags[tag];
+    stats->live += size;
+    stats->blocks++;
+    stats->allocs++;
+    if (stats->live > stats->peak)
+    {
+        stats->peak = stats->live;
+    }
+}
+
+static void HEAP_Untrack(void *block)
+{
+    uint32_t i = HEAP_Hash(block);
+    HEAP_TagStats_t *stats;
+
+    for (uint32_t n = 0; slots[i].ptr != block; n++, i = (i + 1) & HEAP_SLOT_MASK)
+    {
+        if (slots[i].ptr == NULL || n == HEAP_PROFILE_SLOTS)
+        {
+            return; // выделен мимо полной таблицы
+        }
+    }
+    stats = &tags[slots[i].tag];
+    stats->live -= slots[i].size;
+    stats->blocks--;
+    lifeHist[HEAP_Bucket(xTaskGetTickCount() - slots[i].born)]++;
+
+    // Сдвиг назад записей цепочки, чей дом не лежит циклически в (i, j]
+    for (;;)
+    {
+        uint32_t j = i;
+        uint32_t home;
+
+        do
+        {
+            j = (j + 1) & HEAP_SLOT_MASK;
+            if (slots[j].ptr == NULL || j == i) // j == i - обошли полную таблицу
+            {
+                slots[i].ptr = NULL;
+                return;
+            }
+            home = HEAP_Hash(slots[j].ptr);
+        } while (i <= j ? (i < home && home <= j) : (i < home || home <= j));
+        slots[i] = slots[j];
+        i = j;
+    }
+}
+
+void HEAP_SetTaskTag(TaskHandle_t task, uint32_t tag)
+{
+    configASSERT(tag < HEAP_TAGS);
+    vTaskSetApplicationTaskTag(task, (TaskHookFunction_t)(uintptr_t)tag);
+}
+
+const HEAP_TagStats_t *HEAP_GetTagStats(uint32_t tag)
+{
+    return tag < HEAP_TAGS ? &tags[tag] : NULL;
+}
+
+uint32_t HEAP_GetUntracked(void)
+{
+    return untracked;
+}
+
+void HEAP_ProfileCheckpoint(void)
+{
+    vTaskSuspendAll();
+    for (uint32_t tag = 0; tag < HEAP_TAGS; tag++)
+    {
+        tags[tag].mark = tags[tag].live;
+    }
+    (void)xTaskResumeAll();
+}
+
+uint32_t HEAP_ProfileLeaks(void)
+{
+    uint32_t mask = 0;
+
+    vTaskSuspendAll();
+    for (uint32_t tag = 0; tag < HEAP_TAGS; tag++)
+    {
+        if (tags[tag].live > tags[tag].mark)
+        {
+            mask |= 1UL << tag;
+        }
+    }
+    (void)xTaskResumeAll();
+    return mask;
+}
+
+void HEAP_ProfileReport(void)
+{
+    TickType_t now;
+
+    vTaskSuspendAll();
+    now = xTaskGetTickCount();
+    for (uint32_t tag = 0; tag < HEAP_TAGS; tag++)
+    {
+        const HEAP_TagStats_t *stats = &tags[tag];
+        uint32_t oldest = 0;
+
+        if (stats->allocs == 0)
+        {
+            continue;
+        }
+        for (uint32_t i = 0; i < HEAP_PROFILE_SLOTS; i++)
+        {
+            if (slots[i].ptr != NULL && slots[i].tag == tag && now - slots[i].born > oldest)
+            {
+                oldest = now - slots[i].born;
+            }
+        }
+        LOG("heap tag %" PRIu32 ": live %" PRIu32 " B in %" PRIu32 " blocks, peak %" PRIu32
+            " B, allocs %" PRIu32 ", oldest %" PRIu32 " ticks",
+            tag, stats->live, stats->blocks, stats->peak, stats->allocs, oldest);
+    }
+    for (uint32_t b = 0; b < HEAP_HIST_BUCKETS; b++)
+    {
+        if (sizeHist[b] != 0 || lifeHist[b] != 0)
+        {
+            LOG("heap <= %" PRIu32 ": %" PRIu32 " allocs of that size, %" PRIu32 " freed within that many ticks",
+                (uint32_t)1 << b, sizeHist[b], lifeHist[b]);
+        }
+    }
+    LOG("heap untracked %" PRIu32 ", free %u B", untracked, (unsigned)HEAP_GetFree());
+    (void)xTaskResumeAll();
+}
+#endif
+
+// Распределитель FreeRTOS поверх malloc
+void *pvPortMalloc(size_t xWantedSize)
+{
+    void *block;
+
+#if HEAP_PROFILE
+    vTaskSuspendAll();
+    block = malloc(xWantedSize);
+    if (block != NULL)
+    {
+        HEAP_Track(block, xWantedSize);
+    }
+    (void)xTaskResumeAll();
+#else
+    block = malloc(xWantedSize);
+#endif
+    traceMALLOC(block, xWantedSize);
+#if (configUSE_MALLOC_FAILED_HOOK == 1)
+    if (block == NULL)
+    {
+        extern void vApplicationMallocFailedHook(void);
+        vApplicationMallocFailedHook();
+    }
+#endif
+    return block;
+}
+
+void vPortFree(void *pv)
+{
+    if (pv != NULL)
+    {
+        traceFREE(pv, malloc_usable_size(pv));
+#if HEAP_PROFILE
+        vTaskSuspendAll();
+        HEAP_Untrack(pv);
+        free(pv);
+        (void)xTaskResumeAll();
+#else
+        free(pv);
+#endif
+    }
+}
+
+size_t xPortGetFreeHeapSize(void)
+{
+    return HEAP_GetFree();
+}
+
+size_t HEAP_GetFree(void)
+{
+    struct mallinfo info = mallinfo();
+
+    return info.fordblks + (size_t)(&_eheap - heapEnd);
+}
+
+size_t HEAP_GetUntouched(void)
+{
+    return (size_t)(&_eheap - heapPeak);
+}
+
+#if HEAP_BENCHMARK
+
+#define HEAP_BENCH_BLOCKS 16
+
+void HEAP_Benchmark(void)
+{
+    static const uint32_t sizes[] = {16, 64, 256};
+    void *blocks[HEAP_BENCH_BLOCKS];
+
+    for (uint32_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        uint32_t allocSum = 0, allocMax = 0, freeSum = 0, freeMax = 0;
+
+        for (uint32_t i = 0; i < HEAP_BENCH_BLOCKS; i++)
+        {
+            uint32_t start = DWT->CYCCNT;
+            blocks[i] = pvPortMalloc(sizes[s]);
+            start = DWT->CYCCNT - start;
+            allocSum += start;
+            allocMax = start > allocMax ? start : allocMax;
+        }
+        // Освобождение через одного, затем остальные - со слиянием соседних блоков
+        for (uint32_t i = 0; i < 2 * HEAP_BENCH_BLOCKS; i += 2)
+        {
+            uint32_t n = i < HEAP_BENCH_BLOCKS ? i : i - HEAP_BENCH_BLOCKS + 1;
+            uint32_t start = DWT->CYCCNT;
+            vPortFree(blocks[n]);
+            start = DWT->CYCCNT - start;
+            freeSum += start;
+            freeMax = start > freeMax ? start : freeMax;
+        }
+        LOG("heap %" PRIu32 " B: malloc avg %" PRIu32 " max %" PRIu32 ", free avg %" PRIu32 " max %" PRIu32
+            " cycles",
+            sizes[s], allocSum / HEAP_BENCH_BLOCKS, allocMax, freeSum / HEAP_BENCH_BLOCKS, freeMax);
+    }
+    LOG("heap free %u B, untouched %u B", (unsigned)HEAP_GetFree(), (unsigned)HEAP_GetUntouched());
+}
+#endif
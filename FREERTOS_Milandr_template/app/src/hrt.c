@@ -0,0 +1,417 @@
+#include "hrt.h"
+
+#if HRT_TIMER == 1
+#define HRT_TIMERx      MDR_TIMER1
+#define HRT_IRQn        Timer1_IRQn
+#define HRT_IRQHandler  Timer1_IRQHandler
+#define HRT_PCLK        RST_CLK_PER_CLOCK_PCLK_EN_TIMER1
+#define HRT_BRG_Msk     RST_CLK_TIM_CLOCK_TIM1_BRG_Msk
+#define HRT_CLK_EN      RST_CLK_TIM_CLOCK_TIM1_CLK_EN
+#define HRT_CONFIG_HZ   CLK_TIMER1_HZ
+#elif HRT_TIMER == 2
+#define HRT_TIMERx      MDR_TIMER2
+#define HRT_IRQn        Timer2_IRQn
+#define HRT_IRQHandler  Timer2_IRQHandler
+#define HRT_PCLK        RST_CLK_PER_CLOCK_PCLK_EN_TIMER2
+#define HRT_BRG_Msk     RST_CLK_TIM_CLOCK_TIM2_BRG_Msk
+#define HRT_CLK_EN      RST_CLK_TIM_CLOCK_TIM2_CLK_EN
+#define HRT_CONFIG_HZ   CLK_TIMER2_HZ
+#else
+#define HRT_TIMERx      MDR_TIMER3
+#define HRT_IRQn        Timer3_IRQn
+#define HRT_IRQHandler  Timer3_IRQHandler
+#define HRT_PCLK        RST_CLK_PER_CLOCK_PCLK_EN_TIMER3
+#define HRT_BRG_Msk     RST_CLK_TIM_CLOCK_TIM3_BRG_Msk
+#define HRT_CLK_EN      RST_CLK_TIM_CLOCK_TIM3_CLK_EN
+#define HRT_CONFIG_HZ   CLK_TIMER3_HZ
+#endif
+
+#if HRT_CONFIG_HZ != 0
+#error "hrt.c: таймер HRT_TIMER занят в clk_config.h (CLK_TIMERn_HZ)"
+#endif
+#if HRT_TIMER == 3 && UPTIME_TORTURE
+#error "hrt.c: TIMER3 занят UPTIME_Torture"
+#endif
+#if HRT_IRQ_PRIORITY < configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY
+#error "hrt.c: HRT_IRQ_PRIORITY старше configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, маска списков его не держит"
+#endif
+#if configTASK_NOTIFICATION_ARRAY_ENTRIES <= HRT_NOTIFY_INDEX
+#error "hrt.c: нужна ячейка HRT_NOTIFY_INDEX (FreeRTOSConfig.h)"
+#endif
+
+#define HRT_REF_IE(ch)    (1UL << (TIMER_IE_CCR_REF_EVENT_IE_Pos + (ch)))
+#define HRT_CCR(ch)       (&HRT_TIMERx->CCR1)[ch]
+#define HRT_CH_CNTRL(ch)  (&HRT_TIMERx->CH1_CNTRL)[ch]
+#define HRT_EPOCH_CARRY   1u // в epoch: переполнение уже учтено, флаг CNT_ZERO еще не снят
+
+static HRT_Timer_t *heads[HRT_CHANNELS]; // по возрастанию срока, все изменения под BASEPRI
+static uint32_t lengths[HRT_CHANNELS];
+static uint32_t armed;                   // взведено таймеров, пока не 0 - держим HRT_DFS_HZ
+static volatile uint32_t epoch;          // старшие 16 бит времени, += 0x10000 на CNT = 0
+
+#if HRT_BENCHMARK
+static HRT_Stats_t stats;
+
+static void HRT_Histogram(uint32_t *bins, uint32_t us)
+{
+    bins[us < HRT_HIST_BINS ? us : HRT_HIST_BINS - 1]++;
+}
+#endif
+
+// Без маски: прерывание таймера между чтениями меняет epoch - чтение повторяется.
+// Прерывание старше, вытеснившее его между переносом в epoch и снятием флага, видит
+// HRT_EPOCH_CARRY
+uint32_t HRT_GetTime(void)
+{
+    uint32_t high, cnt, status;
+
+    do
+    {
+        high = epoch;
+        cnt = HRT_TIMERx->CNT;
+        status = HRT_TIMERx->STATUS;
+    } while (epoch != high);
+    // Переполнение, до которого не дошло прерывание: флаг уже стоит, CNT начал новый круг
+    if (!(high & HRT_EPOCH_CARRY) && (status & TIMER_STATUS_CNT_ZERO_EVENT) && cnt < 0x8000)
+    {
+        high += 0x10000;
+    }
+    return (high & ~HRT_EPOCH_CARRY) + cnt;
+}
+
+// Под маской. DFS_Hold и DFS_Release под BASEPRI можно
+static void HRT_Armed(void)
+{
+    if (armed++ == 0 && HRT_DFS_HZ != 0)
+    {
+        DFS_Hold(HRT_DFS_HZ);
+    }
+}
+
+static void HRT_Disarmed(void)
+{
+    if (--armed == 0 && HRT_DFS_HZ != 0)
+    {
+        DFS_Release(HRT_DFS_HZ);
+    }
+}
+
+// Под маской. Срок уже близко - совпадение CNT с CCR можно проскочить, его отработает
+// прерывание, запрошенное программно
+static void HRT_Program(uint32_t ch)
+{
+    HRT_Timer_t *t = heads[ch];
+
+    if (t == NULL)
+    {
+        HRT_TIMERx->IE &= ~HRT_REF_IE(ch);
+        return;
+    }
+    HRT_CCR(ch) = t->deadline & 0xFFFF;
+    HRT_TIMERx->IE |= HRT_REF_IE(ch);
+    if ((int32_t)(t->deadline - HRT_GetTime()) <= HRT_GUARD_US)
+    {
+        NVIC_SetPendingIRQ(HRT_IRQn);
+    }
+}
+
+// Под маской. Равные сроки - в порядке взвода
+static void HRT_Insert(HRT_Timer_t *t, uint32_t ch)
+{
+    HRT_Timer_t **link = &heads[ch];
+
+    while (*link != NULL && (int32_t)((*link)->deadline - t->deadline) <= 0)
+    {
+        link = &(*link)->next;
+    }
+    t->next = *link;
+    *link = t;
+    t->channel = ch;
+    lengths[ch]++;
+#if HRT_BENCHMARK
+    if (lengths[ch] > stats.maxLength)
+    {
+        stats.maxLength = lengths[ch];
+    }
+#endif
+}
+
+// Под маской, таймер взведен
+static void HRT_Unlink(HRT_Timer_t *t)
+{
+    uint32_t ch = t->channel;
+    HRT_Timer_t **link = &heads[ch];
+
+    while (*link != t)
+    {
+        link = &(*link)->next;
+    }
+    *link = t->next;
+    lengths[ch]--;
+    t->channel = HRT_IDLE;
+    if (link == &heads[ch])
+    {
+        HRT_Program(ch);
+    }
+}
+
+void HRT_TimerInit(HRT_Timer_t *t, HRT_Callback_t callback, void *arg)
+{
+    t->next = NULL;
+    t->callback = callback;
+    t->arg = arg;
+    t->deadline = 0;
+    t->period = 0;
+    t->missed = 0;
+    t->channel = HRT_IDLE;
+}
+
+void HRT_Arm(HRT_Timer_t *t, uint32_t deadline, uint32_t period)
+{
+    UBaseType_t mask;
+    uint32_t ch = 0;
+#if HRT_BENCHMARK
+    uint32_t start = DWT->CYCCNT;
+#endif
+
+    mask = taskENTER_CRITICAL_FROM_ISR();
+    if (t->channel != HRT_IDLE)
+    {
+        HRT_Unlink(t);
+    }
+    else
+    {
+        HRT_Armed();
+    }
+    t->deadline = deadline;
+    t->period = period;
+    t->missed = 0;
+    for (uint32_t i = 1; i < HRT_CHANNELS; i++)
+    {
+        if (lengths[i] < lengths[ch])
+        {
+            ch = i;
+        }
+    }
+    HRT_Insert(t, ch);
+    if (heads[ch] == t)
+    {
+        HRT_Program(ch);
+    }
+#if HRT_BENCHMARK
+    stats.armCycles += DWT->CYCCNT - start;
+    stats.arms++;
+#endif
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+void HRT_Start(HRT_Timer_t *t, uint32_t us, uint32_t period)
+{
+    HRT_Arm(t, HRT_GetTime() + us, period);
+}
+
+void HRT_Cancel(HRT_Timer_t *t)
+{
+    UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+
+    if (t->channel != HRT_IDLE)
+    {
+        HRT_Unlink(t);
+        HRT_Disarmed();
+    }
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+void HRT_IRQHandler(void)
+{
+    BaseType_t woken = pdFALSE;
+    UBaseType_t mask;
+#if HRT_BENCHMARK
+    uint32_t start = DWT->CYCCNT;
+#endif
+
+    // Перенос в epoch и снятие флага: HRT_GetTime из прерываний старше, вытеснивших нас
+    // между ними, по HRT_EPOCH_CARRY не считает переполнение дважды
+    if (HRT_TIMERx->STATUS & TIMER_STATUS_CNT_ZERO_EVENT)
+    {
+        epoch = (epoch + 0x10000) | HRT_EPOCH_CARRY;
+        HRT_TIMERx->STATUS = ~TIMER_STATUS_CNT_ZERO_EVENT;
+        epoch &= ~HRT_EPOCH_CARRY;
+    }
+    // Флаги каналов только будят: что сработало, решают сроки в списках
+    HRT_TIMERx->STATUS = ~TIMER_STATUS_CCR_REF_EVENT_Msk;
+
+    for (uint32_t ch = 0; ch < HRT_CHANNELS; ch++)
+    {
+        HRT_Timer_t *t;
+
+        // Ожидание близкого срока - тоже под BASEPRI: прерывания старше его не ждут
+        mask = taskENTER_CRITICAL_FROM_ISR();
+        while ((t = heads[ch]) != NULL && (int32_t)(t->deadline - HRT_GetTime()) <= HRT_GUARD_US)
+        {
+            uint32_t deadline = t->deadline;
+            uint32_t now;
+
+            while ((int32_t)(deadline - (now = HRT_GetTime())) > 0) {} // до HRT_GUARD_US мкс
+            heads[ch] = t->next;
+            lengths[ch]--;
+            t->channel = HRT_IDLE;
+            if (t->period != 0)
+            {
+                // От срока, а не от момента вызова: период не копит опоздания.
+                // Опоздание больше периода - пропущенные сроки не догоняются
+                uint32_t next = deadline + t->period;
+                if ((int32_t)(next - now) <= 0)
+                {
+                    uint32_t skip = (now - next) / t->period + 1;
+                    t->missed += skip;
+                    next += skip * t->period;
+                }
+                t->deadline = next;
+                HRT_Insert(t, ch);
+            }
+            else
+            {
+                HRT_Disarmed();
+            }
+#if HRT_BENCHMARK
+            HRT_Histogram(stats.isrLate, now - deadline);
+            stats.fired++;
+#endif
+            taskEXIT_CRITICAL_FROM_ISR(mask);
+            woken |= t->callback(t, t->arg);
+            mask = taskENTER_CRITICAL_FROM_ISR();
+        }
+        HRT_Program(ch);
+        taskEXIT_CRITICAL_FROM_ISR(mask);
+    }
+
+#if HRT_BENCHMARK
+    stats.isrCycles += DWT->CYCCNT - start;
+#endif
+    portYIELD_FROM_ISR(woken);
+}
+
+static BaseType_t HRT_Wake(HRT_Timer_t *t, void *arg)
+{
+    BaseType_t woken = pdFALSE;
+
+    (void) t;
+    vTaskNotifyGiveIndexedFromISR((TaskHandle_t)arg, HRT_NOTIFY_INDEX, &woken);
+    return woken;
+}
+
+void HRT_SleepUntil(uint32_t deadline)
+{
+    HRT_Timer_t timer;
+
+    // Таймер срабатывает ровно один раз - одно уведомление на одно ожидание
+    HRT_TimerInit(&timer, HRT_Wake, xTaskGetCurrentTaskHandle());
+    HRT_Arm(&timer, deadline, 0);
+    ulTaskNotifyTakeIndexed(HRT_NOTIFY_INDEX, pdTRUE, portMAX_DELAY);
+#if HRT_BENCHMARK
+    HRT_Histogram(stats.taskLate, HRT_GetTime() - deadline);
+#endif
+}
+
+void HRT_Sleep(uint32_t us)
+{
+    HRT_SleepUntil(HRT_GetTime() + us);
+}
+
+// Ближайший делитель: частота не кратна HRT_HZ (HSE не 8/16 МГц) - счет уходит от мкс
+// не больше чем на HRT_HZ / 2 / hz, сроки и HRT_GetTime идут с той же ошибкой
+static uint32_t HRT_Prescaler(uint32_t hz)
+{
+    uint32_t div = (hz + HRT_HZ / 2) / HRT_HZ;
+
+    return div != 0 ? div - 1 : 0;
+}
+
+// Нотификатор CLK_SetFrequency: счет остается HRT_HZ
+static void HRT_Retune(CLK_Event_t event, uint32_t hz)
+{
+    if (event != CLK_SWITCH)
+    {
+        return;
+    }
+    HRT_TIMERx->PSG = HRT_Prescaler(hz);
+}
+
+void HRT_Init(void)
+{
+    // HCLK без деления BRG, до HRT_HZ делит PSG - его и меняет HRT_Retune
+    MDR_RST_CLK->PER_CLOCK |= HRT_PCLK;
+    MDR_RST_CLK->TIM_CLOCK = (MDR_RST_CLK->TIM_CLOCK & ~HRT_BRG_Msk) | HRT_CLK_EN;
+
+    HRT_TIMERx->CNTRL = 0;
+    HRT_TIMERx->CNT = 0;
+    HRT_TIMERx->PSG = HRT_Prescaler(SystemCoreClock);
+    HRT_TIMERx->ARR = 0xFFFF;
+    for (uint32_t ch = 0; ch < HRT_CHANNELS; ch++)
+    {
+        // REF = 1, пока CNT = CCR: событие на каждом совпадении без перенастройки канала
+        HRT_CH_CNTRL(ch) = TIMER_CH_REF_Format1;
+    }
+    HRT_TIMERx->STATUS = 0;
+    HRT_TIMERx->IE = TIMER_IE_CNT_ZERO_EVENT_IE;
+    NVIC_ClearPendingIRQ(HRT_IRQn);
+    NVIC_SetPriority(HRT_IRQn, HRT_IRQ_PRIORITY);
+    NVIC_EnableIRQ(HRT_IRQn);
+    CLK_AddNotifier(HRT_Retune);
+    HRT_TIMERx->CNTRL = TIMER_CNTRL_CNT_EN;
+}
+
+#if HRT_BENCHMARK
+#define HRT_BENCH_MAX 32
+
+static HRT_Timer_t benchTimers[HRT_BENCH_MAX];
+
+static BaseType_t HRT_BenchCallback(HRT_Timer_t *t, void *arg)
+{
+    (void) t;
+    (void) arg;
+    return pdFALSE;
+}
+
+const HRT_Stats_t *HRT_GetStats(void)
+{
+    stats.armAvgCycles = stats.arms != 0 ? (uint32_t)(stats.armCycles / stats.arms) : 0;
+    stats.fireAvgCycles = stats.fired != 0 ? (uint32_t)(stats.isrCycles / stats.fired) : 0;
+    return &stats;
+}
+
+const HRT_Stats_t *HRT_Benchmark(uint32_t timers, uint32_t ms)
+{
+    uint32_t now, next, end;
+
+    configASSERT(timers <= HRT_BENCH_MAX);
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    stats = (HRT_Stats_t){0};
+
+    now = HRT_GetTime();
+    for (uint32_t i = 0; i < timers; i++)
+    {
+        // Периоды 100..999 мкс, взаимно сдвинуты - сроки расходятся по всем каналам
+        uint32_t period = 100 + i * 29;
+
+        HRT_TimerInit(&benchTimers[i], HRT_BenchCallback, NULL);
+        HRT_Arm(&benchTimers[i], now + period, period);
+    }
+
+    next = now;
+    end = now + ms * 1000;
+    while ((int32_t)(next - end) < 0)
+    {
+        next += 1000;
+        HRT_SleepUntil(next);
+    }
+
+    for (uint32_t i = 0; i < timers; i++)
+    {
+        HRT_Cancel(&benchTimers[i]);
+    }
+    return HRT_GetStats();
+}
+#endif
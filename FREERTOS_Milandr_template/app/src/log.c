@@ -0,0 +1,222 @@
+#include "log.h"
+
+#if (LOG_RING_WORDS & (LOG_RING_WORDS - 1)) != 0
+#error "log.c: LOG_RING_WORDS - степень двойки"
+#endif
+
+#define LOG_MASK       (LOG_RING_WORDS - 1)
+#define LOG_DMA_WORDS  (1024 / 4) // за цикл DMA - до 1024 байтовых передач
+#define LOG_MAGIC      0x4C4F4731UL
+
+// Кольцо и индексы - в .noinit: записи, не ушедшие в UART до сброса (сторож, отказ,
+// SYSRESETREQ), уйдут после перезапуска. Недоотправленный кусок уйдет повторно,
+// декодер пересинхронизируется
+static uint32_t ring[LOG_RING_WORDS] __NOINIT;
+
+static struct
+{
+    uint32_t magic;
+    uint32_t head;           // пишут LOG_Write* под PRIMASK
+    volatile uint32_t tail;  // двигает только завершение DMA
+} kept __NOINIT;
+
+static struct
+{
+    uint32_t dropped;        // потеряно с последней записи о потерях
+    uint32_t sending;        // слов в текущем цикле DMA, 0 - канал стоит
+    int32_t channel;         // -1 - LOG_Init не вызывался
+    MDR_UART_TypeDef *uart;
+} state = {.channel = -1};
+
+// Из __libc_init_array до остальных конструкторов и main: после включения питания
+// в кольце мусор, после сброса - журнал
+static void __attribute__((constructor(101))) LOG_Restore(void)
+{
+    if (kept.magic != LOG_MAGIC || kept.head - kept.tail > LOG_RING_WORDS)
+    {
+        kept.magic = LOG_MAGIC;
+        kept.head = 0;
+        kept.tail = 0;
+    }
+}
+
+// Запись о потерянных перед очередной записью, если для обеих есть место
+static __attribute__((noinline)) uint32_t LOG_PutDropped(uint32_t head, uint32_t words)
+{
+    if (head - kept.tail + 3 + words > LOG_RING_WORDS)
+    {
+        return 0;
+    }
+    ring[head & LOG_MASK] = LOG_SYNC | (1UL << 24) | LOG_ID_DROPPED;
+    ring[(head + 1) & LOG_MASK] = DWT->CYCCNT;
+    ring[(head + 2) & LOG_MASK] = state.dropped;
+    state.dropped = 0;
+    return 3;
+}
+
+// n - константа у каждого LOG_Write*, копирование разворачивается
+static inline __attribute__((always_inline)) void LOG_Put(uint32_t header, uint32_t n, const uint32_t *args)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint32_t head;
+
+    __disable_irq();
+    head = kept.head;
+    if (state.dropped != 0)
+    {
+        uint32_t words = LOG_PutDropped(head, n + 2);
+        if (words == 0)
+        {
+            state.dropped++;
+            __set_PRIMASK(primask);
+            return;
+        }
+        head += words;
+    }
+    if (head - kept.tail + n + 2 > LOG_RING_WORDS)
+    {
+        state.dropped++;
+        __set_PRIMASK(primask);
+        return;
+    }
+    ring[head & LOG_MASK] = header;
+    ring[(head + 1) & LOG_MASK] = DWT->CYCCNT;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        ring[(head + 2 + i) & LOG_MASK] = args[i];
+    }
+    kept.head = head + n + 2;
+    __set_PRIMASK(primask);
+}
+
+void LOG_Write0(uint32_t header)
+{
+    LOG_Put(header, 0, NULL);
+}
+
+void LOG_Write1(uint32_t header, uint32_t a)
+{
+    uint32_t args[] = {a};
+    LOG_Put(header, 1, args);
+}
+
+void LOG_Write2(uint32_t header, uint32_t a, uint32_t b)
+{
+    uint32_t args[] = {a, b};
+    LOG_Put(header, 2, args);
+}
+
+void LOG_Write3(uint32_t header, uint32_t a, uint32_t b, uint32_t c)
+{
+    uint32_t args[] = {a, b, c};
+    LOG_Put(header, 3, args);
+}
+
+void LOG_WriteN(uint32_t header, const uint32_t *args)
+{
+    LOG_Put(header, (header >> 24) & 0xF, args);
+}
+
+// Отправка: непрерывный кусок кольца от tail, не дальше конца массива
+static BaseType_t LOG_DmaDone(uint32_t channel, void *arg)
+{
+    (void)channel;
+    (void)arg;
+    kept.tail += state.sending;
+    state.sending = 0;
+    LOG_Kick();
+    return pdFALSE;
+}
+
+void LOG_Kick(void)
+{
+    UBaseType_t mask;
+    uint32_t tail, first, words;
+    DMA_CtrlDataTypeDef *ctrl;
+
+    if (state.channel < 0)
+    {
+        return;
+    }
+
+    mask = taskENTER_CRITICAL_FROM_ISR();
+    tail = kept.tail;
+    words = kept.head - tail;
+    if (state.sending != 0 || words == 0)
+    {
+        taskEXIT_CRITICAL_FROM_ISR(mask);
+        return;
+    }
+    first = tail & LOG_MASK;
+    if (words > LOG_RING_WORDS - first)
+    {
+        words = LOG_RING_WORDS - first;
+    }
+    if (words > LOG_DMA_WORDS)
+    {
+        words = LOG_DMA_WORDS;
+    }
+    state.sending = words;
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+
+    // Байтами в DR по запросу UART (FIFO передатчика)
+    ctrl = DMAM_Control(state.channel, DMA_CTRL_DATA_PRIMARY);
+    ctrl->DMA_SourceEndAddr = (uint32_t)&ring[first + words] - 1;
+    ctrl->DMA_DestEndAddr = (uint32_t)&state.uart->DR;
+    ctrl->DMA_Control = (DMA_DestIncNo << 30) | (DMA_SourceIncByte << 26) | DMA_MemoryDataSize_Byte | DMA_Transfers_1 |
+                        ((words * 4 - 1) << 4) | DMA_Mode_Basic;
+    DMAM_Start(state.channel);
+}
+
+// Частота CYCCNT с этой метки - для перевода тактов во время в декодере
+static void LOG_Clock(uint32_t hz)
+{
+    uint32_t args[] = {hz};
+    LOG_Put(LOG_SYNC | (1UL << 24) | LOG_ID_CLOCK, 1, args);
+}
+
+// Бодрейт считается от HCLK: на смене частоты передача встает на паузу.
+// SWITCH - сразу после переключения, метка записи - граница участков частоты
+static void LOG_ClockChanged(CLK_Event_t event, uint32_t hz)
+{
+    if (event == CLK_SWITCH)
+    {
+        LOG_Clock(hz);
+    }
+    CLK_UARTRetune(state.uart, event, hz);
+}
+
+void LOG_Init(MDR_UART_TypeDef *UARTx)
+{
+    int32_t channel = DMAM_Alloc(UARTx == MDR_UART1 ? DMA_Channel_UART1_TX : DMA_Channel_UART2_TX,
+                                 LOG_DmaDone, NULL);
+
+    configASSERT(channel >= 0);
+    state.uart = UARTx;
+    UARTx->DMACR |= UART_DMA_TXE;
+    UARTx->CR |= UART_CR_UARTEN | UART_CR_TXE;
+    state.channel = channel;
+    CLK_AddNotifier(LOG_ClockChanged);
+    LOG_Clock(SystemCoreClock);
+}
+
+#if LOG_BENCHMARK
+#include <stdio.h>
+#include <inttypes.h>
+
+void LOG_Benchmark(void)
+{
+    char text[64];
+    uint32_t start, logCycles, printfCycles;
+
+    start = DWT->CYCCNT;
+    LOG("bench %u %d", 12345u, -42);
+    logCycles = DWT->CYCCNT - start;
+
+    start = DWT->CYCCNT;
+    snprintf(text, sizeof(text), "bench %u %d", 12345u, -42);
+    printfCycles = DWT->CYCCNT - start;
+
+    LOG("LOG %" PRIu32 " cycles, snprintf %" PRIu32 " cycles (without UART)", logCycles, printfCycles);
+}
+#endif
@@ -0,0 +1,124 @@
+#include "mpsc.h"
+
+// Прерывание по умолчанию - компаратора: с драйвером компаратора в app.h нужно другое
+#if defined(MPSC_WAKEUP_DEFAULT) && defined(__MDR32FxQI_COMP_H)
+#error "mpsc.c: компаратор занят, задайте MPSC_WAKEUP_IRQn и MPSC_WAKEUP_IRQHandler"
+#endif
+
+static MPSC_Queue_t *queues[MPSC_MAX_QUEUES];
+static volatile uint32_t queuesCount;
+
+void MPSC_Init(MPSC_Queue_t *q, TaskHandle_t consumer)
+{
+    q->head = NULL;
+    q->pending = NULL;
+    q->signal = 0;
+    q->consumer = consumer;
+
+    // Обработчик пробуждения обходит queues[] - дописываем под маской, он ниже syscall
+    taskENTER_CRITICAL();
+    configASSERT(queuesCount < MPSC_MAX_QUEUES);
+    queues[queuesCount] = q;
+    queuesCount++;
+    taskEXIT_CRITICAL();
+
+    // приоритет не выше syscall - обработчик зовет FromISR API
+    NVIC_SetPriority(MPSC_WAKEUP_IRQn, configLIBRARY_LOWEST_INTERRUPT_PRIORITY);
+    NVIC_EnableIRQ(MPSC_WAKEUP_IRQn);
+}
+
+void MPSC_Post(MPSC_Queue_t *q, MPSC_Node_t *node)
+{
+    MPSC_Node_t *old;
+
+    // Содержимое события должно быть записано раньше, чем узел станет виден читателю
+    // (LDREX/STREX в CMSIS не объявлены барьером для компилятора)
+    portMEMORY_BARRIER();
+
+    // Вставка в голову стека. Если между LDREX и STREX случилось любое прерывание
+    // (а значит, возможно, и чужая вставка), исключительный доступ сбрасывается
+    // и STREX вернет 1 - просто повторяем. Ни одно прерывание не маскируется.
+    do
+    {
+        old = (MPSC_Node_t *)__LDREXW((volatile uint32_t *)&q->head);
+        node->next = old;
+    } while (__STREXW((uint32_t)node, (volatile uint32_t *)&q->head) != 0);
+
+    // Будим читателя только на переходе "пусто -> не пусто", остальное он заберет сам
+    if (old == NULL)
+    {
+        q->signal = 1;
+        NVIC_SetPendingIRQ(MPSC_WAKEUP_IRQn); // одна запись в ISPR, атомарна
+    }
+}
+
+MPSC_Node_t *MPSC_Take(MPSC_Queue_t *q)
+{
+    MPSC_Node_t *node = q->pending;
+
+    if (node == NULL)
+    {
+        MPSC_Node_t *list;
+
+        // Забираем весь стек разом. Узлы по одному из стека не снимаются,
+        // поэтому проблемы ABA здесь нет.
+        do
+        {
+            list = (MPSC_Node_t *)__LDREXW((volatile uint32_t *)&q->head);
+        } while (__STREXW(0, (volatile uint32_t *)&q->head) != 0);
+
+        // Разворачиваем LIFO в порядок поступления
+        while (list != NULL)
+        {
+            MPSC_Node_t *next = list->next;
+            list->next = node;
+            node = list;
+            list = next;
+        }
+
+        if (node == NULL)
+        {
+            return NULL;
+        }
+    }
+
+    q->pending = node->next;
+    node->next = NULL;
+    return node;
+}
+
+MPSC_Node_t *MPSC_Wait(MPSC_Queue_t *q, TickType_t ticks)
+{
+    MPSC_Node_t *node = MPSC_Take(q);
+    TimeOut_t timeout;
+
+    // Уведомление, пришедшее между Take и ulTaskNotifyTake, не теряется -
+    // счетчик уведомлений задачи его запомнит, и ожидание сразу завершится.
+    // Пустое пробуждение (узел уже забран прошлым Take) ждет только остаток ticks
+    vTaskSetTimeOutState(&timeout);
+    while (node == NULL)
+    {
+        if (xTaskCheckForTimeOut(&timeout, &ticks) != pdFALSE || ulTaskNotifyTake(pdTRUE, ticks) == 0)
+        {
+            return NULL; // таймаут
+        }
+        node = MPSC_Take(q);
+    }
+    return node;
+}
+
+void MPSC_WAKEUP_IRQHandler(void)
+{
+    BaseType_t woken = pdFALSE;
+
+    for (uint32_t i = 0; i < queuesCount; i++)
+    {
+        MPSC_Queue_t *q = queues[i];
+        if (q->signal)
+        {
+            q->signal = 0;
+            vTaskNotifyGiveFromISR(q->consumer, &woken);
+        }
+    }
+    portYIELD_FROM_ISR(woken);
+}
@@ -0,0 +1,390 @@
+#include "pwmseq.h"
+
+#if configTASK_NOTIFICATION_ARRAY_ENTRIES <= PWMSEQ_NOTIFY_INDEX
+#error "pwmseq.c: нужна ячейка PWMSEQ_NOTIFY_INDEX (FreeRTOSConfig.h)"
+#endif
+
+#define PWMSEQ_TIMERS         3
+#define PWMSEQ_CYCLE_CTRL_Msk 0x7UL // режим в слове управления DMA, 0 - Stop
+
+// Память -> CCR: источник по полуслову, приемник на месте, одна передача на запрос цепочки
+#define PWMSEQ_DMA_CONTROL (((uint32_t)DMA_DestIncNo << 30) | ((uint32_t)DMA_SourceIncHalfword << 26) | \
+                            DMA_MemoryDataSize_HalfWord | DMA_Transfers_1)
+
+// Цепочка на запрос таймера: основная структура копирует задачу (4 слова) в альтернативную,
+// та выполняется. Задачи: программный запрос feed, снятие CNT_ZERO - запрос таймера уходит
+// до следующего периода - и перезарядка основной структуры, цепочка идет по кругу.
+// Перезарядка берет уже запрос следующего периода и выполняется последней: контроллер
+// пишет основную структуру после каждой копии
+#define PWMSEQ_TASK_KICK   0
+#define PWMSEQ_TASK_CLEAR  1
+#define PWMSEQ_TASK_REARM  2
+#define PWMSEQ_TASK_CONTROL (((uint32_t)DMA_DestIncNo << 30) | ((uint32_t)DMA_SourceIncNo << 26) | \
+                             DMA_MemoryDataSize_Word | DMA_Transfers_1 | DMA_Mode_PerScatterAlt)
+#define PWMSEQ_CHAIN_CONTROL (((uint32_t)DMA_DestIncWord << 30) | ((uint32_t)DMA_SourceIncWord << 26) | DMA_MemoryDataSize_Word | \
+                              DMA_Transfers_4 | ((4 * PWMSEQ_CHAIN_TASKS - 1) << 4) | DMA_Mode_PerScatterPri)
+
+static const struct
+{
+    MDR_TIMER_TypeDef *timer;
+    uint32_t pclk;
+    uint32_t brgMsk;
+    uint32_t clkEn;
+    uint32_t configHz;
+    uint8_t dma;
+} PWMSEQ_Timers[PWMSEQ_TIMERS] =
+{
+    {MDR_TIMER1, RST_CLK_PER_CLOCK_PCLK_EN_TIMER1, RST_CLK_TIM_CLOCK_TIM1_BRG_Msk, RST_CLK_TIM_CLOCK_TIM1_CLK_EN, CLK_TIMER1_HZ, DMA_Channel_TIM1},
+    {MDR_TIMER2, RST_CLK_PER_CLOCK_PCLK_EN_TIMER2, RST_CLK_TIM_CLOCK_TIM2_BRG_Msk, RST_CLK_TIM_CLOCK_TIM2_CLK_EN, CLK_TIMER2_HZ, DMA_Channel_TIM2},
+    {MDR_TIMER3, RST_CLK_PER_CLOCK_PCLK_EN_TIMER3, RST_CLK_TIM_CLOCK_TIM3_BRG_Msk, RST_CLK_TIM_CLOCK_TIM3_CLK_EN, CLK_TIMER3_HZ, DMA_Channel_TIM3},
+};
+
+static PWMSEQ_t *sequencers[PWMSEQ_TIMERS];
+static uint32_t demand; // сумма floor занятых секвенсоров, удержана DFS_Hold
+
+static BaseType_t PWMSEQ_DmaDone(uint32_t channel, void *arg);
+static void PWMSEQ_Retune(CLK_Event_t event, uint32_t hz);
+
+void PWMSEQ_Init(PWMSEQ_t *seq, uint32_t timer, uint32_t channel, uint32_t period,
+                 uint16_t *buffer, uint32_t half, uint16_t idle, PWMSEQ_Fill_t fill, void *arg)
+{
+    MDR_TIMER_TypeDef *t;
+    DMA_CtrlDataTypeDef *primary;
+    uint32_t ch = channel - 1;
+    int32_t dma, feed;
+
+    configASSERT(timer >= 1 && timer <= PWMSEQ_TIMERS && channel >= 1 && channel <= 4);
+    configASSERT(period >= 2 && period <= 0x10000 && half >= 1 && half <= PWMSEQ_MAX_HALF);
+    configASSERT(SystemCoreClock % PWMSEQ_HZ == 0);
+    timer--;
+    // Таймер не должен быть занят: CLK_InitPeripherals, HRT_Init и UPTIME_Torture включают его тактирование
+    configASSERT(PWMSEQ_Timers[timer].configHz == 0 && !(MDR_RST_CLK->TIM_CLOCK & PWMSEQ_Timers[timer].clkEn));
+
+    t = PWMSEQ_Timers[timer].timer;
+    seq->timer = t;
+    seq->ccr = &(&t->CCR1)[ch];
+    seq->buffer = buffer;
+    seq->half = half;
+    seq->idle = idle;
+    seq->busy = 0;
+    seq->ending = 0;
+    seq->fill = fill;
+    seq->arg = arg;
+    seq->underruns = 0;
+    seq->waiter = NULL;
+    // Цепочка плюс передача значения за период: частота, на которой DMA успевает
+    seq->floor = (uint32_t)(((uint64_t)PWMSEQ_HZ * PWMSEQ_DMA_CYCLES + period - 1) / period);
+    configASSERT(seq->floor <= CLK_MAX_HZ);
+    seq->dma = PWMSEQ_Timers[timer].dma;
+    dma = DMAM_Alloc(seq->dma, NULL, seq); // цепочка не кончается, обработчик не нужен
+    feed = DMAM_Alloc(DMAM_ANY, PWMSEQ_DmaDone, seq);
+    configASSERT(dma == seq->dma && feed >= 0);
+    (void)dma;
+    seq->feed = (uint8_t)feed;
+    // Запрос таймера обслуживается раньше копирований DMAM_Memcpy: опоздание - пропущенный период
+    MDR_DMA->CHNL_PRIORITY_SET = (1UL << seq->dma) | (1UL << seq->feed);
+
+    seq->kick = 1UL << seq->feed;
+    seq->zero = 0;
+    seq->chainControl = PWMSEQ_CHAIN_CONTROL;
+    seq->chain[PWMSEQ_TASK_KICK] = (DMA_CtrlDataTypeDef){
+        (uint32_t)&seq->kick, (uint32_t)&MDR_DMA->CHNL_SW_REQUEST, PWMSEQ_TASK_CONTROL, 0};
+    seq->chain[PWMSEQ_TASK_CLEAR] = (DMA_CtrlDataTypeDef){
+        (uint32_t)&seq->zero, (uint32_t)&t->STATUS, PWMSEQ_TASK_CONTROL, 0};
+    primary = DMAM_Control(seq->dma, DMA_CTRL_DATA_PRIMARY);
+    seq->chain[PWMSEQ_TASK_REARM] = (DMA_CtrlDataTypeDef){
+        (uint32_t)&seq->chainControl, (uint32_t)&primary->DMA_Control, PWMSEQ_TASK_CONTROL, 0};
+    // Концы копии задачи: контроллеру нужны адреса последних слов
+    primary->DMA_SourceEndAddr = (uint32_t)&seq->chain[PWMSEQ_CHAIN_TASKS - 1].DMA_Unused;
+    primary->DMA_DestEndAddr = (uint32_t)&DMAM_Control(seq->dma, DMA_CTRL_DATA_ALTERNATE)->DMA_Unused;
+#if PWMSEQ_BENCHMARK
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    seq->refills = 0;
+    seq->values = 0;
+    seq->cycles = 0;
+    seq->since = UPTIME_GetCycles();
+#endif
+
+    // HCLK без деления BRG, до PWMSEQ_HZ делит PSG - его и меняет PWMSEQ_Retune
+    MDR_RST_CLK->PER_CLOCK |= PWMSEQ_Timers[timer].pclk;
+    MDR_RST_CLK->TIM_CLOCK = (MDR_RST_CLK->TIM_CLOCK & ~PWMSEQ_Timers[timer].brgMsk) | PWMSEQ_Timers[timer].clkEn;
+
+    t->CNTRL = 0;
+    t->CNT = 0;
+    t->PSG = SystemCoreClock / PWMSEQ_HZ - 1;
+    t->ARR = period - 1;
+    // REF = 1, пока CNT < CCR; новое CCR - с начала следующего периода, импульс не рвется
+    (&t->CH1_CNTRL)[ch] = TIMER_CH_REF_Format6;
+    (&t->CH1_CNTRL1)[ch] = (TIMER_CH_OutMode_Output << TIMER_CH_CNTRL1_SELOE_Pos) |
+                           (TIMER_CH_OutSrc_REF << TIMER_CH_CNTRL1_SELO_Pos);
+    (&t->CH1_CNTRL2)[ch] = TIMER_CH_CNTRL2_CCRRLD;
+    *seq->ccr = idle;
+    t->IE = 0;
+    t->DMA_RE = TIMER_DMA_RE_CNT_ZERO_EVENT_RE;
+    t->STATUS = 0;
+
+    if (sequencers[0] == NULL && sequencers[1] == NULL && sequencers[2] == NULL)
+    {
+        CLK_AddNotifier(PWMSEQ_Retune); // один на все секвенсоры
+    }
+    sequencers[timer] = seq;
+}
+
+// Порция в половину index. Конец потока - за последним значением idle, структура basic:
+// на ней цикл DMA закончится
+static void PWMSEQ_Load(PWMSEQ_t *seq, uint32_t index)
+{
+    DMA_CtrlDataTypeDef *ctrl = DMAM_Control(seq->feed, index ? DMA_CTRL_DATA_ALTERNATE : DMA_CTRL_DATA_PRIMARY);
+    uint16_t *values = seq->buffer + index * seq->half;
+    uint32_t mode = DMA_Mode_PingPong;
+    uint32_t n = seq->fill(seq, values, seq->half);
+
+    if (n < seq->half)
+    {
+        values[n++] = seq->idle;
+        mode = DMA_Mode_Basic;
+        seq->ending = 1;
+    }
+    // Контроллеру нужен адрес последней передачи, а не начала
+    ctrl->DMA_SourceEndAddr = (uint32_t)&values[n - 1];
+    ctrl->DMA_Control = PWMSEQ_DMA_CONTROL | ((n - 1) << 4) | mode;
+#if PWMSEQ_BENCHMARK
+    seq->refills++;
+    seq->values += n;
+#endif
+}
+
+// Контроллер DMA у секвенсоров общий: держим сумму их floor. Сначала новое удержание,
+// потом снятие старого - частота не проседает между вызовами.
+// Под критической секцией или из DMA_IRQHandler
+static void PWMSEQ_Demand(uint32_t add, uint32_t remove)
+{
+    uint32_t old = demand;
+
+    demand = demand + add - remove;
+    if (demand != 0)
+    {
+        DFS_Hold(demand);
+    }
+    if (old != 0)
+    {
+        DFS_Release(old);
+    }
+}
+
+// Под критической секцией или из DMA_IRQHandler
+static BaseType_t PWMSEQ_Finish(PWMSEQ_t *seq)
+{
+    BaseType_t woken = pdFALSE;
+
+    DMAM_Stop(seq->dma);
+    DMAM_Stop(seq->feed);
+    seq->busy = 0;
+    PWMSEQ_Demand(0, seq->floor);
+    if (seq->waiter != NULL)
+    {
+        vTaskNotifyGiveIndexedFromISR(seq->waiter, PWMSEQ_NOTIFY_INDEX, &woken);
+    }
+    return woken;
+}
+
+static BaseType_t PWMSEQ_DmaDone(uint32_t channel, void *arg)
+{
+    PWMSEQ_t *seq = arg;
+    DMA_CtrlDataTypeDef *primary = DMAM_Control(channel, DMA_CTRL_DATA_PRIMARY);
+    DMA_CtrlDataTypeDef *alternate = DMAM_Control(channel, DMA_CTRL_DATA_ALTERNATE);
+    BaseType_t woken = pdFALSE;
+#if PWMSEQ_BENCHMARK
+    uint32_t start = DWT->CYCCNT;
+#endif
+
+    // Отданная половина - в Stop. После последней порции не перезаряжаем: вызовы
+    // на каждом прерывании DMA до конца цикла
+    if (!seq->ending && (primary->DMA_Control & PWMSEQ_CYCLE_CTRL_Msk) == DMA_Mode_Stop)
+    {
+        PWMSEQ_Load(seq, 0);
+    }
+    if (!seq->ending && (alternate->DMA_Control & PWMSEQ_CYCLE_CTRL_Msk) == DMA_Mode_Stop)
+    {
+        PWMSEQ_Load(seq, 1);
+    }
+    __DMB();
+
+    // Контроллер снимает разрешение канала, когда кончилась basic-порция или следующая
+    // структура оказалась в Stop. Во втором случае часть потока не ушла - обрыв,
+    // в CCR осталось последнее значение
+    if (!(MDR_DMA->CHNL_ENABLE_SET & (1UL << channel)))
+    {
+        if (!seq->ending ||
+            (primary->DMA_Control & PWMSEQ_CYCLE_CTRL_Msk) != DMA_Mode_Stop ||
+            (alternate->DMA_Control & PWMSEQ_CYCLE_CTRL_Msk) != DMA_Mode_Stop)
+        {
+            *seq->ccr = seq->idle;
+            seq->underruns++;
+        }
+        woken = PWMSEQ_Finish(seq);
+    }
+
+#if PWMSEQ_BENCHMARK
+    seq->cycles += DWT->CYCCNT - start;
+#endif
+    return woken;
+}
+
+void PWMSEQ_Play(PWMSEQ_t *const seqs[], uint32_t count)
+{
+    uint32_t floor = 0;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        configASSERT(!seqs[i]->busy);
+        floor += seqs[i]->floor;
+    }
+    // Из задачи младше губернатора: на выходе из секции частота уже поднята, PSG пересчитан
+    taskENTER_CRITICAL();
+    PWMSEQ_Demand(floor, 0);
+    taskEXIT_CRITICAL();
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        PWMSEQ_t *seq = seqs[i];
+        DMA_CtrlDataTypeDef *primary = DMAM_Control(seq->feed, DMA_CTRL_DATA_PRIMARY);
+        DMA_CtrlDataTypeDef *alternate = DMAM_Control(seq->feed, DMA_CTRL_DATA_ALTERNATE);
+
+        // Счет стоит, CCR = idle: выход не меняется до запуска
+        seq->timer->CNTRL = 0;
+        seq->timer->CNT = 0;
+        seq->ending = 0;
+        seq->waiter = xTaskGetCurrentTaskHandle();
+        seq->busy = 1;
+
+        primary->DMA_DestEndAddr = (uint32_t)seq->ccr;
+        alternate->DMA_DestEndAddr = (uint32_t)seq->ccr;
+        PWMSEQ_Load(seq, 0);
+        if (!seq->ending)
+        {
+            PWMSEQ_Load(seq, 1);
+        }
+        else
+        {
+            alternate->DMA_Control = DMA_Mode_Stop;
+        }
+        DMAM_Control(seq->dma, DMA_CTRL_DATA_PRIMARY)->DMA_Control = seq->chainControl;
+        // Запросы от прошлого потока сбрасываются, первый придет на первом CNT = 0
+        seq->timer->STATUS = 0;
+        DMAM_Start(seq->feed);
+        DMAM_Start(seq->dma);
+    }
+
+    // Значение, записанное по запросу на CNT = 0, действует с периода после него:
+    // первые периоды на выходе idle
+    taskENTER_CRITICAL();
+    for (uint32_t i = 0; i < count; i++)
+    {
+        seqs[i]->timer->CNTRL = TIMER_CNTRL_CNT_EN;
+    }
+    taskEXIT_CRITICAL();
+}
+
+BaseType_t PWMSEQ_Wait(PWMSEQ_t *seq, TickType_t ticks)
+{
+    // Уведомление могло остаться от другого потока этой же задачи - проверяем busy
+    while (seq->busy)
+    {
+        if (ulTaskNotifyTakeIndexed(PWMSEQ_NOTIFY_INDEX, pdTRUE, ticks) == 0)
+        {
+            return pdFALSE;
+        }
+    }
+    return pdTRUE;
+}
+
+void PWMSEQ_Stop(PWMSEQ_t *seq)
+{
+    taskENTER_CRITICAL();
+    if (seq->busy)
+    {
+        *seq->ccr = seq->idle;
+        (void)PWMSEQ_Finish(seq);
+    }
+    taskEXIT_CRITICAL();
+}
+
+// Нотификатор CLK_SetFrequency: счет остается PWMSEQ_HZ
+static void PWMSEQ_Retune(CLK_Event_t event, uint32_t hz)
+{
+    if (event != CLK_SWITCH)
+    {
+        return;
+    }
+    for (uint32_t i = 0; i < PWMSEQ_TIMERS; i++)
+    {
+        if (sequencers[i] != NULL)
+        {
+            configASSERT(hz % PWMSEQ_HZ == 0);
+            sequencers[i]->timer->PSG = hz / PWMSEQ_HZ - 1;
+        }
+    }
+}
+
+uint32_t PWMSEQ_Ws2812Fill(PWMSEQ_t *seq, uint16_t *values, uint32_t count)
+{
+    PWMSEQ_Ws2812_t *strip = seq->arg;
+    uint32_t n = 0;
+
+    // Байт целиком - 8 периодов, старший бит первым. count кратен 8
+    while (n < count && strip->position < strip->bytes)
+    {
+        uint32_t byte = strip->grb[strip->position++];
+
+        for (uint32_t mask = 0x80; mask != 0; mask >>= 1)
+        {
+            values[n++] = (byte & mask) ? PWMSEQ_WS2812_T1H : PWMSEQ_WS2812_T0H;
+        }
+    }
+    // Пауза сброса тоже идет потоком: следующий кадр не начнется раньше нее
+    while (n < count && strip->reset != 0)
+    {
+        values[n++] = 0;
+        strip->reset--;
+    }
+    return n;
+}
+
+void PWMSEQ_Ws2812(PWMSEQ_t *seq, const uint8_t *grb, uint32_t leds)
+{
+    PWMSEQ_Ws2812_t *strip = seq->arg;
+
+    configASSERT(seq->fill == PWMSEQ_Ws2812Fill && seq->idle == 0 && (seq->half & 7) == 0);
+    strip->grb = grb;
+    strip->bytes = leds * 3;
+    strip->position = 0;
+    strip->reset = PWMSEQ_WS2812_RESET;
+    PWMSEQ_Play(&seq, 1);
+}
+
+#if PWMSEQ_BENCHMARK
+void PWMSEQ_GetStats(PWMSEQ_t *seq, PWMSEQ_Stats_t *stats)
+{
+    uint64_t now = UPTIME_GetCycles();
+    uint64_t elapsed = now - seq->since;
+    uint32_t refills;
+    uint64_t values, cycles;
+
+    taskENTER_CRITICAL();
+    refills = seq->refills;
+    values = seq->values;
+    cycles = seq->cycles;
+    seq->refills = 0;
+    seq->values = 0;
+    seq->cycles = 0;
+    taskEXIT_CRITICAL();
+    seq->since = now;
+
+    stats->refills = refills;
+    stats->cyclesPerRefill = refills != 0 ? (uint32_t)(cycles / refills) : 0;
+    stats->cyclesPer100Values = values != 0 ? (uint32_t)(cycles * 100 / values) : 0;
+    stats->loadPermille = elapsed != 0 ? (uint32_t)(cycles * 1000 / elapsed) : 0;
+}
+#endif
@@ -0,0 +1,23 @@
+# Сжатый образ .data во FLASH. После линковки tools/data_pack.py заменяет образ
+# по адресу _sidata на блок LZ4 и переписывает ELF (секция .data_lz, сегмент PT_LOAD),
+# Reset_Handler разворачивает его через CopyData из Startup/data_lz4.s.
+# Без опции CopyData - слабый псевдоним CopySection, копирование как раньше.
+# Выигрыш печатает data_pack.py, отчет линкера (--print-memory-usage) считает .data несжатой.
+# Вывода data_pack.py на настоящей прошивке пока нет (не было ARM-тулчейна): сжатие и такты
+# распаковки есть только на случайных образах в модели, lib/test/test_data_lz4.py.
+option(DATA_COMPRESS "Сжатие образа .data во FLASH (LZ4)" OFF)
+
+function(target_data_compress target)
+    if(NOT DATA_COMPRESS)
+        return()
+    endif()
+
+    find_package(Python3 REQUIRED COMPONENTS Interpreter)
+    target_sources(${target} PRIVATE ${CMAKE_SOURCE_DIR}/Startup/data_lz4.s)
+
+    add_custom_command(TARGET ${target} POST_BUILD
+        COMMAND Python3::Interpreter ${CMAKE_SOURCE_DIR}/tools/data_pack.py $<TARGET_FILE:${target}>
+        COMMENT "Compressing the .data image"
+        VERBATIM
+    )
+endfunction()
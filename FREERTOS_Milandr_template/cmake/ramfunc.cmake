@@ -0,0 +1,48 @@
+# Исполнение горячего кода из ОЗУ (FLASH на 80 МГц работает с 3 тактами ожидания).
+# Секция .ramfunc скрипта линкера всегда собирает __RAMFUNC (EXECUTABLE_MEMORY_SECTION)
+# и подключает сгенерированный ramfunc.ld. С опцией RAMFUNC в него попадают функции
+# из профиля RAMFUNC_PROFILE (по одной на строку, # - комментарий) и RAMFUNC_FUNCTIONS.
+# Строка со скобкой передается линкеру как есть, например *libc_nano.a:*memcpy*.o(.text*)
+option(RAMFUNC "Перенос горячих функций из профиля в ОЗУ" OFF)
+set(RAMFUNC_PROFILE ${CMAKE_SOURCE_DIR}/ramfunc.txt CACHE FILEPATH "Список функций для ОЗУ")
+set(RAMFUNC_FUNCTIONS "" CACHE STRING "Дополнительные функции для ОЗУ через ';'")
+
+function(target_ramfunc target)
+    set(gen_dir ${CMAKE_BINARY_DIR}/generated)
+    set(script "/* Сгенерировано cmake/ramfunc.cmake, не редактировать */\n")
+
+    if(RAMFUNC)
+        # Для замера RAMFUNC_BENCHMARK в app.c: какая это сборка
+        target_compile_definitions(${target} PRIVATE RAMFUNC_ENABLED)
+        set(names ${RAMFUNC_FUNCTIONS})
+        if(EXISTS "${RAMFUNC_PROFILE}")
+            file(STRINGS "${RAMFUNC_PROFILE}" profile ENCODING UTF-8 REGEX "^[^#]")
+            list(APPEND names ${profile})
+            set_property(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS ${RAMFUNC_PROFILE})
+        endif()
+
+        foreach(name IN LISTS names)
+            string(STRIP "${name}" name)
+            if(name STREQUAL "")
+                continue()
+            elseif(name MATCHES "\\(")
+                string(APPEND script "${name}\n")
+            else()
+                # -ffunction-sections: функция лежит в .text.<имя>, клоны в .text.<имя>.*
+                string(APPEND script "*(.text.${name} .text.${name}.*)\n")
+            endif()
+        endforeach()
+    endif()
+
+    # CONFIGURE не перезаписывает файл без изменений - нет лишней перелинковки
+    file(CONFIGURE OUTPUT ${gen_dir}/ramfunc.ld CONTENT "${script}" @ONLY)
+    target_link_options(${target} PRIVATE -L${gen_dir})
+    set_property(TARGET ${target} APPEND PROPERTY LINK_DEPENDS ${gen_dir}/ramfunc.ld)
+
+    # Расход ОЗУ под код - размер секции .ramfunc
+    add_custom_command(TARGET ${target} POST_BUILD
+        COMMAND ${SIZE} -A $<TARGET_FILE:${target}>
+        COMMENT "Section sizes (.ramfunc - code in RAM)"
+        VERBATIM
+    )
+endfunction()
@@ -0,0 +1,58 @@
+# Статический расчет стеков задач и прерываний.
+# С включенной опцией сборка идет в две стадии. Первая - объектная библиотека <цель>_su
+# из тех же исходников с теми же флагами и -fcallgraph-info=su, по ее *.ci
+# tools/stack_usage.py пишет stack_sizes.h + stack_usage.txt. Вторая - сама цель: заголовок
+# в ее исходниках, поэтому он готов до компиляции app.c, а правка любого исходника
+# пересчитывает его до линковки. Размеры стеков не зависят от них самих, так что
+# app.c первой стадии собирается с размерами по умолчанию без вреда для графа.
+option(STACK_USAGE "Расчет размеров стеков по графу вызовов" OFF)
+set(STACK_USAGE_TASKS "exampleTask;DFS_Task" CACHE STRING "Точки входа задач через ';'")
+set(STACK_USAGE_MARGIN 25 CACHE STRING "Запас к расчетному размеру стека, %")
+
+function(target_stack_usage target)
+    if(NOT STACK_USAGE)
+        return()
+    endif()
+
+    find_package(Python3 REQUIRED COMPONENTS Interpreter)
+    set(gen_dir ${CMAKE_BINARY_DIR}/generated)
+    set(analysis ${target}_su)
+
+    # Первая стадия. Опции и определения цели берутся при генерации, так что
+    # добавленные после этого вызова (ramfunc, data_compress) тоже попадут
+    get_target_property(sources ${target} SOURCES)
+    get_target_property(libraries ${target} LINK_LIBRARIES)
+    add_library(${analysis} OBJECT EXCLUDE_FROM_ALL ${sources})
+    if(libraries)
+        target_link_libraries(${analysis} PRIVATE ${libraries})
+    endif()
+    target_include_directories(${analysis} PRIVATE $<TARGET_PROPERTY:${target},INCLUDE_DIRECTORIES>)
+    # STACK_USAGE_ANALYSIS: заголовка еще нет, app.c берет размеры по умолчанию
+    target_compile_definitions(${analysis} PRIVATE
+        $<TARGET_PROPERTY:${target},COMPILE_DEFINITIONS>
+        STACK_USAGE_ANALYSIS
+    )
+    target_compile_options(${analysis} PRIVATE
+        $<TARGET_PROPERTY:${target},COMPILE_OPTIONS>
+        "$<$<COMPILE_LANGUAGE:C,CXX>:-fstack-usage;-fcallgraph-info=su>"
+    )
+
+    add_custom_command(
+        OUTPUT ${gen_dir}/stack_sizes.h ${CMAKE_BINARY_DIR}/stack_usage.txt
+        COMMAND Python3::Interpreter ${CMAKE_SOURCE_DIR}/tools/stack_usage.py
+            --objdir ${CMAKE_BINARY_DIR}/CMakeFiles/${analysis}.dir
+            --startup ${CMAKE_SOURCE_DIR}/Startup/startup_gcc_MDR32F9Q2I.s
+            --tasks "${STACK_USAGE_TASKS}"
+            --margin ${STACK_USAGE_MARGIN}
+            --header ${gen_dir}/stack_sizes.h
+            --report ${CMAKE_BINARY_DIR}/stack_usage.txt
+        DEPENDS ${analysis} $<TARGET_OBJECTS:${analysis}> ${CMAKE_SOURCE_DIR}/tools/stack_usage.py
+        COMMENT "Calculating stack usage"
+        VERBATIM
+    )
+
+    # Вторая стадия
+    target_sources(${target} PRIVATE ${gen_dir}/stack_sizes.h)
+    target_include_directories(${target} PRIVATE ${gen_dir})
+    target_compile_definitions(${target} PRIVATE STACK_USAGE_ENABLED)
+endfunction()
@@ -0,0 +1,193 @@
+#pragma once
+// Модель ядра Cortex-M3 для тестов времени: SysTick, ICSR/SHCSR и вход в SysTick_Handler.
+// Каждое обращение к SysTick или SCB - один такт ядра, CM3_Run - такты простоя.
+// Запись в VAL модель замечает на следующем обращении (VAL отличается от отданного):
+// счетчик обнуляется и перезагружается на следующем такте без запроса тика.
+// SysTick_Handler входит, когда нет PRIMASK, FAULTMASK, BASEPRI и критической секции, как
+// на кристалле: PENDSTSET снимается, SYSTICKACT ставится, потом первая инструкция; выход
+// снимает FAULTMASK. Прерывание cm3.irq - приоритет выше BASEPRI (или cm3.irqPriority, тогда
+// BASEPRI не выше него маскирует), маскируется PRIMASK и FAULTMASK, вытесняет и
+// SysTick_Handler. Такты, которые пришедшее cm3.irq ждало маски, - cm3.irqWait*.
+// Монитор исключительного доступа: LDREX открывает его, STREX пишет, только если он еще
+// открыт, и закрывает. Вход и выход из любого исключения монитор сбрасывают, как CLREX на
+// кристалле, поэтому cm3.irq между LDREX и STREX делает STREX неудачным. LDREX и STREX -
+// по такту ядра
+#include "host.h"
+
+typedef struct
+{
+    uint32_t CTRL, LOAD, VAL, CALIB;
+} SysTick_Type;
+
+typedef struct
+{
+    uint32_t ICSR;
+    uintptr_t VTOR; // на хосте указатель шире 32 бит
+    uint32_t SHCSR;
+} SCB_Type;
+
+#define SysTick_CTRL_ENABLE_Msk    (1UL << 0)
+#define SysTick_CTRL_TICKINT_Msk   (1UL << 1)
+#define SysTick_CTRL_CLKSOURCE_Msk (1UL << 2)
+#define SysTick_CTRL_COUNTFLAG_Msk (1UL << 16)
+#define SysTick_LOAD_RELOAD_Msk    (0xFFFFFFUL)
+#define SCB_ICSR_PENDSTSET_Msk     (1UL << 26)
+#define SCB_SHCSR_SYSTICKACT_Msk   (1UL << 11)
+
+void SysTick_Handler(void);
+
+static struct
+{
+    SysTick_Type systick;
+    SCB_Type scb;
+    uint32_t counter;
+    uint32_t shownVal;         // VAL, отданный последним обращением
+    int pend, active, inIrq;
+    uint64_t cycles;
+    uint64_t wraps;            // счетчик дошел до 0: периодов SysTick
+    double ns;                 // время по тактам модели
+    uint32_t (*clock)(void);   // частота на этом такте (модель тактов), иначе SystemCoreClock
+    void (*entryHook)(void);   // между снятием PENDSTSET и первой инструкцией SysTick_Handler
+    void (*irq)(void);
+    uint32_t irqPeriod;        // тактов между запросами cm3.irq, 0 - не приходит
+    uint32_t irqCountdown;
+    uint32_t irqPriority;      // 0 - выше BASEPRI, иначе значение приоритета, как в NVIC
+    uint32_t irqWaiting;       // тактов ждет маски текущий запрос
+    uint64_t irqWaitTotal, irqWaitMax, irqCount;
+    int exclusive;             // монитор открыт LDREX
+    uint64_t ldrex, strex, strexFailed;
+} cm3;
+
+static void CM3_Dispatch(void);
+
+static void CM3_Refresh(void)
+{
+    cm3.systick.VAL = cm3.shownVal = cm3.counter;
+    cm3.scb.ICSR = cm3.pend ? SCB_ICSR_PENDSTSET_Msk : 0;
+    cm3.scb.SHCSR = cm3.active ? SCB_SHCSR_SYSTICKACT_Msk : 0;
+}
+
+static void CM3_Clock(void)
+{
+    SysTick_Type *t = &cm3.systick;
+    uint32_t hz = cm3.clock != NULL ? cm3.clock() : SystemCoreClock;
+
+    hostUnmaskHook = CM3_Dispatch; // с первого такта: снятие маски пускает отложенный тик
+
+    if (t->VAL != cm3.shownVal)
+    {
+        cm3.counter = 0;
+        t->CTRL &= ~SysTick_CTRL_COUNTFLAG_Msk;
+    }
+    cm3.cycles++;
+    cm3.ns += 1e9 / hz;
+    if (cm3.irqPeriod != 0 && cm3.irqCountdown == 0 && !cm3.inIrq)
+    {
+        cm3.irqWaiting++;
+    }
+    if (t->CTRL & SysTick_CTRL_ENABLE_Msk)
+    {
+        if (cm3.counter == 0)
+        {
+            cm3.counter = t->LOAD & SysTick_LOAD_RELOAD_Msk;
+        }
+        else if (--cm3.counter == 0)
+        {
+            cm3.wraps++;
+            t->CTRL |= SysTick_CTRL_COUNTFLAG_Msk;
+            if (t->CTRL & SysTick_CTRL_TICKINT_Msk)
+            {
+                cm3.pend = 1;
+            }
+        }
+    }
+    CM3_Refresh();
+}
+
+static void CM3_Dispatch(void)
+{
+    if (cm3.irqPeriod != 0 && cm3.irqCountdown != 0)
+    {
+        cm3.irqCountdown--;
+    }
+    if (cm3.irqPeriod != 0 && cm3.irqCountdown == 0 && !cm3.inIrq && !hostPrimask && !hostFaultmask &&
+        (cm3.irqPriority == 0 || hostBasepri == 0 || cm3.irqPriority < hostBasepri))
+    {
+        uint32_t wait = cm3.irqWaiting;
+
+        cm3.irqWaitTotal += wait;
+        cm3.irqWaitMax = wait > cm3.irqWaitMax ? wait : cm3.irqWaitMax;
+        cm3.irqCount++;
+        cm3.irqWaiting = 0;
+        cm3.irqCountdown = cm3.irqPeriod;
+        cm3.inIrq = 1;
+        cm3.exclusive = 0;
+        cm3.irq();
+        cm3.exclusive = 0;
+        cm3.inIrq = 0;
+    }
+    if (cm3.pend && !cm3.active && !cm3.inIrq && !hostPrimask && !hostFaultmask && hostBasepri == 0 && hostCritical == 0)
+    {
+        cm3.pend = 0;
+        cm3.active = 1;
+        CM3_Refresh();
+        if (cm3.entryHook != NULL)
+        {
+            cm3.entryHook();
+        }
+        cm3.exclusive = 0;
+        SysTick_Handler();
+        cm3.exclusive = 0;
+        hostFaultmask = 0;
+        cm3.active = 0;
+        CM3_Refresh();
+    }
+}
+
+static void CM3_Run(uint32_t cycles)
+{
+    while (cycles-- != 0)
+    {
+        CM3_Clock();
+        CM3_Dispatch();
+    }
+}
+
+static SysTick_Type *CM3_SysTick(void)
+{
+    CM3_Run(1);
+    return &cm3.systick;
+}
+
+static SCB_Type *CM3_Scb(void)
+{
+    CM3_Run(1);
+    return &cm3.scb;
+}
+
+static inline uint32_t __LDREXW(volatile uint32_t *addr)
+{
+    CM3_Run(1);
+    cm3.ldrex++;
+    cm3.exclusive = 1;
+    return *addr;
+}
+
+static inline uint32_t __STREXW(uint32_t value, volatile uint32_t *addr)
+{
+    CM3_Run(1); // прерывание перед STREX закрывает монитор
+    cm3.strex++;
+    if (!cm3.exclusive)
+    {
+        cm3.strexFailed++;
+        return 1;
+    }
+    cm3.exclusive = 0;
+    *addr = value;
+    return 0;
+}
+
+static inline void __CLREX(void) { cm3.exclusive = 0; }
+
+#define SysTick (CM3_SysTick())
+#define SCB     (CM3_Scb())
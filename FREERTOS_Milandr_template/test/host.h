@@ -0,0 +1,134 @@
+#pragma once
+// Окружение прошивки для хост-тестов test_*.c. Тест включает исходник из app/src целиком
+// (статические функции и переменные видны), а все, что тот берет из app.h, FreeRTOS, CMSIS
+// и SPL, определяет сам поверх этого файла. Критические секции, BASEPRI, VTOR - переменные,
+// периферия - модели в тесте. Один тест - один исполняемый файл, см. CMakeLists.txt.
+// Тесты ядра FreeRTOS (HOST_RTOS) берут типы и критические секции из настоящих заголовков
+// FreeRTOS и порта rtos/portmacro.h
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define _APP_H_ // app.h не нужен: его содержимое дает тест
+
+#ifndef HOST_RTOS
+// FreeRTOS
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void *TaskHandle_t;
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE  ((BaseType_t)1)
+#define pdPASS  pdTRUE
+#define pdFAIL  pdFALSE
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+
+#define configPRIO_BITS 4
+#define configTICK_RATE_HZ ((TickType_t)1000)
+#define configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY 5
+#define configMAX_SYSCALL_INTERRUPT_PRIORITY (configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY << (8 - configPRIO_BITS))
+#endif
+
+// SPL
+typedef enum { ERROR = 0, SUCCESS = !ERROR } ErrorStatus;
+typedef enum { DISABLE = 0, ENABLE = !DISABLE } FunctionalState;
+
+#define __RAMFUNC
+#define __DMA_RAM
+#define __NOINIT
+
+static uint32_t SystemCoreClock = 8000000;
+
+// Проверки
+static int hostFailures;
+static int hostAsserts; // сработавших configASSERT: тест может ждать их намеренно
+
+#define CHECK(cond)                                                          \
+    do                                                                       \
+    {                                                                        \
+        if (!(cond))                                                         \
+        {                                                                    \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            hostFailures++;                                                  \
+        }                                                                    \
+    } while (0)
+
+#define configASSERT(x)     \
+    do                      \
+    {                       \
+        if (!(x))           \
+        {                   \
+            hostAsserts++;  \
+        }                   \
+    } while (0)
+
+static int HOST_Result(const char *name)
+{
+    if (hostFailures != 0)
+    {
+        printf("%s: %d failed\n", name, hostFailures);
+        return 1;
+    }
+    printf("%s: ok\n", name);
+    return 0;
+}
+
+// Ядро: маска прерываний и барьеры
+static uint32_t hostBasepri;
+static uint32_t hostPrimask;
+static uint32_t hostFaultmask; // снимает выход из обработчика, см. cm3.h
+static int hostCritical; // вложенность taskENTER_CRITICAL
+static void (*hostBasepriHook)(uint32_t value); // модели, которым важно время под маской
+static void (*hostUnmaskHook)(void); // модель ядра: отложенное прерывание входит сразу
+
+static inline void HOST_Unmasked(void)
+{
+    if (hostUnmaskHook != NULL)
+    {
+        hostUnmaskHook();
+    }
+}
+
+static inline uint32_t __get_BASEPRI(void) { return hostBasepri; }
+static inline void __set_BASEPRI(uint32_t value)
+{
+    hostBasepri = value;
+    if (hostBasepriHook != NULL)
+    {
+        hostBasepriHook(value);
+    }
+    if (value == 0)
+    {
+        HOST_Unmasked();
+    }
+}
+static inline uint32_t __get_PRIMASK(void) { return hostPrimask; }
+static inline void __set_PRIMASK(uint32_t value)
+{
+    hostPrimask = value;
+    if (value == 0)
+    {
+        HOST_Unmasked();
+    }
+}
+static inline void __set_FAULTMASK(uint32_t value) { hostFaultmask = value; }
+static inline void __disable_irq(void) { hostPrimask = 1; }
+static inline void __enable_irq(void) { __set_PRIMASK(0); }
+#define __ISB() ((void)0)
+#define __DSB() ((void)0)
+#define __DMB() ((void)0)
+#define __NOP() ((void)0)
+
+#ifndef HOST_RTOS
+#define taskENTER_CRITICAL() (hostCritical++)
+#define taskEXIT_CRITICAL()       \
+    do                            \
+    {                             \
+        if (--hostCritical == 0)  \
+        {                         \
+            HOST_Unmasked();      \
+        }                         \
+    } while (0)
+#endif
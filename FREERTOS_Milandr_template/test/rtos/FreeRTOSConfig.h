@@ -0,0 +1,38 @@
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+// FreeRTOSConfig.h тестов ядра (rtos_test в CMakeLists.txt). Подключается ключом -include
+// раньше всего, поэтому одноименный файл прошивки из FreeRTOS/include пропускается по защите
+// FREERTOS_CONFIG_H. Значения - как у прошивки там, где от них зависит проверяемый код ядра.
+// Планировщика нет: функции tasks.c, которые зовут очереди и буферы, дает rtos/tasks.h
+#define HOST_RTOS
+#include "host.h"
+
+#define configCPU_CLOCK_HZ                    (SystemCoreClock)
+#define configTICK_RATE_HZ                    ((TickType_t)1000)
+#define configMINIMAL_STACK_SIZE              ((unsigned short)130)
+#define configMAX_PRIORITIES                  (5)
+#define configUSE_PREEMPTION                  1
+#define configMAX_TASK_NAME_LEN               (10)
+#define configUSE_TIMERS                      0
+#define configUSE_MUTEXES                     1
+#define configUSE_RECURSIVE_MUTEXES           1
+#define configUSE_COUNTING_SEMAPHORES         1
+#define configUSE_QUEUE_SETS                  1
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES 7
+#define configUSE_IDLE_HOOK                   0
+#define configUSE_TICK_HOOK                   0
+#define configUSE_16_BIT_TICKS                0
+#define configUSE_PORT_ATOMICS                1
+#define configSUPPORT_DYNAMIC_ALLOCATION      1
+#define configSUPPORT_STATIC_ALLOCATION       1
+
+#define configPRIO_BITS                              4
+#define configLIBRARY_LOWEST_INTERRUPT_PRIORITY      15
+#define configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY 5
+#define configKERNEL_INTERRUPT_PRIORITY      (configLIBRARY_LOWEST_INTERRUPT_PRIORITY << (8 - configPRIO_BITS))
+#define configMAX_SYSCALL_INTERRUPT_PRIORITY (configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY << (8 - configPRIO_BITS))
+
+#define INCLUDE_vTaskSuspend                  1
+#define INCLUDE_xTaskGetSchedulerState        1
+
+#endif
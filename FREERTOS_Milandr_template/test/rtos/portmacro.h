@@ -0,0 +1,87 @@
+#ifndef PORTMACRO_H
+#define PORTMACRO_H
+// Порт FreeRTOS для тестов ядра на хосте. Критическая секция - вложенность hostCritical,
+// маска FromISR - hostBasepri из host.h. Переключение контекста - TASK_Yield модели
+// планировщика rtos/tasks.h, LDREX/STREX - монитор cm3.h
+#include <stdint.h>
+
+typedef uint32_t StackType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define portCHAR          char
+#define portFLOAT         float
+#define portDOUBLE        double
+#define portLONG          long
+#define portSHORT         short
+#define portSTACK_TYPE    uint32_t
+#define portBASE_TYPE     long
+
+#define portMAX_DELAY              ((TickType_t)0xffffffffUL)
+#define portTICK_TYPE_IS_ATOMIC    1
+#define portSTACK_GROWTH           (-1)
+#define portTICK_PERIOD_MS         ((TickType_t)1000 / configTICK_RATE_HZ)
+#define portBYTE_ALIGNMENT         8
+#define portDONT_DISCARD           __attribute__((used))
+#define portNOP()
+#define portINLINE                 __inline
+#define portFORCE_INLINE           inline __attribute__((always_inline))
+#define portMEMORY_BARRIER()       __asm volatile("" ::: "memory")
+
+#define portTASK_FUNCTION_PROTO(vFunction, pvParameters) void vFunction(void *pvParameters)
+#define portTASK_FUNCTION(vFunction, pvParameters)       void vFunction(void *pvParameters)
+
+static void TASK_Yield(void);
+#define portYIELD()                              TASK_Yield()
+#define portEND_SWITCHING_ISR(xSwitchRequired)   if ((xSwitchRequired) != pdFALSE) portYIELD()
+#define portYIELD_FROM_ISR(x)                    portEND_SWITCHING_ISR(x)
+
+// Замеры времени под маской: вход (1) и выход (0) внешней критической секции задачи.
+// Маску FromISR видит hostBasepriHook
+static void (*hostCriticalHook)(int entered);
+
+static inline void vPortEnterCritical(void)
+{
+    if (hostCritical++ == 0 && hostCriticalHook != NULL)
+    {
+        hostCriticalHook(1);
+    }
+}
+
+static inline void vPortExitCritical(void)
+{
+    if (--hostCritical == 0)
+    {
+        if (hostCriticalHook != NULL)
+        {
+            hostCriticalHook(0);
+        }
+        HOST_Unmasked();
+    }
+}
+
+static inline uint32_t ulPortRaiseBASEPRI(void)
+{
+    uint32_t old = __get_BASEPRI();
+    __set_BASEPRI(configMAX_SYSCALL_INTERRUPT_PRIORITY);
+    return old;
+}
+
+#define portSET_INTERRUPT_MASK_FROM_ISR()      ulPortRaiseBASEPRI()
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR(x)   __set_BASEPRI(x)
+#define portDISABLE_INTERRUPTS()               __set_BASEPRI(configMAX_SYSCALL_INTERRUPT_PRIORITY)
+#define portENABLE_INTERRUPTS()                __set_BASEPRI(0)
+#define portENTER_CRITICAL()                   vPortEnterCritical()
+#define portEXIT_CRITICAL()                    vPortExitCritical()
+
+// Исключительный доступ atomic.h - монитор модели cm3.h, ее подключает тест атомиков
+#define portHAS_EXCLUSIVE_ACCESS               1
+static inline uint32_t __LDREXW(volatile uint32_t *addr);
+static inline uint32_t __STREXW(uint32_t value, volatile uint32_t *addr);
+static inline void __CLREX(void);
+#define ulPortLoadExclusive(address)           __LDREXW(address)
+#define ulPortStoreExclusive(address, value)   __STREXW((value), (address))
+#define vPortClearExclusive()                  __CLREX()
+
+#endif
@@ -0,0 +1,266 @@
+#pragma once
+// Модель tasks.c для тестов ядра: то, что зовут queue.c и stream_buffer.c. Бежит одна
+// задача taskCurrent, остальные задачи - только TCB, которые тест ставит в списки событий
+// (TASK_Block) и смотрит, кого разбудили. Когда текущая задача засыпает (портовый yield
+// после vTaskPlaceOnEventList или ожидание уведомления), выполняется taskSleepHook - все,
+// что происходит, пока она спит (прерывания, другие задачи). Если и после него ее не
+// разбудили, проходит таймаут: тики идут на время ожидания, задача снимается со списка.
+// Бесконечное ожидание без пробуждения - ошибка теста
+#include "FreeRTOS.h"
+#include "task.h"
+#include "list.h"
+
+typedef struct tskTaskControlBlock
+{
+    ListItem_t xEventListItem;
+    UBaseType_t uxPriority;
+    TickType_t xBlockTicks;    // время ожидания, с которым задача заснула
+    uint32_t ulNotifiedValue[configTASK_NOTIFICATION_ARRAY_ENTRIES];
+    uint8_t ucNotifyState[configTASK_NOTIFICATION_ARRAY_ENTRIES];
+    uint32_t wakes;            // сколько раз задачу будили событием или уведомлением
+} TCB_t;
+
+#define TASK_NOT_WAITING 0
+#define TASK_WAITING     1
+#define TASK_RECEIVED    2
+
+static TCB_t taskMain = {.uxPriority = 1};
+static TCB_t *taskCurrent = &taskMain;
+static TickType_t taskTicks;
+static UBaseType_t taskCount = 3;  // uxTaskGetNumberOfTasks: ограничивает счетчики блокировок очереди
+static int taskSuspended;
+static int taskYields;       // запросов переключения контекста
+static int taskMissedYields;
+static int taskSleeping;
+static void (*taskSleepHook)(void);
+
+static void TASK_Init(TCB_t *tcb, UBaseType_t priority)
+{
+    memset(tcb, 0, sizeof(*tcb));
+    tcb->uxPriority = priority;
+    vListInitialiseItem(&tcb->xEventListItem);
+    listSET_LIST_ITEM_OWNER(&tcb->xEventListItem, tcb);
+    listSET_LIST_ITEM_VALUE(&tcb->xEventListItem, (TickType_t)configMAX_PRIORITIES - priority);
+}
+
+// Чужая задача ждет на списке событий объекта (как ее поставил бы vTaskPlaceOnEventList)
+static void TASK_Block(TCB_t *tcb, List_t *list)
+{
+    vListInsert(list, &tcb->xEventListItem);
+}
+
+static int TASK_Blocked(const TCB_t *tcb)
+{
+    return listLIST_ITEM_CONTAINER(&tcb->xEventListItem) != NULL;
+}
+
+// Текущая задача засыпает до события или таймаута
+static void TASK_Sleep(int (*awake)(void))
+{
+    if (taskSleeping)
+    {
+        return;
+    }
+    taskSleeping = 1;
+    if (taskSleepHook != NULL)
+    {
+        taskSleepHook();
+    }
+    if (!awake())
+    {
+        if (taskCurrent->xBlockTicks == portMAX_DELAY)
+        {
+            printf("tasks.h: бесконечное ожидание без пробуждения\n");
+            hostFailures++;
+        }
+        taskTicks += taskCurrent->xBlockTicks;
+        if (TASK_Blocked(taskCurrent))
+        {
+            (void)uxListRemove(&taskCurrent->xEventListItem);
+        }
+    }
+    taskSleeping = 0;
+}
+
+static int TASK_EventArrived(void)
+{
+    return !TASK_Blocked(taskCurrent);
+}
+
+// Портовый yield: если текущая задача встала в список событий - она спит
+static void TASK_Yield(void)
+{
+    taskYields++;
+    if (TASK_Blocked(taskCurrent))
+    {
+        TASK_Sleep(TASK_EventArrived);
+    }
+}
+
+void *pvPortMalloc(size_t size) { return malloc(size); }
+void vPortFree(void *pv) { free(pv); }
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) { return taskCurrent; }
+UBaseType_t uxTaskGetNumberOfTasks(void) { return taskCount; }
+BaseType_t xTaskGetSchedulerState(void) { return taskSuspended ? taskSCHEDULER_SUSPENDED : taskSCHEDULER_RUNNING; }
+void vTaskSuspendAll(void) { taskSuspended++; }
+BaseType_t xTaskResumeAll(void)
+{
+    taskSuspended--;
+    return pdFALSE;
+}
+void vTaskMissedYield(void) { taskMissedYields++; }
+
+void vTaskInternalSetTimeOutState(TimeOut_t *const pxTimeOut)
+{
+    pxTimeOut->xOverflowCount = 0;
+    pxTimeOut->xTimeOnEntering = taskTicks;
+}
+void vTaskSetTimeOutState(TimeOut_t *const pxTimeOut) { vTaskInternalSetTimeOutState(pxTimeOut); }
+
+BaseType_t xTaskCheckForTimeOut(TimeOut_t *const pxTimeOut, TickType_t *const pxTicksToWait)
+{
+    TickType_t elapsed = taskTicks - pxTimeOut->xTimeOnEntering;
+
+    if (*pxTicksToWait == portMAX_DELAY)
+    {
+        return pdFALSE;
+    }
+    if (elapsed < *pxTicksToWait)
+    {
+        *pxTicksToWait -= elapsed;
+        vTaskInternalSetTimeOutState(pxTimeOut);
+        return pdFALSE;
+    }
+    *pxTicksToWait = 0;
+    return pdTRUE;
+}
+
+void vTaskPlaceOnEventList(List_t *const pxEventList, const TickType_t xTicksToWait)
+{
+    listSET_LIST_ITEM_OWNER(&taskCurrent->xEventListItem, taskCurrent);
+    listSET_LIST_ITEM_VALUE(&taskCurrent->xEventListItem, (TickType_t)configMAX_PRIORITIES - taskCurrent->uxPriority);
+    taskCurrent->xBlockTicks = xTicksToWait;
+    vListInsert(pxEventList, &taskCurrent->xEventListItem);
+}
+
+BaseType_t xTaskRemoveFromEventList(const List_t *const pxEventList)
+{
+    TCB_t *tcb = listGET_OWNER_OF_HEAD_ENTRY(pxEventList);
+
+    (void)uxListRemove(&tcb->xEventListItem);
+    tcb->wakes++;
+    return tcb->uxPriority > taskCurrent->uxPriority ? pdTRUE : pdFALSE;
+}
+
+// Мьютексы: наследования приоритета в модели нет
+BaseType_t xTaskPriorityInherit(TaskHandle_t const pxMutexHolder) { (void)pxMutexHolder; return pdFALSE; }
+BaseType_t xTaskPriorityDisinherit(TaskHandle_t const pxMutexHolder) { (void)pxMutexHolder; return pdFALSE; }
+void vTaskPriorityDisinheritAfterTimeout(TaskHandle_t const pxMutexHolder, UBaseType_t uxHighestPriorityWaitingTask)
+{
+    (void)pxMutexHolder;
+    (void)uxHighestPriorityWaitingTask;
+}
+TaskHandle_t pvTaskIncrementMutexHeldCount(void) { return taskCurrent; }
+
+static BaseType_t TASK_Notify(TCB_t *tcb, UBaseType_t index, uint32_t value, eNotifyAction action, uint32_t *previous)
+{
+    configASSERT(index < configTASK_NOTIFICATION_ARRAY_ENTRIES);
+    if (previous != NULL)
+    {
+        *previous = tcb->ulNotifiedValue[index];
+    }
+    switch (action)
+    {
+    case eSetBits:
+        tcb->ulNotifiedValue[index] |= value;
+        break;
+    case eIncrement:
+        tcb->ulNotifiedValue[index]++;
+        break;
+    case eSetValueWithOverwrite:
+        tcb->ulNotifiedValue[index] = value;
+        break;
+    case eSetValueWithoutOverwrite:
+        if (tcb->ucNotifyState[index] == TASK_RECEIVED)
+        {
+            return pdFAIL;
+        }
+        tcb->ulNotifiedValue[index] = value;
+        break;
+    default:
+        break;
+    }
+    if (tcb->ucNotifyState[index] == TASK_WAITING)
+    {
+        tcb->wakes++;
+    }
+    tcb->ucNotifyState[index] = TASK_RECEIVED;
+    return pdPASS;
+}
+
+BaseType_t xTaskGenericNotify(TaskHandle_t xTaskToNotify, UBaseType_t uxIndexToNotify, uint32_t ulValue,
+                              eNotifyAction eAction, uint32_t *pulPreviousNotificationValue)
+{
+    return TASK_Notify(xTaskToNotify, uxIndexToNotify, ulValue, eAction, pulPreviousNotificationValue);
+}
+
+BaseType_t xTaskGenericNotifyFromISR(TaskHandle_t xTaskToNotify, UBaseType_t uxIndexToNotify, uint32_t ulValue,
+                                     eNotifyAction eAction, uint32_t *pulPreviousNotificationValue,
+                                     BaseType_t *pxHigherPriorityTaskWoken)
+{
+    BaseType_t result = TASK_Notify(xTaskToNotify, uxIndexToNotify, ulValue, eAction, pulPreviousNotificationValue);
+
+    if (pxHigherPriorityTaskWoken != NULL && xTaskToNotify->uxPriority > taskCurrent->uxPriority)
+    {
+        *pxHigherPriorityTaskWoken = pdTRUE;
+    }
+    return result;
+}
+
+static UBaseType_t taskWaitIndex;
+
+static int TASK_NotificationArrived(void)
+{
+    return taskCurrent->ucNotifyState[taskWaitIndex] == TASK_RECEIVED;
+}
+
+BaseType_t xTaskGenericNotifyWait(UBaseType_t uxIndexToWait, uint32_t ulBitsToClearOnEntry, uint32_t ulBitsToClearOnExit,
+                                  uint32_t *pulNotificationValue, TickType_t xTicksToWait)
+{
+    TCB_t *tcb = taskCurrent;
+    BaseType_t result = pdFALSE;
+
+    if (tcb->ucNotifyState[uxIndexToWait] != TASK_RECEIVED)
+    {
+        tcb->ulNotifiedValue[uxIndexToWait] &= ~ulBitsToClearOnEntry;
+        if (xTicksToWait != 0)
+        {
+            tcb->ucNotifyState[uxIndexToWait] = TASK_WAITING;
+            tcb->xBlockTicks = xTicksToWait;
+            taskWaitIndex = uxIndexToWait;
+            taskYields++;
+            TASK_Sleep(TASK_NotificationArrived);
+        }
+    }
+    if (pulNotificationValue != NULL)
+    {
+        *pulNotificationValue = tcb->ulNotifiedValue[uxIndexToWait];
+    }
+    if (tcb->ucNotifyState[uxIndexToWait] == TASK_RECEIVED)
+    {
+        tcb->ulNotifiedValue[uxIndexToWait] &= ~ulBitsToClearOnExit;
+        result = pdTRUE;
+    }
+    tcb->ucNotifyState[uxIndexToWait] = TASK_NOT_WAITING;
+    return result;
+}
+
+BaseType_t xTaskGenericNotifyStateClear(TaskHandle_t xTask, UBaseType_t uxIndexToClear)
+{
+    TCB_t *tcb = xTask != NULL ? xTask : taskCurrent;
+    BaseType_t result = tcb->ucNotifyState[uxIndexToClear] == TASK_RECEIVED ? pdPASS : pdFAIL;
+
+    tcb->ucNotifyState[uxIndexToClear] = TASK_NOT_WAITING;
+    return result;
+}
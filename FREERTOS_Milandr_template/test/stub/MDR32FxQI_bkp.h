@@ -0,0 +1,11 @@
+#pragma once
+// Тип MDR32FxQI_bkp.h для clk_config.h
+#include <stdint.h>
+
+typedef enum
+{
+    BKP_DUcc_upto_10MHz = ((uint32_t)0x00),
+    BKP_DUcc_upto_40MHz = ((uint32_t)0x05),
+    BKP_DUcc_upto_80MHz = ((uint32_t)0x06),
+    BKP_DUcc_over_80MHz = ((uint32_t)0x07),
+} BKP_DUcc_Mode;
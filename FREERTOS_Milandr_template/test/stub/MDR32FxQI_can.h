@@ -0,0 +1,8 @@
+#pragma once
+// Типы MDR32FxQI_can.h для clk_config.h: тестам CAN не нужен, значения не важны
+#include <stdint.h>
+
+typedef enum { CAN_PSEG_Mul_1TQ } CAN_Propagation_Time;
+typedef enum { CAN_SEG1_Mul_1TQ } CAN_Phase_Seg1_Time;
+typedef enum { CAN_SEG2_Mul_1TQ } CAN_Phase_Seg2_Time;
+typedef enum { CAN_SJW_Mul_1TQ } CAN_SJW_Time;
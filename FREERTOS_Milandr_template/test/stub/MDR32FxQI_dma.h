@@ -0,0 +1,67 @@
+#pragma once
+// Типы и константы MDR32FxQI_dma.h для dma.h. Регистры контроллера - модель в тесте
+#include <stdint.h>
+
+typedef struct
+{
+    uint32_t DMA_SourceEndAddr;
+    uint32_t DMA_DestEndAddr;
+    uint32_t DMA_Control;
+    uint32_t DMA_Unused;
+} DMA_CtrlDataTypeDef;
+
+typedef enum
+{
+    DMA_CTRL_DATA_PRIMARY,
+    DMA_CTRL_DATA_ALTERNATE,
+} DMA_Data_Struct_Selection;
+
+enum
+{
+    DMA_Channel_UART1_TX = ((uint8_t)(0)),
+    DMA_Channel_UART2_TX = ((uint8_t)(2)),
+    DMA_Channel_TIM1     = ((uint8_t)(10)),
+    DMA_Channel_TIM2     = ((uint8_t)(11)),
+    DMA_Channel_TIM3     = ((uint8_t)(12)),
+    DMA_Channel_SW1      = ((uint8_t)(13)),
+};
+
+typedef enum
+{
+    DMA_SourceIncByte     = ((uint32_t)0x00),
+    DMA_SourceIncHalfword = ((uint32_t)0x01),
+    DMA_SourceIncWord     = ((uint32_t)0x02),
+    DMA_SourceIncNo       = ((uint32_t)0x03),
+} DMA_Src_Inc_Mode;
+
+typedef enum
+{
+    DMA_DestIncByte     = ((uint32_t)0x00),
+    DMA_DestIncHalfword = ((uint32_t)0x01),
+    DMA_DestIncWord     = ((uint32_t)0x02),
+    DMA_DestIncNo       = ((uint32_t)0x03),
+} DMA_Dest_Inc_Mode;
+
+typedef enum
+{
+    DMA_MemoryDataSize_Byte     = ((uint32_t)(0x00 << 24)),
+    DMA_MemoryDataSize_HalfWord = ((uint32_t)(0x11 << 24)),
+    DMA_MemoryDataSize_Word     = ((uint32_t)(0x22 << 24)),
+} DMA_Mem_Data_Size;
+
+typedef enum
+{
+    DMA_Mode_Stop          = ((uint32_t)0x0),
+    DMA_Mode_Basic         = ((uint32_t)0x1),
+    DMA_Mode_AutoRequest   = ((uint32_t)0x2),
+    DMA_Mode_PingPong      = ((uint32_t)0x3),
+    DMA_Mode_PerScatterPri = ((uint32_t)0x6),
+    DMA_Mode_PerScatterAlt = ((uint32_t)0x7),
+} DMA_Operating_Mode;
+
+typedef enum
+{
+    DMA_Transfers_1  = ((uint32_t)(0x00 << 14)),
+    DMA_Transfers_4  = ((uint32_t)(0x02 << 14)),
+    DMA_Transfers_16 = ((uint32_t)(0x04 << 14)),
+} DMA_Number_Continuous_Transfers;
@@ -0,0 +1,11 @@
+#pragma once
+// Тип MDR32FxQI_eeprom.h для clk_config.h
+#include <stdint.h>
+
+typedef enum
+{
+    EEPROM_Latency_0 = ((uint32_t)0x00),
+    EEPROM_Latency_1 = ((uint32_t)0x08),
+    EEPROM_Latency_2 = ((uint32_t)0x10),
+    EEPROM_Latency_3 = ((uint32_t)0x18),
+} EEPROM_Latency_Cycles;
@@ -0,0 +1,55 @@
+#pragma once
+// Типы MDR32FxQI_rst_clk.h, которые нужны clk_config.h. Регистры и функции - модель в тесте
+#include <stdint.h>
+
+#define HSI_Value ((uint32_t)8000000)
+#define HSE_Value ((uint32_t)8000000) // как в MDR32FxQI_config.h, clk.h подменяет на CLK_HSE_HZ
+
+typedef enum
+{
+    RST_CLK_HSE_OFF = ((uint32_t)0x00),
+    RST_CLK_HSE_ON  = ((uint32_t)0x01),
+} RST_CLK_HSE_Mode;
+
+typedef enum
+{
+    RST_CLK_CPU_PLLsrcHSIdiv1 = ((uint32_t)0x00),
+    RST_CLK_CPU_PLLsrcHSEdiv1 = ((uint32_t)0x02),
+} RST_CLK_CPU_PLL_Source;
+
+typedef enum
+{
+    RST_CLK_CPU_C1srcHSIdiv1 = ((uint32_t)0x00),
+    RST_CLK_CPU_C1srcHSEdiv1 = ((uint32_t)0x02),
+} RST_CLK_CPU_C1_Source;
+
+typedef enum
+{
+    RST_CLK_CPU_PLLmul1 = ((uint32_t)0x00),
+    RST_CLK_CPU_PLLmul16 = ((uint32_t)0x0F),
+} RST_CLK_CPU_PLL_Multiplier;
+
+typedef enum
+{
+    RST_CLK_CPUclkDIV1   = ((uint32_t)0x00),
+    RST_CLK_CPUclkDIV2   = ((uint32_t)0x08),
+    RST_CLK_CPUclkDIV256 = ((uint32_t)0x0F),
+} RST_CLK_CPU_C3_Divisor;
+
+typedef enum
+{
+    RST_CLK_CPUclkHSI    = ((uint32_t)0x0000),
+    RST_CLK_CPUclkCPU_C3 = ((uint32_t)0x0100),
+} RST_CLK_HCLK_Source;
+
+#define RST_CLK_CLOCK_STATUS_PLL_CPU_RDY    ((uint32_t)0x00000002)
+#define RST_CLK_CLOCK_STATUS_HSE_RDY        ((uint32_t)0x00000004)
+#define RST_CLK_PLL_CONTROL_PLL_CPU_ON      ((uint32_t)0x00000004)
+#define RST_CLK_PLL_CONTROL_PLL_CPU_MUL_Pos 8
+#define RST_CLK_PLL_CONTROL_PLL_CPU_MUL_Msk ((uint32_t)0x00000F00)
+#define RST_CLK_UART_CLOCK_UART1_BRG_Pos    0
+#define RST_CLK_UART_CLOCK_UART2_BRG_Pos    8
+#define RST_CLK_UART_CLOCK_UART1_BRG_Msk    ((uint32_t)0x000000FF)
+#define RST_CLK_UART_CLOCK_UART2_BRG_Msk    ((uint32_t)0x0000FF00)
+#define RST_CLK_UART_CLOCK_UART1_CLK_EN     ((uint32_t)0x01000000)
+#define RST_CLK_UART_CLOCK_UART2_CLK_EN     ((uint32_t)0x02000000)
@@ -0,0 +1,21 @@
+#pragma once
+// Константы MDR32FxQI_timer.h для pwmseq.h и hrt.h. Регистры таймеров - модель в тесте
+#include <stdint.h>
+
+#define TIMER_CH_CNTRL_OCCM_Pos 9
+
+typedef enum
+{
+    TIMER_CH_REF_Format1 = (((uint32_t)0x1) << TIMER_CH_CNTRL_OCCM_Pos),
+    TIMER_CH_REF_Format6 = (((uint32_t)0x6) << TIMER_CH_CNTRL_OCCM_Pos),
+} TIMER_CH_REF_Format;
+
+typedef enum
+{
+    TIMER_CH_OutSrc_REF = ((uint32_t)0x2),
+} TIMER_CH_OUT_Src;
+
+typedef enum
+{
+    TIMER_CH_OutMode_Output = ((uint32_t)0x1),
+} TIMER_CH_OUT_Mode;
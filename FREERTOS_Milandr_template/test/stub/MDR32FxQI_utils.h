@@ -0,0 +1,11 @@
+#pragma once
+// Программные задержки SPL для хост-тестов: те же формулы (K1986VE9x), а
+// DELAY_PROGRAM_WaitLoopsAsm определяет тест - в нем модель видит время
+#include <stdint.h>
+
+#define DELAY_PROGRAM_LOOP_CYCLES (6UL)
+
+#define DELAY_PROGRAM_GET_CONST_US(CLK)      ((((CLK) + DELAY_PROGRAM_LOOP_CYCLES - 1) / DELAY_PROGRAM_LOOP_CYCLES) / (1000000UL / 1024UL))
+#define DELAY_PROGRAM_GET_US_LOOPS(N, CONST) (((N) * (CONST)) / 1024UL)
+
+void DELAY_PROGRAM_WaitLoopsAsm(uint32_t Loops);
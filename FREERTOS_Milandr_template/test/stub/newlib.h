@@ -0,0 +1,3 @@
+#pragma once
+// newlib.h для console.c: newlib собран с блокировками, которые переопределяет прошивка
+#define _RETARGETABLE_LOCKING 1
@@ -0,0 +1,13 @@
+#pragma once
+// reent.h newlib для console.c и heap.c: один общий _reent, поля не нужны
+struct _reent
+{
+    int errnoValue;
+};
+
+static struct _reent hostReent;
+static struct _reent *_impure_ptr __attribute__((unused)) = &hostReent;
+static struct _reent *const _global_impure_ptr __attribute__((unused)) = &hostReent;
+
+#define _REENT_INIT_PTR(reent) memset((reent), 0, sizeof(struct _reent))
+static inline void _reclaim_reent(struct _reent *reent) { (void)reent; }
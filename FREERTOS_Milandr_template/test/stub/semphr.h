@@ -0,0 +1,3 @@
+#pragma once
+// semphr.h FreeRTOS для console.c: мьютексы - заглушки в тесте
+typedef void *SemaphoreHandle_t;
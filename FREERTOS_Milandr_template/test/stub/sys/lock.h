@@ -0,0 +1,4 @@
+#pragma once
+// sys/lock.h newlib для console.c: структуру блокировки определяет прошивка
+struct __lock;
+typedef struct __lock *_LOCK_T;
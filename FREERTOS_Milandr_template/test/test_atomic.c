@@ -0,0 +1,265 @@
+// atomic.h в обоих вариантах: на LDREX/STREX (configUSE_PORT_ATOMICS 1, монитор модели
+// cm3.h) и на маске BASEPRI (0, функции переименованы в CRIT_*). Заголовок подключается
+// дважды, так что варианты идут в одной программе по одному расписанию.
+// Проверяется: одинаковые результаты обоих на случайных операциях; под вытеснением
+// прерыванием (приоритет под syscall, как положено вызывающим atomic.h) через 1..7 тактов
+// после его выхода ни одно обновление не теряется, а обычный ++ с тактом между чтением и
+// записью теряет.
+// Печатается сравнение тактов на операцию и задержки прерывания. Такты вариантов - оценки
+// MODEL_*_CYCLES по таблице TRM Cortex-M3, попытки STREX и ожидание маски - счетчики модели.
+// Замера на кристалле нет
+#include "cm3.h"
+#include "FreeRTOS.h"
+
+// Вариант с маской
+#undef configUSE_PORT_ATOMICS
+#define configUSE_PORT_ATOMICS 0
+#define Atomic_CompareAndSwap_u32          CRIT_CompareAndSwap_u32
+#define Atomic_SwapPointers_p32            CRIT_SwapPointers_p32
+#define Atomic_CompareAndSwapPointers_p32  CRIT_CompareAndSwapPointers_p32
+#define Atomic_Add_u32                     CRIT_Add_u32
+#define Atomic_Subtract_u32                CRIT_Subtract_u32
+#define Atomic_Increment_u32               CRIT_Increment_u32
+#define Atomic_Decrement_u32               CRIT_Decrement_u32
+#define Atomic_OR_u32                      CRIT_OR_u32
+#define Atomic_AND_u32                     CRIT_AND_u32
+#define Atomic_NAND_u32                    CRIT_NAND_u32
+#define Atomic_XOR_u32                     CRIT_XOR_u32
+#include "atomic.h"
+#undef Atomic_CompareAndSwap_u32
+#undef Atomic_SwapPointers_p32
+#undef Atomic_CompareAndSwapPointers_p32
+#undef Atomic_Add_u32
+#undef Atomic_Subtract_u32
+#undef Atomic_Increment_u32
+#undef Atomic_Decrement_u32
+#undef Atomic_OR_u32
+#undef Atomic_AND_u32
+#undef Atomic_NAND_u32
+#undef Atomic_XOR_u32
+
+// Вариант на LDREX/STREX
+#undef ATOMIC_H
+#undef atomicUSE_EXCLUSIVE_ACCESS
+#undef configUSE_PORT_ATOMICS
+#define configUSE_PORT_ATOMICS 1
+#include "atomic.h"
+
+void SysTick_Handler(void) {}
+
+static uint32_t seed = 1;
+static uint32_t TEST_Random(void)
+{
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+// Одна операция каждого вида: op - номер, variant 1 - LDREX/STREX, 0 - маска
+#define OPS 9
+static uint32_t TEST_Op(int variant, int op, volatile uint32_t *p, uint32_t a, uint32_t b)
+{
+    switch (op)
+    {
+    case 0: return variant ? Atomic_CompareAndSwap_u32(p, a, b) : CRIT_CompareAndSwap_u32(p, a, b);
+    case 1: return variant ? Atomic_Add_u32(p, a) : CRIT_Add_u32(p, a);
+    case 2: return variant ? Atomic_Subtract_u32(p, a) : CRIT_Subtract_u32(p, a);
+    case 3: return variant ? Atomic_Increment_u32(p) : CRIT_Increment_u32(p);
+    case 4: return variant ? Atomic_Decrement_u32(p) : CRIT_Decrement_u32(p);
+    case 5: return variant ? Atomic_OR_u32(p, a) : CRIT_OR_u32(p, a);
+    case 6: return variant ? Atomic_AND_u32(p, a) : CRIT_AND_u32(p, a);
+    case 7: return variant ? Atomic_NAND_u32(p, a) : CRIT_NAND_u32(p, a);
+    default: return variant ? Atomic_XOR_u32(p, a) : CRIT_XOR_u32(p, a);
+    }
+}
+
+// Без вытеснения варианты неотличимы: те же возвраты и то же значение в памяти
+static void TEST_Same(void)
+{
+    volatile uint32_t x = 0, y = 0;
+
+    for (int i = 0; i < 1000000; i++)
+    {
+        int op = TEST_Random() % OPS;
+        uint32_t a = TEST_Random() & 3 ? TEST_Random() : x; // CAS попадает в текущее значение
+        uint32_t b = TEST_Random() & 1 ? x : TEST_Random();
+
+        CHECK(TEST_Op(1, op, &x, a, b) == TEST_Op(0, op, &y, a, b));
+        CHECK(x == y);
+    }
+    CHECK(hostBasepri == 0 && !cm3.exclusive);
+    CHECK(hostAsserts == 0);
+}
+
+// Вытеснение. Задача и прерывание меняют общий счетчик и каждый свою половину слова
+// флагов; в конце счетчик - сумма всех изменений, половины - как их видел владелец
+static int variant;
+static volatile uint32_t counter, flags;
+static uint32_t irqAdded, irqFlags;
+
+static uint64_t irqLdrexTotal;
+
+static void TEST_IrqOps(void)
+{
+    uint32_t bit = 1u << (16 + TEST_Random() % 16);
+    uint64_t ldrex = cm3.ldrex;
+
+    irqAdded += TEST_Random() & 1 ? (TEST_Op(variant, 3, &counter, 0, 0), 1) : (TEST_Op(variant, 1, &counter, 3, 0), 3);
+    if (TEST_Random() & 1)
+    {
+        (void)TEST_Op(variant, 5, &flags, bit, 0);
+        irqFlags |= bit;
+    }
+    else
+    {
+        (void)TEST_Op(variant, 6, &flags, ~bit, 0);
+        irqFlags &= ~bit;
+    }
+    CHECK((flags & 0xFFFF0000u) == irqFlags);
+    irqLdrexTotal += cm3.ldrex - ldrex;
+    cm3.irqCountdown = 1 + TEST_Random() % 7; // от выхода: сам обработчик идет несколько тактов
+}
+
+// Такты на кристалле по TRM (оценки): попытка LDREX/STREX - LDREX 2, операция 1, STREX 2,
+// ветвление 1; маска - MRS, MOV, MSR BASEPRI, ISB, DSB (7), LDR, операция, STR (4),
+// MSR BASEPRI (1), из них под маской - все после первого MSR (9)
+#define MODEL_EXCL_CYCLES        6
+#define MODEL_CRIT_CYCLES        12
+#define MODEL_CRIT_MASKED_CYCLES 9
+
+// Попытки LDREX и маски задачи: обработчик свои вычитает
+static uint64_t taskLdrex, taskMasks;
+
+// Вариант с маской: тело под BASEPRI длится на модели столько, сколько на кристалле
+static void TEST_Basepri(uint32_t value)
+{
+    if (value != 0 && variant == 0)
+    {
+        taskMasks += !cm3.inIrq;
+        CM3_Run(MODEL_CRIT_MASKED_CYCLES);
+    }
+}
+
+#define STRESS_OPS 1000000
+
+typedef struct
+{
+    double cycles;                // тактов на операцию задачи с повторами
+    double waitMean;              // ожидание маски прерыванием, тактов
+    uint64_t waitMax;
+} Result_t;
+
+static Result_t TEST_Stress(int v)
+{
+    uint32_t added = 0, mine = 0;
+    Result_t r;
+
+    variant = v;
+    counter = flags = 0;
+    irqAdded = irqFlags = 0;
+    seed = 5;
+    taskLdrex = taskMasks = 0;
+    cm3.irqWaitTotal = cm3.irqWaitMax = cm3.irqCount = 0;
+    cm3.irqWaiting = 0;
+    cm3.irq = TEST_IrqOps;
+    cm3.irqPriority = 6 << (8 - configPRIO_BITS); // под configMAX_SYSCALL_INTERRUPT_PRIORITY
+    cm3.irqPeriod = cm3.irqCountdown = 3;
+    hostBasepriHook = TEST_Basepri;
+    for (int i = 0; i < STRESS_OPS; i++)
+    {
+        uint32_t old, bit = 1u << (TEST_Random() % 16);
+        uint64_t ldrex = cm3.ldrex, irqLdrex = irqLdrexTotal;
+
+        switch (TEST_Random() % 4)
+        {
+        case 0:
+            (void)TEST_Op(v, 3, &counter, 0, 0);
+            added++;
+            break;
+        case 1:
+            (void)TEST_Op(v, 2, &counter, 2, 0);
+            added -= 2;
+            break;
+        case 2:
+            // Инкремент через CAS: повтор, пока никто не вклинился
+            do
+            {
+                old = counter;
+                CM3_Run(1);
+            } while (TEST_Op(v, 0, &counter, old + 5, old) != ATOMIC_COMPARE_AND_SWAP_SUCCESS);
+            added += 5;
+            break;
+        default:
+            if (TEST_Random() & 1)
+            {
+                (void)TEST_Op(v, 5, &flags, bit, 0);
+                mine |= bit;
+            }
+            else
+            {
+                (void)TEST_Op(v, 6, &flags, ~bit, 0);
+                mine &= ~bit;
+            }
+            CHECK((flags & 0xFFFFu) == mine);
+            break;
+        }
+        taskLdrex += (cm3.ldrex - ldrex) - (irqLdrexTotal - irqLdrex);
+    }
+    cm3.irqPeriod = 0;
+    hostBasepriHook = NULL;
+    CHECK(counter == added + irqAdded);
+    CHECK(flags == (mine | irqFlags));
+    CHECK(cm3.irqCount > STRESS_OPS / 4);
+    CHECK(hostBasepri == 0);
+    r.cycles = (double)(v ? taskLdrex * MODEL_EXCL_CYCLES : taskMasks * MODEL_CRIT_CYCLES) / STRESS_OPS;
+    r.waitMean = (double)cm3.irqWaitTotal / cm3.irqCount;
+    r.waitMax = cm3.irqWaitMax;
+    return r;
+}
+
+// Контроль: обычный ++ с тактом между чтением и записью под тем же прерыванием теряет
+static void TEST_PlainIrq(void)
+{
+    counter++;
+    irqAdded++;
+    cm3.irqCountdown = 1 + TEST_Random() % 7;
+}
+
+static void TEST_Plain(void)
+{
+    counter = 0;
+    irqAdded = 0;
+    cm3.irq = TEST_PlainIrq;
+    cm3.irqPeriod = 3;
+    for (int i = 0; i < STRESS_OPS; i++)
+    {
+        uint32_t v = counter;
+        CM3_Run(1);
+        counter = v + 1;
+    }
+    cm3.irqPeriod = 0;
+    CHECK(counter < STRESS_OPS + irqAdded); // окно чтение-запись модель действительно ловит
+}
+
+int main(void)
+{
+    Result_t excl, crit;
+    uint64_t failed = cm3.strexFailed;
+
+    TEST_Same();
+    excl = TEST_Stress(1);
+    CHECK(cm3.strexFailed - failed > 10000); // вытеснения между LDREX и STREX были
+    crit = TEST_Stress(0);
+    TEST_Plain();
+
+    printf("atomic.h под прерыванием через 1..7 тактов после выхода, %d операций задачи\n"
+           "(такты - оценки MODEL_*_CYCLES, повторы и ожидание маски - модель):\n"
+           "               тактов/операцию      ожидание прерывания, тактов\n"
+           "               без прерываний  под ними  среднее  макс\n"
+           "  LDREX/STREX  %8d  %12.1f  %8.2f  %4llu\n"
+           "  BASEPRI      %8d  %12.1f  %8.2f  %4llu\n",
+           STRESS_OPS, MODEL_EXCL_CYCLES, excl.cycles, excl.waitMean, (unsigned long long)excl.waitMax,
+           MODEL_CRIT_CYCLES, crit.cycles, crit.waitMean, (unsigned long long)crit.waitMax);
+    CHECK(excl.waitMax == 0); // LDREX/STREX прерывания не задерживает
+    CHECK(crit.waitMax >= MODEL_CRIT_MASKED_CYCLES - 1);
+    return HOST_Result("test_atomic");
+}
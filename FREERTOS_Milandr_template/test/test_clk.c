@@ -0,0 +1,440 @@
+// Смена частоты ядра (app/src/clk.c) с SysTick и временем uptime.c на модели RST_CLK и UART.
+// Модель тактов считает частоту ядра по своим регистрам на каждом такте и проверяет
+// латентность FLASH и режим регулятора. UART с DMA передает без пауз, пока стоит DMACR.TXE,
+// бодрейт каждого байта сверяется с заданным. Проходит быстрый старт на HSI, уровни DFS
+// и отказ PLL: бодрейт, период тика 1 мс, непрерывность и точность UPTIME_GetUs.
+// Старт без быстрого режима (CLK_Init) с отказом HSE или PLL завершается за ограниченное время
+#include "cm3.h"
+
+#include <math.h>
+
+// SPL
+typedef struct
+{
+    uint32_t FR, IBRD, FBRD, LCR_H, CR, DMACR;
+} MDR_UART_TypeDef;
+
+typedef struct
+{
+    uint32_t UART_BaudRate;
+    uint16_t UART_WordLength;
+    uint16_t UART_StopBits;
+    uint16_t UART_Parity;
+    uint16_t UART_FIFOMode;
+    uint16_t UART_HardwareFlowControl;
+} UART_InitTypeDef;
+
+#define UART_FR_BUSY     ((uint32_t)0x00000008)
+#define UART_DMA_TXE     ((uint32_t)0x02)
+#define UART_WordLength8b ((uint16_t)0x0060)
+#define UART_FIFO_ON     ((uint16_t)0x0010)
+#define UART_HardwareFlowControl_TXE ((uint16_t)0x0100)
+#define UART_HardwareFlowControl_UARTEN ((uint16_t)0x0001)
+
+static MDR_UART_TypeDef uarts[2];
+#define MDR_UART1 (&uarts[0])
+#define MDR_UART2 (&uarts[1])
+
+typedef struct
+{
+    uint32_t CLOCK_STATUS, PLL_CONTROL, UART_CLOCK, SSP_CLOCK, CAN_CLOCK, TIM_CLOCK;
+} MDR_RST_CLK_TypeDef;
+static MDR_RST_CLK_TypeDef rstClk;
+#define MDR_RST_CLK (&rstClk)
+
+typedef struct
+{
+    uint32_t RTC_CNT, RTC_DIV, RTC_PRL;
+} MDR_BKP_TypeDef;
+static MDR_BKP_TypeDef bkp;
+#define MDR_BKP (&bkp)
+
+#define RST_CLK_PCLK_EEPROM 0
+#define RST_CLK_PCLK_BKP    1
+
+// FreeRTOS
+#define configCPU_CLOCK_HZ (SystemCoreClock)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+#define BOOT_STAGE_PLL 0
+static void BOOT_Mark(uint32_t stage) { (void)stage; }
+
+#define CLK_ASSERT(expr) configASSERT(expr) // как в clk.h
+#include "clk_config.h"
+
+// Как посчитал бы clk_tree.hpp: 80 МГц от кварца 16 МГц, UART2 115200 без BRG
+const CLK_Config_t CLK_Config = {
+    .cpu = { 80000000, 5, RST_CLK_CPUclkDIV1, EEPROM_Latency_3, BKP_DUcc_upto_80MHz },
+    .uart = { { 0 }, { 115200, 43, 26, -80 } },
+    .uartClock = RST_CLK_UART_CLOCK_UART2_CLK_EN,
+};
+
+// Модель RST_CLK: CPU_C1 (HSI или HSE) -> PLL -> CPU_C3 (делитель) -> HCLK (HSI или CPU_C3)
+#define MODEL_HSE_START_CYCLES 20000
+#define MODEL_PLL_LOCK_CYCLES  800
+#define MODEL_POLL_CYCLES      400 // цикл ожидания внутри RST_CLK_*status
+// RST_CLK_HSEstatus: HSEonTimeOut (0x600 в MDR32FxQI_config.h) проходов по ~16 тактов (оценка)
+#define MODEL_HSE_POLL_CYCLES  (0x600 * 16)
+
+static struct
+{
+    int hseOn, c1Hse, pllUse, hclkC3;
+    uint32_t c3Shift;
+    uint64_t hseReadyAt, pllReadyAt;
+    int pllBroken;               // PLL не захватывается
+    int hseBroken;               // кварц не запускается
+    uint32_t latency, ducc;
+    uint32_t timingErrors;       // латентность или регулятор не под частоту
+} rst;
+
+// Модель UART2: кадр 10 бит, пока стоит TXE, следующий уходит сразу за предыдущим
+static struct
+{
+    uint64_t busyUntil;
+    uint32_t bytes;
+    uint32_t badBaud;            // кадр ушел с ошибкой бодрейта больше CLK_BAUD_ERROR_PPM
+    int32_t worstPpm;
+} uartModel;
+
+static uint32_t MODEL_Hz(void)
+{
+    uint32_t c1 = rst.c1Hse && (rstClk.CLOCK_STATUS & RST_CLK_CLOCK_STATUS_HSE_RDY) ? CLK_HSE_HZ : HSI_Value;
+    uint32_t c2 = c1;
+
+    if (!rst.hclkC3)
+    {
+        return HSI_Value;
+    }
+    if (rst.pllUse && (rstClk.CLOCK_STATUS & RST_CLK_CLOCK_STATUS_PLL_CPU_RDY))
+    {
+        c2 = CLK_HSE_HZ * (((rstClk.PLL_CONTROL & RST_CLK_PLL_CONTROL_PLL_CPU_MUL_Msk) >> RST_CLK_PLL_CONTROL_PLL_CPU_MUL_Pos) + 1);
+    }
+    return c2 >> rst.c3Shift;
+}
+
+static uint32_t MODEL_Clock(void)
+{
+    static const uint32_t latencyHz[] = { 25000000, 50000000, 75000000, 100000000 };
+    uint32_t hz;
+    uint32_t duccHz;
+
+    if (rst.hseOn && !rst.hseBroken && cm3.cycles >= rst.hseReadyAt)
+    {
+        rstClk.CLOCK_STATUS |= RST_CLK_CLOCK_STATUS_HSE_RDY;
+    }
+    if ((rstClk.PLL_CONTROL & RST_CLK_PLL_CONTROL_PLL_CPU_ON) && !rst.pllBroken && cm3.cycles >= rst.pllReadyAt)
+    {
+        rstClk.CLOCK_STATUS |= RST_CLK_CLOCK_STATUS_PLL_CPU_RDY;
+    }
+
+    hz = MODEL_Hz();
+    if (cm3.cycles >= uartModel.busyUntil && (uarts[1].DMACR & UART_DMA_TXE))
+    {
+        uint32_t div64 = uarts[1].IBRD * 64 + uarts[1].FBRD;
+        int32_t ppm = (int32_t)((uint64_t)hz * 4 * 1000000 / div64 / CLK_Config.uart[1].baud) - 1000000;
+
+        if (ppm > CLK_BAUD_ERROR_PPM || ppm < -CLK_BAUD_ERROR_PPM)
+        {
+            uartModel.badBaud++;
+        }
+        if (abs(ppm) > abs(uartModel.worstPpm))
+        {
+            uartModel.worstPpm = ppm;
+        }
+        uartModel.busyUntil = cm3.cycles + (uint64_t)div64 * 10 * 16 / 64;
+        uartModel.bytes++;
+    }
+    uarts[1].FR = cm3.cycles < uartModel.busyUntil ? UART_FR_BUSY : 0;
+
+    duccHz = rst.ducc == BKP_DUcc_upto_10MHz ? 10000000 :
+             rst.ducc == BKP_DUcc_upto_40MHz ? 40000000 :
+             rst.ducc == BKP_DUcc_upto_80MHz ? 80000000 : 0xFFFFFFFF;
+    if (hz > latencyHz[rst.latency >> 3] || hz > duccHz)
+    {
+        rst.timingErrors++;
+    }
+    return hz;
+}
+
+static void RST_CLK_DeInit(void)
+{
+    int hseBroken = rst.hseBroken, pllBroken = rst.pllBroken;
+
+    memset(&rst, 0, sizeof(rst));
+    rst.hseBroken = hseBroken;
+    rst.pllBroken = pllBroken;
+    rstClk.CLOCK_STATUS = 0;
+    rstClk.PLL_CONTROL = 0;
+}
+static void RST_CLK_HSEconfig(RST_CLK_HSE_Mode mode)
+{
+    rst.hseOn = mode == RST_CLK_HSE_ON;
+    rst.hseReadyAt = cm3.cycles + MODEL_HSE_START_CYCLES;
+    if (!rst.hseOn)
+    {
+        rstClk.CLOCK_STATUS &= ~RST_CLK_CLOCK_STATUS_HSE_RDY;
+    }
+}
+static ErrorStatus RST_CLK_HSEstatus(void)
+{
+    CM3_Run(MODEL_HSE_POLL_CYCLES);
+    return (rstClk.CLOCK_STATUS & RST_CLK_CLOCK_STATUS_HSE_RDY) ? SUCCESS : ERROR;
+}
+static void RST_CLK_CPUclkSelectionC1(RST_CLK_CPU_C1_Source source) { rst.c1Hse = source == RST_CLK_CPU_C1srcHSEdiv1; }
+static void RST_CLK_CPU_PLLconfig(RST_CLK_CPU_PLL_Source source, RST_CLK_CPU_PLL_Multiplier mul)
+{
+    CHECK(source == RST_CLK_CPU_PLLsrcHSEdiv1);
+    rstClk.PLL_CONTROL = (rstClk.PLL_CONTROL & ~RST_CLK_PLL_CONTROL_PLL_CPU_MUL_Msk) | ((uint32_t)mul << RST_CLK_PLL_CONTROL_PLL_CPU_MUL_Pos);
+}
+static void RST_CLK_CPU_PLLcmd(FunctionalState state)
+{
+    rstClk.CLOCK_STATUS &= ~RST_CLK_CLOCK_STATUS_PLL_CPU_RDY;
+    if (state == ENABLE)
+    {
+        rstClk.PLL_CONTROL |= RST_CLK_PLL_CONTROL_PLL_CPU_ON;
+        rst.pllReadyAt = cm3.cycles + MODEL_PLL_LOCK_CYCLES;
+    }
+    else
+    {
+        rstClk.PLL_CONTROL &= ~RST_CLK_PLL_CONTROL_PLL_CPU_ON;
+    }
+}
+static ErrorStatus RST_CLK_CPU_PLLstatus(void)
+{
+    CHECK(hostCritical == 0); // захват PLL ждут вне критической секции: SysTick и прерывания идут
+    CM3_Run(MODEL_POLL_CYCLES);
+    return (rstClk.CLOCK_STATUS & RST_CLK_CLOCK_STATUS_PLL_CPU_RDY) ? SUCCESS : ERROR;
+}
+static void RST_CLK_CPU_PLLuse(FunctionalState state) { rst.pllUse = state == ENABLE; }
+static void RST_CLK_CPUclkPrescaler(RST_CLK_CPU_C3_Divisor div) { rst.c3Shift = div == RST_CLK_CPUclkDIV1 ? 0 : div - RST_CLK_CPUclkDIV2 + 1; }
+static void RST_CLK_CPUclkSelection(RST_CLK_HCLK_Source source) { rst.hclkC3 = source == RST_CLK_CPUclkCPU_C3; }
+static void RST_CLK_PCLKcmd(uint32_t pclk, FunctionalState state) { (void)pclk; (void)state; }
+static void EEPROM_SetLatency(EEPROM_Latency_Cycles latency) { rst.latency = latency; }
+static void BKP_DUccMode(BKP_DUcc_Mode mode) { rst.ducc = mode; }
+
+#include "clk.h"
+
+// FreeRTOS
+static uint32_t tickHandlers;
+static double lastTickNs;
+static int tickDirty;            // период тика задела смена частоты
+static double worstTickErrorNs;
+
+static void xPortSysTickHandler(void)
+{
+    if (tickHandlers != 0 && !tickDirty)
+    {
+        double error = cm3.ns - lastTickNs - 1e6;
+        if (error < 0)
+        {
+            error = -error;
+        }
+        if (error > worstTickErrorNs)
+        {
+            worstTickErrorNs = error;
+        }
+    }
+    tickDirty = 0;
+    lastTickNs = cm3.ns;
+    tickHandlers++;
+}
+
+static TickType_t xTaskGetTickCount(void);
+
+#include "../app/src/uptime.c"
+#include "../app/src/clk.c"
+
+static TickType_t xTaskGetTickCount(void) { return (TickType_t)UPTIME_GetTicks(); }
+
+// Драйвер UART2 с DMA, как console.c
+static void CONSOLE_ClockChanged(CLK_Event_t event, uint32_t hz)
+{
+    CLK_UARTRetune(MDR_UART2, event, hz);
+}
+
+// Последний нотификатор: порядок событий и состояние в каждом
+static struct
+{
+    uint32_t changes;
+    CLK_Event_t last;
+    uint32_t hz;
+    double preNs;
+    uint32_t errors;
+} seen;
+
+static void TEST_Notifier(CLK_Event_t event, uint32_t hz)
+{
+    int ok;
+
+    switch (event)
+    {
+    case CLK_PRE_CHANGE:
+        ok = seen.last == CLK_POST_CHANGE && hostCritical == 0;
+        seen.preNs = cm3.ns;
+        break;
+    case CLK_SWITCH:
+        // UART2 отдал FIFO и не берет новое от DMA, SysTick уже на новой частоте.
+        // Второй SWITCH - после захвата PLL
+        ok = (seen.last == CLK_PRE_CHANGE || seen.last == CLK_SWITCH) && hostCritical > 0 &&
+             hz == MODEL_Hz() && SystemCoreClock == hz && !(uarts[1].DMACR & UART_DMA_TXE) && cm3.cycles >= uartModel.busyUntil &&
+             cm3.systick.LOAD + 1 == hz / configTICK_RATE_HZ;
+        break;
+    default:
+        ok = seen.last == CLK_SWITCH && hostCritical == 0 && hz == SystemCoreClock && (uarts[1].DMACR & UART_DMA_TXE);
+        seen.changes++;
+        tickDirty = 1;
+        break;
+    }
+    if (!ok)
+    {
+        printf("notifier: event %d after %d, %u Hz, critical %d\n", event, seen.last, (unsigned)hz, hostCritical);
+        seen.errors++;
+    }
+    seen.last = event;
+    seen.hz = hz;
+}
+
+// Время: UPTIME_GetUs против времени модели
+static uint64_t lastUs;
+static double offsetNs; // модель до vPortSetupTimerInterrupt
+static uint32_t backwards;
+
+static double TEST_UptimeErrorUs(void)
+{
+    uint64_t us = UPTIME_GetUs();
+
+    if (us < lastUs)
+    {
+        backwards++;
+    }
+    lastUs = us;
+    return (double)us - (cm3.ns - offsetNs) / 1000;
+}
+
+// Работа между сменами: чтения времени каждые ~100 тактов
+static double worstUptimeUs;
+
+static void TEST_Run(uint32_t cycles)
+{
+    for (uint32_t i = 0; i < cycles; i += 97)
+    {
+        double error = fabs(TEST_UptimeErrorUs());
+
+        if (error > worstUptimeUs)
+        {
+            worstUptimeUs = error;
+        }
+        CM3_Run(97);
+    }
+}
+
+static void TEST_Level(uint32_t hz, ErrorStatus expected, uint32_t actual)
+{
+    double before = TEST_UptimeErrorUs();
+    ErrorStatus status = CLK_SetFrequency(hz);
+    double switchUs = (cm3.ns - seen.preNs) / 1000;
+    double after = TEST_UptimeErrorUs();
+
+    CHECK(status == expected);
+    CHECK(SystemCoreClock == actual && MODEL_Hz() == actual && seen.hz == actual);
+    CHECK(cm3.systick.LOAD + 1 == actual / configTICK_RATE_HZ);
+    // Время не рвется и не уходит: такты на HSE во время захвата PLL тоже посчитаны
+    CHECK(after - before < 2 && before - after < 2 && after > -10 && after < 10);
+    printf("%2u MHz: %s, switch %.1f us, uptime error %+.2f -> %+.2f us\n", (unsigned)(actual / 1000000),
+           status == SUCCESS ? "ok" : "ERROR", switchUs, before, after);
+}
+
+// Старт без CLK_FAST_BOOT: CLK_Init ждет HSE и PLL ограниченное число опросов.
+// Отказ - ERROR, ядро на HSI или HSE, CLK_PollStartup сообщает о нем губернатору
+static void TEST_Init(int hseBroken, int pllBroken, ErrorStatus expected, uint32_t actual)
+{
+    double start;
+
+    cm3.clock = MODEL_Clock;
+    rst.hseBroken = hseBroken;
+    rst.pllBroken = pllBroken;
+    startup = CLK_STARTUP_DONE;
+    start = cm3.ns;
+    CHECK(CLK_Init() == expected);
+    CHECK(SystemCoreClock == actual && MODEL_Hz() == actual);
+    CHECK(CLK_PollStartup() == (expected == SUCCESS ? CLK_STARTUP_DONE : CLK_STARTUP_FAILED));
+    // Опросы идут не быстрее HSI
+    CHECK(cm3.ns - start <= ((double)CLK_HSE_ATTEMPTS * MODEL_HSE_POLL_CYCLES + CLK_PLL_ATTEMPTS * MODEL_POLL_CYCLES) * 1e9 / HSI_Value);
+    printf("CLK_Init, HSE %s, PLL %s: %s at %u MHz after %.1f ms\n", hseBroken ? "broken" : "ok", pllBroken ? "broken" : "ok",
+           expected == SUCCESS ? "ok" : "ERROR", (unsigned)(actual / 1000000), (cm3.ns - start) / 1e6);
+    rst.hseBroken = rst.pllBroken = 0;
+}
+
+int main(void)
+{
+    static const uint32_t levels[] = { 8000000, 16000000, 40000000, 80000000, 40000000, 8000000, 80000000, 16000000, 80000000 };
+    const UART_InitTypeDef init = { 115200, UART_WordLength8b, 0, 0, UART_FIFO_ON, UART_HardwareFlowControl_TXE | UART_HardwareFlowControl_UARTEN };
+    uint32_t lastChanges;
+
+    // Сброс: ядро на HSI, как после SystemInit
+    cm3.clock = MODEL_Clock;
+    RST_CLK_DeInit();
+    rst.latency = EEPROM_Latency_0;
+    rst.ducc = BKP_DUcc_upto_10MHz;
+    seen.last = CLK_POST_CHANGE;
+
+    // main при CLK_FAST_BOOT: фоновый запуск, UART на HSI, потом планировщик и опрос раз в тик
+    CLK_StartAsync();
+    CLK_InitPeripherals();
+    CLK_UARTInit(MDR_UART2, &init);
+    CLK_AddNotifier(CONSOLE_ClockChanged);
+    uarts[1].DMACR = UART_DMA_TXE;
+    offsetNs = cm3.ns;
+    vPortSetupTimerInterrupt();
+    CLK_AddNotifier(TEST_Notifier); // после UPTIME_Retune: SysTick в SWITCH уже перестроен
+    CHECK(SystemCoreClock == HSI_Value && MODEL_Hz() == HSI_Value);
+
+    while (CLK_PollStartup() == CLK_STARTUP_BUSY)
+    {
+        TEST_Run(HSI_Value / 1000);
+    }
+    CHECK(CLK_PollStartup() == CLK_STARTUP_DONE);
+    CHECK(SystemCoreClock == CLK_Config.cpu.hz && MODEL_Hz() == CLK_Config.cpu.hz && seen.changes == 1);
+    printf("fast boot: %u ticks on HSI\n", (unsigned)UPTIME_GetTicks());
+
+    // Уровни DFS
+    for (uint32_t i = 0; i < sizeof(levels) / sizeof(levels[0]); i++)
+    {
+        TEST_Run(levels[i == 0 ? 0 : i - 1] / 200);
+        TEST_Level(levels[i], SUCCESS, levels[i]);
+    }
+
+    // Отказ PLL: остаемся на HSE / div, ERROR, нотификаторы получают фактическую частоту
+    TEST_Run(80000000 / 200);
+    rst.pllBroken = 1;
+    TEST_Level(64000000, ERROR, CLK_HSE_HZ); // множитель 4 вместо захваченного 5
+    rst.pllBroken = 0;
+    TEST_Run(8000000 / 200);
+    TEST_Level(80000000, SUCCESS, 80000000);
+    TEST_Run(80000000 / 50);
+
+    // Неверная частота: ничего не меняется
+    lastChanges = seen.changes;
+    CHECK(CLK_SetFrequency(30000000) == ERROR && CLK_SetFrequency(0) == ERROR);
+    CHECK(seen.changes == lastChanges && SystemCoreClock == 80000000);
+
+    CHECK(hostAsserts == 0);
+    CHECK(rst.timingErrors == 0);
+    CHECK(seen.errors == 0);
+    CHECK(backwards == 0);
+    CHECK(uartModel.badBaud == 0);
+    CHECK(worstTickErrorNs < 1000); // задержка входа в обработчик, такт-другой
+    CHECK(worstUptimeUs < 10);
+    printf("%u ticks, %u UART bytes, worst baud %+d ppm, worst tick %.0f ns, worst uptime %.2f us\n",
+           (unsigned)tickHandlers, (unsigned)uartModel.bytes, (int)uartModel.worstPpm, worstTickErrorNs, worstUptimeUs);
+
+    // Дальше SysTick и UART не сверяются: CLK_Init их не перестраивает
+    cm3.systick.CTRL = 0;
+    uarts[1].DMACR = 0;
+    TEST_Init(0, 0, SUCCESS, CLK_Config.cpu.hz);
+    TEST_Init(0, 1, ERROR, CLK_HSE_HZ);
+    TEST_Init(1, 0, ERROR, HSI_Value);
+    CHECK(hostAsserts == 0);
+    CHECK(rst.timingErrors == 0);
+    return HOST_Result("test_clk");
+}
@@ -0,0 +1,396 @@
+// Консоль (app/src/console.c) на модели UART с каналом DMA по тактам HCLK. Задача пишет
+// строки через _write, DMA отдает кольцо в линию со скоростью бодрейта (FIFO передатчика -
+// MODEL_FIFO байт), прерывание - на конец цикла DMA. Цена кода процессора - оценки
+// MODEL_*_CYCLES, не замер на кристалле; форматирование vfprintf newlib не входит.
+// Проверяется, что поток дошел байт в байт и линия не простаивает, пока есть что слать.
+// Печатаются пропускная способность, такты процессора на байт против побайтной блокирующей
+// передачи и задержка контура управления - прерывания 1 кГц с приоритетом под BASEPRI - от
+// критических секций консоли и прерывания DMA. Адреса в структурах DMA - 32 бита, тест без PIE
+#include "host.h"
+
+// CMSIS
+typedef int IRQn_Type;
+#define UART1_IRQn ((IRQn_Type)6)
+#define UART2_IRQn ((IRQn_Type)7)
+static void NVIC_SetPriority(IRQn_Type irq, uint32_t priority) { (void)irq; (void)priority; }
+static void NVIC_EnableIRQ(IRQn_Type irq) { (void)irq; }
+static uint32_t __get_IPSR(void);
+
+// SPL
+typedef struct
+{
+    uint32_t DR, FR, ICR, DMACR, IMSC, CR;
+} MDR_UART_TypeDef;
+static MDR_UART_TypeDef uarts[2];
+#define MDR_UART1 (&uarts[0])
+#define MDR_UART2 (&uarts[1])
+
+#define UART_FR_RXFE   ((uint32_t)0x00000010)
+#define UART_CR_UARTEN ((uint32_t)0x00000001)
+#define UART_CR_TXE    ((uint32_t)0x00000100)
+#define UART_CR_RXE    ((uint32_t)0x00000200)
+#define UART_IMSC_RXIM ((uint32_t)0x00000010)
+#define UART_IMSC_RTIM ((uint32_t)0x00000040)
+#define UART_ICR_RXIC  ((uint32_t)0x00000010)
+#define UART_ICR_RTIC  ((uint32_t)0x00000040)
+#define UART_DMA_TXE   ((uint32_t)0x02)
+#define UART_FLAG_RXFE UART_FR_RXFE
+typedef enum { RESET = 0, SET = !RESET } FlagStatus;
+
+// MDR32FxQI_inline.h
+static FlagStatus UART_GetFlagStatus_Inline(MDR_UART_TypeDef *UARTx, uint32_t flag) { return (UARTx->FR & flag) ? SET : RESET; }
+static uint16_t UART_ReceiveData_Inline(MDR_UART_TypeDef *UARTx) { return (uint16_t)UARTx->DR; }
+
+// FreeRTOS
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS 1
+#define CONSOLE_TLS_INDEX                       0
+#define taskSCHEDULER_SUSPENDED   ((BaseType_t)0)
+#define taskSCHEDULER_NOT_STARTED ((BaseType_t)1)
+#define taskSCHEDULER_RUNNING     ((BaseType_t)2)
+
+static UBaseType_t TEST_Enter(void);
+static void TEST_Exit(UBaseType_t mask);
+#define taskENTER_CRITICAL_FROM_ISR()    TEST_Enter()
+#define taskEXIT_CRITICAL_FROM_ISR(mask) TEST_Exit(mask)
+#define portYIELD_FROM_ISR(woken)        ((void)(woken))
+
+#include "semphr.h"
+
+static int self;
+static void *tls;
+static uint32_t notifications;
+static TaskHandle_t xTaskGetCurrentTaskHandle(void) { return &self; }
+static BaseType_t xTaskGetSchedulerState(void) { return taskSCHEDULER_RUNNING; }
+static void vTaskSuspendAll(void) {}
+static BaseType_t xTaskResumeAll(void) { return pdFALSE; }
+static void *pvPortMalloc(size_t size) { return malloc(size); }
+static void vPortFree(void *p) { free(p); }
+static void vTaskSetThreadLocalStoragePointer(TaskHandle_t task, BaseType_t index, void *value)
+{
+    CHECK(task == NULL && index == CONSOLE_TLS_INDEX);
+    tls = value;
+}
+static void *pvTaskGetThreadLocalStoragePointer(TaskHandle_t task, BaseType_t index)
+{
+    CHECK(task == NULL && index == CONSOLE_TLS_INDEX);
+    return tls;
+}
+static uint32_t ulTaskNotifyTakeIndexed(UBaseType_t index, BaseType_t clear, TickType_t ticks);
+
+// Мьютексы: задача одна, захват всегда удается
+static int mutexTaken;
+static SemaphoreHandle_t xSemaphoreCreateMutex(void) { return &mutexTaken; }
+static SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void) { return &mutexTaken; }
+static void vSemaphoreDelete(SemaphoreHandle_t mutex) { (void)mutex; }
+static BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t ticks)
+{
+    (void)mutex;
+    (void)ticks;
+    CHECK(mutexTaken == 0);
+    mutexTaken = 1;
+    return pdTRUE;
+}
+static BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex)
+{
+    (void)mutex;
+    mutexTaken = 0;
+    return pdTRUE;
+}
+static BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t mutex, TickType_t ticks) { return xSemaphoreTake(mutex, ticks); }
+static BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t mutex) { return xSemaphoreGive(mutex); }
+
+#include "dma.h"
+#include "console.h" // CONSOLE_NOTIFY_INDEX для заглушки ниже
+
+static void vTaskNotifyGiveIndexedFromISR(TaskHandle_t task, UBaseType_t index, BaseType_t *woken)
+{
+    CHECK(task == &self && index == CONSOLE_NOTIFY_INDEX);
+    notifications++;
+    *woken = pdTRUE;
+}
+
+// clk.h
+typedef enum
+{
+    CLK_PRE_CHANGE,
+    CLK_SWITCH,
+    CLK_POST_CHANGE,
+} CLK_Event_t;
+typedef void (*CLK_Notifier_t)(CLK_Event_t event, uint32_t hz);
+static void CLK_AddNotifier(CLK_Notifier_t notifier) { (void)notifier; }
+static void CLK_UARTRetune(MDR_UART_TypeDef *UARTx, CLK_Event_t event, uint32_t hz)
+{
+    (void)UARTx;
+    (void)event;
+    (void)hz;
+}
+
+// Буфер stdout общего _reent - не буфер stdout хоста
+static int TEST_Setvbuf(FILE *stream, char *buffer, int mode, size_t size)
+{
+    (void)stream;
+    (void)buffer;
+    (void)mode;
+    (void)size;
+    return 0;
+}
+#define setvbuf(stream, buffer, mode, size) TEST_Setvbuf(stream, buffer, mode, size)
+
+#include "../app/src/console.c"
+
+// Модель. Оценки тактов HCLK
+#define MODEL_WRITE_CYCLES    120 // _write вне критических секций: вызов, мьютекс, проверки
+#define MODEL_CRITICAL_CYCLES 16  // вход и выход критической секции, свободное место
+#define MODEL_BYTE_CYCLES     5   // байт в кольцо: ldrb, strb, индекс по маске
+#define MODEL_START_CYCLES    40  // DMAM_Control и DMAM_Start
+#define MODEL_IRQ_CYCLES      150 // вход в DMA_IRQHandler, опрос каналов, CONSOLE_DmaDone, выход
+#define MODEL_WAKE_CYCLES     250 // переключение на разбуженную задачу
+#define MODEL_FIFO            16  // байт FIFO передатчика UART
+#define MODEL_STREAM          16384
+
+static struct
+{
+    uint64_t now;            // такты HCLK
+    uint64_t cpu;            // из них заняты консолью: задача в _write и прерывание DMA
+    int inIrq;
+    uint64_t enteredAt;      // начало внешней критической секции
+    uint32_t enteredHead;
+    uint32_t criticalMax;    // тактов в самой длинной критической секции задачи
+    // Контур управления: запрос раз в period, задержка - пока замаскирован
+    uint32_t period;
+    uint64_t nextControl;
+    uint32_t controls;
+    uint32_t delayed;
+    uint32_t latencyMax;
+    uint64_t latencySum;
+    // Канал DMA и линия
+    DMA_CtrlDataTypeDef ctrl;
+    DMAM_Callback_t callback;
+    uint32_t byteCycles;     // 10 бит в линии
+    int busy;
+    uint64_t done;           // конец цикла DMA: последний байт ушел в FIFO
+    uint64_t lineFree;       // линия передаст все к этому такту
+    uint64_t lineIdle;       // тактов простоя линии между циклами DMA
+    uint64_t firstByte;
+    uint32_t irqs;
+    uint32_t sent;
+    uint8_t out[MODEL_STREAM];
+} model;
+
+static uint32_t __get_IPSR(void) { return model.inIrq ? 16 : 0; }
+
+int32_t DMAM_Alloc(int32_t ch, DMAM_Callback_t callback, void *arg)
+{
+    CHECK(ch == CONSOLE_DMA_CHANNEL && arg == NULL);
+    model.callback = callback;
+    return ch;
+}
+
+DMA_CtrlDataTypeDef *DMAM_Control(uint32_t ch, DMA_Data_Struct_Selection select)
+{
+    CHECK(ch == CONSOLE_DMA_CHANNEL && select == DMA_CTRL_DATA_PRIMARY);
+    return &model.ctrl;
+}
+
+// Байты уходят в линию подряд с начала цикла или с конца предыдущей передачи
+void DMAM_Start(uint32_t ch)
+{
+    uint32_t size = ((model.ctrl.DMA_Control >> 4) & 0x3FF) + 1;
+    uint32_t first = model.ctrl.DMA_SourceEndAddr - (uint32_t)tx.buffer + 1 - size;
+    uint64_t begin;
+
+    CHECK(ch == CONSOLE_DMA_CHANNEL && !model.busy);
+    CHECK(model.ctrl.DMA_DestEndAddr == (uint32_t)&CONSOLE_UARTx->DR);
+    CHECK((model.ctrl.DMA_Control & 7) == DMA_Mode_Basic);
+    CHECK(first + size <= CONSOLE_TX_SIZE && model.sent + size <= MODEL_STREAM);
+    memcpy(&model.out[model.sent], &tx.buffer[first], size);
+
+    model.now += MODEL_START_CYCLES;
+    model.cpu += MODEL_START_CYCLES;
+    begin = model.now > model.lineFree ? model.now : model.lineFree;
+    if (model.sent == 0)
+    {
+        model.firstByte = begin;
+    }
+    else
+    {
+        model.lineIdle += begin - model.lineFree;
+    }
+    model.sent += size;
+    model.lineFree = begin + (uint64_t)size * model.byteCycles;
+    model.done = model.lineFree - (uint64_t)(size < MODEL_FIFO ? size : MODEL_FIFO) * model.byteCycles;
+    model.busy = 1;
+}
+
+// Запросы контура до to; пришедшие с from ждут до to
+static void MODEL_Masked(uint64_t from, uint64_t to)
+{
+    while (model.nextControl < to)
+    {
+        if (model.nextControl >= from)
+        {
+            uint32_t latency = (uint32_t)(to - model.nextControl);
+
+            model.delayed++;
+            model.latencySum += latency;
+            if (latency > model.latencyMax)
+            {
+                model.latencyMax = latency;
+            }
+        }
+        model.controls++;
+        model.nextControl += model.period;
+    }
+}
+
+// Прерывание DMA, если цикл кончился и маски нет. Контур замаскирован с from
+static void MODEL_Dispatch(uint64_t from)
+{
+    if (model.busy && model.done <= model.now && !model.inIrq && hostCritical == 0)
+    {
+        model.busy = 0;
+        model.irqs++;
+        model.inIrq = 1;
+        model.now += MODEL_IRQ_CYCLES;
+        model.cpu += MODEL_IRQ_CYCLES;
+        model.callback(CONSOLE_DMA_CHANNEL, NULL);
+        model.inIrq = 0;
+    }
+    MODEL_Masked(from, model.now);
+}
+
+static UBaseType_t TEST_Enter(void)
+{
+    if (hostCritical++ == 0 && !model.inIrq)
+    {
+        model.enteredAt = model.now;
+        model.enteredHead = tx.head;
+    }
+    return 0;
+}
+
+// Цена секции - при выходе: вход, выход и скопированные байты
+static void TEST_Exit(UBaseType_t mask)
+{
+    uint32_t cycles;
+
+    (void)mask;
+    if (--hostCritical != 0)
+    {
+        return;
+    }
+    cycles = MODEL_CRITICAL_CYCLES;
+    if (!model.inIrq)
+    {
+        cycles += (tx.head - model.enteredHead) * MODEL_BYTE_CYCLES;
+    }
+    model.now += cycles;
+    model.cpu += cycles;
+    if (model.inIrq)
+    {
+        return;
+    }
+    if (cycles > model.criticalMax)
+    {
+        model.criticalMax = cycles;
+    }
+    MODEL_Dispatch(model.enteredAt);
+}
+
+// Задача ждет конца цикла DMA: процессор свободен
+static uint32_t ulTaskNotifyTakeIndexed(UBaseType_t index, BaseType_t clear, TickType_t ticks)
+{
+    CHECK(index == CONSOLE_NOTIFY_INDEX && clear == pdTRUE && ticks == portMAX_DELAY);
+    while (notifications == 0)
+    {
+        CHECK(model.busy);
+        if (!model.busy)
+        {
+            return 0;
+        }
+        if (model.now < model.done)
+        {
+            model.now = model.done;
+        }
+        MODEL_Dispatch(model.now);
+    }
+    notifications = 0;
+    model.now += MODEL_WAKE_CYCLES;
+    model.cpu += MODEL_WAKE_CYCLES;
+    MODEL_Dispatch(model.now);
+    return 1;
+}
+
+static void TEST_Write(const char *text, uint32_t size)
+{
+    model.now += MODEL_WRITE_CYCLES;
+    model.cpu += MODEL_WRITE_CYCLES;
+    CHECK(_write(1, (char *)text, (int)size) == (int)size);
+    MODEL_Dispatch(model.now);
+}
+
+static uint8_t expected[MODEL_STREAM];
+
+// Задача печатает строки по line байт без пауз, пока не наберет MODEL_STREAM
+static void TEST_Stream(uint32_t hz, uint32_t baud, uint32_t line)
+{
+    char text[128];
+    uint32_t total = 0;
+    uint64_t elapsed;
+
+    memset(&model, 0, sizeof(model));
+    memset(&tx, 0, sizeof(tx));
+    notifications = 0;
+    SystemCoreClock = hz;
+    model.byteCycles = hz / (baud / 10);
+    model.period = hz / 1000;
+    model.nextControl = model.period / 3;
+    CONSOLE_Init();
+
+    while (total + line <= MODEL_STREAM)
+    {
+        int n = snprintf(text, sizeof(text), "%04u ", (unsigned)(total / line));
+
+        memset(text + n, 'a' + (total / line) % 26, line - n - 1);
+        text[line - 1] = '\n';
+        memcpy(&expected[total], text, line);
+        TEST_Write(text, line);
+        total += line;
+    }
+    // Остаток кольца уходит без задачи
+    while (model.busy)
+    {
+        if (model.now < model.done)
+        {
+            model.now = model.done;
+        }
+        MODEL_Dispatch(model.now);
+    }
+    MODEL_Masked(model.lineFree, model.lineFree);
+
+    CHECK(model.sent == total && memcmp(model.out, expected, total) == 0);
+    CHECK(model.lineIdle == 0);
+    CHECK(CONSOLE_GetDropped() == 0);
+    CHECK(model.criticalMax <= MODEL_CRITICAL_CYCLES + CONSOLE_CHUNK * MODEL_BYTE_CYCLES);
+    CHECK(model.latencyMax <= model.criticalMax + MODEL_IRQ_CYCLES + MODEL_START_CYCLES + MODEL_CRITICAL_CYCLES);
+
+    elapsed = model.lineFree - model.firstByte;
+    printf("console %u MHz, %u baud, lines of %u bytes: %.0f bytes/s (line %u), DMA IRQ per %u bytes\n",
+           (unsigned)(hz / 1000000), (unsigned)baud, (unsigned)line, (double)total * hz / elapsed,
+           (unsigned)(hz / model.byteCycles), (unsigned)(total / model.irqs));
+    printf("  model: CPU %.1f cycles/byte, %.2f%% load (blocking byte-per-byte UART: %u cycles/byte, 100%%)\n",
+           (double)model.cpu / total, 100.0 * model.cpu / model.now, (unsigned)model.byteCycles);
+    printf("  model: 1 kHz control IRQ under BASEPRI delayed %u of %u times, max %u cycles (%.2f us), "
+           "mean %.0f cycles\n",
+           (unsigned)model.delayed, (unsigned)model.controls, (unsigned)model.latencyMax,
+           model.latencyMax * 1e6 / hz, model.delayed != 0 ? (double)model.latencySum / model.delayed : 0.0);
+}
+
+int main(void)
+{
+    TEST_Stream(80000000, 115200, 64);
+    TEST_Stream(80000000, 921600, 64);
+    TEST_Stream(8000000, 115200, 64);
+    TEST_Stream(8000000, 921600, 16);
+    return HOST_Result("test_console");
+}
@@ -0,0 +1,622 @@
+// Копирование и заполнение каналом DMA (DMAM_Memcpy/DMAM_Memset из app/src/dma.c) на модели
+// контроллера PL230 по тактам HCLK. Программный запрос auto-request ведет цикл до конца
+// пачками по 2^R передач с переарбитражем, передача и арбитраж стоят MODEL_*_CYCLES - оценки,
+// не замер на кристалле. ОЗУ кристалла (32 КБ с RAM_AHB_BASE) отображено по его адресу, все
+// остальное для dma.c - FLASH.
+// Проверяется: случайные блоки до 14 КБ (больше 1024 передач - несколько порций) всех ширин
+// передачи совпадают с эталоном байт в байт и не задевают соседние; FLASH, короткий блок и
+// занятые программные каналы - копирует процессор; DMAM_Wait по таймауту останавливает и
+// освобождает канал, после чего в dst никто не пишет; ошибка шины (ERR_CLR) сбрасывается,
+// задача узнает о ней из DMAM_Wait, соседний канал доходит до конца.
+// Печатается точка безубыточности по тактам процессора и освобожденные такты, из нее -
+// DMAM_MIN_SIZE и DMAM_MIN_FILL. Адреса в структурах DMA - 32 бита, тест без PIE
+#include "host.h"
+#include <sys/mman.h>
+
+// CMSIS
+typedef int IRQn_Type;
+#define DMA_IRQn ((IRQn_Type)1)
+static void NVIC_ClearPendingIRQ(IRQn_Type irq) { (void)irq; }
+static void NVIC_SetPriority(IRQn_Type irq, uint32_t priority) { (void)irq; (void)priority; }
+static void NVIC_EnableIRQ(IRQn_Type irq) { (void)irq; }
+static inline uint32_t __CLZ(uint32_t value) { return value != 0 ? (uint32_t)__builtin_clz(value) : 32; }
+static inline uint32_t __RBIT(uint32_t value)
+{
+    uint32_t result = 0;
+
+    for (uint32_t i = 0; i < 32; i++)
+    {
+        result |= ((value >> i) & 1) << (31 - i);
+    }
+    return result;
+}
+
+// SPL
+typedef struct
+{
+    uint32_t STATUS, CFG, CTRL_BASE_PTR, ALT_CTRL_BASE_PTR, WAITONREQ_STATUS, CHNL_SW_REQUEST;
+    uint32_t CHNL_USEBURST_SET, CHNL_USEBURST_CLR, CHNL_REQ_MASK_SET, CHNL_REQ_MASK_CLR;
+    uint32_t CHNL_ENABLE_SET, CHNL_ENABLE_CLR, CHNL_PRI_ALT_SET, CHNL_PRI_ALT_CLR;
+    uint32_t CHNL_PRIORITY_SET, CHNL_PRIORITY_CLR, ERR_CLR;
+} MDR_DMA_TypeDef;
+static MDR_DMA_TypeDef *MODEL_Dma(void);
+#define MDR_DMA (MODEL_Dma())
+
+#define RST_CLK_PCLK_DMA 0
+static void RST_CLK_PCLKcmd(uint32_t pclk, FunctionalState state) { (void)pclk; (void)state; }
+
+#define RAM_AHB_BASE          ((uint32_t)0x20000000)
+#define DMA_CFG_MASTER_ENABLE ((uint32_t)0x00000001)
+
+// MDR32FxQI_config.h
+#define DMA_AlternateData   1
+#define DMA_Channels_Number 32
+
+// FreeRTOS
+#define taskENTER_CRITICAL_FROM_ISR() (hostCritical++, (UBaseType_t)0)
+#define taskEXIT_CRITICAL_FROM_ISR(mask) \
+    do                                   \
+    {                                    \
+        (void)(mask);                    \
+        taskEXIT_CRITICAL();             \
+    } while (0)
+#define portYIELD_FROM_ISR(woken) ((void)(woken))
+
+static int self;
+static uint32_t notifications;
+static TaskHandle_t xTaskGetCurrentTaskHandle(void) { return &self; }
+static uint32_t ulTaskNotifyTakeIndexed(UBaseType_t index, BaseType_t clear, TickType_t ticks);
+
+#include "dma.h"
+
+static uint64_t doneAt; // такт последнего уведомления
+
+static void vTaskNotifyGiveIndexedFromISR(TaskHandle_t task, UBaseType_t index, BaseType_t *woken);
+
+#include "../app/src/dma.c"
+
+// Модель контроллера. Такты на передачу ОЗУ-ОЗУ (чтение и запись) и на арбитраж пачки
+// (чтение структуры канала и запись ее назад)
+#define MODEL_TRANSFER_CYCLES  3
+#define MODEL_ARBITRATE_CYCLES 8
+#define MODEL_IRQ_LATENCY      12
+
+static MDR_DMA_TypeDef dmaRegs;
+static int hostIsr;
+
+static struct
+{
+    uint64_t cycles;
+    // PL230: истинные регистры, dmaRegs - их отражение для процессора
+    uint32_t enable, mask, alt, priority;
+    uint32_t active;             // auto-request: цикл идет до конца по одному запросу
+    uint32_t error;              // флаг ERR_CLR
+    uint64_t busyUntil;
+    int irq;
+    uint64_t irqAt;
+    uint32_t irqs;               // входов в DMA_IRQHandler
+    uint64_t transfers;
+    uint32_t writes;             // передач в ОЗУ с последнего сброса
+    uint32_t errors;             // структура или адрес, которые контроллер не выполнил бы
+    uintptr_t badFrom, badTo;    // запись сюда - ошибка шины
+} model;
+
+static void MODEL_Error(const char *what)
+{
+    if (model.errors++ < 10)
+    {
+        printf("dma model: %s\n", what);
+    }
+}
+
+// Отражение ERR_CLR при ошибке держит еще старший бит: запись 1 процессором его стирает
+#define MODEL_ERR_MIRROR 0x80000001UL
+
+static void MODEL_DmaRefresh(void)
+{
+    MDR_DMA_TypeDef *r = &dmaRegs;
+
+    r->CHNL_ENABLE_SET = model.enable;
+    r->CHNL_REQ_MASK_SET = model.mask;
+    r->CHNL_PRI_ALT_SET = model.alt;
+    r->CHNL_PRIORITY_SET = model.priority;
+    r->CHNL_ENABLE_CLR = r->CHNL_REQ_MASK_CLR = r->CHNL_PRI_ALT_CLR = r->CHNL_PRIORITY_CLR = 0;
+    r->CHNL_SW_REQUEST = 0;
+    r->ERR_CLR = model.error ? MODEL_ERR_MIRROR : 0;
+}
+
+// Регистры SET/CLR: процессор записал - отражение разошлось с истинным значением
+static void MODEL_DmaCommit(void)
+{
+    MDR_DMA_TypeDef *r = &dmaRegs;
+
+    if (r->CHNL_ENABLE_SET != model.enable)
+    {
+        model.enable |= r->CHNL_ENABLE_SET;
+    }
+    if (r->CHNL_REQ_MASK_SET != model.mask)
+    {
+        model.mask |= r->CHNL_REQ_MASK_SET;
+    }
+    if (r->CHNL_PRI_ALT_SET != model.alt)
+    {
+        model.alt |= r->CHNL_PRI_ALT_SET;
+    }
+    if (r->CHNL_PRIORITY_SET != model.priority)
+    {
+        model.priority |= r->CHNL_PRIORITY_SET;
+    }
+    model.enable &= ~r->CHNL_ENABLE_CLR;
+    model.mask &= ~r->CHNL_REQ_MASK_CLR;
+    model.alt &= ~r->CHNL_PRI_ALT_CLR;
+    model.priority &= ~r->CHNL_PRIORITY_CLR;
+    model.active |= r->CHNL_SW_REQUEST & model.enable;
+    if (r->ERR_CLR != (model.error ? MODEL_ERR_MIRROR : 0) && (r->ERR_CLR & 1))
+    {
+        model.error = 0;
+    }
+    MODEL_DmaRefresh();
+}
+
+static void MODEL_DmaDone(void)
+{
+    if (!model.irq)
+    {
+        model.irq = 1;
+        model.irqAt = model.cycles + MODEL_IRQ_LATENCY;
+    }
+}
+
+static int MODEL_IsRam(uintptr_t address, uint32_t size)
+{
+    return address >= RAM_AHB_BASE && address + size <= RAM_AHB_BASE + DMAM_RAM_SIZE;
+}
+
+// Пачка auto-request основной структуры канала
+static void MODEL_Service(uint32_t channel)
+{
+    uint32_t bit = 1UL << channel;
+    DMA_CtrlDataTypeDef *s = &DMA_ControlTable[channel];
+    uint32_t control = s->DMA_Control;
+    uint32_t left = ((control >> 4) & 0x3FF) + 1;
+    uint32_t burst = 1u << ((control >> 14) & 0xF);
+    uint32_t dstInc = control >> 30, srcInc = (control >> 26) & 3, size = (control >> 24) & 3;
+
+    if ((model.alt & bit) || (control & 7) != DMA_Mode_AutoRequest)
+    {
+        MODEL_Error("unexpected mode");
+        model.enable &= ~bit;
+        return;
+    }
+    if (((control >> 28) & 3) != size || size == 3 || dstInc != size || (srcInc != 3 && srcInc != size))
+    {
+        MODEL_Error("bad sizes");
+        model.enable &= ~bit;
+        return;
+    }
+    model.busyUntil += MODEL_ARBITRATE_CYCLES;
+    for (; burst != 0 && left != 0; burst--, left--)
+    {
+        uintptr_t src = s->DMA_SourceEndAddr - (srcInc == 3 ? 0 : (left - 1) << srcInc);
+        uintptr_t dst = s->DMA_DestEndAddr - ((left - 1) << dstInc);
+
+        if (dst >= model.badFrom && dst < model.badTo)
+        {
+            // Ошибка шины: канал выключен, структура не записана назад
+            model.error = 1;
+            model.enable &= ~bit;
+            model.active &= ~bit;
+            MODEL_DmaDone();
+            return;
+        }
+        if (!MODEL_IsRam(dst, 1u << size) || (srcInc != 3 && !MODEL_IsRam(src, 1u << size)))
+        {
+            MODEL_Error("transfer outside RAM");
+        }
+        memcpy((void *)dst, (const void *)src, 1u << size);
+        model.busyUntil += MODEL_TRANSFER_CYCLES;
+        model.transfers++;
+        model.writes++;
+    }
+    if (left == 0)
+    {
+        s->DMA_Control = control & ~((0x3FFUL << 4) | 7);
+        model.enable &= ~bit;
+        model.active &= ~bit;
+        MODEL_DmaDone();
+    }
+    else
+    {
+        s->DMA_Control = (control & ~(0x3FFUL << 4)) | ((left - 1) << 4);
+    }
+}
+
+static void MODEL_Cycle(void)
+{
+    model.cycles++;
+    MODEL_DmaCommit();
+    model.active &= model.enable;
+    if (model.cycles >= model.busyUntil && model.active != 0)
+    {
+        uint32_t high = model.active & model.priority;
+
+        model.busyUntil = model.cycles;
+        MODEL_Service(__CLZ(__RBIT(high != 0 ? high : model.active)));
+    }
+    MODEL_DmaRefresh();
+}
+
+static void MODEL_Dispatch(void)
+{
+    if (!model.irq || hostIsr || hostCritical != 0 || model.cycles < model.irqAt)
+    {
+        return;
+    }
+    model.irq = 0;
+    model.irqs++;
+    hostIsr = 1;
+    DMA_IRQHandler();
+    hostIsr = 0;
+}
+
+static void MODEL_Run(uint64_t cycles)
+{
+    uint64_t end = model.cycles + cycles;
+
+    while (model.cycles < end)
+    {
+        MODEL_Cycle();
+        MODEL_Dispatch();
+    }
+}
+
+// Каждое обращение к контроллеру - такт, на нем может войти DMA_IRQHandler
+static MDR_DMA_TypeDef *MODEL_Dma(void)
+{
+    MODEL_Run(1);
+    return &dmaRegs;
+}
+
+static void vTaskNotifyGiveIndexedFromISR(TaskHandle_t task, UBaseType_t index, BaseType_t *woken)
+{
+    CHECK(task == &self && index == DMAM_NOTIFY_INDEX);
+    CHECK(hostIsr);
+    notifications++;
+    doneAt = model.cycles;
+    *woken = pdTRUE;
+}
+
+static uint32_t ulTaskNotifyTakeIndexed(UBaseType_t index, BaseType_t clear, TickType_t ticks)
+{
+    uint64_t end = model.cycles + (uint64_t)ticks * SystemCoreClock / configTICK_RATE_HZ;
+    uint32_t value;
+
+    CHECK(index == DMAM_NOTIFY_INDEX && clear == pdTRUE);
+    CHECK(hostCritical == 0);
+    while (notifications == 0 && model.cycles < end)
+    {
+        MODEL_Run(1);
+    }
+    value = notifications;
+    notifications = 0;
+    return value;
+}
+
+// ОЗУ кристалла: dst и src в разных половинах, по краям - контрольные байты
+#define ARENA    ((uint8_t *)(uintptr_t)RAM_AHB_BASE)
+#define HALF     (DMAM_RAM_SIZE / 2)
+#define MAX_SIZE 14000
+
+static uint8_t reference[DMAM_RAM_SIZE];
+
+static uint32_t seed = 1;
+static uint32_t TEST_Random(void)
+{
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+static void TEST_Fill(uint8_t *p, uint32_t size)
+{
+    for (uint32_t i = 0; i < size; i++)
+    {
+        p[i] = (uint8_t)TEST_Random();
+    }
+    memcpy(reference, ARENA, DMAM_RAM_SIZE);
+}
+
+// Вся арена совпадает с эталоном: ни байта мимо dst
+static int TEST_Same(void)
+{
+    return memcmp(reference, ARENA, DMAM_RAM_SIZE) == 0;
+}
+
+static DMAM_Job_t job, other;
+
+// Один блок: ширина передачи, число порций и содержимое
+static void TEST_Block(uint32_t dstOffset, uint32_t srcOffset, uint32_t size, int fill)
+{
+    uint8_t *dst = ARENA + dstOffset, *src = ARENA + HALF + srcOffset;
+    uint8_t value = (uint8_t)TEST_Random();
+    uint32_t align = dstOffset | (fill ? 0 : srcOffset) | size;
+    uint32_t unit = (align & 1) ? 1 : (align & 2) ? 2 : 4;
+    uint32_t irqs = model.irqs;
+    uint64_t transfers = model.transfers;
+    int dma = size >= (fill ? DMAM_MIN_FILL : DMAM_MIN_SIZE);
+
+    TEST_Fill(ARENA, DMAM_RAM_SIZE);
+    if (fill)
+    {
+        memset(reference + dstOffset, value, size);
+        DMAM_Memset(&job, dst, value, size);
+    }
+    else
+    {
+        memcpy(reference + dstOffset, src, size);
+        DMAM_Memcpy(&job, dst, src, size);
+    }
+    CHECK(job.busy == dma && (job.channel >= 0) == dma);
+    CHECK(DMAM_Wait(&job, portMAX_DELAY) == pdTRUE);
+    CHECK(TEST_Same());
+    CHECK(allocated == 0 && armed == 0 && hostCritical == 0);
+    if (dma)
+    {
+        uint32_t count = size / unit;
+
+        CHECK(job.unit == unit);
+        CHECK(model.transfers - transfers == count);
+        CHECK(model.irqs - irqs == (count + DMAM_MAX_TRANSFERS - 1) / DMAM_MAX_TRANSFERS); // прерывание на порцию
+    }
+    else
+    {
+        CHECK(model.transfers == transfers);
+    }
+}
+
+static void TEST_Random_Blocks(void)
+{
+    uint32_t units[5] = { 0 }, multi = 0;
+
+    for (int i = 0; i < 300; i++)
+    {
+        uint32_t size = TEST_Random() % 3 == 0 ? TEST_Random() % 2048 : TEST_Random() % MAX_SIZE;
+        uint32_t dstOffset = TEST_Random() % (HALF - MAX_SIZE);
+        uint32_t srcOffset = TEST_Random() % (HALF - MAX_SIZE);
+        uint32_t shape = TEST_Random() % 3; // ширина: выравниваем под 4, 2 или как вышло
+
+        if (shape == 0)
+        {
+            size &= ~3u;
+            dstOffset &= ~3u;
+            srcOffset &= ~3u;
+        }
+        else if (shape == 1)
+        {
+            size = (size & ~1u) | 2;
+            dstOffset &= ~1u;
+            srcOffset &= ~1u;
+        }
+        TEST_Block(dstOffset, srcOffset, size, TEST_Random() & 1);
+        if (job.channel >= 0)
+        {
+            units[job.unit]++;
+            multi += size / job.unit > DMAM_MAX_TRANSFERS;
+        }
+    }
+    CHECK(units[1] > 10 && units[2] > 10 && units[4] > 10);
+    CHECK(multi > 50);
+}
+
+// Границы порций: ровно 1024 передачи и на одну больше, у каждой ширины
+static void TEST_Chunks(void)
+{
+    static const uint32_t units[] = { 1, 2, 4 };
+
+    for (uint32_t u = 0; u < 3; u++)
+    {
+        uint32_t unit = units[u];
+
+        for (uint32_t extra = 0; extra < 2; extra++)
+        {
+            uint32_t size = (DMAM_MAX_TRANSFERS + extra) * unit;
+            uint32_t offset = unit == 1 ? 1 : unit == 2 ? 2 : 0;
+
+            if (size >= DMAM_MIN_SIZE && size >= DMAM_MIN_FILL && size < HALF)
+            {
+                TEST_Block(offset, offset, size, 0);
+                CHECK(job.unit == unit);
+                TEST_Block(offset, 0, size, 1);
+            }
+        }
+    }
+}
+
+// Не ОЗУ, коротко, каналы кончились - копирует процессор, канал не занимается
+static const uint8_t flashData[8192] = { 1, 2, 3, 4, 5 };
+
+static void TEST_Cpu(void)
+{
+    int32_t taken[32];
+    int n = 0;
+
+    TEST_Fill(ARENA, DMAM_RAM_SIZE);
+    memcpy(reference, flashData, sizeof(flashData));
+    DMAM_Memcpy(&job, ARENA, flashData, sizeof(flashData));
+    CHECK(!job.busy && job.channel == -1 && DMAM_Wait(&job, 0) == pdTRUE);
+    CHECK(TEST_Same());
+
+    // Блок заходит за конец ОЗУ
+    TEST_Fill(ARENA, DMAM_RAM_SIZE);
+    memcpy(reference, ARENA + DMAM_RAM_SIZE - 4096, 4096);
+    DMAM_Memcpy(&job, ARENA, ARENA + DMAM_RAM_SIZE - 4096, 4096);
+    CHECK(job.channel >= 0); // ровно до конца - еще ОЗУ
+    CHECK(DMAM_Wait(&job, portMAX_DELAY) == pdTRUE && TEST_Same());
+    CHECK(!DMAM_IsRam(ARENA + DMAM_RAM_SIZE - 4095, 4096));
+
+    // Все программные каналы заняты
+    while ((taken[n] = DMAM_Alloc(DMAM_ANY, NULL, NULL)) >= 0)
+    {
+        n++;
+    }
+    CHECK(n == 32 - DMA_Channel_SW1);
+    TEST_Fill(ARENA, DMAM_RAM_SIZE);
+    memcpy(reference, ARENA + HALF, 8192);
+    DMAM_Memcpy(&job, ARENA, ARENA + HALF, 8192);
+    CHECK(!job.busy && job.channel == -1 && TEST_Same());
+    memset(reference, 0x5A, 8192);
+    DMAM_Memset(&job, ARENA, 0x5A, 8192);
+    CHECK(!job.busy && job.channel == -1 && TEST_Same());
+    while (n-- > 0)
+    {
+        DMAM_Free((uint32_t)taken[n]);
+    }
+    CHECK(allocated == 0);
+}
+
+// Таймаут посреди передачи: канал остановлен и свободен, dst больше не меняется
+static void TEST_Timeout(void)
+{
+    uint32_t writes;
+
+    TEST_Fill(ARENA, DMAM_RAM_SIZE);
+    model.writes = 0;
+    DMAM_Memcpy(&job, ARENA + 1, ARENA + HALF, MAX_SIZE); // байтами: ~3.5 такта на байт
+    CHECK(job.busy && job.channel >= 0);
+    CHECK(DMAM_Wait(&job, 1) == pdFALSE); // тик - 8000 тактов, передаче нужно ~49000
+    CHECK(!job.busy && job.error);
+    CHECK(allocated == 0 && armed == 0 && hostCritical == 0);
+    writes = model.writes;
+    CHECK(writes > 0 && writes < MAX_SIZE);
+    memcpy(reference, ARENA, DMAM_RAM_SIZE);
+    MODEL_Run(100000);
+    CHECK(model.writes == writes && TEST_Same());
+    CHECK((model.enable & model.active) == 0);
+
+    // Следующая передача на том же канале проходит, опоздавшее уведомление не мешает
+    TEST_Block(0, 0, 4096, 0);
+    CHECK(job.channel >= 0 && !job.error);
+}
+
+// Ошибка шины на одном канале: он кончается с ошибкой, соседний - как обычно
+static void TEST_BusError(void)
+{
+    int32_t channel;
+
+    TEST_Fill(ARENA, DMAM_RAM_SIZE);
+    memcpy(reference + HALF / 2, ARENA + HALF, 4096);
+    model.badFrom = (uintptr_t)ARENA + 2000;
+    model.badTo = model.badFrom + 4;
+    DMAM_Memcpy(&job, ARENA, ARENA + HALF + 4096, 4096);
+    channel = job.channel;
+    DMAM_Memcpy(&other, ARENA + HALF / 2, ARENA + HALF, 4096);
+    CHECK(job.channel >= 0 && other.channel >= 0 && job.channel != other.channel);
+    CHECK(DMAM_Wait(&job, portMAX_DELAY) == pdFALSE && job.error);
+    CHECK(DMAM_Failed((uint32_t)channel));
+    CHECK(DMAM_Wait(&other, portMAX_DELAY) == pdTRUE && !other.error);
+    CHECK(memcmp(reference + HALF / 2, ARENA + HALF / 2, 4096) == 0);
+    CHECK(model.error == 0); // обработчик сбросил ERR_CLR
+    CHECK(allocated == 0 && armed == 0 && hostCritical == 0);
+    model.badFrom = model.badTo = 0;
+
+    // Флаг живет до следующего запуска канала
+    TEST_Block(0, 0, 4096, 0);
+    CHECK(job.channel == channel && !DMAM_Failed((uint32_t)channel));
+}
+
+// Такты процессора на передачу каналом (оценки по коду dma.c, не замер):
+#define MODEL_START_CYCLES 160 // DMAM_JobStart: проверки адресов, DMAM_Alloc, порция, DMAM_Start
+#define MODEL_CHUNK_CYCLES 140 // прерывание порции: вход, опрос armed, DMAM_JobDone, порция, выход
+#define MODEL_DONE_CYCLES  260 // последнее: DMAM_Free, уведомление, переключение на ждущую задачу
+#define MODEL_BLOCK_CYCLES 200 // DMAM_Wait: засыпание и переключение на другую задачу
+// Процессором, тактов на КБ из test_cm3_string.py --table при 1024 байтах (модель тактов)
+#define MODEL_MEMCPY_KB_CYCLES           747  // 1.37 байта за такт
+#define MODEL_MEMCPY_UNALIGNED_KB_CYCLES 1249 // 0.82, src+1; так же считаются полуслова
+#define MODEL_MEMSET_KB_CYCLES           461  // 2.22
+
+static uint32_t TEST_CpuCycles(uint32_t size, uint32_t unit, int fill)
+{
+    uint32_t kb = fill ? MODEL_MEMSET_KB_CYCLES : unit == 4 ? MODEL_MEMCPY_KB_CYCLES : MODEL_MEMCPY_UNALIGNED_KB_CYCLES;
+
+    return (uint32_t)(((uint64_t)size * kb + 1023) / 1024);
+}
+
+static uint32_t TEST_DmaCycles(uint32_t size, uint32_t unit)
+{
+    uint32_t chunks = (size / unit + DMAM_MAX_TRANSFERS - 1) / DMAM_MAX_TRANSFERS;
+
+    return MODEL_START_CYCLES + (chunks - 1) * MODEL_CHUNK_CYCLES + MODEL_DONE_CYCLES + MODEL_BLOCK_CYCLES;
+}
+
+// Наименьший размер, с которого канал берет у процессора меньше тактов, чем memcpy
+static uint32_t TEST_BreakEven(uint32_t unit, int fill)
+{
+    uint32_t size = unit;
+
+    while (TEST_CpuCycles(size, unit, fill) < TEST_DmaCycles(size, unit))
+    {
+        size += unit;
+    }
+    return size;
+}
+
+static void TEST_Figures(void)
+{
+    static const uint32_t sizes[] = { 2048, 4096, 12288 };
+    uint32_t copy4 = TEST_BreakEven(4, 0), copy1 = TEST_BreakEven(1, 0), fill = TEST_BreakEven(4, 1);
+
+    printf("DMAM_Memcpy/DMAM_Memset, такты процессора (оценки MODEL_*_CYCLES, memcpy - модель\n"
+           "cm3_string.S) и длительность передачи на модели PL230, не замер:\n"
+           "               байт  процессор  канал  освобождено  передача каналом\n");
+    for (uint32_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        for (int f = 0; f < 2; f++)
+        {
+            for (uint32_t unit = 1; unit <= 4; unit *= 2)
+            {
+                uint32_t size = sizes[i], cpu = TEST_CpuCycles(size, unit, f), dma = TEST_DmaCycles(size, unit);
+                uint32_t offset = unit == 1 ? 1 : unit == 2 ? 2 : 0;
+                uint64_t start;
+
+                if (f && unit != 4)
+                {
+                    continue; // memset процессором от выравнивания почти не зависит
+                }
+                TEST_Fill(ARENA, DMAM_RAM_SIZE);
+                start = model.cycles;
+                if (f)
+                {
+                    DMAM_Memset(&job, ARENA, 0, size);
+                }
+                else
+                {
+                    DMAM_Memcpy(&job, ARENA + offset, ARENA + HALF + offset, size);
+                }
+                CHECK(DMAM_Wait(&job, portMAX_DELAY) == pdTRUE && job.unit == unit);
+                printf("  %s %u  %6u  %9u  %5u  %11d  %8llu\n", f ? "memset" : "memcpy", (unsigned)unit, (unsigned)size,
+                       (unsigned)cpu, (unsigned)dma, (int)cpu - (int)dma, (unsigned long long)(doneAt - start));
+            }
+        }
+    }
+    printf("безубыточность: memcpy словами %u байт, байтами %u, memset %u;\n"
+           "DMAM_MIN_SIZE %u, DMAM_MIN_FILL %u\n",
+           (unsigned)copy4, (unsigned)copy1, (unsigned)fill, (unsigned)DMAM_MIN_SIZE, (unsigned)DMAM_MIN_FILL);
+    // Пороги - безубыточность самого дешевого для процессора варианта, округленная до 64
+    CHECK(DMAM_MIN_SIZE >= copy4 && DMAM_MIN_SIZE < copy4 + 64);
+    CHECK(DMAM_MIN_FILL >= fill && DMAM_MIN_FILL < fill + 64);
+}
+
+int main(void)
+{
+    CHECK(mmap(ARENA, DMAM_RAM_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0) == ARENA);
+    DMAM_Init();
+    hostUnmaskHook = MODEL_Dispatch;
+
+    TEST_Random_Blocks();
+    TEST_Chunks();
+    TEST_Cpu();
+    TEST_Timeout();
+    TEST_BusError();
+    TEST_Figures();
+    CHECK(model.errors == 0 && hostAsserts == 0);
+    return HOST_Result("test_dma");
+}
@@ -0,0 +1,400 @@
+// Сервис записи FLASH (app/src/flash.c) на модели контроллера EEPROM.
+// Модель смотрит на CMD/ADR/DI в каждой задержке DELAY_PROGRAM_WaitLoopsAsm: проверяет
+// последовательность команд и минимальные времена по спецификации, стирает сектор и
+// программирует слово, а заодно меряет время под BASEPRI - задержку маскированных прерываний
+#include "host.h"
+
+// CMSIS
+typedef int IRQn_Type;
+typedef struct
+{
+    uintptr_t VTOR; // на хосте указатель шире 32 бит
+} SCB_Type;
+typedef struct
+{
+    uint32_t ISER[1];
+} NVIC_Type;
+static SCB_Type hostScb;
+static NVIC_Type hostNvic;
+static uint32_t nvicPriority[32];
+#define SCB  (&hostScb)
+#define NVIC (&hostNvic)
+static uint32_t NVIC_GetPriority(IRQn_Type irq) { return nvicPriority[irq]; }
+
+// SPL
+typedef struct
+{
+    uint32_t CMD, ADR, DI, DO, KEY;
+} MDR_EEPROM_TypeDef;
+static MDR_EEPROM_TypeDef eeprom;
+#define MDR_EEPROM (&eeprom)
+
+#define EEPROM_BASE  ((uint32_t)0x08000000)
+#define RAM_AHB_BASE ((uint32_t)0x20000000)
+
+#define EEPROM_CMD_CON       ((uint32_t)0x00000001)
+#define EEPROM_CMD_DELAY_Msk ((uint32_t)0x00000038)
+#define EEPROM_CMD_XE        ((uint32_t)0x00000040)
+#define EEPROM_CMD_YE        ((uint32_t)0x00000080)
+#define EEPROM_CMD_ERASE     ((uint32_t)0x00000400)
+#define EEPROM_CMD_PROG      ((uint32_t)0x00001000)
+#define EEPROM_CMD_NVSTR     ((uint32_t)0x00002000)
+
+// Из MDR32FxQI_eeprom.h, с запасом 25%
+#define EEPROM_TNVS_US   (7)
+#define EEPROM_TNVH_US   (7)
+#define EEPROM_TPGS_US   (13)
+#define EEPROM_TRCV_US   (2)
+#define EEPROM_THV_US    (5000)
+#define EEPROM_TPROG_US  (25)
+#define EEPROM_TERASE_US (25000)
+
+#define RST_CLK_PCLK_EEPROM 0
+static void RST_CLK_PCLKcmd(uint32_t pclk, FunctionalState state) { (void)pclk; (void)state; }
+static int dcacheUpdates;
+static void EEPROM_UpdateDCache(void) { dcacheUpdates++; }
+
+// FreeRTOS
+static int suspendCalls;
+static TickType_t caughtUp;
+static int self;
+static uint32_t notifications;
+static uint32_t (*blockHook)(TickType_t ticks); // что происходит, пока задача спит в FLASH_Wait
+
+static void vTaskSuspendAll(void) { suspendCalls++; }
+static BaseType_t xTaskResumeAll(void) { return pdFALSE; }
+static BaseType_t xTaskCatchUpTicks(TickType_t ticks)
+{
+    caughtUp += ticks;
+    return pdFALSE;
+}
+static TaskHandle_t xTaskGetCurrentTaskHandle(void) { return &self; }
+
+#include "flash.h" // FLASH_NOTIFY_INDEX для заглушек ниже
+
+static void xTaskNotifyGiveIndexed(TaskHandle_t task, UBaseType_t index)
+{
+    CHECK(task == &self && index == FLASH_NOTIFY_INDEX);
+    notifications++;
+}
+static uint32_t ulTaskNotifyTakeIndexed(UBaseType_t index, BaseType_t clear, TickType_t ticks)
+{
+    CHECK(index == FLASH_NOTIFY_INDEX && clear == pdTRUE);
+    CHECK(hostCritical == 0);
+    uint32_t value = blockHook(ticks) + notifications;
+    notifications = 0;
+    return value;
+}
+
+#include "../app/src/flash.c"
+
+// Модель контроллера
+
+static uint32_t memory[FLASH_BANK_SIZE / 4];
+static double sliceUs, maxMaskedUs;
+static int protocolErrors;
+static uint32_t programmed, erased;
+
+// Минимумы по спецификации 1986ВЕ9х, SPL держит запас 25% с округлением вверх
+#define SPEC_TNVS_US   5
+#define SPEC_TNVH_US   5
+#define SPEC_TPGS_US   10
+#define SPEC_TPROG_US  20
+#define SPEC_TRCV_US   1
+#define SPEC_TERASE_US 20000
+
+static void MODEL_Error(const char *what)
+{
+    printf("flash model: %s, CMD %04x ADR %08x\n", what, (unsigned)eeprom.CMD, (unsigned)eeprom.ADR);
+    protocolErrors++;
+}
+
+static void MODEL_Basepri(uint32_t value)
+{
+    if (value != 0)
+    {
+        sliceUs = 0;
+    }
+    else if (sliceUs > maxMaskedUs)
+    {
+        maxMaskedUs = sliceUs;
+    }
+}
+
+void DELAY_PROGRAM_WaitLoopsAsm(uint32_t loops)
+{
+    const uint32_t modes = EEPROM_CMD_XE | EEPROM_CMD_YE | EEPROM_CMD_ERASE | EEPROM_CMD_PROG | EEPROM_CMD_NVSTR;
+    double us = (double)loops * DELAY_PROGRAM_LOOP_CYCLES * 1e6 / SystemCoreClock;
+    uint32_t mode = eeprom.CMD & modes;
+    uint32_t word = (eeprom.ADR - EEPROM_BASE) / 4;
+    double need = 0;
+
+    sliceUs += us;
+
+    // FLASH не читается: маскированы все прерывания, кроме исполняемых из ОЗУ
+    if (hostBasepri != FLASH_BASEPRI || (uint32_t)hostScb.VTOR != (uint32_t)(uintptr_t)ramVectors)
+    {
+        MODEL_Error("FLASH busy without BASEPRI mask or RAM vector table");
+    }
+    if (mode != 0 && (eeprom.KEY != FLASH_KEY || !(eeprom.CMD & EEPROM_CMD_CON)))
+    {
+        MODEL_Error("command without KEY/CON");
+    }
+    if (mode != 0 && word >= FLASH_BANK_SIZE / 4)
+    {
+        MODEL_Error("address out of bank");
+        return;
+    }
+
+    if (mode == (EEPROM_CMD_XE | EEPROM_CMD_ERASE) || mode == (EEPROM_CMD_XE | EEPROM_CMD_PROG))
+    {
+        need = SPEC_TNVS_US;
+    }
+    else if (mode == (EEPROM_CMD_XE | EEPROM_CMD_ERASE | EEPROM_CMD_NVSTR))
+    {
+        // Сектор - слова страницы с теми же битами 2-3 адреса
+        uint32_t page = word & ~(FLASH_PAGE_SIZE / 4 - 1);
+        for (uint32_t i = word % FLASH_SECTORS; i < FLASH_PAGE_SIZE / 4; i += FLASH_SECTORS)
+        {
+            memory[page + i] = 0xFFFFFFFF;
+        }
+        erased++;
+        need = SPEC_TERASE_US;
+    }
+    else if (mode == (EEPROM_CMD_XE | EEPROM_CMD_PROG | EEPROM_CMD_NVSTR))
+    {
+        need = SPEC_TPGS_US;
+    }
+    else if (mode == (EEPROM_CMD_XE | EEPROM_CMD_PROG | EEPROM_CMD_NVSTR | EEPROM_CMD_YE))
+    {
+        if (memory[word] != 0xFFFFFFFF)
+        {
+            MODEL_Error("program over a word that is not erased");
+        }
+        memory[word] &= eeprom.DI;
+        programmed++;
+        need = SPEC_TPROG_US;
+    }
+    else if (mode == (EEPROM_CMD_XE | EEPROM_CMD_NVSTR))
+    {
+        need = SPEC_TNVH_US;
+    }
+    else if (mode == 0)
+    {
+        need = eeprom.KEY == FLASH_KEY ? SPEC_TRCV_US : 0; // THV - после снятия ключа
+    }
+    else
+    {
+        MODEL_Error("unexpected mode");
+    }
+
+    if (us < need)
+    {
+        MODEL_Error("phase too short");
+    }
+}
+
+// Сценарии
+
+static uint32_t flashVectors[FLASH_VECTORS];
+
+static void TEST_Reset(uint32_t hz)
+{
+    SystemCoreClock = hz;
+    suspendCalls = 0;
+    caughtUp = 0;
+    maxMaskedUs = 0;
+    programmed = erased = 0;
+    dcacheUpdates = 0;
+}
+
+static void TEST_Idle(void)
+{
+    TEST_Reset(80000000);
+    CHECK(FLASH_Process(0) == pdFALSE);
+    CHECK(suspendCalls == 0); // холостой проход idle hook не трогает планировщик
+    CHECK(dcacheUpdates == 0);
+}
+
+static void TEST_Erase(uint32_t hz)
+{
+    uint32_t first = 3 * FLASH_PAGE_SIZE / 4;
+    uint32_t slices = 0;
+
+    TEST_Reset(hz);
+    for (uint32_t i = 0; i < FLASH_BANK_SIZE / 4; i++)
+    {
+        memory[i] = i * 2654435761u;
+    }
+
+    CHECK(FLASH_Erase(EEPROM_BASE + 3 * FLASH_PAGE_SIZE, 2) == SUCCESS);
+    CHECK(FLASH_Erase(EEPROM_BASE, 1) == ERROR); // одна операция за раз
+    while (FLASH_IsBusy())
+    {
+        FLASH_Process(0);
+        slices++;
+    }
+
+    CHECK(slices == 2 * FLASH_SECTORS);
+    CHECK(erased == 2 * FLASH_SECTORS);
+    for (uint32_t i = 0; i < FLASH_BANK_SIZE / 4; i++)
+    {
+        int inside = i >= first && i < first + 2 * FLASH_PAGE_SIZE / 4;
+        CHECK(memory[i] == (inside ? 0xFFFFFFFF : i * 2654435761u));
+    }
+    CHECK(maxMaskedUs <= FLASH_MAX_LATENCY_US);
+    CHECK(maxMaskedUs >= SPEC_TERASE_US);
+    // За квант стирания (~25 мс) SysTick взводится один раз: остальное досчитано
+    CHECK(caughtUp == 2 * FLASH_SECTORS * (FLASH_ERASE_SLICE_US / 1000 - 1) + EEPROM_THV_US / 1000);
+    CHECK(dcacheUpdates == 1);
+    printf("erase at %u MHz: %u slices, masked max %.0f us (limit %u)\n",
+           (unsigned)(hz / 1000000), (unsigned)slices, maxMaskedUs, (unsigned)FLASH_MAX_LATENCY_US);
+}
+
+static void TEST_Write(uint32_t hz, uint32_t budgetUs, uint32_t offset)
+{
+    static uint32_t data[37];
+    uint32_t address = EEPROM_BASE + 3 * FLASH_PAGE_SIZE + offset;
+    uint32_t calls = 0;
+
+    TEST_Reset(hz);
+    for (uint32_t i = 0; i < 37; i++)
+    {
+        data[i] = (uint32_t)rand() * 2654435761u;
+    }
+
+    CHECK(FLASH_Write(address + 2, data, 37) == ERROR);
+    CHECK(FLASH_Write(EEPROM_BASE + FLASH_BANK_SIZE - 8, data, 37) == ERROR);
+    CHECK(FLASH_Write(address, data, 37) == SUCCESS);
+    while (FLASH_Process(budgetUs))
+    {
+        calls++;
+    }
+    calls++;
+
+    CHECK(programmed == 37);
+    CHECK(memcmp(&memory[(address - EEPROM_BASE) / 4], data, sizeof(data)) == 0);
+    CHECK(memory[(address - EEPROM_BASE) / 4 + 37] == 0xFFFFFFFF);
+    CHECK(maxMaskedUs <= FLASH_MAX_LATENCY_US);
+    CHECK(maxMaskedUs <= FLASH_SLICE_WORDS * FLASH_WORD_US);
+    if (budgetUs == 0)
+    {
+        CHECK(calls == (37 + FLASH_SLICE_WORDS - 1) / FLASH_SLICE_WORDS);
+    }
+    else
+    {
+        CHECK(calls == 1);
+    }
+    CHECK(dcacheUpdates == 1);
+}
+
+// Прерывание выше FLASH_CRITICAL_PRIORITY с обработчиком во FLASH - ошибка конфигурации
+static void TEST_Vectors(void)
+{
+    hostNvic.ISER[0] = 1u << 3;
+    nvicPriority[3] = FLASH_CRITICAL_PRIORITY - 1;
+    ramVectors[16 + 3] = EEPROM_BASE + 0x1234;
+    hostAsserts = 0;
+    CHECK(FLASH_Erase(EEPROM_BASE, 1) == SUCCESS);
+    CHECK(hostAsserts == 1);
+    while (FLASH_Process(0))
+    {
+    }
+
+    ramVectors[16 + 3] = RAM_AHB_BASE + 0x101;
+    hostAsserts = 0;
+    CHECK(FLASH_Erase(EEPROM_BASE, 1) == SUCCESS);
+    CHECK(hostAsserts == 0);
+    while (FLASH_Process(0))
+    {
+    }
+    hostNvic.ISER[0] = 0;
+}
+
+// FLASH_Wait: пока задача спит, работу делает другая задача (FLASH_Process)
+
+static uint32_t BLOCK_Finish(TickType_t ticks)
+{
+    (void)ticks;
+    while (FLASH_Process(0))
+    {
+    }
+    return 0; // уведомление считает xTaskNotifyGiveIndexed
+}
+
+static uint32_t BLOCK_Timeout(TickType_t ticks)
+{
+    (void)ticks;
+    FLASH_Process(0);
+    return 0;
+}
+
+static uint32_t late;
+
+static uint32_t BLOCK_LateFinish(TickType_t ticks)
+{
+    // Таймаут истек, а до снятия регистрации FLASH_Process закончил работу:
+    // задача видит 0, уведомление приходит после
+    (void)ticks;
+    while (FLASH_Process(0))
+    {
+    }
+    late = notifications;
+    notifications = 0;
+    return 0;
+}
+
+static void TEST_Wait(void)
+{
+    static const uint32_t data[20] = {1, 2, 3};
+
+    TEST_Reset(80000000);
+    CHECK(FLASH_Wait(10) == pdTRUE); // нечего ждать
+
+    CHECK(FLASH_Erase(EEPROM_BASE + 8 * FLASH_PAGE_SIZE, 1) == SUCCESS);
+    blockHook = BLOCK_Finish;
+    CHECK(FLASH_Wait(portMAX_DELAY) == pdTRUE);
+    CHECK(job.waiter == NULL);
+
+    CHECK(FLASH_Write(EEPROM_BASE + 8 * FLASH_PAGE_SIZE, data, 20) == SUCCESS);
+    blockHook = BLOCK_Timeout;
+    CHECK(FLASH_Wait(1) == pdFALSE);
+    CHECK(job.waiter == NULL); // регистрация снята: позднее завершение не уведомит
+    CHECK(FLASH_IsBusy());
+    CHECK(hostCritical == 0);
+
+    blockHook = BLOCK_LateFinish;
+    CHECK(FLASH_Wait(1) == pdTRUE); // таймаут, но работа уже сделана
+    CHECK(job.waiter == NULL);
+    CHECK(hostCritical == 0);
+    CHECK(memory[8 * FLASH_PAGE_SIZE / 4 + 2] == 3);
+
+    notifications = late; // опоздавшее уведомление ничего не ломает
+    CHECK(late == 1);
+    CHECK(FLASH_Wait(1) == pdTRUE);
+}
+
+int main(void)
+{
+    for (uint32_t i = 0; i < FLASH_VECTORS; i++)
+    {
+        flashVectors[i] = EEPROM_BASE + 0x100 + i * 4;
+    }
+    hostScb.VTOR = (uintptr_t)flashVectors;
+    hostBasepriHook = MODEL_Basepri;
+    FLASH_Init();
+    CHECK(memcmp(ramVectors, flashVectors, sizeof(flashVectors)) == 0);
+
+    TEST_Idle();
+    TEST_Erase(8000000);
+    TEST_Erase(80000000);
+    TEST_Write(8000000, 0, 64);
+    TEST_Write(40000000, 0, 1024);
+    TEST_Write(80000000, 100000, FLASH_PAGE_SIZE + 4);
+    TEST_Vectors();
+    TEST_Wait();
+
+    CHECK(protocolErrors == 0);
+    CHECK(hostCritical == 0 && hostBasepri == 0);
+    return HOST_Result("test_flash");
+}
@@ -0,0 +1,244 @@
+// Профилировщик кучи (app/src/heap.c, HEAP_PROFILE) поверх malloc хоста. Задачи - теги
+// без планировщика: выделения идут на тег "текущей" задачи. Проверяется, что синтетическая
+// утечка одной подсистемы видна в HEAP_ProfileLeaks только по ее тегу, пока остальные
+// выделяют и освобождают столько же; таблица со сдвигом при удалении сходится со
+// справочной моделью на случайной нагрузке; переполнение таблицы - счетчик untracked
+#include "host.h"
+
+#include <malloc.h>
+
+// CMSIS
+static uint32_t __get_IPSR(void) { return 0; }
+static inline uint32_t __CLZ(uint32_t value) { return value != 0 ? (uint32_t)__builtin_clz(value) : 32; }
+
+// FreeRTOS
+#define HEAP_PROFILE 1
+#define HEAP_PROFILE_SLOTS 64
+#define configUSE_MALLOC_FAILED_HOOK 0
+#define traceMALLOC(block, size) ((void)(block), (void)(size))
+#define traceFREE(block, size)   ((void)(block), (void)(size))
+#define taskSCHEDULER_SUSPENDED   ((BaseType_t)0)
+#define taskSCHEDULER_NOT_STARTED ((BaseType_t)1)
+#define taskSCHEDULER_RUNNING     ((BaseType_t)2)
+typedef void (*TaskHookFunction_t)(void *);
+
+static struct
+{
+    uintptr_t tags[4];   // тег приложения задачи
+    uint32_t current;    // выполняющаяся задача
+    BaseType_t state;
+    TickType_t ticks;
+    int suspended;
+} rtos = {.state = taskSCHEDULER_NOT_STARTED};
+
+static BaseType_t xTaskGetSchedulerState(void) { return rtos.state; }
+static TickType_t xTaskGetTickCount(void) { return rtos.ticks; }
+static void vTaskSuspendAll(void) { rtos.suspended++; }
+static BaseType_t xTaskResumeAll(void)
+{
+    CHECK(rtos.suspended > 0);
+    rtos.suspended--;
+    return pdFALSE;
+}
+static TaskHookFunction_t xTaskGetApplicationTaskTag(TaskHandle_t task)
+{
+    CHECK(task == NULL && rtos.suspended > 0);
+    return (TaskHookFunction_t)rtos.tags[rtos.current];
+}
+static void vTaskSetApplicationTaskTag(TaskHandle_t task, TaskHookFunction_t tag)
+{
+    uint32_t index = task == NULL ? rtos.current : (uint32_t)((uintptr_t *)task - rtos.tags);
+
+    rtos.tags[index] = (uintptr_t)tag;
+}
+
+// log.h: отчет - в stdout теста
+#define LOG(...) (printf(__VA_ARGS__), (void)putchar('\n'))
+
+#include "heap.h"
+
+// mallinfo в glibc помечена устаревшей, в newlib - основная
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+#include "../app/src/heap.c"
+
+uint8_t _sheap; // границы кучи прошивки: на хосте _sbrk не вызывается
+uint8_t _eheap;
+
+enum
+{
+    TAG_WORKER = 1, // выделяет и освобождает поровну
+    TAG_LEAKY = 2,  // теряет каждое десятое сообщение
+};
+
+static void TEST_Reset(void)
+{
+    memset(slots, 0, sizeof(slots));
+    memset(tags, 0, sizeof(tags));
+    memset(sizeHist, 0, sizeof(sizeHist));
+    memset(lifeHist, 0, sizeof(lifeHist));
+    untracked = 0;
+    memset(&rtos, 0, sizeof(rtos));
+    rtos.state = taskSCHEDULER_NOT_STARTED;
+}
+
+static void TEST_Buckets(void)
+{
+    CHECK(HEAP_Bucket(0) == 0 && HEAP_Bucket(1) == 0);
+    CHECK(HEAP_Bucket(2) == 1);
+    CHECK(HEAP_Bucket(3) == 2 && HEAP_Bucket(4) == 2);
+    CHECK(HEAP_Bucket(5) == 3 && HEAP_Bucket(1024) == 10);
+    CHECK(HEAP_Bucket(0xFFFFFFFF) == HEAP_HIST_BUCKETS - 1);
+}
+
+// Две задачи гоняют сообщения через очередь из 8; TAG_LEAKY не освобождает каждое десятое
+static void TEST_Leak(void)
+{
+    void *boot[3];
+    void *queue[2][8] = {{NULL}};
+    uint32_t leaked = 0;
+    void *lost[40];
+
+    TEST_Reset();
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        boot[i] = pvPortMalloc(100);
+    }
+    CHECK(HEAP_GetTagStats(HEAP_TAG_BOOT)->live == 300);
+
+    HEAP_SetTaskTag(&rtos.tags[1], TAG_WORKER);
+    HEAP_SetTaskTag(&rtos.tags[2], TAG_LEAKY);
+    rtos.state = taskSCHEDULER_RUNNING;
+
+    for (uint32_t round = 0; round < 400; round++)
+    {
+        rtos.ticks++;
+        if (round == 100)
+        {
+            HEAP_ProfileCheckpoint();
+            CHECK(HEAP_ProfileLeaks() == 0);
+        }
+        for (uint32_t task = 1; task <= 2; task++)
+        {
+            void **slot = &queue[task - 1][round & 7];
+
+            rtos.current = task;
+            if (*slot != NULL)
+            {
+                if (task == 2 && round % 10 == 0 && leaked < 40)
+                {
+                    lost[leaked++] = *slot; // синтетическая утечка
+                }
+                else
+                {
+                    vPortFree(*slot);
+                }
+            }
+            *slot = pvPortMalloc(16 + (round * 7) % 48);
+        }
+    }
+
+    CHECK(HEAP_ProfileLeaks() == (1UL << TAG_LEAKY));
+    CHECK(HEAP_GetTagStats(TAG_LEAKY)->blocks == 8 + leaked);
+    CHECK(HEAP_GetTagStats(TAG_WORKER)->blocks == 8);
+    CHECK(HEAP_GetTagStats(TAG_LEAKY)->live > HEAP_GetTagStats(TAG_LEAKY)->mark);
+    CHECK(HEAP_GetTagStats(HEAP_TAG_BOOT)->live == 300 && HEAP_GetTagStats(HEAP_TAG_BOOT)->allocs == 3);
+    CHECK(HEAP_GetTagStats(TAG_WORKER)->allocs == 400 && HEAP_GetTagStats(TAG_LEAKY)->allocs == 400);
+    CHECK(HEAP_GetUntracked() == 0);
+    CHECK(rtos.suspended == 0);
+    HEAP_ProfileReport();
+
+    // Вернуть потерянное - утечки нет
+    rtos.current = 2;
+    for (uint32_t i = 0; i < leaked; i++)
+    {
+        vPortFree(lost[i]);
+    }
+    CHECK(HEAP_ProfileLeaks() == 0);
+
+    for (uint32_t task = 0; task < 2; task++)
+    {
+        for (uint32_t i = 0; i < 8; i++)
+        {
+            vPortFree(queue[task][i]);
+        }
+    }
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        vPortFree(boot[i]);
+    }
+    for (uint32_t tag = 0; tag < HEAP_TAGS; tag++)
+    {
+        CHECK(HEAP_GetTagStats(tag)->live == 0 && HEAP_GetTagStats(tag)->blocks == 0);
+    }
+}
+
+// Случайные выделения и освобождения с переполнением таблицы против списка живых блоков.
+// Блок учтен, если при выделении в таблице было место; размер 0 - мимо таблицы
+static void TEST_Table(unsigned seed)
+{
+    void *live[HEAP_PROFILE_SLOTS + 16];
+    uint32_t sizes[HEAP_PROFILE_SLOTS + 16];
+    uint32_t count = 0, tracked = 0, expectedLive = 0, expectedUntracked = 0;
+
+    TEST_Reset();
+    srand(seed);
+    for (uint32_t op = 0; op < 20000; op++)
+    {
+        if (count < HEAP_PROFILE_SLOTS + 16 && (count == 0 || rand() % 100 < 52))
+        {
+            uint32_t size = 1 + rand() % 200;
+
+            live[count] = pvPortMalloc(size);
+            if (tracked < HEAP_PROFILE_SLOTS)
+            {
+                sizes[count] = size;
+                expectedLive += size;
+                tracked++;
+            }
+            else
+            {
+                sizes[count] = 0;
+                expectedUntracked++;
+            }
+            count++;
+        }
+        else
+        {
+            uint32_t i = rand() % count;
+
+            vPortFree(live[i]);
+            if (sizes[i] != 0)
+            {
+                expectedLive -= sizes[i];
+                tracked--;
+            }
+            count--;
+            live[i] = live[count];
+            sizes[i] = sizes[count];
+        }
+        CHECK(HEAP_GetTagStats(HEAP_TAG_BOOT)->live == expectedLive);
+        CHECK(HEAP_GetTagStats(HEAP_TAG_BOOT)->blocks == tracked);
+        if (hostFailures != 0)
+        {
+            printf("seed %u, operation %u\n", seed, (unsigned)op);
+            return;
+        }
+    }
+    CHECK(HEAP_GetUntracked() == expectedUntracked && expectedUntracked != 0);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        vPortFree(live[i]);
+    }
+    CHECK(HEAP_GetTagStats(HEAP_TAG_BOOT)->live == 0 && HEAP_GetTagStats(HEAP_TAG_BOOT)->blocks == 0);
+}
+
+int main(void)
+{
+    TEST_Buckets();
+    TEST_Leak();
+    for (unsigned seed = 1; seed <= 8; seed++)
+    {
+        TEST_Table(seed);
+    }
+    return HOST_Result("test_heap");
+}
@@ -0,0 +1,637 @@
+// Таймеры высокого разрешения (app/src/hrt.c) на модели TIMER2 и прерывания по тактам HCLK.
+// Таймер считает как на кристалле: PSG, ARR, флаг CNT_ZERO на CNT = 0, флаги CCR_REF на
+// CNT = CCRn (REF Format1), запись 0 в бит STATUS снимает его. Прерывание - уровень
+// STATUS & IE или NVIC_SetPendingIRQ, маскируется BASEPRI не выше HRT_IRQ_PRIORITY.
+// Каждое обращение к регистру таймера - MODEL_ACCESS_CYCLES тактов, в которые может войти
+// прерывание. Проверяется: HRT_GetTime не идет назад и совпадает со счетом модели через
+// переполнения; случайные однократные и периодические таймеры, перевзвод и снятие из задачи
+// и из обработчиков, сроки дальше круга CNT и уже прошедшие - каждый срабатывает не раньше
+// срока и один раз; удержание DFS, пока взведен хоть один; PSG при смене частоты, в том
+// числе не кратной 1 МГц. test_hrt --table - гистограммы опоздания и цена HRT_Arm.
+// Такты - оценки MODEL_*_CYCLES (TRM Cortex-M3 и число инструкций), не замер на кристалле
+#include "host.h"
+
+#include <math.h>
+
+// CMSIS
+typedef int IRQn_Type;
+#define Timer2_IRQn ((IRQn_Type)15)
+static void NVIC_SetPendingIRQ(IRQn_Type irq);
+static void NVIC_ClearPendingIRQ(IRQn_Type irq);
+static void NVIC_SetPriority(IRQn_Type irq, uint32_t priority);
+static void NVIC_EnableIRQ(IRQn_Type irq) { (void)irq; }
+
+typedef struct
+{
+    uint32_t CTRL, CYCCNT;
+} DWT_Type;
+typedef struct
+{
+    uint32_t DEMCR;
+} CoreDebug_Type;
+static DWT_Type *MODEL_Dwt(void);
+static CoreDebug_Type coreDebug;
+#define DWT       (MODEL_Dwt())
+#define CoreDebug (&coreDebug)
+#define CoreDebug_DEMCR_TRCENA_Msk (1UL << 24)
+#define DWT_CTRL_CYCCNTENA_Msk     (1UL << 0)
+
+// SPL
+typedef struct
+{
+    uint32_t CNT, PSG, ARR, CNTRL, CCR1, CCR2, CCR3, CCR4;
+    uint32_t CH1_CNTRL, CH2_CNTRL, CH3_CNTRL, CH4_CNTRL;
+    uint32_t CH1_CNTRL1, CH2_CNTRL1, CH3_CNTRL1, CH4_CNTRL1;
+    uint32_t CH1_DTG, CH2_DTG, CH3_DTG, CH4_DTG;
+    uint32_t BRKETR_CNTRL, STATUS, IE, DMA_RE;
+    uint32_t CH1_CNTRL2, CH2_CNTRL2, CH3_CNTRL2, CH4_CNTRL2;
+} MDR_TIMER_TypeDef;
+static MDR_TIMER_TypeDef *MODEL_Timer(void);
+#define MDR_TIMER2 (MODEL_Timer())
+
+typedef struct
+{
+    uint32_t PER_CLOCK, TIM_CLOCK;
+} MDR_RST_CLK_TypeDef;
+static MDR_RST_CLK_TypeDef rstClk;
+#define MDR_RST_CLK (&rstClk)
+
+#define RST_CLK_PER_CLOCK_PCLK_EN_TIMER2 ((uint32_t)0x00008000)
+#define RST_CLK_TIM_CLOCK_TIM2_BRG_Msk   ((uint32_t)0x0000FF00)
+#define RST_CLK_TIM_CLOCK_TIM2_CLK_EN    ((uint32_t)0x02000000)
+
+#define TIMER_CNTRL_CNT_EN             ((uint32_t)0x00000001)
+#define TIMER_STATUS_CNT_ZERO_EVENT    ((uint32_t)0x00000001)
+#define TIMER_STATUS_CCR_REF_EVENT_Msk ((uint32_t)0x00001E00)
+#define TIMER_IE_CNT_ZERO_EVENT_IE     ((uint32_t)0x00000001)
+#define TIMER_IE_CCR_REF_EVENT_IE_Pos  9
+
+// FreeRTOS
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES 7
+static UBaseType_t MODEL_Raise(void);
+#define taskENTER_CRITICAL_FROM_ISR()    MODEL_Raise()
+#define taskEXIT_CRITICAL_FROM_ISR(mask) __set_BASEPRI(mask)
+#define portYIELD_FROM_ISR(woken)        ((void)(woken))
+
+static int self;
+static TaskHandle_t xTaskGetCurrentTaskHandle(void) { return &self; }
+static void vTaskNotifyGiveIndexedFromISR(TaskHandle_t task, UBaseType_t index, BaseType_t *woken);
+static uint32_t ulTaskNotifyTakeIndexed(UBaseType_t index, BaseType_t clear, TickType_t ticks);
+
+// clk.h
+#define CLK_TIMER1_HZ 0
+#define CLK_TIMER2_HZ 0
+#define CLK_TIMER3_HZ 0
+typedef enum
+{
+    CLK_PRE_CHANGE,
+    CLK_SWITCH,
+    CLK_POST_CHANGE,
+} CLK_Event_t;
+typedef void (*CLK_Notifier_t)(CLK_Event_t event, uint32_t hz);
+static CLK_Notifier_t notifier;
+static void CLK_AddNotifier(CLK_Notifier_t value) { notifier = value; }
+
+// dfs.h: удержание сразу поднимает частоту до уровня, как губернатор старше задачи
+static const uint32_t dfsLevels[] = { 8000000, 16000000, 40000000, 80000000 };
+static struct
+{
+    uint32_t count; // взятых и не снятых удержаний
+    int ignore;     // частоту не поднимать: опоздания на 8 МГц
+} dfs;
+
+static void DFS_Hold(uint32_t hz)
+{
+    uint32_t i = 0;
+
+    CHECK(hostBasepri != 0); // HRT_Armed - под маской списков
+    dfs.count++;
+    while (i < 3 && dfsLevels[i] < hz)
+    {
+        i++;
+    }
+    if (!dfs.ignore && SystemCoreClock < dfsLevels[i])
+    {
+        SystemCoreClock = dfsLevels[i];
+        notifier(CLK_SWITCH, SystemCoreClock);
+    }
+}
+
+static void DFS_Release(uint32_t hz)
+{
+    (void)hz;
+    CHECK(dfs.count != 0);
+    dfs.count--;
+}
+
+#define HRT_BENCHMARK 1
+#include "../app/src/hrt.c"
+
+// Модель. Такты обращения к регистру таймера на APB с окружающими инструкциями, входа и
+// выхода из прерывания, обработчика HRT на одно срабатывание без обращений к таймеру
+// (снятие из списка, перевзвод, BASEPRI), вызова функции таймера, переключения на
+// разбуженную задачу; HRT_Arm без обращений к таймеру и на узел списка в HRT_Insert
+#define MODEL_ACCESS_CYCLES    2
+#define MODEL_IRQ_ENTRY_CYCLES 12
+#define MODEL_IRQ_EXIT_CYCLES  10
+#define MODEL_FIRE_CYCLES      40
+#define MODEL_CALLBACK_CYCLES  20
+#define MODEL_SWITCH_CYCLES    150
+#define MODEL_ARM_CYCLES       50
+#define MODEL_NODE_CYCLES      6
+
+static MDR_TIMER_TypeDef regs; // отражение для процессора
+
+static struct
+{
+    uint64_t cycles;
+    double ns;          // реальное время по частоте ядра
+    uint32_t ticks;     // счет CNT с запуска таймера - мкс модели
+    uint32_t prescaler;
+    uint32_t cnt, status; // истинные CNT и STATUS
+    uint32_t shownCnt, shownStatus;
+    int pending;        // NVIC
+    int inIsr;
+    uint32_t priority;
+    uint64_t isrCycles;
+    uint32_t isrCount;
+} model;
+
+static DWT_Type dwt;
+static DWT_Type *MODEL_Dwt(void)
+{
+    dwt.CYCCNT = (uint32_t)model.cycles;
+    return &dwt;
+}
+
+static void NVIC_SetPendingIRQ(IRQn_Type irq)
+{
+    CHECK(irq == Timer2_IRQn);
+    model.pending = 1;
+}
+
+static void NVIC_ClearPendingIRQ(IRQn_Type irq)
+{
+    CHECK(irq == Timer2_IRQn);
+    model.pending = 0;
+}
+
+static void NVIC_SetPriority(IRQn_Type irq, uint32_t priority)
+{
+    CHECK(irq == Timer2_IRQn);
+    model.priority = priority;
+}
+
+static UBaseType_t MODEL_Raise(void)
+{
+    UBaseType_t mask = hostBasepri;
+
+    hostBasepri = configMAX_SYSCALL_INTERRUPT_PRIORITY;
+    return mask;
+}
+
+// Процессор записал CNT или STATUS - отражение разошлось с отданным
+static void MODEL_Commit(void)
+{
+    if (regs.CNT != model.shownCnt)
+    {
+        model.cnt = regs.CNT;
+    }
+    if (regs.STATUS != model.shownStatus)
+    {
+        model.status &= regs.STATUS;
+    }
+}
+
+static void MODEL_Refresh(void)
+{
+    regs.CNT = model.shownCnt = model.cnt;
+    regs.STATUS = model.shownStatus = model.status;
+}
+
+static void MODEL_Advance(uint32_t cycles);
+
+static void MODEL_Dispatch(void)
+{
+    uint64_t start;
+
+    if (model.inIsr || hostPrimask || hostCritical != 0 ||
+        (hostBasepri != 0 && hostBasepri <= (model.priority << (8 - configPRIO_BITS))))
+    {
+        return;
+    }
+    if (!(model.status & regs.IE) && !model.pending)
+    {
+        return;
+    }
+    model.inIsr = 1;
+    model.pending = 0;
+    start = model.cycles;
+    MODEL_Advance(MODEL_IRQ_ENTRY_CYCLES);
+    Timer2_IRQHandler();
+    MODEL_Advance(MODEL_IRQ_EXIT_CYCLES);
+    model.isrCycles += model.cycles - start;
+    model.isrCount++;
+    model.inIsr = 0;
+}
+
+static void MODEL_Cycle(void)
+{
+    MODEL_Commit();
+    model.cycles++;
+    model.ns += 1e9 / SystemCoreClock;
+    if ((regs.CNTRL & TIMER_CNTRL_CNT_EN) && ++model.prescaler > regs.PSG)
+    {
+        model.prescaler = 0;
+        model.ticks++;
+        model.cnt = model.cnt >= regs.ARR ? 0 : model.cnt + 1;
+        if (model.cnt == 0)
+        {
+            model.status |= TIMER_STATUS_CNT_ZERO_EVENT;
+        }
+        for (uint32_t ch = 0; ch < HRT_CHANNELS; ch++)
+        {
+            if ((&regs.CH1_CNTRL)[ch] == TIMER_CH_REF_Format1 && model.cnt == (&regs.CCR1)[ch])
+            {
+                model.status |= 1UL << (TIMER_IE_CCR_REF_EVENT_IE_Pos + ch);
+            }
+        }
+    }
+    MODEL_Refresh();
+    MODEL_Dispatch();
+}
+
+static void MODEL_Advance(uint32_t cycles)
+{
+    while (cycles-- != 0)
+    {
+        MODEL_Cycle();
+    }
+}
+
+static MDR_TIMER_TypeDef *MODEL_Timer(void)
+{
+    MODEL_Advance(MODEL_ACCESS_CYCLES);
+    return &regs;
+}
+
+static volatile int notified;
+
+static void vTaskNotifyGiveIndexedFromISR(TaskHandle_t task, UBaseType_t index, BaseType_t *woken)
+{
+    CHECK(task == &self && index == HRT_NOTIFY_INDEX && model.inIsr);
+    MODEL_Advance(MODEL_FIRE_CYCLES);
+    notified = 1;
+    *woken = pdTRUE;
+}
+
+// Задача - main: спит, пока идет модель, до уведомления
+static uint32_t ulTaskNotifyTakeIndexed(UBaseType_t index, BaseType_t clear, TickType_t ticks)
+{
+    CHECK(index == HRT_NOTIFY_INDEX && clear == pdTRUE && ticks == portMAX_DELAY);
+    while (!notified)
+    {
+        MODEL_Cycle();
+    }
+    notified = 0;
+    MODEL_Advance(MODEL_SWITCH_CYCLES);
+    return 1;
+}
+
+static void TEST_Start(uint32_t hz)
+{
+    memset(&model, 0, sizeof(model));
+    memset(&regs, 0, sizeof(regs));
+    memset(heads, 0, sizeof(heads));
+    memset(lengths, 0, sizeof(lengths));
+    armed = 0;
+    epoch = 0;
+    stats = (HRT_Stats_t){0};
+    dfs.count = 0;
+    dfs.ignore = 0;
+    hostBasepri = 0;
+    hostAsserts = 0;
+    notified = 0;
+    SystemCoreClock = hz;
+    hostUnmaskHook = MODEL_Dispatch;
+    HRT_Init();
+    CHECK(regs.PSG == hz / HRT_HZ - 1 && regs.ARR == 0xFFFF && (regs.CNTRL & TIMER_CNTRL_CNT_EN));
+    CHECK(notifier == HRT_Retune && model.priority == HRT_IRQ_PRIORITY);
+}
+
+// Время через четыре переполнения CNT, в том числе из прерывания, где флаг CNT_ZERO уже
+// стоит, а перенос в epoch еще не сделан
+static void TEST_Time(void)
+{
+    uint32_t last = 0;
+    uint32_t wrong = 0;
+
+    TEST_Start(8000000);
+    while (model.ticks < 4 * 0x10000 + 1000)
+    {
+        uint32_t before = model.ticks;
+        uint32_t now = HRT_GetTime();
+
+        if ((int32_t)(now - last) < 0 || now < before || now > model.ticks)
+        {
+            wrong++;
+        }
+        last = now;
+        MODEL_Advance(model.ticks % 7);
+    }
+    CHECK(wrong == 0);
+    CHECK(epoch == 4 * 0x10000 && model.isrCount == 4);
+}
+
+#define TEST_SLOTS 32
+#define TEST_BINS  16
+
+static struct
+{
+    HRT_Timer_t timer;
+    uint32_t due;       // ожидаемый срок: не раньше срока и не раньше взвода
+    uint32_t period;
+    int armed;
+    uint32_t fired;
+    uint32_t early;
+} slots[TEST_SLOTS];
+
+static struct
+{
+    uint32_t hist[TEST_BINS]; // опоздание вызова функции таймера от срока, мкс
+    uint32_t maxLate;
+    uint32_t fired;
+    uint32_t arms;
+    uint64_t armCycles;       // HRT_Arm: такты модели на обращения и MODEL_ARM_CYCLES, MODEL_NODE_CYCLES
+    uint32_t armMax;
+    uint32_t rng;
+} run;
+
+static uint32_t TEST_Random(uint32_t range)
+{
+    run.rng = run.rng * 1103515245u + 12345u;
+    return (run.rng >> 8) % range;
+}
+
+static uint32_t TEST_Position(HRT_Timer_t *t)
+{
+    uint32_t n = 0;
+
+    if (t->channel == HRT_IDLE)
+    {
+        return 0;
+    }
+    for (HRT_Timer_t *p = heads[t->channel]; p != t; p = p->next)
+    {
+        n++;
+    }
+    return n;
+}
+
+static void TEST_Arm(uint32_t i, uint32_t deadline, uint32_t period)
+{
+    uint32_t now = model.ticks;
+    uint32_t walked = TEST_Position(&slots[i].timer); // снятие
+    uint64_t before = stats.armCycles;
+    uint32_t cycles;
+
+    // Прошедший срок срабатывает на выходе из HRT_Arm - слот готов до вызова
+    slots[i].due = (int32_t)(deadline - now) > 0 ? deadline : now;
+    slots[i].period = period;
+    slots[i].armed = 1;
+    HRT_Arm(&slots[i].timer, deadline, period);
+    walked += TEST_Position(&slots[i].timer); // вставка
+    cycles = (uint32_t)(stats.armCycles - before) + MODEL_ARM_CYCLES + walked * MODEL_NODE_CYCLES;
+    run.arms++;
+    run.armCycles += cycles;
+    run.armMax = cycles > run.armMax ? cycles : run.armMax;
+}
+
+static void TEST_Cancel(uint32_t i)
+{
+    HRT_Cancel(&slots[i].timer);
+    slots[i].armed = 0;
+}
+
+static BaseType_t TEST_Fire(HRT_Timer_t *t, void *arg)
+{
+    uint32_t i = (uint32_t)(uintptr_t)arg;
+    uint32_t late;
+
+    MODEL_Advance(MODEL_FIRE_CYCLES);
+    late = model.ticks - slots[i].due;
+    CHECK(t == &slots[i].timer && slots[i].armed && model.inIsr);
+    if ((int32_t)late < 0)
+    {
+        slots[i].early++;
+        late = 0;
+    }
+    run.hist[late < TEST_BINS ? late : TEST_BINS - 1]++;
+    run.maxLate = late > run.maxLate ? late : run.maxLate;
+    run.fired++;
+    slots[i].fired++;
+    if (slots[i].period != 0)
+    {
+        CHECK(t->channel != HRT_IDLE);
+        slots[i].due = t->deadline;
+    }
+    else
+    {
+        CHECK(t->channel == HRT_IDLE);
+        slots[i].armed = 0;
+    }
+    // Из обработчика: иногда снять соседа или перевзвести себя
+    if (TEST_Random(16) == 0)
+    {
+        uint32_t j = TEST_Random(TEST_SLOTS);
+
+        if (j != i && slots[j].armed)
+        {
+            TEST_Cancel(j);
+        }
+    }
+    else if (slots[i].period == 0 && TEST_Random(4) == 0)
+    {
+        TEST_Arm(i, model.ticks + 1 + TEST_Random(3000), 0);
+    }
+    MODEL_Advance(MODEL_CALLBACK_CYCLES);
+    return pdFALSE;
+}
+
+// Срок: близкий (в пределах HRT_GUARD_US), прошедший, обычный, дальше круга CNT
+static uint32_t TEST_Deadline(void)
+{
+    uint32_t now = HRT_GetTime();
+
+    switch (TEST_Random(8))
+    {
+    case 0:
+        return now + TEST_Random(HRT_GUARD_US + 2);
+    case 1:
+        return now - TEST_Random(50);
+    case 2:
+        return now + 0x10000 + TEST_Random(100000);
+    default:
+        return now + TEST_Random(5000);
+    }
+}
+
+static void TEST_Timers(uint32_t hz, uint32_t count, uint32_t ms, int ignoreDfs, uint32_t seed, int print)
+{
+    uint32_t end;
+
+    TEST_Start(hz);
+    memset(&run, 0, sizeof(run));
+    memset(slots, 0, sizeof(slots));
+    run.rng = seed;
+    dfs.ignore = ignoreDfs;
+    for (uint32_t i = 0; i < TEST_SLOTS; i++)
+    {
+        HRT_TimerInit(&slots[i].timer, TEST_Fire, (void *)(uintptr_t)i);
+    }
+
+    end = HRT_GetTime() + ms * 1000;
+    while ((int32_t)(HRT_GetTime() - end) < 0)
+    {
+        uint32_t i = TEST_Random(count);
+        uint32_t action = TEST_Random(10);
+
+        if (action < 5 && !slots[i].armed)
+        {
+            TEST_Arm(i, TEST_Deadline(), TEST_Random(2) ? 50 + TEST_Random(2000) : 0);
+        }
+        else if (action == 5)
+        {
+            TEST_Arm(i, TEST_Deadline(), slots[i].armed ? slots[i].period : 0); // перевзвод
+        }
+        else if (action == 6 && slots[i].armed)
+        {
+            TEST_Cancel(i);
+        }
+        MODEL_Advance(TEST_Random(hz / 5000)); // до 200 мкс
+        CHECK(armed == (uint32_t)(lengths[0] + lengths[1] + lengths[2] + lengths[3]));
+        CHECK(dfs.count == (armed != 0));
+    }
+
+    // Новых нет: все однократные сработают, периодические идут без отставания
+    while (model.ticks - end < 0x10000 + 110000)
+    {
+        MODEL_Advance(hz / 1000);
+    }
+    for (uint32_t i = 0; i < count; i++)
+    {
+        CHECK(slots[i].early == 0);
+        CHECK(slots[i].armed == (slots[i].timer.channel != HRT_IDLE));
+        CHECK(!slots[i].armed || slots[i].period != 0);
+        CHECK(!slots[i].armed || (int32_t)(slots[i].due - model.ticks) > -(int32_t)run.maxLate - 1);
+        if (slots[i].armed)
+        {
+            TEST_Cancel(i);
+        }
+    }
+    CHECK(armed == 0 && dfs.count == 0);
+    CHECK((regs.IE & ~TIMER_IE_CNT_ZERO_EVENT_IE) == 0);
+    CHECK(hostAsserts == 0 && hostBasepri == 0);
+    // hrt.h: на HRT_DFS_HZ и выше опоздание до 10 мкс
+    CHECK(hz < HRT_DFS_HZ || run.maxLate <= 10);
+
+    if (print)
+    {
+        printf("  %2u МГц, %2u таймеров: %u срабатываний, опоздание до %u мкс:", SystemCoreClock / 1000000, count,
+               run.fired, run.maxLate);
+        for (uint32_t b = 0; b < TEST_BINS; b++)
+        {
+            printf(" %u", run.hist[b]);
+        }
+        printf("\n     HRT_Arm %u тактов в среднем, до %u; прерывание %u тактов на срабатывание\n",
+               (uint32_t)(run.armCycles / run.arms), run.armMax, (uint32_t)(model.isrCycles / run.fired));
+    }
+}
+
+// HRT_Benchmark прошивки: периодические таймеры и задача на HRT_SleepUntil
+static void TEST_Benchmark(uint32_t hz, uint32_t timers, int print)
+{
+    const HRT_Stats_t *s;
+    uint32_t late = 0;
+
+    TEST_Start(hz);
+    dfs.ignore = 1;
+    s = HRT_Benchmark(timers, 50);
+    CHECK(s->fired != 0 && armed == 0 && dfs.count == 0 && hostAsserts == 0);
+    for (uint32_t b = 0; b < HRT_HIST_BINS; b++)
+    {
+        late = s->taskLate[b] != 0 ? b : late;
+    }
+    // Задача просыпается через прерывание и переключение: на 80 МГц - в пределах 5 мкс
+    CHECK(hz < 80000000 || late <= 5);
+    if (print)
+    {
+        // armAvgCycles и fireAvgCycles модели - только обращения к таймеру, их не выводим
+        printf("  HRT_Benchmark(%u, 50), %u МГц: %u срабатываний, самый длинный список %u\n"
+               "     опоздание обработчика:", timers, hz / 1000000, s->fired, s->maxLength);
+        for (uint32_t b = 0; b < HRT_HIST_BINS; b++)
+        {
+            printf(" %u", s->isrLate[b]);
+        }
+        printf("\n     опоздание задачи:    ");
+        for (uint32_t b = 0; b < HRT_HIST_BINS; b++)
+        {
+            printf(" %u", s->taskLate[b]);
+        }
+        printf("\n");
+    }
+}
+
+// CLK_SWITCH: PSG под новую частоту, не кратная 1 МГц - ближайший делитель
+static void TEST_Retune(void)
+{
+    uint32_t start;
+    double ns;
+    double error;
+
+    TEST_Start(80000000);
+    dfs.ignore = 1;
+    notifier(CLK_PRE_CHANGE, 40000000);
+    CHECK(regs.PSG == 79);
+    notifier(CLK_SWITCH, 40000000);
+    CHECK(regs.PSG == 39);
+    notifier(CLK_SWITCH, 500000);
+    CHECK(regs.PSG == 0);
+    CHECK(HRT_Prescaler(14500000) == 14 && HRT_Prescaler(14499999) == 13);
+
+    // 14.7456 МГц (кварц UART): делитель 15, мкс счета на 1.7% длиннее
+    SystemCoreClock = 14745600;
+    notifier(CLK_SWITCH, SystemCoreClock);
+    CHECK(regs.PSG == 14 && hostAsserts == 0);
+    start = HRT_GetTime();
+    ns = model.ns;
+    HRT_SleepUntil(start + 100000);
+    error = (model.ns - ns) / 1000 / (HRT_GetTime() - start) - 1;
+    CHECK(fabs(error - (15.0 / 14.7456 - 1)) < 1e-3 && fabs(error) <= 0.5 / 15);
+    CHECK(armed == 0 && hostAsserts == 0);
+}
+
+int main(int argc, char **argv)
+{
+    int table = argc > 1 && strcmp(argv[1], "--table") == 0;
+
+    TEST_Time();
+    TEST_Retune();
+    for (uint32_t seed = 1; seed <= 4; seed++)
+    {
+        TEST_Timers(80000000, 1 + seed * 7, 300, 0, seed, 0);
+    }
+
+    if (table)
+    {
+        printf("модель, оценки MODEL_*_CYCLES, не замер; опоздание по 1 мкс, последний - 15 и больше:\n");
+    }
+    TEST_Timers(80000000, 1, 300, 0, 11, table);
+    TEST_Timers(80000000, 8, 300, 0, 12, table);
+    TEST_Timers(80000000, 32, 300, 0, 13, table);
+    TEST_Timers(40000000, 8, 300, 0, 14, table);
+    TEST_Timers(8000000, 8, 300, 1, 15, table);
+    TEST_Benchmark(80000000, 32, table);
+    TEST_Benchmark(8000000, 8, table);
+    return HOST_Result("test_hrt");
+}
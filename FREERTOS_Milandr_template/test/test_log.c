@@ -0,0 +1,371 @@
+// Журнал app/src/log.c: записи LOG в кольце, отправка каналом DMA (модель: цикл DMA отдает
+// в поток байты из кольца по его структуре) и разбор потока tools/log_decode.py.
+// Строки формата лежат, как в прошивке, в не загружаемой секции .log_fmt с адреса 0
+// (log_fmt.ld), ID записи - смещение в ней. Проверяется в C: кольцо не теряет и не портит
+// записей, полное - считает потерянные и пишет запись о потерях, когда для нее и следующей
+// есть место; .noinit после включения питания сбрасывается, после сброса - сохраняется.
+// С аргументом-каталогом тест пишет туда поток stream.bin и ожидаемые строки expected.txt,
+// test_log.py разбирает поток декодером по ELF теста и сверяет строки и метки времени:
+// разворот CYCCNT через 2^32, смена частоты, запись о потерях, пересинхронизация после
+// сброса посреди цикла DMA (недоотправленный кусок уходит повторно).
+// Печатаются байты в UART на запись против того же текста через printf
+#include "host.h"
+#include <stdarg.h>
+
+// CMSIS
+typedef struct
+{
+    uint32_t CTRL, CYCCNT;
+} DWT_Type;
+static DWT_Type dwt;
+#define DWT (&dwt)
+
+// SPL
+typedef struct
+{
+    uint32_t DR, FR, ICR, DMACR, IMSC, CR;
+} MDR_UART_TypeDef;
+static MDR_UART_TypeDef uarts[2];
+#define MDR_UART1 (&uarts[0])
+#define MDR_UART2 (&uarts[1])
+
+#define UART_CR_UARTEN ((uint32_t)0x00000001)
+#define UART_CR_TXE    ((uint32_t)0x00000100)
+#define UART_DMA_TXE   ((uint32_t)0x02)
+
+#include "MDR32FxQI_dma.h"
+
+// FreeRTOS
+#define taskENTER_CRITICAL_FROM_ISR() (hostCritical++, (UBaseType_t)0)
+#define taskEXIT_CRITICAL_FROM_ISR(mask) \
+    do                                   \
+    {                                    \
+        (void)(mask);                    \
+        taskEXIT_CRITICAL();             \
+    } while (0)
+
+// clk.h
+typedef enum
+{
+    CLK_PRE_CHANGE,
+    CLK_SWITCH,
+    CLK_POST_CHANGE,
+} CLK_Event_t;
+typedef void (*CLK_Notifier_t)(CLK_Event_t event, uint32_t hz);
+static CLK_Notifier_t notifier;
+static void CLK_AddNotifier(CLK_Notifier_t callback) { notifier = callback; }
+static void CLK_UARTRetune(MDR_UART_TypeDef *UARTx, CLK_Event_t event, uint32_t hz)
+{
+    (void)UARTx;
+    (void)event;
+    (void)hz;
+}
+
+// dma.h: канал один, цикл отдает байты по запросу теста
+typedef BaseType_t (*DMAM_Callback_t)(uint32_t channel, void *arg);
+static DMA_CtrlDataTypeDef control;
+static DMAM_Callback_t dmaDone;
+static int dmaRunning;
+static int32_t DMAM_Alloc(int32_t channel, DMAM_Callback_t callback, void *arg)
+{
+    CHECK(channel == DMA_Channel_UART1_TX && arg == NULL);
+    dmaDone = callback;
+    return channel;
+}
+static DMA_CtrlDataTypeDef *DMAM_Control(uint32_t channel, DMA_Data_Struct_Selection select)
+{
+    CHECK(channel == DMA_Channel_UART1_TX && select == DMA_CTRL_DATA_PRIMARY);
+    return &control;
+}
+static void DMAM_Start(uint32_t channel)
+{
+    CHECK(channel == DMA_Channel_UART1_TX && !dmaRunning);
+    dmaRunning = 1;
+}
+
+#include "log.h"
+#include "../app/src/log.c"
+
+// Поток в UART и ожидаемый разбор: "метка\tтекст", метка "*" - не сверять
+static uint8_t stream[256 * 1024];
+static uint32_t streamSize;
+static char expected[256 * 1024];
+static uint32_t expectedSize;
+
+// Время, как его считает декодер: такты развернутого CYCCNT по участкам частоты
+static uint64_t now;
+static uint32_t hz;             // 0 - до первой записи о частоте, метки в тактах
+static uint64_t since;
+static double seconds;
+static int afterReset;          // метки после сброса не сверяются
+
+// LOG против printf того же сообщения: байт в UART
+static uint32_t logBytes, printfBytes, records;
+
+static void TEST_Advance(uint64_t cycles)
+{
+    now += cycles;
+    dwt.CYCCNT = (uint32_t)now;
+}
+
+static void TEST_Line(const char *text)
+{
+    char stamp[32];
+
+    if (afterReset)
+    {
+        strcpy(stamp, "*");
+    }
+    else if (hz != 0)
+    {
+        snprintf(stamp, sizeof(stamp), "%.6f", seconds + (double)(now - since) / hz);
+    }
+    else
+    {
+        snprintf(stamp, sizeof(stamp), "%llu", (unsigned long long)now);
+    }
+    expectedSize += snprintf(expected + expectedSize, sizeof(expected) - expectedSize, "%s\t%s\n", stamp, text);
+}
+
+static void TEST_Clock(uint32_t value)
+{
+    char text[64];
+
+    snprintf(text, sizeof(text), "-- частота %u Гц", (unsigned)value);
+    TEST_Line(text);
+    if (hz != 0)
+    {
+        seconds += (double)(now - since) / hz;
+    }
+    since = now;
+    hz = value;
+}
+
+static __attribute__((format(printf, 3, 4))) void TEST_Expect(const char *where, uint32_t words, const char *fmt, ...)
+{
+    char text[256], line[320];
+    va_list args;
+
+    va_start(args, fmt);
+    vsnprintf(text, sizeof(text), fmt, args);
+    va_end(args);
+    snprintf(line, sizeof(line), "%s: %s", where, text);
+    TEST_Line(line);
+    logBytes += words * 4;
+    printfBytes += strlen(text) + 2; // "\r\n"
+    records++;
+}
+
+// Запись и ее ожидаемый разбор - в одной строке исходника, место совпадает
+#define TEST_HERE __FILE__ ":" LOG_STR(__LINE__)
+#define TEST_LOG(...)                                                    \
+    do                                                                   \
+    {                                                                    \
+        LOG(__VA_ARGS__);                                                \
+        TEST_Expect(TEST_HERE, LOG_NARGS(__VA_ARGS__) + 2, __VA_ARGS__); \
+    } while (0)
+
+// Цикл DMA целиком или первые limit байт (сброс посреди передачи)
+static void TEST_Drain(uint32_t limit)
+{
+    uint32_t bytes = ((control.DMA_Control >> 4) & 0x3FF) + 1;
+    const uint8_t *end = (const uint8_t *)(uintptr_t)control.DMA_SourceEndAddr;
+
+    CHECK(dmaRunning);
+    CHECK((control.DMA_Control & 7) == DMA_Mode_Basic && control.DMA_DestEndAddr == (uint32_t)(uintptr_t)&MDR_UART1->DR);
+    if (limit < bytes)
+    {
+        bytes = limit;
+    }
+    memcpy(stream + streamSize, end - (((control.DMA_Control >> 4) & 0x3FF)), bytes);
+    streamSize += bytes;
+    if (limit != UINT32_MAX)
+    {
+        return; // цикл не кончился
+    }
+    dmaRunning = 0;
+    (void)dmaDone(DMA_Channel_UART1_TX, NULL);
+}
+
+static void TEST_DrainAll(void)
+{
+    LOG_Kick();
+    while (dmaRunning)
+    {
+        TEST_Drain(UINT32_MAX);
+    }
+    CHECK(kept.head == kept.tail);
+}
+
+static uint32_t seed = 1;
+static uint32_t TEST_Random(void)
+{
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+static const char name[] = "motor"; // %s - только константы, декодер читает их из ELF
+
+// Записи с 0..8 аргументами всех видов, через случайные промежутки до 2^31 тактов
+static void TEST_Records(int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        uint32_t a = TEST_Random(), b = TEST_Random();
+
+        TEST_Advance(TEST_Random() % 4 == 0 ? (uint64_t)TEST_Random() << 8 : TEST_Random() % 5000);
+        switch (i % 10)
+        {
+        case 0: TEST_LOG("tick"); break;
+        case 1: TEST_LOG("a=%u", a); break;
+        case 2: TEST_LOG("%d %x", (int)a - (1 << 23), b); break;
+        case 3: TEST_LOG("%s: %c %08X", name, 'A' + (int)(a % 26), b); break;
+        case 4: TEST_LOG("%f %.2f", 1.5f, -0.25 * (int)(a % 8)); break;
+        case 5: TEST_LOG("%u %u %u %u", a, b, a ^ b, 4u); break;
+        case 6: TEST_LOG("%u %u %u %u %u", a, b, 3u, 4u, 5u); break;
+        case 7: TEST_LOG("%d %d %d %d %d %d", 1, -2, 3, -4, 5, -6); break;
+        case 8: TEST_LOG("%u %u %u %u %u %u %u", 1u, 2u, 3u, 4u, 5u, 6u, a); break;
+        default: TEST_LOG("%u%% %u %u %u %u %u %u %u", 1u, 2u, 3u, 4u, 5u, 6u, 7u, b); break;
+        }
+        if (TEST_Random() % 3 == 0)
+        {
+            LOG_Kick();
+        }
+        if (dmaRunning && TEST_Random() % 2 == 0)
+        {
+            TEST_Drain(UINT32_MAX);
+        }
+    }
+}
+
+// Полное кольцо: записи теряются, запись о потерях уходит перед первой, что поместилась
+static void TEST_Dropped(void)
+{
+    uint32_t accepted = 0, record = 4; // слов в записи с двумя аргументами
+
+    for (uint32_t i = 0; i < LOG_RING_WORDS / record + 72; i++)
+    {
+        uint32_t head = kept.head;
+        const char *where;
+
+        TEST_Advance(100);
+        LOG("lost %u %u", i, 0u); where = TEST_HERE; // одна строка: место записи
+        if (kept.head != head)
+        {
+            TEST_Expect(where, record, "lost %u %u", i, 0u);
+            accepted++;
+        }
+    }
+    CHECK(accepted == LOG_RING_WORDS / record && state.dropped == 72);
+
+    // Для записи о потерях и новой места нет - теряется и новая
+    kept.tail += record; // как будто ушла одна запись
+    TEST_Advance(100);
+    LOG("lost %u %u", 0u, 0u);
+    CHECK(state.dropped == 73);
+    kept.tail -= record;
+
+    TEST_DrainAll();
+    TEST_Advance(1000);
+    TEST_Line("-- потеряно записей: 73");
+    TEST_LOG("after %u", 73u);
+    CHECK(state.dropped == 0);
+    TEST_DrainAll();
+}
+
+// Сброс посреди цикла DMA: кольцо в .noinit, отправка начнется с той же записи.
+// Декодер выдаст три дошедшие до сброса записи, пропуск половины заголовка, все шесть
+// заново (их метки CYCCNT уже позади - время дальше не сверяется) и частоту из LOG_Init
+static void TEST_Reset(void)
+{
+    char lines[6][128], stamps[6][32];
+    uint32_t head, tail, bytes;
+    const char *where;
+
+    kept.head = kept.tail = 0; // кольцо пустое: с начала массива, чтобы цикл DMA был один
+    for (uint32_t i = 0; i < 6; i++)
+    {
+        TEST_Advance(500);
+        LOG("before reset %u %u", i, 7u); where = TEST_HERE;
+        snprintf(lines[i], sizeof(lines[i]), "%s: before reset %u %u", where, (unsigned)i, 7u);
+        snprintf(stamps[i], sizeof(stamps[i]), "%.6f", seconds + (double)(now - since) / hz);
+    }
+    LOG_Kick();
+    TEST_Drain(16 * 3 + 2); // три записи и половина заголовка четвертой
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        expectedSize += snprintf(expected + expectedSize, sizeof(expected) - expectedSize, "%s\t%s\n", stamps[i], lines[i]);
+    }
+    afterReset = 1;
+    TEST_Line("-- пропущено");
+    for (uint32_t i = 0; i < 6; i++)
+    {
+        TEST_Line(lines[i]);
+    }
+
+    // Перезапуск: state - обычная .bss, DMA стоит
+    head = kept.head;
+    tail = kept.tail;
+    memset(&state, 0, sizeof(state));
+    state.channel = -1;
+    dmaRunning = 0;
+    LOG_Restore();
+    CHECK(kept.magic == LOG_MAGIC && kept.head == head && kept.tail == tail);
+    LOG_Init(MDR_UART1);
+    TEST_Clock(SystemCoreClock);
+    bytes = streamSize;
+    TEST_DrainAll();
+    CHECK(streamSize - bytes == (head - tail + 3) * 4);
+}
+
+static int TEST_Write(const char *dir, const char *file, const void *data, uint32_t size)
+{
+    char path[512];
+    FILE *f;
+
+    snprintf(path, sizeof(path), "%s/%s", dir, file);
+    f = fopen(path, "wb");
+    if (f == NULL || fwrite(data, 1, size, f) != size)
+    {
+        printf("%s: не записать\n", path);
+        return 0;
+    }
+    fclose(f);
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    // Включение питания: в .noinit мусор
+    memset(&kept, 0x5A, sizeof(kept));
+    LOG_Restore();
+    CHECK(kept.magic == LOG_MAGIC && kept.head == 0 && kept.tail == 0);
+
+    TEST_Advance(0xFFFF0000u); // CYCCNT перевалит через 2^32 почти сразу
+    TEST_LOG("boot %u", 1u);   // до LOG_Init: копится в кольце, метка в тактах
+    LOG_Init(MDR_UART1);
+    TEST_Clock(SystemCoreClock);
+    TEST_Records(400);
+    TEST_Advance(20000);
+    notifier(CLK_SWITCH, 80000000);
+    TEST_Clock(80000000);
+    TEST_Records(400);
+    TEST_DrainAll();
+    CHECK(now > (5ull << 32)); // CYCCNT развернулся не раз
+
+    TEST_Dropped();
+    TEST_Reset();
+    CHECK(hostAsserts == 0 && hostCritical == 0 && hostPrimask == 0);
+
+    printf("LOG против printf того же сообщения, %u записей 0..8 аргументов:\n"
+           "  байт в UART: LOG %u (%.1f на запись), printf %u (%.1f, текст без места в исходнике)\n",
+           (unsigned)records, (unsigned)logBytes, (double)logBytes / records, (unsigned)printfBytes,
+           (double)printfBytes / records);
+
+    if (argc > 1 && !(TEST_Write(argv[1], "stream.bin", stream, streamSize) &&
+                      TEST_Write(argv[1], "expected.txt", expected, expectedSize)))
+    {
+        hostFailures++;
+    }
+    return HOST_Result("test_log");
+}
@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+"""
+Разбор потока test_log.c декодером tools/log_decode.py.
+
+test_log пишет в каталог поток из UART (stream.bin) и ожидаемые строки (expected.txt:
+"метка<TAB>текст", метка "*" не сверяется, текст "-- пропущено" - по началу строки).
+Декодер читает строки формата из ELF теста: он 64-битный, а декодеру нужен ELF32 -
+секции те же, objcopy -O elf32-i386. Поток подается кусками случайной длины, как из порта.
+"""
+
+import argparse
+import importlib.util
+import os
+import random
+import subprocess
+import sys
+import tempfile
+
+
+def load_decoder(path):
+    spec = importlib.util.spec_from_file_location("log_decode", path)
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    return module
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--test", required=True, help="исполняемый test_log")
+    ap.add_argument("--objcopy", default="objcopy")
+    ap.add_argument("--decoder", required=True, help="tools/log_decode.py")
+    args = ap.parse_args()
+
+    decoder = load_decoder(args.decoder)
+    with tempfile.TemporaryDirectory() as tmp:
+        run = subprocess.run([args.test, tmp], capture_output=True, text=True)
+        if run.returncode != 0:
+            print(run.stdout + run.stderr)
+            return 1
+        elf = os.path.join(tmp, "test_log.elf")
+        subprocess.run([args.objcopy, "-O", "elf32-i386", args.test, elf], check=True)
+        with open(os.path.join(tmp, "stream.bin"), "rb") as f:
+            stream = f.read()
+        with open(os.path.join(tmp, "expected.txt"), encoding="utf-8") as f:
+            expected = [line.split("\t", 1) for line in f.read().splitlines()]
+        d = decoder.Decoder(decoder.Elf(elf), 0)
+
+    rng = random.Random(1)
+    lines = []
+    pos = 0
+    while pos < len(stream):
+        size = rng.randint(1, 300)
+        lines += d.feed(stream[pos:pos + size])
+        pos += size
+
+    failures = 0
+    if len(lines) != len(expected):
+        print("строк %d, ожидалось %d" % (len(lines), len(expected)))
+        failures += 1
+    for i, (line, (stamp, text)) in enumerate(zip(lines, expected)):
+        if line[:12].isspace():
+            got_stamp, got_text = "", line.strip()  # пропуск байт - без метки
+        else:
+            got_stamp, _, got_text = line.lstrip().partition("  ")
+        if text == "-- пропущено":
+            ok = got_text.startswith(text)
+        else:
+            ok = got_text == text
+        if ok and stamp != "*":
+            ok = abs(float(got_stamp) - float(stamp)) <= 2e-6
+        if not ok:
+            print("строка %d: %r, ожидалось %s  %s" % (i + 1, line, stamp, text))
+            failures += 1
+            if failures > 10:
+                break
+
+    if failures:
+        print("test_log_decode: %d failed" % failures)
+        return 1
+    print("test_log_decode: ok, %d строк, %d байт" % (len(lines), len(stream)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,341 @@
+// Очередь MPSC (app/src/mpsc.c) на модели монитора исключительного доступа из cm3.h.
+// Писатели - задача и прерывание cm3.irq, которое приходит через 1..7 тактов ядра и потому
+// попадает между LDREX и STREX и задачи-писателя, и читателя (MPSC_Take). Прерывание
+// пробуждения (самое младшее) входит, как только задача снимает маску. Проверяется: ни один
+// узел не потерян и не получен дважды, порядок каждого писателя сохранен, читатель не
+// засыпает, когда в очереди есть узлы, а уведомления нет (потерянное пробуждение).
+// MPSC_Wait: пустые пробуждения не продлевают таймаут, узел посреди ожидания отдается.
+// Печатается задержка MPSC_Post задачи: распределение попыток STREX под нагрузкой и такты
+// по оценке MODEL_*_CYCLES (не замер на кристалле). Узлы по 32-битным адресам - тест без PIE
+#include "cm3.h"
+
+// CMSIS. SysTick в тесте не включается
+void SysTick_Handler(void) {}
+
+typedef int IRQn_Type;
+#define COMPARATOR_IRQn ((IRQn_Type)19)
+static int wakeEnabled, wakePending;
+static void NVIC_SetPriority(IRQn_Type irq, uint32_t priority) { (void)irq; (void)priority; }
+static void NVIC_EnableIRQ(IRQn_Type irq) { wakeEnabled += irq == COMPARATOR_IRQn; }
+static void NVIC_SetPendingIRQ(IRQn_Type irq)
+{
+    CHECK(irq == COMPARATOR_IRQn);
+    wakePending = 1;
+}
+
+// FreeRTOS
+#define configLIBRARY_LOWEST_INTERRUPT_PRIORITY 15
+#define portMEMORY_BARRIER() __asm volatile("" ::: "memory")
+#define portYIELD_FROM_ISR(woken) ((void)(woken))
+
+typedef struct
+{
+    TickType_t xTimeOnEntering;
+} TimeOut_t;
+
+static TickType_t ticksNow;
+static uint32_t notifyCount;
+static int consumer;
+static void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken)
+{
+    CHECK(task == &consumer);
+    notifyCount++;
+    *woken = pdTRUE;
+}
+static void vTaskSetTimeOutState(TimeOut_t *timeout) { timeout->xTimeOnEntering = ticksNow; }
+static BaseType_t xTaskCheckForTimeOut(TimeOut_t *timeout, TickType_t *ticks)
+{
+    TickType_t elapsed = ticksNow - timeout->xTimeOnEntering;
+
+    if (*ticks == portMAX_DELAY)
+    {
+        return pdFALSE;
+    }
+    if (elapsed < *ticks)
+    {
+        *ticks -= elapsed;
+        timeout->xTimeOnEntering = ticksNow;
+        return pdFALSE;
+    }
+    *ticks = 0;
+    return pdTRUE;
+}
+static uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks);
+
+#include "../app/src/mpsc.c"
+
+// Прерывание пробуждения младше всех: входит, когда задача без маски
+static void TEST_Task(void)
+{
+    if (wakePending && wakeEnabled && hostCritical == 0 && !cm3.inIrq)
+    {
+        wakePending = 0;
+        MPSC_WAKEUP_IRQHandler();
+    }
+}
+
+// Ожидание уведомления. Пока задача спит, каждые sleepEvery тиков приходит sleepEvent
+static MPSC_Queue_t *sleepQueue;
+static TickType_t sleepEvery;
+static void (*sleepEvent)(void);
+static int lostWakes;
+
+static uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks)
+{
+    uint32_t value;
+
+    TEST_Task();
+    if (notifyCount == 0 && sleepQueue != NULL && (sleepQueue->head != NULL || sleepQueue->pending != NULL))
+    {
+        lostWakes++; // в очереди узлы, а будить некому
+    }
+    while (notifyCount == 0 && ticks != 0)
+    {
+        CHECK(sleepEvent != NULL || ticks != portMAX_DELAY);
+        if (sleepEvent != NULL && sleepEvery <= ticks)
+        {
+            ticksNow += sleepEvery;
+            ticks -= sleepEvery;
+            sleepEvent();
+            TEST_Task();
+        }
+        else
+        {
+            ticksNow += ticks;
+            ticks = 0;
+        }
+    }
+    value = notifyCount;
+    notifyCount = clear ? 0 : (value != 0 ? value - 1 : 0);
+    return value;
+}
+
+static uint32_t seed = 1;
+static uint32_t TEST_Random(void)
+{
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+// Событие с узлом внутри. Узел свой у каждого писателя, снова уходит, когда читатель
+// его забрал
+#define POOL 32
+typedef struct
+{
+    MPSC_Node_t node;
+    uint32_t producer, seq;
+    int busy;
+} Event_t;
+
+enum
+{
+    PRODUCER_TASK,
+    PRODUCER_IRQ,
+    PRODUCERS
+};
+
+static MPSC_Queue_t queue;
+static Event_t pools[PRODUCERS][POOL];
+static uint32_t sent[PRODUCERS], received[PRODUCERS];
+
+static int TEST_Post(uint32_t producer)
+{
+    Event_t *e = &pools[producer][sent[producer] % POOL];
+
+    if (e->busy)
+    {
+        return 0;
+    }
+    e->busy = 1;
+    e->producer = producer;
+    e->seq = sent[producer]++;
+    MPSC_Post(&queue, &e->node);
+    return 1;
+}
+
+// Пока читатель спит, идут только такты ядра и прерывание-писатель
+static void TEST_Sleep(void)
+{
+    CM3_Run(4);
+}
+
+static void TEST_IrqProducer(void)
+{
+    for (uint32_t n = TEST_Random() % 3; n != 0; n--)
+    {
+        (void)TEST_Post(PRODUCER_IRQ);
+    }
+    cm3.irqPeriod = 1 + TEST_Random() % 7;
+}
+
+static void TEST_Consume(Event_t *e)
+{
+    CHECK(e->busy);
+    CHECK(e->seq == received[e->producer]); // порядок писателя, без потерь и повторов
+    received[e->producer] = e->seq + 1;
+    e->busy = 0;
+}
+
+// Попытки STREX одного MPSC_Post задачи
+#define ATTEMPTS 8
+static uint64_t attempts[ATTEMPTS];
+
+static void TEST_Stress(void)
+{
+    MPSC_Node_t *node;
+    uint32_t steps = 0;
+
+    MPSC_Init(&queue, &consumer);
+    CHECK(wakeEnabled == 1 && hostCritical == 0);
+    sleepQueue = &queue;
+    sleepEvent = TEST_Sleep;
+    sleepEvery = 1;
+    cm3.irq = TEST_IrqProducer;
+    cm3.irqPeriod = 3;
+    while (sent[PRODUCER_TASK] < 2000000)
+    {
+        // Задача-писатель выдает пачку, прерывание вмешивается где попало
+        for (uint32_t n = 1 + TEST_Random() % 12; n != 0; n--)
+        {
+            uint64_t failed = cm3.strexFailed;
+
+            if (TEST_Post(PRODUCER_TASK))
+            {
+                uint64_t retries = cm3.strexFailed - failed;
+                attempts[retries < ATTEMPTS - 1 ? retries : ATTEMPTS - 1]++;
+            }
+            TEST_Task();
+        }
+        // Читатель: иногда снимает часть, иногда все и засыпает до уведомления
+        if (TEST_Random() & 1)
+        {
+            for (uint32_t n = TEST_Random() % 8; n != 0 && (node = MPSC_Take(&queue)) != NULL; n--)
+            {
+                TEST_Consume((Event_t *)node);
+            }
+        }
+        else
+        {
+            // Как MPSC_Wait: пусто - к уведомлениям, есть уведомление - снова Take.
+            // Уведомлений нет - задача спит, пока прерывание пишет; проспать до таймаута с
+            // узлами в очереди - потерянное пробуждение
+            do
+            {
+                while ((node = MPSC_Take(&queue)) != NULL)
+                {
+                    TEST_Consume((Event_t *)node);
+                }
+            } while (ulTaskNotifyTake(pdTRUE, 0) != 0);
+            if (ulTaskNotifyTake(pdTRUE, 50) == 0)
+            {
+                lostWakes += queue.head != NULL;
+            }
+        }
+        steps++;
+    }
+    cm3.irqPeriod = 0;
+    while ((node = MPSC_Take(&queue)) != NULL)
+    {
+        TEST_Consume((Event_t *)node);
+    }
+    for (int p = 0; p < PRODUCERS; p++)
+    {
+        CHECK(received[p] == sent[p]);
+    }
+    CHECK(lostWakes == 0);
+    CHECK(sent[PRODUCER_IRQ] > 1000000);
+    CHECK(attempts[1] > 10000); // вытеснение между LDREX и STREX действительно было
+    CHECK(cm3.strexFailed > 100000);
+    CHECK(hostAsserts == 0);
+}
+
+// Такты MPSC_Post без вытеснения и цена повтора: LDREX, запись next, STREX, ветвление;
+// первый узел в пустую очередь добавляет запись signal и ISPR. Оценки, не замер
+#define MODEL_POST_CYCLES   12
+#define MODEL_RETRY_CYCLES  6
+#define MODEL_WAKE_CYCLES   5
+
+static void TEST_Latency(void)
+{
+    uint64_t posts = 0;
+    double mean = 0;
+    int worst = 0;
+
+    for (int i = 0; i < ATTEMPTS; i++)
+    {
+        posts += attempts[i];
+    }
+    printf("MPSC_Post задачи под прерыванием каждые 1..7 тактов, %llu вызовов\n"
+           "(такты - оценка MODEL_*_CYCLES, +%d на пробуждение из пустой очереди):\n"
+           "  попыток  доля       тактов\n",
+           (unsigned long long)posts, MODEL_WAKE_CYCLES);
+    for (int i = 0; i < ATTEMPTS; i++)
+    {
+        if (attempts[i] != 0)
+        {
+            int cycles = MODEL_POST_CYCLES + i * MODEL_RETRY_CYCLES;
+            printf("  %d%s      %8.5f%%  %d\n", i + 1, i == ATTEMPTS - 1 ? "+" : " ", 100.0 * attempts[i] / posts, cycles);
+            mean += (double)attempts[i] / posts * cycles;
+            worst = cycles;
+        }
+    }
+    printf("  среднее %.1f такта, худшее в прогоне %d; прерывания не маскируются\n", mean, worst);
+}
+
+// Пустые пробуждения: каждые 4 тика уведомление без узла. Таймаут 10 тиков должен
+// кончиться через 10 тиков, а не продлеваться на каждом пробуждении
+static void TEST_SpuriousWake(void)
+{
+    notifyCount++;
+}
+
+static Event_t lateEvent;
+static int lateCountdown;
+
+static void TEST_LateEvent(void)
+{
+    if (--lateCountdown == 0)
+    {
+        lateEvent.busy = 1;
+        MPSC_Post(&queue, &lateEvent.node);
+    }
+    else
+    {
+        notifyCount++;
+    }
+}
+
+static void TEST_Wait(void)
+{
+    TickType_t start = ticksNow;
+
+    cm3.irqPeriod = 0;
+    sleepEvent = TEST_SpuriousWake;
+    sleepEvery = 4;
+    CHECK(MPSC_Wait(&queue, 10) == NULL);
+    CHECK(ticksNow - start == 10);
+    start = ticksNow;
+    CHECK(MPSC_Wait(&queue, 0) == NULL); // без ожидания
+    CHECK(ticksNow == start);
+
+    // Два пустых пробуждения, потом узел: он отдается, время не вышло
+    sleepEvent = TEST_LateEvent;
+    sleepEvery = 3;
+    lateCountdown = 3;
+    CHECK(MPSC_Wait(&queue, 100) == &lateEvent.node);
+    CHECK(ticksNow - start == 9);
+    lateCountdown = 1;
+    start = ticksNow;
+    CHECK(MPSC_Wait(&queue, portMAX_DELAY) == &lateEvent.node);
+    CHECK(ticksNow - start == 3);
+    sleepEvent = NULL;
+    CHECK(hostAsserts == 0);
+}
+
+int main(void)
+{
+    TEST_Stress();
+    TEST_Latency();
+    TEST_Wait();
+    return HOST_Result("test_mpsc");
+}
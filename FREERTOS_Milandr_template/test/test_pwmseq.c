@@ -0,0 +1,891 @@
+// Секвенсор ШИМ (app/src/pwmseq.c) и менеджер DMA (app/src/dma.c) на модели TIMER1..3 и
+// контроллера PL230 по тактам HCLK. Запрос таймера - уровень: держится, пока в STATUS стоит
+// CNT_ZERO. Контроллер выполняет basic, ping-pong, peripheral scatter-gather и программные
+// запросы, на задачу цепочки и передачу тратит такты по оценке MODEL_*_CYCLES - это модель,
+// не замер на кристалле. Проверяется вывод по периодам бит в бит, конец потока, обрыв,
+// PWMSEQ_Stop, удержание DFS и что цепочка успевает за периодом. Адреса в структурах DMA -
+// 32 бита, поэтому тест собирается без PIE (CMakeLists.txt)
+#include "host.h"
+
+// CMSIS
+typedef int IRQn_Type;
+#define DMA_IRQn ((IRQn_Type)1)
+static void NVIC_ClearPendingIRQ(IRQn_Type irq) { (void)irq; }
+static void NVIC_SetPriority(IRQn_Type irq, uint32_t priority) { (void)irq; (void)priority; }
+static void NVIC_EnableIRQ(IRQn_Type irq) { (void)irq; }
+static inline uint32_t __CLZ(uint32_t value) { return value != 0 ? (uint32_t)__builtin_clz(value) : 32; }
+static inline uint32_t __RBIT(uint32_t value)
+{
+    uint32_t result = 0;
+
+    for (uint32_t i = 0; i < 32; i++)
+    {
+        result |= ((value >> i) & 1) << (31 - i);
+    }
+    return result;
+}
+
+typedef struct
+{
+    uint32_t CTRL, CYCCNT;
+} DWT_Type;
+typedef struct
+{
+    uint32_t DEMCR;
+} CoreDebug_Type;
+static DWT_Type *MODEL_Dwt(void);
+static CoreDebug_Type coreDebug;
+#define DWT       (MODEL_Dwt())
+#define CoreDebug (&coreDebug)
+#define CoreDebug_DEMCR_TRCENA_Msk (1UL << 24)
+#define DWT_CTRL_CYCCNTENA_Msk     (1UL << 0)
+
+// SPL
+typedef struct
+{
+    uint32_t CNT, PSG, ARR, CNTRL, CCR1, CCR2, CCR3, CCR4;
+    uint32_t CH1_CNTRL, CH2_CNTRL, CH3_CNTRL, CH4_CNTRL;
+    uint32_t CH1_CNTRL1, CH2_CNTRL1, CH3_CNTRL1, CH4_CNTRL1;
+    uint32_t CH1_DTG, CH2_DTG, CH3_DTG, CH4_DTG;
+    uint32_t BRKETR_CNTRL, STATUS, IE, DMA_RE;
+    uint32_t CH1_CNTRL2, CH2_CNTRL2, CH3_CNTRL2, CH4_CNTRL2;
+} MDR_TIMER_TypeDef;
+static MDR_TIMER_TypeDef timers[3];
+#define MDR_TIMER1 (&timers[0])
+#define MDR_TIMER2 (&timers[1])
+#define MDR_TIMER3 (&timers[2])
+
+typedef struct
+{
+    uint32_t STATUS, CFG, CTRL_BASE_PTR, ALT_CTRL_BASE_PTR, WAITONREQ_STATUS, CHNL_SW_REQUEST;
+    uint32_t CHNL_USEBURST_SET, CHNL_USEBURST_CLR, CHNL_REQ_MASK_SET, CHNL_REQ_MASK_CLR;
+    uint32_t CHNL_ENABLE_SET, CHNL_ENABLE_CLR, CHNL_PRI_ALT_SET, CHNL_PRI_ALT_CLR;
+    uint32_t CHNL_PRIORITY_SET, CHNL_PRIORITY_CLR, ERR_CLR;
+} MDR_DMA_TypeDef;
+static MDR_DMA_TypeDef *MODEL_Dma(void);
+#define MDR_DMA (MODEL_Dma())
+
+typedef struct
+{
+    uint32_t PER_CLOCK, TIM_CLOCK;
+} MDR_RST_CLK_TypeDef;
+static MDR_RST_CLK_TypeDef rstClk;
+#define MDR_RST_CLK (&rstClk)
+
+#define RST_CLK_PCLK_DMA 0
+static void RST_CLK_PCLKcmd(uint32_t pclk, FunctionalState state) { (void)pclk; (void)state; }
+
+#define RAM_AHB_BASE ((uint32_t)0x20000000)
+
+#define RST_CLK_PER_CLOCK_PCLK_EN_TIMER1 ((uint32_t)0x00004000)
+#define RST_CLK_PER_CLOCK_PCLK_EN_TIMER2 ((uint32_t)0x00008000)
+#define RST_CLK_PER_CLOCK_PCLK_EN_TIMER3 ((uint32_t)0x00010000)
+#define RST_CLK_TIM_CLOCK_TIM1_BRG_Msk   ((uint32_t)0x000000FF)
+#define RST_CLK_TIM_CLOCK_TIM2_BRG_Msk   ((uint32_t)0x0000FF00)
+#define RST_CLK_TIM_CLOCK_TIM3_BRG_Msk   ((uint32_t)0x00FF0000)
+#define RST_CLK_TIM_CLOCK_TIM1_CLK_EN    ((uint32_t)0x01000000)
+#define RST_CLK_TIM_CLOCK_TIM2_CLK_EN    ((uint32_t)0x02000000)
+#define RST_CLK_TIM_CLOCK_TIM3_CLK_EN    ((uint32_t)0x04000000)
+
+#define TIMER_CNTRL_CNT_EN             ((uint32_t)0x00000001)
+#define TIMER_STATUS_CNT_ZERO          ((uint32_t)0x00000001)
+#define TIMER_DMA_RE_CNT_ZERO_EVENT_RE ((uint32_t)0x00000001)
+#define TIMER_CH_CNTRL1_SELOE_Pos      0
+#define TIMER_CH_CNTRL1_SELO_Pos       2
+#define TIMER_CH_CNTRL2_CCRRLD         ((uint32_t)0x00000008)
+#define DMA_CFG_MASTER_ENABLE          ((uint32_t)0x00000001)
+
+// MDR32FxQI_config.h
+#define DMA_AlternateData   1
+#define DMA_Channels_Number 32
+
+// FreeRTOS
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES 7
+#define taskENTER_CRITICAL_FROM_ISR() (hostCritical++, (UBaseType_t)0)
+#define taskEXIT_CRITICAL_FROM_ISR(mask) \
+    do                                   \
+    {                                    \
+        (void)(mask);                    \
+        taskEXIT_CRITICAL();             \
+    } while (0)
+#define portYIELD_FROM_ISR(woken) ((void)(woken))
+
+static int self;
+static uint32_t notifications;
+static TaskHandle_t xTaskGetCurrentTaskHandle(void) { return &self; }
+static uint32_t ulTaskNotifyTakeIndexed(UBaseType_t index, BaseType_t clear, TickType_t ticks);
+
+#define PWMSEQ_BENCHMARK 1
+#include "dma.h"
+#include "pwmseq.h" // PWMSEQ_NOTIFY_INDEX для заглушки ниже
+
+static void vTaskNotifyGiveIndexedFromISR(TaskHandle_t task, UBaseType_t index, BaseType_t *woken)
+{
+    CHECK(task == &self && index == PWMSEQ_NOTIFY_INDEX);
+    notifications++;
+    *woken = pdTRUE;
+}
+
+// clk.h
+#define CLK_MAX_HZ    80000000
+#define CLK_TIMER1_HZ 0
+#define CLK_TIMER2_HZ 0
+#define CLK_TIMER3_HZ 0
+typedef enum
+{
+    CLK_PRE_CHANGE,
+    CLK_SWITCH,
+    CLK_POST_CHANGE,
+} CLK_Event_t;
+typedef void (*CLK_Notifier_t)(CLK_Event_t event, uint32_t hz);
+static CLK_Notifier_t notifier;
+static void CLK_AddNotifier(CLK_Notifier_t value) { notifier = value; }
+
+// dfs.h: удержание сразу поднимает частоту до уровня, как губернатор старше задачи
+static const uint32_t dfsLevels[] = { 8000000, 16000000, 40000000, 80000000 };
+static int hostIsr; // в DMA_IRQHandler
+static struct
+{
+    uint32_t count;             // взятых и не снятых удержаний
+    uint64_t hz;                // их сумма
+    uint32_t top;               // наибольшее удержание
+    int ignore;                 // частоту не поднимать: что будет без удержания
+} dfs;
+
+static void DFS_Hold(uint32_t hz)
+{
+    uint32_t i = 0;
+
+    CHECK(hostCritical != 0 || hostIsr); // Play - под секцией, Finish - под секцией или из DMA_IRQHandler
+    CHECK(hz <= CLK_MAX_HZ);
+    dfs.count++;
+    dfs.hz += hz;
+    if (hz > dfs.top)
+    {
+        dfs.top = hz;
+    }
+    while (i < 3 && dfsLevels[i] < hz)
+    {
+        i++;
+    }
+    if (!dfs.ignore && SystemCoreClock < dfsLevels[i])
+    {
+        SystemCoreClock = dfsLevels[i];
+        notifier(CLK_SWITCH, SystemCoreClock);
+    }
+}
+
+static void DFS_Release(uint32_t hz)
+{
+    CHECK(dfs.count != 0 && dfs.hz >= hz);
+    dfs.count--;
+    dfs.hz -= hz;
+}
+
+// uptime.h
+static uint64_t UPTIME_GetCycles(void);
+
+#include "../app/src/dma.c"
+#include "../app/src/pwmseq.c"
+
+// Модель. Такты контроллера DMA на задачу цепочки (копия 4 слов и одна передача с чтением
+// и записью структур) и на передачу basic/ping-pong, такты процессора на значение fill
+// и на вход в прерывание
+#define MODEL_TASK_CYCLES  22
+#define MODEL_FEED_CYCLES  10
+#define MODEL_FILL_CYCLES  8
+#define MODEL_ENTRY_CYCLES 200
+#define MODEL_IRQ_LATENCY  12
+#define MODEL_TRACE        (1 << 20)
+
+static MDR_DMA_TypeDef dmaRegs;
+
+static struct
+{
+    uint64_t cycles;
+    uint32_t prescaler[3];
+    uint32_t active[3][4];       // CCR, действующий в текущем периоде
+    uint16_t trace[3][MODEL_TRACE];
+    uint32_t traced[3];          // периодов записано: канал таймера - channel[ti]
+    uint32_t channel[3];
+    uint32_t overruns;           // CNT_ZERO не снят к следующему периоду: цепочка не успела
+    uint32_t lostKicks;          // программный запрос feed пришел раньше, чем ушел прошлый
+    uint32_t errors;             // структура, которую контроллер не выполнил бы
+    // PL230: истинные регистры, dmaRegs - их отражение для процессора
+    uint32_t enable, mask, alt, priority, sw;
+    uint64_t busyUntil, busyCycles;
+    int irq;
+    uint64_t irqAt;
+    uint32_t stall;              // такты следующего входа в DMA_IRQHandler ждут (прерывание старше)
+    uint32_t stallEvery, stallMax; // случайная задержка входа: раз в stallEvery, до stallMax
+    uint64_t isrCycles;
+} model;
+
+static DWT_Type dwt;
+static uint64_t UPTIME_GetCycles(void) { return model.cycles; }
+static DWT_Type *MODEL_Dwt(void)
+{
+    dwt.CYCCNT = (uint32_t)model.cycles;
+    return &dwt;
+}
+
+static void MODEL_Error(const char *what)
+{
+    if (model.errors++ < 10)
+    {
+        printf("dma model: %s\n", what);
+    }
+}
+
+static void MODEL_DmaRefresh(void);
+
+// Регистры SET/CLR: процессор записал - отражение разошлось с истинным значением
+static void MODEL_DmaCommit(void)
+{
+    MDR_DMA_TypeDef *r = &dmaRegs;
+
+    if (r->CHNL_ENABLE_SET != model.enable)
+    {
+        model.enable |= r->CHNL_ENABLE_SET;
+    }
+    if (r->CHNL_REQ_MASK_SET != model.mask)
+    {
+        model.mask |= r->CHNL_REQ_MASK_SET;
+    }
+    if (r->CHNL_PRI_ALT_SET != model.alt)
+    {
+        model.alt |= r->CHNL_PRI_ALT_SET;
+    }
+    if (r->CHNL_PRIORITY_SET != model.priority)
+    {
+        model.priority |= r->CHNL_PRIORITY_SET;
+    }
+    model.enable &= ~r->CHNL_ENABLE_CLR;
+    model.mask &= ~r->CHNL_REQ_MASK_CLR;
+    model.alt &= ~r->CHNL_PRI_ALT_CLR;
+    model.priority &= ~r->CHNL_PRIORITY_CLR;
+    if (model.sw & r->CHNL_SW_REQUEST)
+    {
+        model.lostKicks++;
+    }
+    model.sw |= r->CHNL_SW_REQUEST;
+    MODEL_DmaRefresh();
+}
+
+static void MODEL_DmaRefresh(void)
+{
+    MDR_DMA_TypeDef *r = &dmaRegs;
+
+    r->CHNL_ENABLE_SET = model.enable;
+    r->CHNL_REQ_MASK_SET = model.mask;
+    r->CHNL_PRI_ALT_SET = model.alt;
+    r->CHNL_PRIORITY_SET = model.priority;
+    r->CHNL_ENABLE_CLR = r->CHNL_REQ_MASK_CLR = r->CHNL_PRI_ALT_CLR = r->CHNL_PRIORITY_CLR = 0;
+    r->CHNL_SW_REQUEST = 0;
+}
+
+static void MODEL_DmaDone(void)
+{
+    if (!model.irq)
+    {
+        model.irq = 1;
+        model.irqAt = model.cycles + MODEL_IRQ_LATENCY + model.stall;
+        if (model.stallEvery != 0 && rand() % model.stallEvery == 0)
+        {
+            model.irqAt += (uint32_t)rand() % model.stallMax;
+        }
+        model.stall = 0;
+    }
+}
+
+// count передач по структуре s и запись структуры назад. 1 - цикл структуры закончен.
+// Основная структура scatter-gather каждую задачу пишет в те же 4 слова альтернативной
+static int MODEL_Transfers(DMA_CtrlDataTypeDef *s, uint32_t count)
+{
+    uint32_t gather = (s->DMA_Control & 7) == DMA_Mode_PerScatterPri ? 3 : 0x3FF;
+    uint32_t control = s->DMA_Control;
+    uint32_t left = ((control >> 4) & 0x3FF) + 1;
+    uint32_t dstInc = control >> 30, srcInc = (control >> 26) & 3, size = (control >> 24) & 3;
+
+    if (((control >> 28) & 3) != size || size == 3 || (dstInc != 3 && dstInc != size) || (srcInc != 3 && srcInc != size))
+    {
+        MODEL_Error("bad sizes");
+        return 1;
+    }
+    for (; count != 0 && left != 0; count--, left--)
+    {
+        uintptr_t src = s->DMA_SourceEndAddr - (srcInc == 3 ? 0 : (left - 1) << srcInc);
+        uintptr_t dst = s->DMA_DestEndAddr - (dstInc == 3 ? 0 : ((left - 1) & gather) << dstInc);
+
+        memcpy((void *)dst, (const void *)src, 1u << size);
+        MODEL_DmaCommit(); // запись в регистры контроллера
+    }
+    s->DMA_Control = left == 0 ? control & ~((0x3FFUL << 4) | 7) : (control & ~(0x3FFUL << 4)) | ((left - 1) << 4);
+    return left == 0;
+}
+
+static void MODEL_Service(uint32_t channel)
+{
+    uint32_t bit = 1UL << channel;
+    DMA_CtrlDataTypeDef *s = &DMA_ControlTable[channel + ((model.alt & bit) ? 32 : 0)];
+    uint32_t mode = s->DMA_Control & 7;
+    uint32_t burst = 1u << ((s->DMA_Control >> 14) & 0xF);
+
+    model.sw &= ~bit;
+    if (mode == DMA_Mode_Stop)
+    {
+        // Следующая структура не заряжена: канал выключается
+        model.enable &= ~bit;
+        MODEL_DmaDone();
+        return;
+    }
+    if (mode == DMA_Mode_PerScatterPri)
+    {
+        // Копия задачи в альтернативную структуру и сразу ее выполнение, без арбитража
+        if (model.alt & bit || burst != 4 || (s->DMA_Control & (3UL << 4)) != (3UL << 4))
+        {
+            MODEL_Error("bad scatter-gather primary");
+        }
+        MODEL_Transfers(s, 4);
+        s = &DMA_ControlTable[channel + 32];
+        mode = s->DMA_Control & 7;
+        burst = 1u << ((s->DMA_Control >> 14) & 0xF);
+        model.busyUntil += MODEL_TASK_CYCLES;
+        if (MODEL_Transfers(s, burst))
+        {
+            if (mode == DMA_Mode_PerScatterAlt)
+            {
+                model.alt &= ~bit;
+            }
+            else
+            {
+                model.enable &= ~bit;
+                MODEL_DmaDone();
+            }
+        }
+        else
+        {
+            model.alt |= bit;
+        }
+        return;
+    }
+    if (mode != DMA_Mode_Basic && mode != DMA_Mode_PingPong)
+    {
+        MODEL_Error("unexpected mode");
+        model.enable &= ~bit;
+        return;
+    }
+    model.busyUntil += MODEL_FEED_CYCLES * burst;
+    if (MODEL_Transfers(s, burst))
+    {
+        MODEL_DmaDone();
+        if (mode == DMA_Mode_PingPong)
+        {
+            model.alt ^= bit;
+        }
+        else
+        {
+            model.enable &= ~bit;
+        }
+    }
+}
+
+static void MODEL_Cycle(void)
+{
+    uint32_t requests = 0;
+
+    model.cycles++;
+    MODEL_DmaCommit();
+
+    for (uint32_t ti = 0; ti < 3; ti++)
+    {
+        MDR_TIMER_TypeDef *t = &timers[ti];
+
+        if (!(t->CNTRL & TIMER_CNTRL_CNT_EN) || ++model.prescaler[ti] <= t->PSG)
+        {
+            continue;
+        }
+        model.prescaler[ti] = 0;
+        t->CNT = t->CNT >= t->ARR ? 0 : t->CNT + 1;
+        if (t->CNT != 0)
+        {
+            continue;
+        }
+        for (uint32_t ch = 0; ch < 4; ch++)
+        {
+            if ((&t->CH1_CNTRL2)[ch] & TIMER_CH_CNTRL2_CCRRLD)
+            {
+                model.active[ti][ch] = (&t->CCR1)[ch];
+            }
+        }
+        if (model.traced[ti] < MODEL_TRACE)
+        {
+            model.trace[ti][model.traced[ti]++] = (uint16_t)model.active[ti][model.channel[ti]];
+        }
+        if ((t->STATUS & TIMER_STATUS_CNT_ZERO) && (model.enable & (1UL << (DMA_Channel_TIM1 + ti))))
+        {
+            model.overruns++;
+        }
+        t->STATUS |= TIMER_STATUS_CNT_ZERO;
+    }
+
+    // Запрос таймера - уровень, программный - один на цикл арбитража
+    for (uint32_t ti = 0; ti < 3; ti++)
+    {
+        if (timers[ti].STATUS & timers[ti].DMA_RE & TIMER_DMA_RE_CNT_ZERO_EVENT_RE)
+        {
+            requests |= 1UL << (DMA_Channel_TIM1 + ti);
+        }
+    }
+    model.sw &= model.enable;
+    requests = ((requests & ~model.mask) | model.sw) & model.enable;
+    if (model.cycles >= model.busyUntil && requests != 0)
+    {
+        uint32_t high = requests & model.priority;
+
+        model.busyUntil = model.cycles;
+        MODEL_Service(__CLZ(__RBIT(high != 0 ? high : requests)));
+        model.busyCycles += model.busyUntil - model.cycles;
+    }
+    MODEL_DmaRefresh();
+}
+
+static void MODEL_Advance(uint32_t cycles)
+{
+    while (cycles-- != 0)
+    {
+        MODEL_Cycle();
+    }
+}
+
+static void MODEL_Dispatch(void)
+{
+    uint64_t start = model.cycles;
+
+    if (!model.irq || hostIsr || hostCritical != 0 || model.cycles < model.irqAt)
+    {
+        return;
+    }
+    model.irq = 0;
+    hostIsr = 1;
+    MODEL_Advance(MODEL_ENTRY_CYCLES);
+    DMA_IRQHandler();
+    MODEL_Advance(MODEL_IRQ_LATENCY);
+    hostIsr = 0;
+    model.isrCycles += model.cycles - start;
+}
+
+static void MODEL_Run(uint64_t cycles)
+{
+    uint64_t end = model.cycles + cycles;
+
+    while (model.cycles < end)
+    {
+        MODEL_Cycle();
+        MODEL_Dispatch();
+    }
+}
+
+// Каждое обращение к контроллеру - такт, на нем может войти DMA_IRQHandler
+static MDR_DMA_TypeDef *MODEL_Dma(void)
+{
+    MODEL_Run(1);
+    return &dmaRegs;
+}
+
+static uint32_t ulTaskNotifyTakeIndexed(UBaseType_t index, BaseType_t clear, TickType_t ticks)
+{
+    uint64_t end = model.cycles + (uint64_t)ticks * SystemCoreClock / configTICK_RATE_HZ;
+    uint32_t value;
+
+    CHECK(index == PWMSEQ_NOTIFY_INDEX && clear == pdTRUE);
+    CHECK(hostCritical == 0);
+    while (notifications == 0 && model.cycles < end)
+    {
+        MODEL_Run(1);
+    }
+    value = notifications;
+    notifications = 0;
+    return value;
+}
+
+// Сценарии
+
+typedef struct
+{
+    uint32_t left, next, period;
+} TEST_Gen_t;
+
+static uint32_t TEST_GenFill(PWMSEQ_t *seq, uint16_t *values, uint32_t count)
+{
+    TEST_Gen_t *gen = seq->arg;
+    uint32_t n = 0;
+
+    while (n < count && gen->left != 0)
+    {
+        values[n++] = (uint16_t)(1 + gen->next++ % (gen->period - 1));
+        gen->left--;
+    }
+    MODEL_Advance(n * MODEL_FILL_CYCLES);
+    return n;
+}
+
+static uint16_t TEST_Expected(const TEST_Gen_t *gen, uint32_t k)
+{
+    return (uint16_t)(1 + (gen->next + k) % (gen->period - 1));
+}
+
+static __attribute__((aligned(4))) uint16_t buffers[3][2 * PWMSEQ_MAX_HALF];
+static PWMSEQ_t seqs[3];
+static TEST_Gen_t gens[3];
+static uint16_t expected[3][20000];
+
+static void TEST_Reset(uint32_t hz, uint32_t half, uint32_t period, PWMSEQ_Fill_t fill, void *const args[3])
+{
+    memset(timers, 0, sizeof(timers));
+    memset(&rstClk, 0, sizeof(rstClk));
+    memset(&dmaRegs, 0, sizeof(dmaRegs));
+    memset(&model, 0, sizeof(model));
+    memset(sequencers, 0, sizeof(sequencers));
+    memset(&dfs, 0, sizeof(dfs));
+    allocated = armed = pingPong = 0;
+    demand = 0;
+    notifications = 0;
+    SystemCoreClock = hz;
+
+    DMAM_Init();
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        model.channel[i] = i;
+        PWMSEQ_Init(&seqs[i], i + 1, i + 1, period, buffers[i], half, 0, fill, args[i]);
+    }
+    hostUnmaskHook = MODEL_Dispatch;
+}
+
+// Вывод таймера ti с периода from: idle не дольше 3 периодов, values[0..n), потом idle.
+// cut - поток оборван: после совпавшего начала последнее значение держится до обработчика.
+// Возвращает число периодов idle в начале
+static uint32_t TEST_Output(uint32_t ti, uint32_t from, const uint16_t *values, uint32_t n, int cut)
+{
+    const uint16_t *trace = model.trace[ti];
+    uint32_t to = model.traced[ti];
+    uint32_t i = from, lead, k = 0;
+
+    CHECK(to < MODEL_TRACE);
+    while (i < to && trace[i] == 0 && (i - from < 3 || n == 0))
+    {
+        i++;
+    }
+    lead = i - from;
+    while (k < n && i < to && trace[i] == values[k])
+    {
+        i++;
+        k++;
+    }
+    if (k < n && !cut)
+    {
+        printf("timer %u: period %u of %u is %u, expected %u\n", (unsigned)ti + 1, (unsigned)k, (unsigned)n,
+               i < to ? trace[i] : 0, values[k]);
+        hostFailures++;
+        return lead;
+    }
+    while (k < n && k > 0 && i < to && trace[i] == values[k - 1])
+    {
+        i++;
+    }
+    while (i < to && trace[i] == 0)
+    {
+        i++;
+    }
+    CHECK(i == to);
+    return lead;
+}
+
+// Поток закончен: каналы выключены, удержаний нет, модель довольна
+static void TEST_Idle(uint32_t ti)
+{
+    CHECK(!seqs[ti].busy);
+    CHECK(!(model.enable & ((1UL << seqs[ti].dma) | (1UL << seqs[ti].feed))));
+    CHECK(hostCritical == 0);
+}
+
+static void TEST_Clean(void)
+{
+    CHECK(dfs.count == 0 && dfs.hz == 0);
+    CHECK(model.errors == 0 && model.lostKicks == 0 && model.overruns == 0);
+}
+
+static uint32_t TEST_PeriodCycles(uint32_t period)
+{
+    return period * (SystemCoreClock / PWMSEQ_HZ);
+}
+
+// Длины вокруг половин и конца потока внутри структуры
+static void TEST_Edges(void)
+{
+    static const uint32_t lengths[] = { 0, 1, 2, 63, 64, 65, 127, 128, 129, 1000 };
+    void *const args[3] = { &gens[0], &gens[1], &gens[2] };
+    PWMSEQ_t *const group[1] = { &seqs[0] };
+
+    TEST_Reset(80000000, 64, 12, TEST_GenFill, args);
+    for (uint32_t j = 0; j < sizeof(lengths) / sizeof(lengths[0]); j++)
+    {
+        uint32_t from;
+
+        gens[0] = (TEST_Gen_t){ lengths[j], 5 * j, 12 };
+        for (uint32_t k = 0; k < lengths[j]; k++)
+        {
+            expected[0][k] = TEST_Expected(&gens[0], k);
+        }
+        PWMSEQ_Play(group, 1);
+        from = model.traced[0];
+        CHECK(dfs.count == 1 && dfs.hz == seqs[0].floor);
+        CHECK(PWMSEQ_Wait(&seqs[0], 100) == pdTRUE);
+        MODEL_Run(4 * TEST_PeriodCycles(12));
+        // Период до первого CNT = 0 и период после него, записи в trace - с CNT = 0
+        CHECK(TEST_Output(0, from, expected[0], lengths[j], 0) == (lengths[j] != 0 ? 1 : model.traced[0] - from));
+        TEST_Idle(0);
+    }
+    CHECK(seqs[0].underruns == 0);
+    TEST_Clean();
+}
+
+// Прерывание DMA опоздало больше чем на половину: поток обрывается, следующий идет
+static void TEST_Underrun(void)
+{
+    void *const args[3] = { &gens[0], &gens[1], &gens[2] };
+    PWMSEQ_t *const group[1] = { &seqs[0] };
+    uint32_t from;
+
+    TEST_Reset(80000000, 64, 10, TEST_GenFill, args);
+    gens[0] = (TEST_Gen_t){ 20000, 0, 10 };
+    for (uint32_t k = 0; k < 20000; k++)
+    {
+        expected[0][k] = TEST_Expected(&gens[0], k);
+    }
+    PWMSEQ_Play(group, 1);
+    from = model.traced[0];
+    MODEL_Run(100000);
+    model.stall = 64 * TEST_PeriodCycles(10) * 2;
+    CHECK(PWMSEQ_Wait(&seqs[0], 100) == pdTRUE);
+    MODEL_Run(4 * TEST_PeriodCycles(10));
+    TEST_Output(0, from, expected[0], 20000, 1);
+    CHECK(model.traced[0] < 20000);
+    CHECK(seqs[0].underruns == 1);
+    TEST_Idle(0);
+
+    gens[0] = (TEST_Gen_t){ 3000, 0, 10 };
+    PWMSEQ_Play(group, 1);
+    from = model.traced[0];
+    CHECK(PWMSEQ_Wait(&seqs[0], 100) == pdTRUE);
+    MODEL_Run(4 * TEST_PeriodCycles(10));
+    TEST_Output(0, from, expected[0], 3000, 0);
+    CHECK(seqs[0].underruns == 1);
+    TEST_Idle(0);
+    TEST_Clean();
+}
+
+// Бесконечный поток до PWMSEQ_Stop
+static void TEST_Stop(void)
+{
+    void *const args[3] = { &gens[0], &gens[1], &gens[2] };
+    PWMSEQ_t *const group[1] = { &seqs[0] };
+    uint32_t played;
+
+    TEST_Reset(40000000, 32, 16, TEST_GenFill, args);
+    model.stallEvery = 3;
+    model.stallMax = 800;
+    gens[0] = (TEST_Gen_t){ 0xFFFFFFFF, 0, 16 };
+    PWMSEQ_Play(group, 1);
+    CHECK(SystemCoreClock == 40000000); // floor 16 периода - ровно 40 МГц
+    MODEL_Run(1000000);
+    PWMSEQ_Stop(&seqs[0]);
+    CHECK(PWMSEQ_Wait(&seqs[0], 0) == pdTRUE);
+    MODEL_Run(4 * TEST_PeriodCycles(16));
+
+    played = gens[0].next;
+    CHECK(played > 10000 && played <= 20000);
+    gens[0].next = 0;
+    for (uint32_t k = 0; k < played; k++)
+    {
+        expected[0][k] = TEST_Expected(&gens[0], k);
+    }
+    TEST_Output(0, 0, expected[0], played, 1);
+    CHECK(seqs[0].underruns == 0);
+    TEST_Idle(0);
+    TEST_Clean();
+}
+
+// Три секвенсора с общей фазой, случайные частота, половины, период и длины
+static void TEST_Group(unsigned seed)
+{
+    static const uint32_t halves[] = { 16, 64, 192, 1024 };
+    void *const args[3] = { &gens[0], &gens[1], &gens[2] };
+    PWMSEQ_t *const group[3] = { &seqs[0], &seqs[1], &seqs[2] };
+    uint32_t hz, half, period, budget;
+
+    srand(seed);
+    hz = dfsLevels[1 + rand() % 3];
+    half = halves[rand() % 4];
+    period = 24 + rand() % 40; // сумма трех floor не выше 80 МГц
+    TEST_Reset(hz, half, period, TEST_GenFill, args);
+
+    for (uint32_t round = 0; round < 3; round++)
+    {
+        uint32_t from[3], length[3], lead[3];
+
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            length[i] = rand() % 5 == 0 ? rand() % 3 : rand() % 3000;
+            gens[i] = (TEST_Gen_t){ length[i], rand() % 1000, period };
+            for (uint32_t k = 0; k < length[i]; k++)
+            {
+                expected[i][k] = TEST_Expected(&gens[i], k);
+            }
+        }
+        // Таймер, до которого PWMSEQ_Play еще не дошел, выводит idle - считаем с запуска
+        PWMSEQ_Play(group, 3);
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            from[i] = model.traced[i];
+        }
+        CHECK(dfs.count == 1 && dfs.hz == seqs[0].floor * 3);
+        CHECK(SystemCoreClock >= dfs.hz);
+        // Прерывание опаздывает, но успевает заполнить половину
+        budget = half * TEST_PeriodCycles(period);
+        model.stallEvery = 4;
+        model.stallMax = budget > 3 * (MODEL_ENTRY_CYCLES + half * MODEL_FILL_CYCLES) ?
+                         (budget - 3 * (MODEL_ENTRY_CYCLES + half * MODEL_FILL_CYCLES)) / 3 : 1;
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            CHECK(PWMSEQ_Wait(&seqs[i], 100) == pdTRUE);
+        }
+        MODEL_Run(4 * TEST_PeriodCycles(period));
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            lead[i] = TEST_Output(i, from[i], expected[i], length[i], 0);
+            TEST_Idle(i);
+        }
+        if (length[0] != 0 && length[1] != 0 && length[2] != 0)
+        {
+            CHECK(lead[0] == 1 && lead[1] == 1 && lead[2] == 1); // общая фаза
+        }
+    }
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        CHECK(seqs[i].underruns == 0);
+    }
+    TEST_Clean();
+}
+
+// Лента WS2812 из 300 светодиодов, кадры подряд. Цифры нагрузки - по модели
+static PWMSEQ_Ws2812_t strips[3];
+static uint8_t grb[900];
+
+// PWMSEQ_Ws2812Fill с тактами процессора на значение: PWMSEQ_GetStats видит обработчик
+static uint32_t TEST_Ws2812Fill(PWMSEQ_t *seq, uint16_t *values, uint32_t count)
+{
+    uint32_t n = PWMSEQ_Ws2812Fill(seq, values, count);
+
+    MODEL_Advance(n * MODEL_FILL_CYCLES);
+    return n;
+}
+
+static void TEST_Ws2812(uint32_t hz, uint32_t frames, int hold)
+{
+    void *const args[3] = { &strips[0], &strips[1], &strips[2] };
+    PWMSEQ_t *const group[1] = { &seqs[0] };
+    PWMSEQ_Stats_t stats;
+    uint64_t start, busy0, isr0;
+
+    TEST_Reset(hz, 192, PWMSEQ_WS2812_PERIOD, TEST_Ws2812Fill, args);
+    dfs.ignore = !hold;
+    CHECK(seqs[0].floor == 64000000);
+    PWMSEQ_GetStats(&seqs[0], &stats);
+    start = model.cycles;
+    busy0 = model.busyCycles;
+    isr0 = model.isrCycles;
+    for (uint32_t f = 0; f < frames; f++)
+    {
+        uint32_t from;
+
+        for (uint32_t i = 0; i < 900; i++)
+        {
+            grb[i] = (uint8_t)rand();
+        }
+        for (uint32_t i = 0; i < 7200; i++)
+        {
+            expected[0][i] = (grb[i >> 3] & (0x80 >> (i & 7))) ? PWMSEQ_WS2812_T1H : PWMSEQ_WS2812_T0H;
+        }
+        // Как PWMSEQ_Ws2812, но со своим fill
+        strips[0] = (PWMSEQ_Ws2812_t){ grb, 900, 0, PWMSEQ_WS2812_RESET };
+        PWMSEQ_Play(group, 1);
+        from = model.traced[0];
+        CHECK(dfs.ignore || SystemCoreClock == 80000000);
+        CHECK(PWMSEQ_Wait(&seqs[0], 100) == pdTRUE);
+        MODEL_Run(4 * TEST_PeriodCycles(PWMSEQ_WS2812_PERIOD));
+        if (!dfs.ignore)
+        {
+            CHECK(model.traced[0] - from >= 7200 + PWMSEQ_WS2812_RESET);
+            TEST_Output(0, from, expected[0], 7200, 0);
+        }
+        TEST_Idle(0);
+    }
+    PWMSEQ_GetStats(&seqs[0], &stats);
+    printf("ws2812 from %u MHz%s: %u frames, overruns %u, underruns %u\n",
+           (unsigned)(hz / 1000000), dfs.ignore ? " without DFS hold" : "", (unsigned)frames,
+           (unsigned)model.overruns, (unsigned)seqs[0].underruns);
+    printf("  model at %u MHz: DMA controller busy %.1f%%, DMA IRQ %.2f%%; "
+           "stats: %u refills, %u cycles/refill, %u per 100 values, load %u permille\n",
+           (unsigned)(SystemCoreClock / 1000000), 100.0 * (model.busyCycles - busy0) / (model.cycles - start),
+           100.0 * (model.isrCycles - isr0) / (model.cycles - start), (unsigned)stats.refills,
+           (unsigned)stats.cyclesPerRefill, (unsigned)stats.cyclesPer100Values, (unsigned)stats.loadPermille);
+}
+
+// Кадр через PWMSEQ_Ws2812: обработчик без тактов на значение, только вывод
+static void TEST_Ws2812Helper(void)
+{
+    void *const args[3] = { &strips[0], &strips[1], &strips[2] };
+    uint32_t from;
+
+    TEST_Reset(16000000, 192, PWMSEQ_WS2812_PERIOD, PWMSEQ_Ws2812Fill, args);
+    for (uint32_t i = 0; i < 30; i++)
+    {
+        grb[i] = (uint8_t)(i * 37);
+    }
+    for (uint32_t i = 0; i < 240; i++)
+    {
+        expected[0][i] = (grb[i >> 3] & (0x80 >> (i & 7))) ? PWMSEQ_WS2812_T1H : PWMSEQ_WS2812_T0H;
+    }
+    PWMSEQ_Ws2812(&seqs[0], grb, 10);
+    from = model.traced[0];
+    CHECK(SystemCoreClock == 80000000);
+    CHECK(PWMSEQ_Wait(&seqs[0], 100) == pdTRUE);
+    MODEL_Run(4 * TEST_PeriodCycles(PWMSEQ_WS2812_PERIOD));
+    CHECK(model.traced[0] - from >= 240 + PWMSEQ_WS2812_RESET);
+    CHECK(TEST_Output(0, from, expected[0], 240, 0) == 1);
+    TEST_Idle(0);
+    TEST_Clean();
+}
+
+int main(void)
+{
+    TEST_Edges();
+    TEST_Underrun();
+    TEST_Stop();
+    for (unsigned seed = 1; seed <= 12; seed++)
+    {
+        TEST_Group(seed);
+    }
+    TEST_Ws2812Helper();
+    TEST_Ws2812(40000000, 4, 1);
+    TEST_Clean();
+    TEST_Ws2812(80000000, 2, 1);
+    TEST_Clean();
+
+    // Без удержания на 40 МГц цепочке не хватает 50 тактов на период
+    TEST_Ws2812(40000000, 1, 0);
+    CHECK(model.overruns != 0);
+
+    return HOST_Result("test_pwmseq");
+}
@@ -0,0 +1,362 @@
+// Пакетные отправка и прием очередей (uxQueueSendBatch/uxQueueReceiveBatch и версии FromISR
+// из FreeRTOS/queue.c) на настоящем коде ядра, модель планировщика - rtos/tasks.h.
+// Проверяются: полный и частичный пакет, блокировка на первом элементе с досылкой
+// остатка, таймаут, случайная смесь пакетов против эталонного кольца с переходом через
+// конец хранилища, пробуждение ждущих задач по одной на элемент, и пакет больше 127
+// элементов из прерывания в заблокированную очередь: счетчик блокировки упирается в число
+// задач, а не переполняет int8_t (регрессия к ограничению cTxLock/cRxLock).
+// Печатается производительность против размера пакета: элементов в секунду и время под
+// маской на хосте, плюс число критических секций на элемент - оно от процессора не
+// зависит. Замеров на кристалле нет
+#include <time.h>
+#include "rtos/tasks.h"
+#include "../FreeRTOS/list.c"
+#include "../FreeRTOS/queue.c"
+
+static uint32_t seed = 1;
+static uint32_t TEST_Random(void)
+{
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+static void TEST_Fill(uint32_t *items, unsigned n, uint32_t first)
+{
+    for (unsigned i = 0; i < n; i++)
+    {
+        items[i] = first + i;
+    }
+}
+
+static int TEST_Sequence(const uint32_t *items, unsigned n, uint32_t first)
+{
+    for (unsigned i = 0; i < n; i++)
+    {
+        if (items[i] != first + i)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Полный и частичный пакет без ожидания
+static void TEST_Partial(void)
+{
+    QueueHandle_t q = xQueueCreate(8, sizeof(uint32_t));
+    uint32_t in[16], out[16];
+
+    TEST_Fill(in, 16, 100);
+    CHECK(uxQueueSendBatch(q, in, 8, 0) == 8);   // ровно по длине
+    CHECK(uxQueueSendBatch(q, in, 1, 0) == 0);   // полна
+    CHECK(uxQueueReceiveBatch(q, out, 3, 0) == 3);
+    CHECK(TEST_Sequence(out, 3, 100));
+    CHECK(uxQueueSendBatch(q, in + 8, 5, 0) == 3); // влезло три из пяти, с переходом
+    CHECK(uxQueueMessagesWaiting(q) == 8);
+    CHECK(uxQueueReceiveBatch(q, out, 16, 0) == 8); // забрали все, что было
+    CHECK(TEST_Sequence(out, 8, 103));
+    CHECK(uxQueueReceiveBatch(q, out, 4, 0) == 0);
+    CHECK(uxQueueSendBatch(q, in, 0, 0) == 0);
+    CHECK(taskTicks == 0);
+    CHECK(hostAsserts == 0);
+    vQueueDelete(q);
+}
+
+static QueueHandle_t isrQueue;
+static unsigned isrCount;
+static uint32_t isrItems[64];
+
+static void TEST_IsrReceive(void)
+{
+    BaseType_t woken = pdFALSE;
+
+    CHECK(uxQueueReceiveBatchFromISR(isrQueue, isrItems, isrCount, &woken) == isrCount);
+    CHECK(woken == pdFALSE); // ждет задача с тем же приоритетом
+}
+
+static void TEST_IsrSend(void)
+{
+    BaseType_t woken = pdFALSE;
+
+    CHECK(uxQueueSendBatchFromISR(isrQueue, isrItems, isrCount, &woken) == isrCount);
+}
+
+// Пакет блокируется только на первом элементе, остаток досылается, сколько влезет
+static void TEST_Block(void)
+{
+    uint32_t in[8], out[8];
+    TickType_t start;
+
+    isrQueue = xQueueCreate(4, sizeof(uint32_t));
+    TEST_Fill(in, 8, 0);
+    CHECK(uxQueueSendBatch(isrQueue, in, 4, 0) == 4);
+
+    // Пока задача спит, прерывание снимает два элемента: первый уходит после ожидания,
+    // второй досылается, два оставшихся не влезают
+    taskSleepHook = TEST_IsrReceive;
+    isrCount = 2;
+    start = taskTicks;
+    CHECK(uxQueueSendBatch(isrQueue, in + 4, 4, 10) == 2);
+    CHECK(taskTicks == start && taskMain.wakes == 1);
+    CHECK(TEST_Sequence(isrItems, 2, 0));
+
+    // Никто не разбудил - таймаут, ничего не отправлено
+    taskSleepHook = NULL;
+    CHECK(uxQueueSendBatch(isrQueue, in + 6, 2, 10) == 0);
+    CHECK(taskTicks == start + 10 && !TASK_Blocked(&taskMain));
+
+    // Прием: очередь пуста, прерывание кладет три - пакет получает все три
+    CHECK(uxQueueReceiveBatch(isrQueue, out, 8, 0) == 4);
+    CHECK(TEST_Sequence(out, 4, 2));
+    taskSleepHook = TEST_IsrSend;
+    TEST_Fill(isrItems, 3, 50);
+    isrCount = 3;
+    start = taskTicks;
+    CHECK(uxQueueReceiveBatch(isrQueue, out, 8, 10) == 3);
+    CHECK(taskTicks == start && taskMain.wakes == 2);
+    CHECK(TEST_Sequence(out, 3, 50));
+    taskSleepHook = NULL;
+
+    CHECK(hostAsserts == 0);
+    vQueueDelete(isrQueue);
+}
+
+// Случайные пакеты всех четырех функций против эталонного кольца. Длина очереди
+// некратна пакетам, так что копирование часто режется на конце хранилища
+#define REF_SIZE 64
+static uint32_t ref[REF_SIZE];
+static unsigned refHead, refTail;
+
+static void TEST_Fifo(void)
+{
+    QueueHandle_t q = xQueueCreate(13, sizeof(uint32_t));
+    uint32_t next = 0, buf[20];
+    BaseType_t woken = pdFALSE;
+
+    seed = 3;
+    refHead = refTail = 0;
+    for (int i = 0; i < 200000; i++)
+    {
+        unsigned want = TEST_Random() % 20;
+        unsigned space = 13 - (refHead - refTail);
+        unsigned expect, got;
+
+        if (TEST_Random() & 1)
+        {
+            TEST_Fill(buf, want, next);
+            expect = want < space ? want : space;
+            got = TEST_Random() & 2 ? uxQueueSendBatch(q, buf, want, 0) : uxQueueSendBatchFromISR(q, buf, want, &woken);
+            CHECK(got == expect);
+            for (unsigned k = 0; k < got; k++)
+            {
+                ref[refHead++ % REF_SIZE] = next++;
+            }
+        }
+        else
+        {
+            expect = want < refHead - refTail ? want : refHead - refTail;
+            got = TEST_Random() & 2 ? uxQueueReceiveBatch(q, buf, want, 0) : uxQueueReceiveBatchFromISR(q, buf, want, &woken);
+            CHECK(got == expect);
+            for (unsigned k = 0; k < got; k++)
+            {
+                CHECK(buf[k] == ref[refTail++ % REF_SIZE]);
+            }
+        }
+        CHECK(uxQueueMessagesWaiting(q) == refHead - refTail);
+        // Одиночный прием в ту же очередь: pcReadFrom у пакетов общий с ним
+        if (refHead != refTail && TEST_Random() % 8 == 0)
+        {
+            CHECK(xQueueReceive(q, buf, 0) == pdPASS && buf[0] == ref[refTail++ % REF_SIZE]);
+        }
+    }
+    CHECK(next > 100000);
+    CHECK(woken == pdFALSE && hostBasepri == 0 && hostCritical == 0);
+    CHECK(hostAsserts == 0);
+    vQueueDelete(q);
+}
+
+// Пакет будит по одной ждущей задаче на элемент, старшую первой
+static void TEST_Wake(void)
+{
+    QueueHandle_t q = xQueueCreate(8, sizeof(uint32_t));
+    Queue_t *queue = q;
+    TCB_t receivers[3];
+    uint32_t in[8], out[8];
+    int yields;
+
+    TEST_Fill(in, 8, 0);
+    for (int i = 0; i < 3; i++)
+    {
+        TASK_Init(&receivers[i], 1 + i); // 1 - как у taskMain, 2 и 3 старше
+        TASK_Block(&receivers[i], &queue->xTasksWaitingToReceive);
+    }
+    yields = taskYields;
+    CHECK(uxQueueSendBatch(q, in, 2, 0) == 2);
+    CHECK(receivers[2].wakes == 1 && receivers[1].wakes == 1 && receivers[0].wakes == 0);
+    CHECK(taskYields == yields + 1); // разбудили старшую - переключение
+    CHECK(uxQueueSendBatch(q, in, 4, 0) == 4);
+    CHECK(receivers[0].wakes == 1 && listLIST_IS_EMPTY(&queue->xTasksWaitingToReceive));
+    CHECK(taskYields == yields + 1); // младшая не вытесняет
+
+    // Прием будит отправителей так же
+    CHECK(uxQueueSendBatch(q, in, 2, 0) == 2);
+    TASK_Init(&receivers[0], 3);
+    TASK_Block(&receivers[0], &queue->xTasksWaitingToSend);
+    CHECK(uxQueueReceiveBatch(q, out, 8, 0) == 8);
+    CHECK(receivers[0].wakes == 1 && taskYields == yields + 2);
+    CHECK(hostAsserts == 0);
+    vQueueDelete(q);
+}
+
+// Заблокированная очередь (задача между prvLockQueue и prvUnlockQueue) принимает пакеты
+// из прерывания. Пакет больше INT8_MAX раньше переполнял счетчик блокировки
+static void TEST_Locked(void)
+{
+    QueueHandle_t q = xQueueCreate(200, sizeof(uint8_t));
+    Queue_t *queue = q;
+    TCB_t receivers[5];
+    uint8_t in[200], out[200];
+    BaseType_t woken = pdFALSE;
+    int missed = taskMissedYields;
+
+    memset(in, 0x5A, sizeof(in));
+    for (int i = 0; i < 5; i++)
+    {
+        TASK_Init(&receivers[i], 2);
+        TASK_Block(&receivers[i], &queue->xTasksWaitingToReceive);
+    }
+    taskCount = 7; // main + 5 ждущих + idle
+    vTaskSuspendAll();
+    prvLockQueue(queue);
+    CHECK(uxQueueSendBatchFromISR(q, in, 150, &woken) == 150);
+    CHECK(queue->cTxLock == 7);   // не 150 и не переполнение
+    CHECK(uxQueueSendBatchFromISR(q, in, 50, &woken) == 50);
+    CHECK(queue->cTxLock == 7);
+    CHECK(woken == pdFALSE);      // в заблокированной очереди будит prvUnlockQueue
+    for (int i = 0; i < 5; i++)
+    {
+        CHECK(receivers[i].wakes == 0);
+    }
+    CHECK(uxQueueReceiveBatchFromISR(q, out, 140, &woken) == 140);
+    CHECK(queue->cRxLock == 7);
+    prvUnlockQueue(queue);
+    (void)xTaskResumeAll();
+    CHECK(queue->cTxLock == queueUNLOCKED && queue->cRxLock == queueUNLOCKED);
+    for (int i = 0; i < 5; i++)
+    {
+        CHECK(receivers[i].wakes == 1); // все ждущие разбужены, по одной на элемент
+    }
+    CHECK(taskMissedYields == missed + 5);
+    CHECK(hostAsserts == 0);
+
+    // Задач больше, чем влезает в int8_t: упор в INT8_MAX ловит configASSERT
+    taskCount = 200;
+    prvLockQueue(queue);
+    CHECK(uxQueueReceiveBatchFromISR(q, out, 60, &woken) == 60);
+    CHECK(queue->cRxLock == 60 && hostAsserts == 0);
+    CHECK(uxQueueReceiveBatchFromISR(q, out, 68, &woken) == 0); // пусто
+    CHECK(uxQueueSendBatchFromISR(q, in, 128, &woken) == 128);
+    CHECK(hostAsserts == 1);
+    hostAsserts = 0;
+    queue->cTxLock = queueLOCKED_UNMODIFIED;
+    prvUnlockQueue(queue);
+    taskCount = 3;
+    vQueueDelete(q);
+}
+
+// Производительность против размера пакета: одна и та же последовательность элементов
+// проходит через очередь одиночными xQueueSend/xQueueReceive и пакетами. Время под маской
+// - от входа до выхода внешней критической секции задачи, часы хоста
+#define BENCH_ITEMS (1u << 22)
+static struct timespec maskStart;
+static double maskTotal;
+static unsigned maskSections;
+
+static double BENCH_Ns(const struct timespec *a, const struct timespec *b)
+{
+    return (b->tv_sec - a->tv_sec) * 1e9 + (b->tv_nsec - a->tv_nsec);
+}
+
+static void BENCH_Mask(int entered)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (entered)
+    {
+        maskStart = now;
+        return;
+    }
+    maskTotal += BENCH_Ns(&maskStart, &now);
+    maskSections++;
+}
+
+// Один проход: все элементы через очередь пакетами по batch, 1 - одиночными вызовами
+static double BENCH_Pass(QueueHandle_t q, unsigned batch)
+{
+    uint32_t in[64], out[64], sum = 0, expect = 0;
+    struct timespec t0, t1;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (uint32_t i = 0; i < BENCH_ITEMS; i += batch)
+    {
+        TEST_Fill(in, batch, i);
+        if (batch == 1)
+        {
+            (void)xQueueSend(q, in, 0);
+            (void)xQueueReceive(q, out, 0);
+        }
+        else
+        {
+            (void)uxQueueSendBatch(q, in, batch, 0);
+            (void)uxQueueReceiveBatch(q, out, batch, 0);
+        }
+        sum += out[batch - 1];
+        expect += i + batch - 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    CHECK(sum == expect);
+    return BENCH_Ns(&t0, &t1);
+}
+
+static void BENCH_Run(unsigned batch)
+{
+    QueueHandle_t q = xQueueCreate(64, sizeof(uint32_t));
+    double total;
+
+    // Пропускная способность - без хука, время под маской - отдельным проходом с ним:
+    // часы внутри секции сами ее удлиняют
+    total = BENCH_Pass(q, batch);
+    maskTotal = 0;
+    maskSections = 0;
+    hostCriticalHook = BENCH_Mask;
+    (void)BENCH_Pass(q, batch);
+    hostCriticalHook = NULL;
+    printf("  %-2u %8.1f M/s %10.3f %14.0f %14.1f\n", batch, BENCH_ITEMS / total * 1e3,
+           (double)maskSections / BENCH_ITEMS, maskTotal / maskSections, maskTotal / BENCH_ITEMS);
+    vQueueDelete(q);
+}
+
+static void TEST_Bench(void)
+{
+    static const unsigned batches[] = {1, 4, 16, 64};
+
+    printf("queue batch, хост, %u элементов по 4 байта (1 - одиночные xQueueSend/xQueueReceive):\n"
+           "  N  элементов/с  секций/элем  маска, нс/секц  маска, нс/элем\n", BENCH_ITEMS);
+    for (unsigned i = 0; i < sizeof(batches) / sizeof(batches[0]); i++)
+    {
+        BENCH_Run(batches[i]);
+    }
+    CHECK(hostAsserts == 0);
+}
+
+int main(void)
+{
+    TEST_Partial();
+    TEST_Block();
+    TEST_Fifo();
+    TEST_Wake();
+    TEST_Locked();
+    TEST_Bench();
+    return HOST_Result("test_queue_batch");
+}
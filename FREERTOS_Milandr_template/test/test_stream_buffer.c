@@ -0,0 +1,484 @@
+// Резерв/коммит и просмотр/снятие буферов потока и сообщений (FreeRTOS/stream_buffer.c)
+// на настоящем коде ядра, модель планировщика - rtos/tasks.h.
+// Проверяются: случайная смесь копирующего и бескопийного API против эталонной очереди
+// байт с переходом через конец хранилища, сообщения (все или ничего, длина на стыке),
+// версии FromISR с пробуждением задачи, защита от коммита сверх резерва.
+// Печатается конвейер UART -> разборщик строк: прерывание кладет байты из FIFO, задача
+// разбирает. Копий на байт - счетчик memcpy внутри ядра, их такты на Cortex-M3 - по
+// таблице модели memcpy из lib/src/cm3_string.S (байт за такт по длине копии), время
+// целиком - хост. Ни то, ни другое не замер на кристалле
+#include <time.h>
+#include "rtos/tasks.h"
+
+static size_t copied;      // байт, скопированных memcpy внутри stream_buffer.c
+static double copyCycles;  // их такты по модели cm3_string.S
+
+// Байт за такт memcpy из таблицы cm3_string.S, между точками - линейно. Короче 16 байт
+// время почти постоянно (вход, выравнивание, хвост) - такты как у 16
+static double TEST_CopyCycles(size_t n)
+{
+    static const struct
+    {
+        double bytes, rate;
+    } table[] = {{16, 0.30}, {64, 0.75}, {256, 1.18}, {1024, 1.37}};
+
+    if (n <= table[0].bytes)
+    {
+        return table[0].bytes / table[0].rate;
+    }
+    for (unsigned i = 1; i < sizeof(table) / sizeof(table[0]); i++)
+    {
+        if (n <= table[i].bytes)
+        {
+            double t = (n - table[i - 1].bytes) / (table[i].bytes - table[i - 1].bytes);
+            return n / (table[i - 1].rate + t * (table[i].rate - table[i - 1].rate));
+        }
+    }
+    return n / table[3].rate;
+}
+
+static void *TEST_Memcpy(void *dst, const void *src, size_t n)
+{
+    copied += n;
+    copyCycles += TEST_CopyCycles(n);
+    return memcpy(dst, src, n);
+}
+
+#include "../FreeRTOS/list.c"
+#define memcpy TEST_Memcpy
+#include "../FreeRTOS/stream_buffer.c"
+#undef memcpy
+#include "message_buffer.h"
+
+static uint32_t seed = 1;
+static uint32_t TEST_Random(void)
+{
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+// Эталон: очередь байт
+#define REF_SIZE 4096
+static uint8_t ref[REF_SIZE];
+static size_t refHead, refTail;
+
+static void REF_Put(uint8_t b)
+{
+    ref[refHead++ % REF_SIZE] = b;
+}
+
+static uint8_t REF_Get(void)
+{
+    return ref[refTail++ % REF_SIZE];
+}
+
+static int TEST_SpansValid(StreamBuffer_t *sb, const StreamBufferSpan_t spans[2], size_t total)
+{
+    const uint8_t *begin = sb->pucBuffer, *end = sb->pucBuffer + sb->xLength;
+
+    if (spans[0].xLength + spans[1].xLength != total)
+    {
+        return 0;
+    }
+    if (spans[0].xLength != 0 && (spans[0].pucData < begin || spans[0].pucData + spans[0].xLength > end))
+    {
+        return 0;
+    }
+    // Второй кусок - только при переходе через конец и всегда с начала хранилища
+    return spans[1].xLength == 0 || (spans[1].pucData == begin && spans[0].pucData + spans[0].xLength == end);
+}
+
+static void TEST_Stream(void)
+{
+    const size_t size = 61;
+    StreamBufferHandle_t sb = xStreamBufferCreate(size, 1);
+    uint8_t next = 0, tmp[64];
+    uint32_t wraps = 0;
+
+    refHead = refTail = 0;
+    for (int i = 0; i < 100000; i++)
+    {
+        StreamBufferSpan_t spans[2];
+        size_t want = TEST_Random() % 40, got, n;
+
+        switch (TEST_Random() % 4)
+        {
+        case 0: // резерв и запись через куски
+            got = xStreamBufferSendReserve(sb, want, spans, 0);
+            CHECK(got == (want < xStreamBufferSpacesAvailable(sb) ? want : xStreamBufferSpacesAvailable(sb)));
+            CHECK(TEST_SpansValid(sb, spans, got));
+            wraps += spans[1].xLength != 0;
+            n = got != 0 ? TEST_Random() % (got + 1) : 0;
+            for (size_t k = 0; k < n; k++)
+            {
+                StreamBufferSpan_t *s = k < spans[0].xLength ? &spans[0] : &spans[1];
+                s->pucData[k < spans[0].xLength ? k : k - spans[0].xLength] = next;
+                REF_Put(next++);
+            }
+            CHECK(xStreamBufferSendCommit(sb, n) == n);
+            break;
+        case 1: // копирующая запись, пустая - configASSERT как в исходном ядре
+            want += want == 0;
+            for (size_t k = 0; k < want; k++)
+            {
+                tmp[k] = (uint8_t)(next + k);
+            }
+            got = xStreamBufferSend(sb, tmp, want, 0);
+            for (size_t k = 0; k < got; k++)
+            {
+                REF_Put(next++);
+            }
+            break;
+        case 2: // просмотр и частичное снятие
+            got = xStreamBufferReceivePeek(sb, spans, 0);
+            CHECK(got == refHead - refTail);
+            CHECK(TEST_SpansValid(sb, spans, got));
+            for (size_t k = 0; k < got; k++)
+            {
+                uint8_t b = k < spans[0].xLength ? spans[0].pucData[k] : spans[1].pucData[k - spans[0].xLength];
+                CHECK(b == ref[(refTail + k) % REF_SIZE]);
+            }
+            n = got != 0 ? TEST_Random() % (got + 1) : 0;
+            CHECK(xStreamBufferReceiveConsume(sb, n) == n);
+            refTail += n;
+            break;
+        default: // копирующее чтение
+            got = xStreamBufferReceive(sb, tmp, want, 0);
+            for (size_t k = 0; k < got; k++)
+            {
+                CHECK(tmp[k] == REF_Get());
+            }
+            break;
+        }
+        CHECK(xStreamBufferBytesAvailable(sb) == refHead - refTail);
+    }
+    CHECK(wraps > 1000);
+    CHECK(hostAsserts == 0);
+    vStreamBufferDelete(sb);
+}
+
+static uint8_t TEST_SpanByte(const StreamBufferSpan_t spans[2], size_t k)
+{
+    return k < spans[0].xLength ? spans[0].pucData[k] : spans[1].pucData[k - spans[0].xLength];
+}
+
+static void TEST_Message(void)
+{
+    const size_t size = 50;
+    MessageBufferHandle_t mb = xMessageBufferCreate(size);
+    StreamBuffer_t *sb = mb;
+    uint8_t next = 0, tmp[64];
+    size_t lengths[64];
+    uint8_t starts[64];
+    uint32_t heads = 0, tails = 0, straddles = 0;
+
+    for (int i = 0; i < 100000; i++)
+    {
+        StreamBufferSpan_t spans[2];
+        size_t want = 1 + TEST_Random() % 30, got, n;
+        size_t space = xStreamBufferSpacesAvailable(mb);
+        size_t expect = heads != tails ? lengths[tails % 64] : 0;
+
+        switch (TEST_Random() % 4)
+        {
+        case 0: // сообщение целиком или ничего, длина - сколько закоммичено
+            got = xMessageBufferSendReserve(mb, want, spans, 0);
+            CHECK(got == (space >= want + sbBYTES_TO_STORE_MESSAGE_LENGTH ? want : 0));
+            CHECK(TEST_SpansValid(sb, spans, got));
+            if (got != 0)
+            {
+                straddles += sb->xHead + sbBYTES_TO_STORE_MESSAGE_LENGTH > sb->xLength; // длина на стыке
+                n = 1 + TEST_Random() % got;
+                for (size_t k = 0; k < n; k++)
+                {
+                    StreamBufferSpan_t *s = k < spans[0].xLength ? &spans[0] : &spans[1];
+                    s->pucData[k < spans[0].xLength ? k : k - spans[0].xLength] = (uint8_t)(next + k);
+                }
+                CHECK(xMessageBufferSendCommit(mb, n) == n);
+                starts[heads % 64] = next;
+                lengths[heads++ % 64] = n;
+                next += n;
+            }
+            break;
+        case 1:
+            for (size_t k = 0; k < want; k++)
+            {
+                tmp[k] = (uint8_t)(next + k);
+            }
+            got = xMessageBufferSend(mb, tmp, want, 0);
+            CHECK(got == (space >= want + sbBYTES_TO_STORE_MESSAGE_LENGTH ? want : 0));
+            if (got != 0)
+            {
+                starts[heads % 64] = next;
+                lengths[heads++ % 64] = got;
+                next += got;
+            }
+            break;
+        case 2: // просмотр - только полезная нагрузка следующего сообщения
+            got = xMessageBufferReceivePeek(mb, spans, 0);
+            CHECK(got == expect);
+            CHECK(TEST_SpansValid(sb, spans, got));
+            for (size_t k = 0; k < got; k++)
+            {
+                CHECK(TEST_SpanByte(spans, k) == (uint8_t)(starts[tails % 64] + k));
+            }
+            // снятие убирает сообщение целиком, сколько бы ни попросили
+            CHECK((TEST_Random() & 1 ? xMessageBufferReceiveConsume(mb) : xStreamBufferReceiveConsume(mb, 1)) == got);
+            tails += got != 0;
+            break;
+        default:
+            got = xMessageBufferReceive(mb, tmp, sizeof(tmp), 0);
+            CHECK(got == expect);
+            for (size_t k = 0; k < got; k++)
+            {
+                CHECK(tmp[k] == (uint8_t)(starts[tails % 64] + k));
+            }
+            tails += got != 0;
+            break;
+        }
+    }
+    CHECK(straddles > 100);
+    CHECK(hostAsserts == 0);
+    vMessageBufferDelete(mb);
+}
+
+// FromISR: прерывание пишет и читает, пока задача спит в ожидании данных или места
+static StreamBufferHandle_t isrBuffer;
+static TCB_t isrReceiver;
+static size_t isrBytes;
+static BaseType_t isrWoken;
+
+static void TEST_IsrProducer(void)
+{
+    StreamBufferSpan_t spans[2];
+    size_t got = xStreamBufferSendReserveFromISR(isrBuffer, isrBytes, spans);
+
+    CHECK(hostBasepri == 0);
+    for (size_t k = 0; k < got; k++)
+    {
+        (k < spans[0].xLength ? spans[0].pucData : spans[1].pucData - spans[0].xLength)[k] = (uint8_t)(0xA0 + k);
+    }
+    isrWoken = pdFALSE;
+    CHECK(xStreamBufferSendCommitFromISR(isrBuffer, got, &isrWoken) == got);
+    CHECK(hostBasepri == 0);
+}
+
+static void TEST_IsrConsumer(void)
+{
+    StreamBufferSpan_t spans[2];
+    size_t got = xStreamBufferReceivePeekFromISR(isrBuffer, spans);
+
+    isrWoken = pdFALSE;
+    CHECK(xStreamBufferReceiveConsumeFromISR(isrBuffer, got, &isrWoken) == got);
+}
+
+static void TEST_Isr(void)
+{
+    StreamBufferSpan_t spans[2];
+    size_t got;
+
+    isrBuffer = xStreamBufferCreate(32, 4);
+
+    // Задача ждет данных в Peek, прерывание кладет 6 байт - задача просыпается с ними
+    isrBytes = 6;
+    taskSleepHook = TEST_IsrProducer;
+    TickType_t start = taskTicks;
+    got = xStreamBufferReceivePeek(isrBuffer, spans, 100);
+    CHECK(got == 6 && TEST_SpanByte(spans, 5) == 0xA5);
+    CHECK(taskTicks == start);     // разбудили, а не таймаут
+    CHECK(taskMain.wakes == 1);
+    CHECK(xStreamBufferReceiveConsume(isrBuffer, got) == 6);
+
+    // Ниже порога срабатывания задача не просыпается: таймаут, данные остаются
+    isrBytes = 3;
+    got = xStreamBufferReceivePeek(isrBuffer, spans, 10);
+    CHECK(taskTicks == start + 10);
+    CHECK(got == 3 && taskMain.wakes == 1);
+    CHECK(xStreamBufferReceiveConsume(isrBuffer, got) == 3);
+
+    // Приоритет ждущей задачи выше - прерывание просит переключение
+    taskSleepHook = NULL;
+    isrReceiver.uxPriority = 3;
+    isrReceiver.ucNotifyState[tskDEFAULT_INDEX_TO_NOTIFY] = TASK_WAITING;
+    ((StreamBuffer_t *)isrBuffer)->xTaskWaitingToReceive = &isrReceiver;
+    isrBytes = 8;
+    TEST_IsrProducer();
+    CHECK(isrWoken == pdTRUE && isrReceiver.wakes == 1);
+    CHECK(((StreamBuffer_t *)isrBuffer)->xTaskWaitingToReceive == NULL);
+
+    // Задача ждет места в резерве, прерывание снимает данные - место появилось
+    got = xStreamBufferSendReserve(isrBuffer, 31, spans, 0);
+    CHECK(got == 32 - 8); // буфер на 32 байта, 8 уже лежат
+    CHECK(xStreamBufferSendCommit(isrBuffer, got) == got);
+    taskSleepHook = TEST_IsrConsumer;
+    got = xStreamBufferSendReserve(isrBuffer, 10, spans, 100);
+    CHECK(got == 10 && taskMain.wakes == 2);
+    CHECK(xStreamBufferSendCommit(isrBuffer, 0) == 0);
+    taskSleepHook = NULL;
+
+    CHECK(hostAsserts == 0);
+    vStreamBufferDelete(isrBuffer);
+}
+
+// Коммит сверх резерва публиковал бы байты, которые никто не писал
+static void TEST_OverCommit(void)
+{
+    StreamBufferHandle_t sb = xStreamBufferCreate(32, 1);
+    MessageBufferHandle_t mb = xMessageBufferCreate(32);
+    StreamBufferSpan_t spans[2];
+    int asserts = hostAsserts;
+
+    CHECK(xStreamBufferSendReserve(sb, 4, spans, 0) == 4);
+    xStreamBufferSendCommit(sb, 5);
+    CHECK(hostAsserts == asserts + 1);
+    CHECK(xStreamBufferSendReserve(sb, 4, spans, 0) == 4);
+    xStreamBufferSendCommit(sb, 4);
+    xStreamBufferSendCommit(sb, 4);  // второй коммит того же резерва
+    CHECK(hostAsserts == asserts + 2);
+    xStreamBufferSendCommit(sb, 0);  // пустой коммит без резерва безвреден
+    CHECK(hostAsserts == asserts + 2);
+
+    CHECK(xMessageBufferSendReserve(mb, 30, spans, 0) == 0); // не влезает с длиной
+    xMessageBufferSendCommit(mb, 1);
+    CHECK(hostAsserts == asserts + 3);
+
+    hostAsserts = asserts;
+    vStreamBufferDelete(sb);
+    vMessageBufferDelete(mb);
+}
+
+// Конвейер UART -> разборщик. Прерывание приема забирает из FIFO (до 16 байт) пачку
+// случайной длины, задача после нескольких прерываний разбирает все накопленное:
+// считает строки и контрольную сумму. Расписание одно для обоих вариантов
+#define BENCH_BYTES (8u << 20)
+#define BENCH_FIFO  16
+static uint8_t *benchLine;
+static size_t benchPos;
+
+typedef struct
+{
+    uint32_t lines, sum;
+} Parser_t;
+
+static void PARSER_Feed(Parser_t *p, const uint8_t *data, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        p->sum = p->sum * 31 + data[i];
+        p->lines += data[i] == '\n';
+    }
+}
+
+static size_t UART_Burst(void)
+{
+    size_t n = 1 + TEST_Random() % BENCH_FIFO;
+    return n < BENCH_BYTES - benchPos ? n : BENCH_BYTES - benchPos;
+}
+
+static void UART_IsrCopy(StreamBufferHandle_t sb)
+{
+    uint8_t fifo[BENCH_FIFO];
+    size_t n = UART_Burst();
+    BaseType_t woken = pdFALSE;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        fifo[i] = benchLine[benchPos + i]; // чтение DR
+    }
+    benchPos += xStreamBufferSendFromISR(sb, fifo, n, &woken);
+}
+
+static void UART_IsrZeroCopy(StreamBufferHandle_t sb)
+{
+    StreamBufferSpan_t spans[2];
+    size_t n = xStreamBufferSendReserveFromISR(sb, UART_Burst(), spans);
+    BaseType_t woken = pdFALSE;
+
+    for (size_t i = 0; i < spans[0].xLength; i++)
+    {
+        spans[0].pucData[i] = benchLine[benchPos + i];
+    }
+    for (size_t i = 0; i < spans[1].xLength; i++)
+    {
+        spans[1].pucData[i] = benchLine[benchPos + spans[0].xLength + i];
+    }
+    benchPos += xStreamBufferSendCommitFromISR(sb, n, &woken);
+}
+
+static double BENCH_Run(int zeroCopy, Parser_t *p, size_t *copies, double *cycles)
+{
+    StreamBufferHandle_t sb = xStreamBufferCreate(1024, 1);
+    uint8_t local[1024];
+    struct timespec t0, t1;
+
+    benchPos = 0;
+    seed = 7;
+    copied = 0;
+    copyCycles = 0;
+    memset(p, 0, sizeof(*p));
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    while (benchPos < BENCH_BYTES || xStreamBufferBytesAvailable(sb) != 0)
+    {
+        for (uint32_t k = TEST_Random() % 32; k != 0 && benchPos < BENCH_BYTES; k--)
+        {
+            zeroCopy ? UART_IsrZeroCopy(sb) : UART_IsrCopy(sb);
+        }
+        if (zeroCopy)
+        {
+            StreamBufferSpan_t spans[2];
+            size_t n = xStreamBufferReceivePeek(sb, spans, 0);
+            PARSER_Feed(p, spans[0].pucData, spans[0].xLength);
+            PARSER_Feed(p, spans[1].pucData, spans[1].xLength);
+            xStreamBufferReceiveConsume(sb, n);
+        }
+        else
+        {
+            size_t n = xStreamBufferReceive(sb, local, sizeof(local), 0);
+            PARSER_Feed(p, local, n);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    *copies = copied;
+    *cycles = copyCycles;
+    vStreamBufferDelete(sb);
+    return (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+}
+
+static void TEST_Pipeline(void)
+{
+    Parser_t copy, zero;
+    size_t copyBytes, zeroBytes;
+    double copyNs = 1e30, zeroNs = 1e30, copyM3, zeroM3;
+
+    benchLine = malloc(BENCH_BYTES);
+    for (size_t i = 0; i < BENCH_BYTES; i++)
+    {
+        benchLine[i] = i % 73 == 72 ? '\n' : (uint8_t)(' ' + TEST_Random() % 90);
+    }
+    // Лучший из трех прогонов: меньше шума планировщика хоста
+    for (int run = 0; run < 3; run++)
+    {
+        double ns = BENCH_Run(0, &copy, &copyBytes, &copyM3);
+        copyNs = ns < copyNs ? ns : copyNs;
+        ns = BENCH_Run(1, &zero, &zeroBytes, &zeroM3);
+        zeroNs = ns < zeroNs ? ns : zeroNs;
+    }
+    CHECK(copy.lines == BENCH_BYTES / 73 && copy.lines == zero.lines && copy.sum == zero.sum);
+    CHECK(copyBytes == 2 * (size_t)BENCH_BYTES); // в буфер и из буфера
+    CHECK(zeroBytes == 0);
+    printf("UART -> parser, %u MB: copy API %.2f copies/byte %.2f M3 copy cycles/byte %.0f MB/s host, "
+           "zero copy %.2f copies/byte %.2f M3 copy cycles/byte %.0f MB/s host (x%.2f)\n",
+           BENCH_BYTES >> 20, (double)copyBytes / BENCH_BYTES, copyM3 / BENCH_BYTES, BENCH_BYTES / copyNs * 1e3,
+           (double)zeroBytes / BENCH_BYTES, zeroM3 / BENCH_BYTES, BENCH_BYTES / zeroNs * 1e3, copyNs / zeroNs);
+    free(benchLine);
+}
+
+int main(void)
+{
+    TEST_Stream();
+    TEST_Message();
+    TEST_Isr();
+    TEST_OverCommit();
+    TEST_Pipeline();
+    return HOST_Result("test_stream_buffer");
+}
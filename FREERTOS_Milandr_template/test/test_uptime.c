@@ -0,0 +1,202 @@
+// Время uptime.c на модели SysTick (cm3.h). Прерывание выше SysTick читает время в каждой
+// точке, где оно может его застать: тик ждет маски (PENDSTSET), SysTick_Handler вошел, но
+// снимок еще не опубликовал (PENDSTSET уже снят, SYSTICKACT стоит), хуки тика, смена
+// частоты. Чтения из всех контекстов по времени модели не идут назад, тики и мкс сходятся
+// с периодами и временем модели
+#include "cm3.h"
+
+#include <math.h>
+
+// SPL
+typedef struct
+{
+    uint32_t RTC_CNT, RTC_DIV, RTC_PRL;
+} MDR_BKP_TypeDef;
+static MDR_BKP_TypeDef bkp;
+#define MDR_BKP (&bkp)
+
+// clk.h
+typedef enum
+{
+    CLK_PRE_CHANGE,
+    CLK_SWITCH,
+    CLK_POST_CHANGE,
+} CLK_Event_t;
+typedef void (*CLK_Notifier_t)(CLK_Event_t event, uint32_t hz);
+static CLK_Notifier_t notifier;
+static void CLK_AddNotifier(CLK_Notifier_t value) { notifier = value; }
+
+// FreeRTOS
+#define configCPU_CLOCK_HZ (SystemCoreClock)
+
+#include "uptime.h"
+
+enum
+{
+    READ_MAIN,
+    READ_IRQ,
+    READ_ENTRY, // между входом в SysTick_Handler и публикацией снимка
+    READ_HOOK,  // из xPortSysTickHandler
+    READ_CONTEXTS
+};
+
+static const char *const contextNames[READ_CONTEXTS] = { "main", "irq", "entry", "hook" };
+
+static struct
+{
+    uint64_t us[READ_CONTEXTS], cycles[READ_CONTEXTS], ticks[READ_CONTEXTS];
+    double offsetNs;               // модель до запуска и потери на сменах частоты
+    uint64_t offsetCycles;
+    uint32_t reads[READ_CONTEXTS];
+    uint32_t backwards[READ_CONTEXTS];
+    uint32_t wrong[READ_CONTEXTS]; // разошлось со временем модели
+    double worstUs;
+} check;
+
+// Чтение идет несколько тактов: значение должно попасть между моделью до и после.
+// Назад - в пределах контекста: вложенное прерывание может прочесть позже, но вернуть раньше
+static void TEST_Read(int context)
+{
+    double nsBefore = cm3.ns;
+    uint64_t cyclesBefore = cm3.cycles;
+    uint64_t wrapsBefore = cm3.wraps;
+    uint64_t us = UPTIME_GetUs();
+    uint64_t cycles = UPTIME_GetCycles();
+    uint64_t ticks = UPTIME_GetTicks();
+    double lowUs = (nsBefore - check.offsetNs) / 1000 - 2;
+    double highUs = (cm3.ns - check.offsetNs) / 1000 + 2;
+
+    check.reads[context]++;
+    if (us < check.us[context] || cycles < check.cycles[context] || ticks < check.ticks[context])
+    {
+        check.backwards[context]++;
+    }
+    if (us < lowUs || us > highUs || cycles + check.offsetCycles + 2 < cyclesBefore ||
+        cycles + check.offsetCycles > cm3.cycles + 2 || ticks < wrapsBefore || ticks > cm3.wraps)
+    {
+        if (check.wrong[context] == 0)
+        {
+            printf("%s: us %llu (%.1f..%.1f), cycles %llu (%llu..%llu), ticks %llu (%llu..%llu)\n",
+                   contextNames[context], (unsigned long long)us, lowUs, highUs,
+                   (unsigned long long)cycles, (unsigned long long)(cyclesBefore - check.offsetCycles),
+                   (unsigned long long)(cm3.cycles - check.offsetCycles), (unsigned long long)ticks,
+                   (unsigned long long)wrapsBefore, (unsigned long long)cm3.wraps);
+        }
+        check.wrong[context]++;
+    }
+    if (fabs(us - (cm3.ns - check.offsetNs) / 1000) > check.worstUs)
+    {
+        check.worstUs = fabs(us - (cm3.ns - check.offsetNs) / 1000);
+    }
+    check.us[context] = us;
+    check.cycles[context] = cycles;
+    check.ticks[context] = ticks;
+}
+
+static void xPortSysTickHandler(void) { TEST_Read(READ_HOOK); }
+
+#include "../app/src/uptime.c"
+
+static uint32_t seed = 1;
+
+static uint32_t TEST_Random(uint32_t low, uint32_t high)
+{
+    seed = seed * 1664525 + 1013904223;
+    return low + (seed >> 8) % (high - low + 1);
+}
+
+static void TEST_Irq(void)
+{
+    TEST_Read(READ_IRQ);
+    cm3.irqPeriod = TEST_Random(20, 1500); // фаза относительно SysTick все время сдвигается
+}
+
+static void TEST_Entry(void) { TEST_Read(READ_ENTRY); }
+
+// Задача: чтения, критические секции и PRIMASK через границы периодов, смены частоты
+static void TEST_Task(uint32_t ms, int retune)
+{
+    static const uint32_t levels[] = { 8000000, 16000000, 40000000, 80000000 };
+    double end = cm3.ns + ms * 1e6;
+
+    while (cm3.ns < end)
+    {
+        uint32_t action = TEST_Random(0, 99);
+
+        if (action < 70)
+        {
+            TEST_Read(READ_MAIN);
+            CM3_Run(TEST_Random(1, 200));
+        }
+        else if (action < 85)
+        {
+            // Тик ждет конца критической секции, прерывание выше BASEPRI читает
+            taskENTER_CRITICAL();
+            CM3_Run(TEST_Random(1, SystemCoreClock / 2000));
+            TEST_Read(READ_MAIN);
+            taskEXIT_CRITICAL();
+        }
+        else if (action < 95)
+        {
+            __disable_irq();
+            CM3_Run(TEST_Random(1, 300));
+            TEST_Read(READ_MAIN);
+            __enable_irq();
+        }
+        else if (retune)
+        {
+            // Как CLK_SetFrequency: SWITCH в критической секции сразу после переключения.
+            // Такты между чтением VAL и его перезаписью теряются, модель их зачитывает.
+            // Замер под PRIMASK: UPTIME_Retune сама не пускает прерывания, а в замер - незачем
+            uint32_t oldHz = SystemCoreClock;
+            int64_t lost;
+
+            taskENTER_CRITICAL();
+            __disable_irq();
+            lost = -(int64_t)cm3.cycles;
+            lost += (int64_t)UPTIME_GetCycles();
+            SystemCoreClock = levels[TEST_Random(0, 3)];
+            notifier(CLK_SWITCH, SystemCoreClock);
+            lost += (int64_t)cm3.cycles;
+            lost -= (int64_t)UPTIME_GetCycles();
+            __enable_irq();
+            taskEXIT_CRITICAL();
+            CHECK(lost >= 0 && lost <= 8);
+            check.offsetCycles += lost;
+            check.offsetNs += lost * 1e9 / oldHz;
+        }
+    }
+}
+
+int main(void)
+{
+    SystemCoreClock = 80000000;
+    check.offsetNs = cm3.ns;
+    vPortSetupTimerInterrupt();
+    check.offsetCycles = cm3.cycles;
+    CHECK(notifier == UPTIME_Retune);
+
+    // Без прерывания: хуки тика и задача
+    TEST_Task(20, 0);
+
+    // Прерывание в случайных точках и в окне между входом в SysTick_Handler и публикацией
+    cm3.irq = TEST_Irq;
+    cm3.irqPeriod = 100;
+    cm3.entryHook = TEST_Entry;
+    TEST_Task(200, 0);
+
+    // То же со сменами частоты
+    TEST_Task(200, 1);
+
+    for (int i = 0; i < READ_CONTEXTS; i++)
+    {
+        printf("%-5s: %7u reads, %u backwards, %u off model time\n", contextNames[i],
+               (unsigned)check.reads[i], (unsigned)check.backwards[i], (unsigned)check.wrong[i]);
+        CHECK(check.reads[i] > 0);
+        CHECK(check.backwards[i] == 0);
+        CHECK(check.wrong[i] == 0);
+    }
+    printf("%llu ticks, worst %.2f us from model time\n", (unsigned long long)cm3.wraps, check.worstUs);
+    CHECK(hostAsserts == 0);
+    return HOST_Result("test_uptime");
+}
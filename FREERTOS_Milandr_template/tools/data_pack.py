@@ -0,0 +1,227 @@
+#!/usr/bin/env python3
+"""
+Сжатие образа .data после линковки (cmake -DDATA_COMPRESS=ON).
+
+Образ .data во FLASH (_sidata) заменяется на "LZ4D" + блок LZ4, который в Reset_Handler
+разворачивает CopyData из Startup/data_lz4.s. ELF переписывается на месте:
+  - секция .data становится NOBITS, у ее сегмента обнуляется p_filesz - ни gdb load,
+    ни openocd program не пишут несжатый образ;
+  - добавляются секция .data_lz и сегмент PT_LOAD с упакованным образом по адресу _sidata.
+Адреса кода и данных не меняются: упакованный образ короче и лежит на месте прежнего,
+последним во FLASH. Перед записью результат распаковывается и сверяется с исходным.
+"""
+
+import argparse
+import struct
+import sys
+
+MAGIC = b"LZ4D"
+SHT_NOBITS = 8
+SHF_ALLOC = 0x2
+PT_LOAD = 1
+PF_R = 4
+
+MIN_MATCH = 4
+LAST_LITERALS = 5  # блок LZ4: последние 5 байт - литералы
+MF_LIMIT = 12      # и совпадение не начинается ближе 12 байт к концу
+MAX_OFFSET = 0xFFFF
+HASH_CHAIN = 256
+
+
+def lz4_compress(data):
+    """Блок LZ4, жадный поиск по цепочкам хешей 4-байтных префиксов."""
+    n = len(data)
+    out = bytearray()
+    heads = {}
+    chain = [0] * n
+    anchor = 0
+    pos = 0
+
+    def insert(i):
+        key = data[i:i + 4]
+        chain[i] = heads.get(key, -1)
+        heads[key] = i
+
+    def emit(literals, offset, length):
+        lit = len(literals)
+        token_lit = min(lit, 15)
+        token_match = 0 if length is None else min(length - MIN_MATCH, 15)
+        out.append(token_lit << 4 | token_match)
+        if lit >= 15:
+            rest = lit - 15
+            while rest >= 255:
+                out.append(255)
+                rest -= 255
+            out.append(rest)
+        out.extend(literals)
+        if length is None:
+            return
+        out.extend(struct.pack("<H", offset))
+        if length - MIN_MATCH >= 15:
+            rest = length - MIN_MATCH - 15
+            while rest >= 255:
+                out.append(255)
+                rest -= 255
+            out.append(rest)
+
+    limit = n - MF_LIMIT
+    while pos < limit:
+        best_len, best_off = 0, 0
+        candidate = heads.get(data[pos:pos + 4], -1)
+        steps = 0
+        while candidate >= 0 and pos - candidate <= MAX_OFFSET and steps < HASH_CHAIN:
+            length = 0
+            end = n - LAST_LITERALS
+            while pos + length < end and data[candidate + length] == data[pos + length]:
+                length += 1
+            if length > best_len:
+                best_len, best_off = length, pos - candidate
+            candidate = chain[candidate]
+            steps += 1
+        if best_len < MIN_MATCH:
+            insert(pos)
+            pos += 1
+            continue
+        emit(data[anchor:pos], best_off, best_len)
+        for i in range(pos, min(pos + best_len, n - 3)):
+            insert(i)
+        pos += best_len
+        anchor = pos
+    emit(data[anchor:], 0, None)
+    return bytes(out)
+
+
+def lz4_decompress(block, size):
+    out = bytearray()
+    i = 0
+    while True:
+        token = block[i]
+        i += 1
+        lit = token >> 4
+        if lit == 15:
+            while True:
+                b = block[i]
+                i += 1
+                lit += b
+                if b != 255:
+                    break
+        out += block[i:i + lit]
+        i += lit
+        if len(out) >= size:
+            return bytes(out)
+        offset = block[i] | block[i + 1] << 8
+        i += 2
+        length = token & 15
+        if length == 15:
+            while True:
+                b = block[i]
+                i += 1
+                length += b
+                if b != 255:
+                    break
+        for _ in range(length + MIN_MATCH):
+            out.append(out[-offset])
+
+
+class Elf:
+    def __init__(self, data):
+        if data[:4] != b"\x7fELF" or data[4] != 1 or data[5] != 1:
+            raise ValueError("нужен ELF32 little-endian")
+        self.data = bytearray(data)
+        (self.phoff, self.shoff) = struct.unpack_from("<II", data, 0x1C)
+        (self.phentsize, self.phnum, self.shentsize, self.shnum,
+         self.shstrndx) = struct.unpack_from("<HHHHH", data, 0x2A)
+        self.sections = [list(struct.unpack_from("<10I", data, self.shoff + i * self.shentsize))
+                         for i in range(self.shnum)]
+        self.segments = [list(struct.unpack_from("<8I", data, self.phoff + i * self.phentsize))
+                         for i in range(self.phnum)]
+        names = self.sections[self.shstrndx]
+        self.shstrtab = bytes(data[names[4]:names[4] + names[5]])
+
+    def name(self, section):
+        start = section[0]
+        return self.shstrtab[start:self.shstrtab.index(b"\0", start)].decode()
+
+    def find(self, title):
+        for section in self.sections:
+            if self.name(section) == title:
+                return section
+        return None
+
+    def append(self, blob, align=4):
+        self.data += bytes(-len(self.data) % align)
+        offset = len(self.data)
+        self.data += blob
+        return offset
+
+    def serialize(self):
+        """Таблицы секций и сегментов и .shstrtab дописываются в конец файла."""
+        names = self.sections[self.shstrndx]
+        names[4] = self.append(self.shstrtab, 1)
+        names[5] = len(self.shstrtab)
+        self.phoff = self.append(b"".join(struct.pack("<8I", *p) for p in self.segments))
+        self.shoff = self.append(b"".join(struct.pack("<10I", *s) for s in self.sections))
+        struct.pack_into("<II", self.data, 0x1C, self.phoff, self.shoff)
+        struct.pack_into("<H", self.data, 0x2C, len(self.segments))
+        struct.pack_into("<H", self.data, 0x30, len(self.sections))
+        return bytes(self.data)
+
+
+def pack(path):
+    with open(path, "rb") as f:
+        elf = Elf(f.read())
+
+    section = elf.find(".data")
+    if section is None or elf.find(".data_lz") is not None or section[1] == SHT_NOBITS:
+        print("data_pack: %s - нечего сжимать или уже сжат" % path)
+        return 0
+    _, _, _, vma, offset, size = section[:6]
+    if size == 0:
+        print("data_pack: .data пуста")
+        return 0
+
+    segment = next((p for p in elf.segments
+                    if p[0] == PT_LOAD and p[1] <= offset < p[1] + p[4] and p[2] <= vma < p[2] + p[5]), None)
+    if segment is None or segment[1] != offset:
+        raise ValueError(".data должна начинать свой сегмент PT_LOAD")
+    lma = segment[3]
+    image = bytes(elf.data[offset:offset + size])
+
+    block = lz4_compress(image)
+    if lz4_decompress(block, size) != image:
+        raise AssertionError("распаковка не совпала с исходным образом")
+    blob = MAGIC + block
+    blob += bytes(-len(blob) % 4)
+    if len(blob) >= size:
+        print("data_pack: .data %d байт не сжимается (%d), образ оставлен как есть" % (size, len(blob)))
+        return 0
+
+    # .data без содержимого в файле, сегмент только резервирует ОЗУ
+    section[1] = SHT_NOBITS
+    segment[4] = 0
+
+    elf.shstrtab += b".data_lz\0"
+    blob_offset = elf.append(blob)
+    elf.sections.append([len(elf.shstrtab) - len(b".data_lz\0"), 1, SHF_ALLOC, lma, blob_offset,
+                         len(blob), 0, 0, 4, 0])
+    # PT_LOAD идут по возрастанию p_vaddr (требование ELF): перед первым с большим адресом
+    loads = [i for i, p in enumerate(elf.segments) if p[0] == PT_LOAD]
+    index = next((i for i in loads if elf.segments[i][2] > lma), loads[-1] + 1)
+    elf.segments.insert(index, [PT_LOAD, blob_offset, lma, lma, len(blob), len(blob), PF_R, 4])
+
+    with open(path, "wb") as f:
+        f.write(elf.serialize())
+    print("data_pack: .data %d -> %d байт во FLASH, экономия %d (%.0f%%)"
+          % (size, len(blob), size - len(blob), 100.0 * (size - len(blob)) / size))
+    return 0
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("elf", help="ELF прошивки, переписывается на месте")
+    args = ap.parse_args()
+    return pack(args.elf)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
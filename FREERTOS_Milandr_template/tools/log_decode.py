@@ -0,0 +1,210 @@
+#!/usr/bin/env python3
+"""
+Декодер журнала app/inc/log.h.
+
+Поток - слова little-endian: заголовок (0xA в старшей тетраде, число аргументов
+в битах 27..24, ID в битах 23..0), DWT->CYCCNT, аргументы. ID - смещение строки
+"файл:строка\\0формат" в секции .log_fmt ELF-файла прошивки. Строки для %s
+читаются из загружаемых секций того же ELF.
+
+CYCCNT идет на частоте ядра, которую меняет DFS. Записи с ID_CLOCK (LOG_Init и каждая
+смена частоты) несут новую частоту: время - сумма участков, каждый в своих тактах.
+--hz - частота до первой такой записи, 0 - до нее метки в тактах.
+
+Источник - файл, stdin ("-") или последовательный порт (--port, нужен pyserial).
+Поток можно подключить с середины и он может терять байты: декодер ищет
+заголовок с известным ID и подходящим числом аргументов.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+SYNC = 0xA
+ID_DROPPED = 0xFFFFFF
+ID_CLOCK = 0xFFFFFE
+SHT_NOBITS = 8
+SHF_ALLOC = 0x2
+
+CONV_RE = re.compile(r"%([-+ #0]*\d*(?:\.\d+)?)(hh|h|ll|l|z|j|t)?([diouxXcsfFeEgGp%])")
+
+
+class Elf:
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            data = f.read()
+        if data[:4] != b"\x7fELF" or data[4] != 1 or data[5] != 1:
+            raise ValueError("%s: нужен ELF32 little-endian" % path)
+        shoff, = struct.unpack_from("<I", data, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from("<HHH", data, 0x2E)
+        headers = [struct.unpack_from("<IIIIIIIIII", data, shoff + i * shentsize) for i in range(shnum)]
+        names = headers[shstrndx]
+        strtab = data[names[4]:names[4] + names[5]]
+
+        self.formats = None
+        self.memory = []  # (адрес, байты) загружаемых секций
+        for name, type_, flags, addr, offset, size, *_ in headers:
+            title = strtab[name:strtab.index(b"\0", name)].decode()
+            body = data[offset:offset + size] if type_ != SHT_NOBITS else None
+            if title == ".log_fmt":
+                self.formats = body
+            elif flags & SHF_ALLOC and body is not None and addr != 0:
+                self.memory.append((addr, body))
+        if self.formats is None:
+            raise ValueError("%s: нет секции .log_fmt" % path)
+
+    def format(self, id_):
+        """(место в исходнике, формат) или None, если по ID не начинается строка."""
+        f = self.formats
+        if id_ >= len(f) or (id_ > 0 and f[id_ - 1] != 0):
+            return None
+        end = f.find(b"\0", id_)
+        end2 = f.find(b"\0", end + 1)
+        if end < 0 or end2 < 0:
+            return None
+        return f[id_:end].decode(errors="replace"), f[end + 1:end2].decode(errors="replace")
+
+    def string(self, address):
+        for base, body in self.memory:
+            if base <= address < base + len(body):
+                start = address - base
+                end = body.find(b"\0", start)
+                return body[start:end if end >= 0 else len(body)].decode(errors="replace")
+        return "<0x%08x вне FLASH>" % address
+
+
+def render(elf, fmt, args):
+    out = []
+    pos = 0
+    args = list(args)
+    for m in CONV_RE.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        flags, _, conv = m.groups()
+        if conv == "%":
+            out.append("%")
+            continue
+        value = args.pop(0) if args else 0
+        if conv in "di":
+            value -= (value >> 31) << 32
+        elif conv in "fFeEgG":
+            value, = struct.unpack("<f", struct.pack("<I", value))
+        elif conv == "c":
+            value = chr(value & 0xFF)
+        elif conv == "s":
+            value = elf.string(value)
+        elif conv == "p":
+            conv, flags, value = "s", flags, "0x%08x" % value
+        elif conv == "u":
+            conv = "d"
+        out.append(("%" + flags + conv) % value)
+    out.append(fmt[pos:])
+    return "".join(out)
+
+
+def conversions(fmt):
+    return sum(1 for m in CONV_RE.finditer(fmt) if m.group(3) != "%")
+
+
+class Decoder:
+    def __init__(self, elf, hz):
+        self.elf = elf
+        self.hz = hz
+        self.buffer = b""
+        self.cycles = None  # развернутый CYCCNT
+        self.since = 0      # такты начала участка с частотой hz
+        self.seconds = 0.0  # время начала участка
+        self.skipped = 0
+
+    def header(self, word):
+        """(число аргументов, место, формат) или None."""
+        if word >> 28 != SYNC:
+            return None
+        n, id_ = (word >> 24) & 0xF, word & 0xFFFFFF
+        if id_ in (ID_DROPPED, ID_CLOCK):
+            return (1, id_, None) if n == 1 else None
+        entry = self.elf.format(id_)
+        if entry is None or conversions(entry[1]) != n:
+            return None
+        return (n,) + entry
+
+    def timestamp(self, cyccnt):
+        if self.cycles is None:
+            self.cycles = cyccnt
+        else:
+            self.cycles += (cyccnt - self.cycles) & 0xFFFFFFFF
+        if self.hz:
+            return "%12.6f" % (self.seconds + (self.cycles - self.since) / self.hz)
+        return "%12d" % self.cycles
+
+    def clock(self, hz):
+        """Новая частота с текущей метки. Без известной частоты время считается от нее."""
+        if self.hz:
+            self.seconds += (self.cycles - self.since) / self.hz
+        self.since = self.cycles
+        self.hz = hz
+
+    def feed(self, data):
+        self.buffer += data
+        lines = []
+        while len(self.buffer) >= 8:
+            word, cyccnt = struct.unpack_from("<II", self.buffer)
+            record = self.header(word)
+            if record is None:
+                self.buffer = self.buffer[1:]  # потеря синхронизации, побайтно
+                self.skipped += 1
+                continue
+            n, where, fmt = record
+            size = 8 + 4 * n
+            if len(self.buffer) < size:
+                break
+            args = struct.unpack_from("<%dI" % n, self.buffer, 8)
+            self.buffer = self.buffer[size:]
+            if self.skipped:
+                lines.append("%12s  -- пропущено %d байт" % ("", self.skipped))
+                self.skipped = 0
+            stamp = self.timestamp(cyccnt)
+            if where == ID_CLOCK:
+                self.clock(args[0])
+                lines.append("%s  -- частота %d Гц" % (stamp, args[0]))
+            elif where == ID_DROPPED:
+                lines.append("%s  -- потеряно записей: %d" % (stamp, args[0]))
+            else:
+                lines.append("%s  %s: %s" % (stamp, where, render(self.elf, fmt, args)))
+        return lines
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--elf", required=True, help="ELF прошивки")
+    ap.add_argument("--hz", type=float, default=0,
+                    help="частота CYCCNT до первой записи о частоте, 0 - до нее метки в тактах")
+    ap.add_argument("--port", help="последовательный порт вместо файла")
+    ap.add_argument("--baud", type=int, default=115200)
+    ap.add_argument("input", nargs="?", default="-", help="файл с потоком, - stdin")
+    args = ap.parse_args()
+
+    decoder = Decoder(Elf(args.elf), args.hz)
+    if args.port:
+        import serial  # pyserial
+        source = serial.Serial(args.port, args.baud, timeout=0.1)
+    elif args.input == "-":
+        source = sys.stdin.buffer
+    else:
+        source = open(args.input, "rb")
+
+    try:
+        while True:
+            data = source.read(256) if args.port else source.read1(4096)
+            if not data and not args.port:
+                break
+            for line in decoder.feed(data):
+                print(line, flush=True)
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
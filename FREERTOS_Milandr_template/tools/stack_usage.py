@@ -0,0 +1,202 @@
+#!/usr/bin/env python3
+"""
+Статический расчет глубины стека по графу вызовов.
+
+Читает файлы *.ci, которые GCC пишет с ключом -fcallgraph-info=su (граф вызовов
+и размер кадра каждой функции), находит худший путь от каждой точки входа
+(задачи FreeRTOS и обработчики из таблицы векторов startup-файла) и генерирует:
+  - заголовок с размерами стеков задач в словах (StackType_t);
+  - текстовый отчет с худшими цепочками вызовов и предупреждениями.
+
+Косвенные вызовы, рекурсия и динамические кадры (alloca/VLA) посчитать нельзя,
+такие точки входа помечаются в отчете как неточные.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+NODE_RE = re.compile(r'node:\s*{\s*title:\s*"([^"]+)"\s*label:\s*"([^"]*)"')
+EDGE_RE = re.compile(r'edge:\s*{\s*sourcename:\s*"([^"]+)"\s*targetname:\s*"([^"]+)"')
+FRAME_RE = re.compile(r'\\n(\d+) bytes \(([a-z,]+)\)')
+VECTOR_RE = re.compile(r'^\s*\.word\s+([A-Za-z_]\w*)')
+
+INDIRECT = "__indirect_call"
+
+# Кадр исключения Cortex-M3: 8 слов аппаратно (r0-r3, r12, lr, pc, xPSR)
+# + 8 слов r4-r11, которые сохраняет PendSV порта FreeRTOS
+CONTEXT_BYTES = 16 * 4
+# Выравнивание кадра исключения до 8 байт (STKALIGN)
+EXCEPTION_FRAME_BYTES = 8 * 4 + 4
+
+
+class Function:
+    def __init__(self, name):
+        self.name = name
+        self.frame = None      # None - функция не найдена ни в одном .ci
+        self.dynamic = False
+        self.callees = set()
+
+
+def load_graph(ci_files):
+    funcs = {}
+
+    def get(name):
+        if name not in funcs:
+            funcs[name] = Function(name)
+        return funcs[name]
+
+    for path in ci_files:
+        with open(path, encoding="utf-8", errors="replace") as f:
+            text = f.read()
+        for title, label in NODE_RE.findall(text):
+            m = FRAME_RE.search(label)
+            fn = get(title)
+            if m:
+                fn.frame = int(m.group(1))
+                fn.dynamic = "dynamic" in m.group(2) and "bounded" not in m.group(2)
+        for src, dst in EDGE_RE.findall(text):
+            get(src).callees.add(dst)
+    return funcs
+
+
+def worst_path(funcs, root, unknown_bytes):
+    """Возвращает (глубина, цепочка, предупреждения) для точки входа."""
+    memo = {}
+    warnings = set()
+
+    def walk(name, stack):
+        if name in stack:
+            warnings.add("рекурсия: " + " -> ".join(stack[stack.index(name):] + [name]))
+            return 0, [name]
+        if name in memo:
+            return memo[name]
+        if name == INDIRECT:
+            warnings.add("косвенный вызов в " + stack[-1])
+            return unknown_bytes, [name]
+        fn = funcs.get(name)
+        if fn is None or fn.frame is None:
+            warnings.add("нет данных о стеке: " + name)
+            return unknown_bytes, [name]
+        if fn.dynamic:
+            warnings.add("динамический кадр: " + name)
+        best, chain = 0, []
+        for callee in sorted(fn.callees):
+            depth, sub = walk(callee, stack + [name])
+            if depth > best:
+                best, chain = depth, sub
+        memo[name] = (fn.frame + best, [name] + chain)
+        return memo[name]
+
+    depth, chain = walk(root, [])
+    return depth, chain, sorted(warnings)
+
+
+def parse_vectors(startup):
+    """Имена обработчиков из секции .isr_vector (без _estack и Reset_Handler)."""
+    handlers = []
+    in_vectors = False
+    with open(startup, encoding="utf-8") as f:
+        for line in f:
+            if line.strip().startswith("__Vectors:"):
+                in_vectors = True
+                continue
+            if in_vectors:
+                if line.strip().startswith(".section") or line.strip().startswith("/****"):
+                    break
+                m = VECTOR_RE.match(line)
+                if m and m.group(1) not in ("_estack", "Reset_Handler"):
+                    handlers.append(m.group(1))
+    return handlers
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--objdir", required=True, help="каталог с объектными файлами и *.ci")
+    ap.add_argument("--startup", required=True, help="startup-файл с таблицей векторов")
+    ap.add_argument("--tasks", default="", help="точки входа задач через ';'")
+    ap.add_argument("--header", required=True)
+    ap.add_argument("--report", required=True)
+    ap.add_argument("--margin", type=int, default=25, help="запас в процентах")
+    ap.add_argument("--unknown", type=int, default=64,
+                    help="сколько байт закладывать на функцию без данных (libc, asm)")
+    args = ap.parse_args()
+
+    ci_files = []
+    for root, _, files in os.walk(args.objdir):
+        ci_files += [os.path.join(root, f) for f in files if f.endswith(".ci")]
+    if not ci_files:
+        print("stack_usage: не найдено ни одного .ci в " + args.objdir, file=sys.stderr)
+        return 1
+
+    funcs = load_graph(ci_files)
+    tasks = [t for t in args.tasks.split(";") if t]
+    handlers = [h for h in parse_vectors(args.startup) if h in funcs]
+
+    report = ["Stack usage report (bytes)", ""]
+    header = [
+        "/* Сгенерировано tools/stack_usage.py, не редактировать */",
+        "#pragma once",
+        "",
+    ]
+
+    report.append("Tasks (frame + context %d B, margin %d%%):" % (CONTEXT_BYTES, args.margin))
+    for task in tasks:
+        depth, chain, warns = worst_path(funcs, task, args.unknown)
+        total = depth + CONTEXT_BYTES
+        words = (total * (100 + args.margin) // 100 + 3) // 4
+        header.append("#define STACK_SIZE_%-24s %5du /* слов%s */"
+                      % (task, words, ", неточно" if warns else ""))
+        header.append("#define STACK_DEPTH_%-23s %5du /* байт без запаса */" % (task, total))
+        report.append("  %-28s %6d  %s" % (task, total, " -> ".join(chain)))
+        report += ["      ! " + w for w in warns]
+
+    report += ["", "Interrupt handlers (main stack, + exception frame %d B):" % EXCEPTION_FRAME_BYTES]
+    isr_sum = 0
+    isr_max = 0
+    for handler in handlers:
+        depth, chain, warns = worst_path(funcs, handler, args.unknown)
+        total = depth + EXCEPTION_FRAME_BYTES
+        isr_sum += total
+        isr_max = max(isr_max, total)
+        report.append("  %-28s %6d  %s" % (handler, total, " -> ".join(chain)))
+        report += ["      ! " + w for w in warns]
+
+    main_depth, main_chain, main_warns = worst_path(funcs, "main", args.unknown)
+    report += [
+        "",
+        "main                           %6d  %s" % (main_depth, " -> ".join(main_chain)),
+        "worst single ISR               %6d" % isr_max,
+        "all ISRs nested (upper bound)  %6d" % isr_sum,
+    ]
+    report += ["      ! " + w for w in main_warns]
+
+    # После запуска планировщика MSP используют только прерывания,
+    # до запуска - main. Берем худшее из двух.
+    msp = max(main_depth, isr_sum)
+    header += [
+        "",
+        "/* Худшая глубина основного стека (MSP) в байтах, все прерывания вложены */",
+        "#define STACK_SIZE_MAIN_BYTES            %5du" % (msp * (100 + args.margin) // 100),
+        "",
+    ]
+
+    os.makedirs(os.path.dirname(os.path.abspath(args.header)), exist_ok=True)
+    new_header = "\n".join(header)
+    old_header = None
+    if os.path.exists(args.header):
+        with open(args.header, encoding="utf-8") as f:
+            old_header = f.read()
+    # Не трогаем заголовок без изменений, иначе каждая сборка пересобирает app.c
+    if new_header != old_header:
+        with open(args.header, "w", encoding="utf-8") as f:
+            f.write(new_header)
+    with open(args.report, "w", encoding="utf-8") as f:
+        f.write("\n".join(report) + "\n")
+    print("\n".join(report))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
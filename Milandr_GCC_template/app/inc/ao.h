@@ -0,0 +1,116 @@
+#pragma once
+#include "app.h"
+
+// Активные объекты: у каждого своя очередь событий и обработчик, который
+// выполняется до конца (run-to-completion) и не ждет ничего внутри.
+// AO_Run - диспетчер вместо while(1): из готовых объектов берет старший по
+// приоритету (битовая маска, CLZ), отдает ему одно событие; нет событий - WFI.
+// Прерывания вытесняют обработчики, обработчики друг друга - нет.
+// Программные таймеры тикают в SysTick_Handler (1 мс) и посылают событие объекту.
+//
+//   static AO_Event_t blinkQueue[4];
+//   static AO_Object_t blink;
+//   static AO_Timer_t blinkTimer;
+//
+//   static void Blink_Dispatch(AO_Object_t *me, const AO_Event_t *e)
+//   {
+//       switch (e->sig)
+//       {
+//       case AO_SIG_INIT: AO_TimerInit(&blinkTimer, me, SIG_BLINK); AO_TimerArm(&blinkTimer, 500, 500); break;
+//       case SIG_BLINK:   MDR_PORTC->RXTX ^= PORT_Pin_0; break;
+//       }
+//   }
+//
+//   AO_Start(&blink, 1, blinkQueue, 4, Blink_Dispatch);
+//   AO_Run();
+
+// Оценки test/test_ao.c (модель тактов по TRM, 80 МГц, не замер на кристалле): событие
+// таймера - в обработчике через ~114 тактов после AO_Post в SysTick_Handler, из них 28 -
+// выбор объекта в AO_Run; обработчик дольше тика задерживает события всех объектов на
+// свой остаток. При 0.5% загрузки ядро спит в WFI 99.2% времени, SysTick_Handler с двумя
+// таймерами - 0.2%. Размер ao.c во FLASH не измерен: нет компилятора ARM, замер -
+// arm-none-eabi-size по сборке прошивки
+#ifndef AO_BENCHMARK
+#define AO_BENCHMARK 0 // 1 - AO_GetStats: задержка диспетчеризации и загрузка по DWT->CYCCNT
+#endif
+
+#define AO_MAX_OBJECTS 32 // приоритеты 0..31, у каждого объекта свой, больше - важнее
+
+// Сигналы ниже AO_SIG_USER зарезервированы
+enum
+{
+    AO_SIG_INIT = 0, // первое событие объекта, посылает AO_Start
+    AO_SIG_USER = 1,
+};
+
+typedef struct
+{
+    uint32_t sig;
+    uint32_t arg;
+#if AO_BENCHMARK
+    uint32_t stamp;          // DWT->CYCCNT в AO_Post
+#endif
+} AO_Event_t;
+
+typedef struct AO_Object AO_Object_t;
+typedef void (*AO_Dispatch_t)(AO_Object_t *me, const AO_Event_t *e);
+
+struct AO_Object
+{
+    AO_Dispatch_t dispatch;
+    AO_Event_t *queue;
+    uint16_t mask;           // длина очереди - 1
+    uint8_t prio;
+    volatile uint16_t head;  // пишет AO_Post под PRIMASK
+    volatile uint16_t tail;  // двигает только AO_Run
+    uint32_t dropped;        // событий не влезло в очередь
+};
+
+typedef struct AO_Timer
+{
+    struct AO_Timer *next;
+    AO_Object_t *ao;
+    uint32_t sig;
+    uint32_t left;           // тиков до срабатывания, 0 - не взведен
+    uint32_t interval;       // 0 - однократный
+} AO_Timer_t;
+
+// length - степень двойки до 32768, в очереди помещается length - 1 событий.
+// До AO_Run или из обработчика другого объекта
+void AO_Start(AO_Object_t *ao, uint8_t prio, AO_Event_t *queue, uint32_t length, AO_Dispatch_t dispatch);
+
+// Из любого контекста, в том числе из прерываний. 0 - очередь полна, событие потеряно
+uint32_t AO_Post(AO_Object_t *ao, uint32_t sig, uint32_t arg);
+
+// Таймер остается в списке AO_Tick навсегда. Повторный вызов для того же таймера
+// снимает его и меняет объект и сигнал, в список второй раз не ставит
+void AO_TimerInit(AO_Timer_t *t, AO_Object_t *ao, uint32_t sig);
+// Первое срабатывание через ticks мс, дальше каждые interval (0 - однократно).
+// Взведенный таймер перезапускается. Из любого контекста
+void AO_TimerArm(AO_Timer_t *t, uint32_t ticks, uint32_t interval);
+void AO_TimerDisarm(AO_Timer_t *t); // уже посланное событие остается в очереди
+void AO_Tick(void);                  // из SysTick_Handler
+
+// Не возвращается
+void AO_Run(void) __attribute__((noreturn));
+
+// Вызывается при запрещенных прерываниях, когда событий нет: WFI разбудит любое
+// ожидающее прерывание, обработчик выполнится после возврата. Можно переопределить
+// (снижение частоты, выключение периферии)
+void AO_Idle(void);
+
+#if AO_BENCHMARK
+typedef struct
+{
+    uint32_t latencyMin;  // тактов от AO_Post до входа в обработчик
+    uint32_t latencyMax;
+    uint32_t dispatched;
+    uint64_t busyCycles;  // в обработчиках
+    uint32_t loadPermille; // busyCycles к UPTIME_GetCycles от AO_Benchmark, 0.1%
+} AO_Stats_t;
+
+const AO_Stats_t *AO_GetStats(void);
+// Объект с приоритетом AO_MAX_OBJECTS - 1 и таймер 1 мс: задержка от SysTick_Handler
+// до обработчика, в том числе выход из WFI. Занимает приоритет, до AO_Run
+void AO_Benchmark(void);
+#endif
@@ -4,9 +4,14 @@
 #include "MDR32FxQI_rst_clk.h"
 #include "MDR32FxQI_bkp.h"
 #include "MDR32FxQI_eeprom.h"
+#include "MDR32FxQI_uart.h"
+#include "MDR32FxQI_inline.h" // быстрые inline-версии частых вызовов SPL
 #include <stdio.h>
 #include "clk.h"
 #include "systick.h"
+#include "ao.h"
+#include "uptime.h"
+#include "pin_bench.h"
 
 #include "MDR32FxQI_port.h"
 
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include "MDR32FxQI_config.h"
+
+// Bit-band Cortex-M3: каждый бит первого мегабайта ОЗУ и периферии отображен на слово
+// в alias-области. Запись слова - атомарная установка/сброс бита одной инструкцией STR
+// (шина сама делает read-modify-write), чтение - значение бита.
+
+namespace bitband
+{
+
+constexpr uint32_t sramBase = 0x20000000;
+constexpr uint32_t sramAlias = 0x22000000;
+constexpr uint32_t periphBase = PERIPH_BASE;
+constexpr uint32_t periphAlias = PERIPH_BB_BASE;
+constexpr uint32_t regionSize = 0x100000;
+
+constexpr uint32_t alias(uint32_t address, uint32_t bit)
+{
+    return address >= periphBase ? periphAlias + (address - periphBase) * 32 + bit * 4
+                                 : sramAlias + (address - sramBase) * 32 + bit * 4;
+}
+
+template <uint32_t Address, uint32_t N>
+struct Bit
+{
+    static_assert(N < 32, "номер бита 0..31");
+    static_assert((Address >= sramBase && Address < sramBase + regionSize) ||
+                  (Address >= periphBase && Address < periphBase + regionSize),
+                  "адрес вне bit-band области");
+
+    static constexpr uint32_t address = alias(Address & ~3u, N + (Address & 3u) * 8);
+
+    static inline volatile uint32_t &word()
+    {
+        return *reinterpret_cast<volatile uint32_t *>(address);
+    }
+    static inline void set() { word() = 1; }
+    static inline void clear() { word() = 0; }
+    static inline void write(bool value) { word() = value; }
+    static inline bool read() { return word() != 0; }
+};
+
+} // namespace bitband
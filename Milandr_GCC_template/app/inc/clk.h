@@ -1,11 +1,19 @@
 #pragma once
 #include "app.h"
 
-// на моей плате кварц стоит на 16мгц поэтому нужен такой костыль. если у вас 8 - закомментировать блок ниже.
-#ifdef HSE_Value 
+#include "clk_config.h"
+
+// HSE_Value из MDR32FxQI_config.h - 8 МГц, кварц платы задается CLK_HSE_HZ в CMakeLists.txt
+#ifdef HSE_Value
 #undef HSE_Value
-#define HSE_Value ((uint32_t)16000000) 
+#define HSE_Value ((uint32_t)CLK_HSE_HZ)
 #endif
 
 
-void CLK_Init_80_mhz(void);
\ No newline at end of file
+// HSE, PLL, латентность и регулятор по CLK_Config, ждет запуска HSE и PLL
+void CLK_Init(void);
+// Делители и разрешения тактирования UART/SSP/CAN/TIMER по CLK_Config
+void CLK_InitPeripherals(void);
+// UART_Init без RST_CLK_GetClocksFreq и деления: IBRD/FBRD из CLK_Config,
+// init->UART_BaudRate должен совпадать с CLK_UARTn_BAUD
+void CLK_UARTInit(MDR_UART_TypeDef *UARTx, const UART_InitTypeDef *init);
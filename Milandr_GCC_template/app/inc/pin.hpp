@@ -0,0 +1,186 @@
+#pragma once
+#include <cstddef>
+#include "bitband.hpp"
+#include "MDR32FxQI_port.h"
+
+// Порты без PORT_Init и PORT_SetBits. Маски и значения регистров считаются при компиляции,
+// настройка группы пинов - одна запись на регистр порта (PORT_Init пишет OE, FUNC и
+// ANALOG дважды), установка и сброс одиночного
+// пина - запись в bit-band alias (атомарно, можно из прерываний).
+//
+//   using Led = gpio::Pin<MDR_PORTC_BASE, 0>;
+//   using Bus = gpio::PinGroup<gpio::Pin<MDR_PORTA_BASE, 0>, gpio::Pin<MDR_PORTA_BASE, 1>>;
+//   Led::init<gpio::output>();
+//   Led::set();
+//
+// Тактирование порта (RST_CLK_PCLKcmd) включается как обычно.
+
+namespace gpio
+{
+
+#if defined(USE_JTAG_A)
+constexpr uint32_t jtagPort = MDR_PORTB_BASE;
+#elif defined(USE_JTAG_B)
+constexpr uint32_t jtagPort = MDR_PORTD_BASE;
+#else
+constexpr uint32_t jtagPort = 0;
+#endif
+constexpr uint32_t jtagPins = 0x1F; // PORT_JTAG_Msk
+
+// Поля PORT_InitTypeDef без PORT_Pin
+struct Config
+{
+    PORT_OE_TypeDef oe = PORT_OE_IN;
+    PORT_MODE_TypeDef mode = PORT_MODE_DIGITAL;
+    PORT_FUNC_TypeDef func = PORT_FUNC_PORT;
+    PORT_SPEED_TypeDef speed = PORT_OUTPUT_OFF;
+    PORT_PULL_UP_TypeDef pullUp = PORT_PULL_UP_OFF;
+    PORT_PULL_DOWN_TypeDef pullDown = PORT_PULL_DOWN_OFF;
+    PORT_PD_TypeDef pd = PORT_PD_DRIVER;
+    PORT_PD_SHM_TypeDef shm = PORT_PD_SHM_OFF;
+    PORT_GFEN_TypeDef gfen = PORT_GFEN_OFF;
+};
+
+constexpr Config input = {};
+constexpr Config output = {.oe = PORT_OE_OUT, .speed = PORT_SPEED_MAXFAST};
+constexpr Config analog = {.mode = PORT_MODE_ANALOG};
+
+// Бит на пин -> два бита на пин (FUNC, PWR)
+constexpr uint32_t spread2(uint32_t mask, uint32_t value)
+{
+    uint32_t result = 0;
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        if (mask & (1u << i))
+        {
+            result |= value << (i * 2);
+        }
+    }
+    return result;
+}
+
+template <uint32_t Base, uint32_t Mask>
+struct Port
+{
+    static_assert(Mask != 0 && (Mask & 0xFFFF0000u) == 0, "пины 0..15");
+    static_assert(Base != jtagPort || (Mask & jtagPins) == 0, "пины JTAG не трогаем");
+
+    static inline MDR_PORT_TypeDef *regs()
+    {
+        return reinterpret_cast<MDR_PORT_TypeDef *>(Base);
+    }
+
+    static inline void modify(volatile uint32_t &reg, uint32_t clear, uint32_t set)
+    {
+        reg = (reg & ~clear) | set;
+    }
+
+    // Настройка - параметр шаблона, маски сброса и значения каждого регистра - constexpr,
+    // на каждый регистр одно чтение и одна запись. Выход отключается записью OE до
+    // остальных регистров, включается ею же после них; если пин уже был выходом и
+    // остается им, OE не трогается и остальное меняется на ходу
+    template <Config C>
+    static inline void init()
+    {
+        constexpr uint32_t m = Mask;
+        constexpr uint32_t m2 = spread2(Mask, 3);
+        constexpr uint32_t pullSet = (C.pullDown ? m : 0) | (C.pullUp ? m << 16 : 0);
+        constexpr uint32_t pwrSet = spread2(m, C.speed);
+        constexpr uint32_t pdSet = (C.pd ? m : 0) | (C.shm ? m << 16 : 0);
+        constexpr uint32_t gfenSet = C.gfen ? m : 0;
+        constexpr uint32_t analogSet = C.mode ? m : 0;
+        constexpr uint32_t funcSet = spread2(m, C.func);
+        MDR_PORT_TypeDef *port = regs();
+
+        if constexpr (C.oe == PORT_OE_IN)
+        {
+            modify(port->OE, m, 0);
+        }
+        modify(port->PULL, m | (m << 16), pullSet);
+        modify(port->PWR, m2, pwrSet);
+        modify(port->PD, m | (m << 16), pdSet);
+        modify(port->GFEN, m, gfenSet);
+        modify(port->ANALOG, m, analogSet);
+        modify(port->FUNC, m2, funcSet);
+        if constexpr (C.oe == PORT_OE_OUT)
+        {
+            modify(port->OE, 0, m);
+        }
+    }
+
+    static inline uint32_t read()
+    {
+        return regs()->RXTX & Mask;
+    }
+
+    // Не атомарно: read-modify-write всего RXTX
+    static inline void write(uint32_t bits)
+    {
+        uint32_t rxtx = regs()->RXTX & ~Mask;
+        if constexpr (Base == jtagPort)
+        {
+            rxtx &= ~jtagPins; // как PORT_SetBits
+        }
+        regs()->RXTX = rxtx | (bits & Mask);
+    }
+};
+
+template <uint32_t Base, uint32_t N>
+struct Pin : Port<Base, 1u << N>
+{
+    static constexpr uint32_t base = Base;
+    static constexpr uint32_t mask = 1u << N;
+    using RXTX = bitband::Bit<Base + offsetof(MDR_PORT_TypeDef, RXTX), N>;
+
+    // На порту JTAG bit-band вернул бы в RXTX прочитанные биты JTAG, там запись как в SPL
+    static inline void set()
+    {
+        if constexpr (Base == jtagPort)
+        {
+            Port<Base, mask>::write(mask);
+        }
+        else
+        {
+            RXTX::set();
+        }
+    }
+    static inline void clear()
+    {
+        if constexpr (Base == jtagPort)
+        {
+            Port<Base, mask>::write(0);
+        }
+        else
+        {
+            RXTX::clear();
+        }
+    }
+    static inline void write(bool value)
+    {
+        value ? set() : clear();
+    }
+    static inline bool read()
+    {
+        return RXTX::read();
+    }
+    // Чтение и запись - две операции, между ними пин может поменять прерывание
+    static inline void toggle()
+    {
+        write(!read());
+    }
+};
+
+template <class... Pins>
+struct PinGroup : Port<(Pins::base, ...), (Pins::mask | ...)>
+{
+    static constexpr uint32_t base = (Pins::base, ...);
+    static constexpr uint32_t mask = (Pins::mask | ...);
+    static_assert(((Pins::base == base) && ...), "все пины группы на одном порту");
+    static_assert((Pins::mask + ...) == mask, "пин в группе дважды");
+
+    // По пину за инструкцию, каждый атомарно
+    static inline void set() { (Pins::set(), ...); }
+    static inline void clear() { (Pins::clear(), ...); }
+};
+
+} // namespace gpio
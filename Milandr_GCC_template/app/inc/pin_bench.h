@@ -0,0 +1,37 @@
+#ifndef _PIN_BENCH_H_
+#define _PIN_BENCH_H_
+
+#include <stdint.h>
+
+#ifndef PIN_BENCHMARK
+#define PIN_BENCHMARK 0 // 1 - PIN_Benchmark: pin.hpp, SPL и MDR32FxQI_inline.h на PC0 по DWT->CYCCNT
+#endif
+
+#if PIN_BENCHMARK
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Тактов на вызов, цикл замера вычтен
+typedef struct
+{
+    uint32_t pinSet;        // Pin::set / clear, запись в bit-band alias
+    uint32_t splSet;        // PORT_SetBits / PORT_ResetBits
+    uint32_t inlineSet;     // PORT_SetBits_Inline / PORT_ResetBits_Inline
+    uint32_t pinToggle;     // Pin::toggle
+    uint32_t splToggle;     // PORT_ReadInputDataBit + PORT_WriteBit
+    uint32_t inlineToggle;  // PORT_ReadInputDataBit_Inline + PORT_SetBits_Inline / PORT_ResetBits_Inline
+    uint32_t pinInit;       // Pin::init<gpio::output>
+    uint32_t splInit;       // PORT_Init с той же настройкой
+} PIN_Stats_t;
+
+// PC0 становится выходом и дергается; вызывать до того, как пин занят приложением.
+// Прерывания на время замера запрещены
+const PIN_Stats_t *PIN_Benchmark(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
+#endif /*_PIN_BENCH_H_*/
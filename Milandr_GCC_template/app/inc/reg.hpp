@@ -0,0 +1,141 @@
+#pragma once
+#include <cstdint>
+#include "bitband.hpp"
+
+// Типизированный доступ к регистрам. Описания регистров и полей генерирует
+// tools/svd_regs.py из MDR32F9Q2I.svd (generated/mdr_regs.hpp), здесь - общая часть.
+//
+//   using CPU_CLOCK = mdr::RST_CLK::CPU_CLOCK;
+//   CPU_CLOCK::write(CPU_CLOCK::CPU_C1_SEL::HSE, CPU_CLOCK::HCLK_SEL::CPU_C3); // одна STR константы
+//   CPU_CLOCK::modify(CPU_CLOCK::CPU_C3_SEL::value(div));                      // LDR, BFI/ORR, STR
+//   mdr::RST_CLK::HS_CONTROL::HSE_ON::set();                                   // bit-band
+//
+// Маски и значения полей складываются при компиляции. Поля чужого регистра, повтор поля,
+// запись в read-only и чтение write-only - ошибки компиляции.
+
+namespace reg
+{
+
+enum class Access
+{
+    ReadWrite,
+    ReadOnly,
+    WriteOnly,
+};
+
+template <typename F>
+struct Value
+{
+    uint32_t bits;
+};
+
+template <uint32_t Address, Access A, uint32_t Reset>
+struct Register
+{
+    static constexpr uint32_t address = Address;
+    static constexpr Access access = A;
+    static constexpr uint32_t reset = Reset;
+
+    static inline volatile uint32_t &word()
+    {
+        return *reinterpret_cast<volatile uint32_t *>(Address);
+    }
+
+    static inline uint32_t read()
+        requires(A != Access::WriteOnly)
+    {
+        return word();
+    }
+
+    static inline void write(uint32_t value)
+        requires(A != Access::ReadOnly)
+    {
+        word() = value;
+    }
+
+    // Поля, которых нет в списке, получают значение после сброса
+    template <typename... F>
+    static inline void write(Value<F>... values)
+        requires(A != Access::ReadOnly && sizeof...(F) > 0)
+    {
+        check<F...>();
+        word() = (reset & ~(F::mask | ...)) | (values.bits | ...);
+    }
+
+    // Чтение-модификация-запись, остальные поля не меняются
+    template <typename... F>
+    static inline void modify(Value<F>... values)
+        requires(A == Access::ReadWrite && sizeof...(F) > 0)
+    {
+        check<F...>();
+        word() = (word() & ~(F::mask | ...)) | (values.bits | ...);
+    }
+
+private:
+    template <typename... F>
+    static constexpr void check()
+    {
+        static_assert(((F::address == Address) && ...), "поле другого регистра");
+        static_assert((F::mask + ...) == (F::mask | ...), "поле указано дважды");
+        static_assert(((F::access != Access::ReadOnly) && ...), "поле только для чтения");
+    }
+};
+
+template <typename Reg, uint32_t Pos, uint32_t Width, Access A>
+struct Field
+{
+    static_assert(Pos + Width <= 32, "поле за границей регистра");
+
+    static constexpr uint32_t address = Reg::address;
+    static constexpr uint32_t pos = Pos;
+    static constexpr uint32_t width = Width;
+    static constexpr uint32_t mask = (Width == 32 ? ~0u : (1u << Width) - 1) << Pos;
+    static constexpr Access access = A;
+
+    // Значение шире поля обрезается по маске
+    static constexpr Value<Field> value(uint32_t v)
+    {
+        return {(v << Pos) & mask};
+    }
+
+    static inline uint32_t read()
+        requires(A != Access::WriteOnly)
+    {
+        return (Reg::read() & mask) >> Pos;
+    }
+
+    static inline void write(uint32_t v)
+        requires(A != Access::ReadOnly)
+    {
+        Reg::write(value(v));
+    }
+
+    static inline void modify(uint32_t v)
+        requires(A != Access::ReadOnly)
+    {
+        Reg::modify(value(v));
+    }
+
+    // Однобитные поля - через bit-band: атомарно, без чтения регистра в ядро.
+    // Шина все равно читает регистр, поэтому только для read-write регистров
+    // (у write-only чтение не определено, флаги write-1-to-clear сбросятся соседние).
+    static inline void set()
+        requires(Width == 1 && Reg::access == Access::ReadWrite && A == Access::ReadWrite)
+    {
+        bitband::Bit<Reg::address, Pos>::set();
+    }
+
+    static inline void clear()
+        requires(Width == 1 && Reg::access == Access::ReadWrite && A == Access::ReadWrite)
+    {
+        bitband::Bit<Reg::address, Pos>::clear();
+    }
+
+    static inline bool test()
+        requires(Width == 1 && A != Access::WriteOnly)
+    {
+        return bitband::Bit<Reg::address, Pos>::read();
+    }
+};
+
+} // namespace reg
@@ -1,6 +1,7 @@
 #pragma once
 #include "app.h"
-extern uint64_t millis;
-void initSystick(); //расчитано на 80 МГц
-uint64_t GetTick(); // как в HAL
-volatile void delay(uint32_t ms); // задержка в милисекундах
+extern volatile uint64_t millis; // 64 бита читаются не атомарно - GetTick
+void initSystick(); // тик 1 мс на CLK_CPU_HZ
+uint64_t GetTick(); // как в HAL, из любого контекста. Мкс и такты - uptime.h
+volatile void delay(uint32_t ms); // задержка в милисекундах, ядро спит между тиками.
+                                  // В обработчиках ao.h не вызывать - таймеры AO_Timer_t
@@ -0,0 +1,54 @@
+#pragma once
+#include "app.h"
+
+// Монотонное время с initSystick: тики SysTick плюс текущее значение его счетчика.
+// 64 бита без разрывов из любого контекста - основной цикл, обработчики ao.h, прерывания
+// любого приоритета - без запрета прерываний. Тик пишет
+// новый снимок в свободную из двух ячеек и меняет номер, чтение повторяется, если номер
+// сменился, пока оно шло. Перезагрузку SysTick, чей тик ждет снятия маски (PENDSTSET) или
+// вытеснен до публикации снимка (SYSTICKACT), чтение учитывает само. Условие: прерывания
+// не замаскированы дольше тика подряд.
+// Мкс поправляются на уход кварца, измеренный по RTC.
+
+#ifndef UPTIME_RTC_HZ
+#define UPTIME_RTC_HZ 32768 // RTC от LSE
+#endif
+#define UPTIME_RTC_EDGE_US 100 // RTC_DIV не сменился за это время - RTC стоит
+#define UPTIME_TICK_HZ 1000
+
+uint64_t UPTIME_GetUs(void);
+uint64_t UPTIME_GetCycles(void); // такты ядра
+uint64_t UPTIME_GetTicks(void);  // мс, GetTick
+
+// Калибровка по RTC: счетчик RTC уже идет от LSE (BKP_RTCclkSource(BKP_RTC_LSEclk)),
+// RTC_DIV считает 0..RTC_PRL-1. Между Start и Finish - от секунды, погрешность около
+// 1 мкс на интервал (10 с - 0.1 ppm). Каждая ждет фронт RTC_DIV с запрещенными
+// прерываниями, до 1 / UPTIME_RTC_HZ. Поправка применяется со следующего тика.
+ErrorStatus UPTIME_CalibrateStart(void);
+ErrorStatus UPTIME_CalibrateFinish(int32_t *ppm); // ppm - уход частоты ядра от номинала
+void UPTIME_SetPpm(int32_t ppm);                   // например, сохраненная в BKP
+
+// Для systick.c: запуск SysTick на частоте ядра hz, тик - первым делом в SysTick_Handler,
+// UPTIME_TickEnd - последним
+void UPTIME_Start(uint32_t hz);
+void UPTIME_Tick(void);
+void UPTIME_TickEnd(void);
+
+#ifndef UPTIME_TORTURE
+#define UPTIME_TORTURE 0 // 1 - UPTIME_Torture
+#endif
+
+#if UPTIME_TORTURE
+typedef struct
+{
+    uint32_t reads;     // чтений в цикле
+    uint32_t isrReads;  // чтений из прерывания TIMER3
+    uint32_t backwards; // время пошло назад: должно быть 0
+    uint32_t maxStepUs; // наибольший шаг между соседними чтениями цикла
+} UPTIME_Torture_t;
+
+// Цикл чтений ms миллисекунд под прерываниями TIMER3 с приоритетом 0 и случайным
+// периодом: чтения попадают внутрь тика и на перезагрузку SysTick. До AO_Run,
+// TIMER3 не должен быть занят
+const UPTIME_Torture_t *UPTIME_Torture(uint32_t ms);
+#endif
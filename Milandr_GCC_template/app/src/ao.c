@@ -0,0 +1,192 @@
+#include "ao.h"
+
+static AO_Object_t *objects[AO_MAX_OBJECTS];
+static volatile uint32_t ready;  // бит prio - в очереди объекта есть события
+static AO_Timer_t *timers;       // все таймеры после AO_TimerInit, взведенные и нет
+
+#if AO_BENCHMARK
+static AO_Stats_t stats = {.latencyMin = UINT32_MAX};
+#endif
+
+void AO_Start(AO_Object_t *ao, uint8_t prio, AO_Event_t *queue, uint32_t length, AO_Dispatch_t dispatch)
+{
+    assert_param(prio < AO_MAX_OBJECTS && objects[prio] == NULL);
+    assert_param(length >= 2 && length <= 32768 && (length & (length - 1)) == 0);
+
+    ao->dispatch = dispatch;
+    ao->queue = queue;
+    ao->mask = length - 1;
+    ao->prio = prio;
+    ao->head = 0;
+    ao->tail = 0;
+    ao->dropped = 0;
+    objects[prio] = ao;
+    AO_Post(ao, AO_SIG_INIT, 0);
+}
+
+uint32_t AO_Post(AO_Object_t *ao, uint32_t sig, uint32_t arg)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint32_t head;
+    AO_Event_t *e;
+
+    __disable_irq();
+    head = ao->head;
+    if (((head + 1) & ao->mask) == ao->tail)
+    {
+        ao->dropped++;
+        __set_PRIMASK(primask);
+        return 0;
+    }
+    e = &ao->queue[head];
+    e->sig = sig;
+    e->arg = arg;
+#if AO_BENCHMARK
+    e->stamp = DWT->CYCCNT;
+#endif
+    ao->head = (head + 1) & ao->mask;
+    ready |= 1UL << ao->prio;
+    __set_PRIMASK(primask);
+    return 1;
+}
+
+void AO_TimerInit(AO_Timer_t *t, AO_Object_t *ao, uint32_t sig)
+{
+    uint32_t primask = __get_PRIMASK();
+    AO_Timer_t *p;
+
+    __disable_irq();
+    t->left = 0;
+    t->interval = 0;
+    t->ao = ao;
+    t->sig = sig;
+    // Уже в списке (повторный SIG_INIT, второй AO_Benchmark) - второе звено замкнуло бы
+    // список в кольцо, AO_Tick не вышел бы из SysTick_Handler
+    for (p = timers; p != NULL && p != t; p = p->next)
+    {
+    }
+    if (p == NULL)
+    {
+        t->next = timers;
+        timers = t;
+    }
+    __set_PRIMASK(primask);
+}
+
+void AO_TimerArm(AO_Timer_t *t, uint32_t ticks, uint32_t interval)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    t->interval = interval;
+    t->left = ticks != 0 ? ticks : 1;
+    __set_PRIMASK(primask);
+}
+
+void AO_TimerDisarm(AO_Timer_t *t)
+{
+    // Одна запись слова, AO_Tick ее не разорвет
+    t->left = 0;
+}
+
+void AO_Tick(void)
+{
+    for (AO_Timer_t *t = timers; t != NULL; t = t->next)
+    {
+        if (t->left != 0 && --t->left == 0)
+        {
+            t->left = t->interval;
+            AO_Post(t->ao, t->sig, 0);
+        }
+    }
+}
+
+__attribute__((weak)) void AO_Idle(void)
+{
+    __WFI();
+}
+
+void AO_Run(void)
+{
+    while (1)
+    {
+        AO_Object_t *ao;
+        AO_Event_t e;
+        uint32_t tail;
+
+        __disable_irq();
+        if (ready == 0)
+        {
+            // Прерывания запрещены до WFI: событие, посланное между проверкой и сном,
+            // оставит прерывание ожидающим, и WFI сразу вернется
+            AO_Idle();
+            __enable_irq();
+            continue;
+        }
+        ao = objects[31 - __CLZ(ready)];
+        tail = ao->tail;
+        e = ao->queue[tail];
+        tail = (tail + 1) & ao->mask;
+        ao->tail = tail;
+        if (tail == ao->head)
+        {
+            ready &= ~(1UL << ao->prio);
+        }
+        __enable_irq();
+
+#if AO_BENCHMARK
+        {
+            uint32_t start = DWT->CYCCNT;
+            uint32_t latency = start - e.stamp;
+
+            if (latency < stats.latencyMin)
+            {
+                stats.latencyMin = latency;
+            }
+            if (latency > stats.latencyMax)
+            {
+                stats.latencyMax = latency;
+            }
+            ao->dispatch(ao, &e);
+            stats.busyCycles += DWT->CYCCNT - start;
+            stats.dispatched++;
+        }
+#else
+        ao->dispatch(ao, &e);
+#endif
+    }
+}
+
+#if AO_BENCHMARK
+static AO_Event_t benchQueue[4];
+static AO_Object_t bench;
+static AO_Timer_t benchTimer;
+static uint64_t benchStart;
+
+static void AO_BenchDispatch(AO_Object_t *me, const AO_Event_t *e)
+{
+    if (e->sig == AO_SIG_INIT)
+    {
+        AO_TimerInit(&benchTimer, me, AO_SIG_USER);
+        AO_TimerArm(&benchTimer, 1, 1);
+    }
+}
+
+void AO_Benchmark(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    benchStart = UPTIME_GetCycles();
+    AO_Start(&bench, AO_MAX_OBJECTS - 1, benchQueue, 4, AO_BenchDispatch);
+}
+
+const AO_Stats_t *AO_GetStats(void)
+{
+    uint64_t cycles = UPTIME_GetCycles() - benchStart;
+
+    // Время - по SysTick: идет ли CYCCNT во время WFI, зависит от реализации ядра
+    stats.loadPermille = cycles != 0 ? (uint32_t)(stats.busyCycles * 1000 / cycles) : 0;
+    return &stats;
+}
+#endif
@@ -1,14 +1,18 @@
 #include "app.h"
 
-#define __ASM __asm
-#define __NOP() __ASM volatile("nop")
 int main(void)
 {
-  CLK_Init_80_mhz();
+  CLK_Init();
+  CLK_InitPeripherals();
   initSystick();
-  
-  while (1)
-  {
-    __NOP();
-  }
+
+  // AO_Start(...) - активные объекты приложения, пример в ao.h
+#if AO_BENCHMARK
+  AO_Benchmark();
+#endif
+#if PIN_BENCHMARK
+  (void)PIN_Benchmark(); // результат - в отладчике, PIN_Stats_t
+#endif
+
+  AO_Run(); // события объектов, без событий - сон до прерывания
 }
@@ -1,7 +1,7 @@
 #include "clk.h"
 
 
-void CLK_Init_80_mhz(void)
+void CLK_Init(void)
 {
     RST_CLK_DeInit();
 
@@ -9,33 +9,38 @@ void CLK_Init_80_mhz(void)
     RST_CLK_HSEconfig(RST_CLK_HSE_ON);
     while(RST_CLK_HSEstatus() == ERROR) {}
 
-    /* Configures the CPU_PLL clock source (CPU_CLK = HSE_CLK * 10 = 8 MHz * 10 = 80 MHz) */
-    RST_CLK_CPU_PLLconfig(RST_CLK_CPU_PLLsrcHSEdiv1, RST_CLK_CPU_PLLmul10);
-    /* Enables the CPU_PLL */
-    RST_CLK_CPU_PLLcmd(ENABLE);
-    while(RST_CLK_CPU_PLLstatus() == ERROR) {}
+    /* CPU_C1 = HSE, CPU_C2 = CPU_C1 * pllMul (множитель и делитель посчитаны в clk_config.cpp) */
+    RST_CLK_CPUclkSelectionC1(RST_CLK_CPU_C1srcHSEdiv1);
+    if (CLK_Config.cpu.pllMul > 1)
+    {
+        RST_CLK_CPU_PLLconfig(RST_CLK_CPU_PLLsrcHSEdiv1, (RST_CLK_CPU_PLL_Multiplier)(CLK_Config.cpu.pllMul - 1));
+        /* Enables the CPU_PLL */
+        RST_CLK_CPU_PLLcmd(ENABLE);
+        while(RST_CLK_CPU_PLLstatus() == ERROR) {}
 
-    /* Select the CPU_PLL output as input for CPU_C2_SEL */
-    RST_CLK_CPU_PLLuse(ENABLE);
-    /* Set CPUClk Prescaler (CPU_C3_SEL = CPU_C2) */
-    RST_CLK_CPUclkPrescaler(RST_CLK_CPUclkDIV1);
+        /* Select the CPU_PLL output as input for CPU_C2_SEL */
+        RST_CLK_CPU_PLLuse(ENABLE);
+    }
+    /* Set CPUClk Prescaler */
+    RST_CLK_CPUclkPrescaler(CLK_Config.cpu.c3Div);
 
     /* Enables the RST_CLK_PCLK_EEPROM */
     RST_CLK_PCLKcmd(RST_CLK_PCLK_EEPROM, ENABLE);
-    /* Sets the code latency value (CPU_CLK up to 100 MHz) */
-    EEPROM_SetLatency(EEPROM_Latency_3);
+    /* Sets the code latency value */
+    EEPROM_SetLatency(CLK_Config.cpu.latency);
     /* Disables the RST_CLK_PCLK_EEPROM */
     RST_CLK_PCLKcmd(RST_CLK_PCLK_EEPROM, DISABLE);
     
     /* Enables the RST_CLK_PCLK_BKP */
     RST_CLK_PCLKcmd(RST_CLK_PCLK_BKP, ENABLE);
-    /* Setting the parameters of the voltage regulator SelectRI and LOW in the BKP controller (CPU_CLK = 80 MHz) */
-    BKP_DUccMode(BKP_DUcc_upto_80MHz);
+    /* Setting the parameters of the voltage regulator SelectRI and LOW in the BKP controller */
+    BKP_DUccMode(CLK_Config.cpu.ducc);
 
     /* Select the CPU clock source */
     RST_CLK_CPUclkSelection(RST_CLK_CPUclkCPU_C3);
 
-    SystemCoreClockUpdate();
+    // SystemCoreClockUpdate считает от HSE_Value из MDR32FxQI_config.h, а не от CLK_HSE_HZ
+    SystemCoreClock = CLK_Config.cpu.hz;
     // MDR_RST_CLK->HS_CONTROL |= 0b01; //включить HSE
     // while(MDR_RST_CLK->CLOCK_STATUS & RST_CLK_CLOCK_STATUS_HSE_RDY != 1); //ждем запуска HSE
 
@@ -53,4 +58,24 @@ void CLK_Init_80_mhz(void)
     
 
     // MDR_RST_CLK->CPU_CLOCK |= 0b01 << RST_CLK_CPU_CLOCK_HCLK_SEL_Pos; // CPU_C3 - HCLK
-}
\ No newline at end of file
+}
+
+void CLK_InitPeripherals(void)
+{
+    MDR_RST_CLK->UART_CLOCK = CLK_Config.uartClock;
+    MDR_RST_CLK->SSP_CLOCK = CLK_Config.sspClock;
+    MDR_RST_CLK->CAN_CLOCK = CLK_Config.canClock;
+    MDR_RST_CLK->TIM_CLOCK = CLK_Config.timClock;
+}
+
+void CLK_UARTInit(MDR_UART_TypeDef *UARTx, const UART_InitTypeDef *init)
+{
+    const CLK_UartConfig_t *config = &CLK_Config.uart[UARTx == MDR_UART1 ? 0 : 1];
+
+    CLK_ASSERT(config->baud == init->UART_BaudRate); // делители посчитаны для config->baud
+    UARTx->CR = init->UART_HardwareFlowControl;
+    UARTx->IBRD = config->ibrd;
+    UARTx->FBRD = config->fbrd;
+    // Запись LCR_H защелкивает IBRD/FBRD
+    UARTx->LCR_H = init->UART_WordLength | init->UART_StopBits | init->UART_Parity | init->UART_FIFOMode;
+}
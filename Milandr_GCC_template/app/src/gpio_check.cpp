@@ -0,0 +1,33 @@
+#include "pin.hpp"
+
+// Проверки bitband.hpp и pin.hpp при компиляции прошивки, кода не дают.
+// Alias по TRM Cortex-M3: база alias + смещение байта * 32 + номер бита * 4
+
+// Границы обеих областей
+static_assert(bitband::Bit<0x20000000, 0>::address == 0x22000000);
+static_assert(bitband::Bit<0x200FFFFC, 31>::address == 0x23FFFFFC);
+static_assert(bitband::Bit<0x40000000, 0>::address == 0x42000000);
+static_assert(bitband::Bit<0x400FFFFC, 31>::address == 0x43FFFFFC);
+// Адрес байта внутри слова: бит 0 байта 1 - бит 8 слова
+static_assert(bitband::Bit<0x20000001, 0>::address == bitband::Bit<0x20000000, 8>::address);
+static_assert(bitband::Bit<MDR_PORTC_BASE + 2, 7>::address == bitband::Bit<MDR_PORTC_BASE, 23>::address);
+
+// RXTX - первое слово порта
+using PC0 = gpio::Pin<MDR_PORTC_BASE, 0>;
+using PA15 = gpio::Pin<MDR_PORTA_BASE, 15>;
+static_assert(PC0::mask == 0x0001 && PC0::base == MDR_PORTC_BASE);
+static_assert(PC0::RXTX::address == 0x43700000);
+static_assert(PA15::mask == 0x8000 && PA15::RXTX::address == 0x43500000 + 15 * 4);
+
+// Два бита на пин в FUNC и PWR
+static_assert(gpio::spread2(0x0001, PORT_SPEED_MAXFAST) == 0x00000003);
+static_assert(gpio::spread2(0x8001, PORT_FUNC_ALTER) == 0x80000002);
+static_assert(gpio::spread2(0x00F0, PORT_SPEED_SLOW) == 0x00005500);
+
+using Bus = gpio::PinGroup<gpio::Pin<MDR_PORTA_BASE, 0>, gpio::Pin<MDR_PORTA_BASE, 3>, gpio::Pin<MDR_PORTA_BASE, 7>>;
+static_assert(Bus::mask == 0x0089 && Bus::base == MDR_PORTA_BASE);
+
+// Готовые настройки
+static_assert(gpio::output.oe == PORT_OE_OUT && gpio::output.speed == PORT_SPEED_MAXFAST);
+static_assert(gpio::input.oe == PORT_OE_IN && gpio::input.mode == PORT_MODE_DIGITAL);
+static_assert(gpio::analog.mode == PORT_MODE_ANALOG);
@@ -0,0 +1,84 @@
+#include "pin_bench.h"
+
+#if PIN_BENCHMARK
+#include "pin.hpp"
+#include "MDR32FxQI_rst_clk.h"
+#include "MDR32FxQI_inline.h"
+
+using Led = gpio::Pin<MDR_PORTC_BASE, 0>;
+
+#define PIN_BENCH_ROUNDS 1000
+
+static PIN_Stats_t stats;
+
+// Тактов на вызов: замер ROUNDS пар вызовов минус пустой цикл
+template <class F>
+static uint32_t PIN_Measure(F f, uint32_t empty)
+{
+    uint32_t start = DWT->CYCCNT;
+
+    for (uint32_t i = 0; i < PIN_BENCH_ROUNDS; i++)
+    {
+        f();
+        __asm volatile("" ::: "memory");
+    }
+    return (DWT->CYCCNT - start - empty) / (PIN_BENCH_ROUNDS * 2);
+}
+
+const PIN_Stats_t *PIN_Benchmark(void)
+{
+    const PORT_InitTypeDef init = {
+        .PORT_Pin = PORT_Pin_0,
+        .PORT_OE = PORT_OE_OUT,
+        .PORT_PULL_UP = PORT_PULL_UP_OFF,
+        .PORT_PULL_DOWN = PORT_PULL_DOWN_OFF,
+        .PORT_PD_SHM = PORT_PD_SHM_OFF,
+        .PORT_PD = PORT_PD_DRIVER,
+        .PORT_GFEN = PORT_GFEN_OFF,
+        .PORT_FUNC = PORT_FUNC_PORT,
+        .PORT_SPEED = PORT_SPEED_MAXFAST,
+        .PORT_MODE = PORT_MODE_DIGITAL,
+    };
+    uint32_t primask = __get_PRIMASK();
+    uint32_t empty;
+
+    RST_CLK_PCLKcmd(RST_CLK_PCLK_PORTC, ENABLE);
+    CoreDebug->DEMCR = CoreDebug->DEMCR | CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL = DWT->CTRL | DWT_CTRL_CYCCNTENA_Msk;
+    __disable_irq();
+
+    empty = PIN_Measure([] {}, 0) * PIN_BENCH_ROUNDS * 2;
+    stats.pinSet = PIN_Measure([] { Led::set(); Led::clear(); }, empty);
+    stats.splSet = PIN_Measure([] { PORT_SetBits(MDR_PORTC, PORT_Pin_0); PORT_ResetBits(MDR_PORTC, PORT_Pin_0); }, empty);
+    stats.inlineSet = PIN_Measure([] { PORT_SetBits_Inline(MDR_PORTC, PORT_Pin_0); PORT_ResetBits_Inline(MDR_PORTC, PORT_Pin_0); }, empty);
+    stats.pinToggle = PIN_Measure([] { Led::toggle(); Led::toggle(); }, empty);
+    stats.splToggle = PIN_Measure(
+        [] {
+            for (int n = 0; n < 2; n++)
+            {
+                PORT_WriteBit(MDR_PORTC, PORT_Pin_0, PORT_ReadInputDataBit(MDR_PORTC, PORT_Pin_0) ? RESET : SET);
+            }
+        },
+        empty);
+    stats.inlineToggle = PIN_Measure(
+        [] {
+            for (int n = 0; n < 2; n++)
+            {
+                if (PORT_ReadInputDataBit_Inline(MDR_PORTC, PORT_Pin_0))
+                {
+                    PORT_ResetBits_Inline(MDR_PORTC, PORT_Pin_0);
+                }
+                else
+                {
+                    PORT_SetBits_Inline(MDR_PORTC, PORT_Pin_0);
+                }
+            }
+        },
+        empty);
+    stats.pinInit = PIN_Measure([] { Led::init<gpio::output>(); Led::init<gpio::output>(); }, empty);
+    stats.splInit = PIN_Measure([&init] { PORT_Init(MDR_PORTC, &init); PORT_Init(MDR_PORTC, &init); }, empty);
+
+    __set_PRIMASK(primask);
+    return &stats;
+}
+#endif
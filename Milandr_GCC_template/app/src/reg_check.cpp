@@ -0,0 +1,58 @@
+#include <cstddef>
+#include "mdr_regs.hpp"
+#include "MDR32FxQI_rst_clk.h"
+
+// Проверки generated/mdr_regs.hpp и reg.hpp при компиляции прошивки, кода не дают.
+// Описания из SVD сверяются с заголовком CMSIS: адреса регистров, позиции и маски полей,
+// значения из enumeratedValues. Ошибки, которые reg.hpp ловит static_assert (поле чужого
+// регистра, повтор поля, запись поля read-only, поле за границей), проверяет
+// test/CMakeLists.txt - reg_fail_*: такой код не должен собираться
+
+using RST_CLK = mdr::RST_CLK;
+using CPU_CLOCK = RST_CLK::CPU_CLOCK;
+using PLL_CONTROL = RST_CLK::PLL_CONTROL;
+
+// Адреса регистров - база и смещение из CMSIS
+static_assert(CPU_CLOCK::address == MDR_RST_CLK_BASE + offsetof(MDR_RST_CLK_TypeDef, CPU_CLOCK));
+static_assert(PLL_CONTROL::address == MDR_RST_CLK_BASE + offsetof(MDR_RST_CLK_TypeDef, PLL_CONTROL));
+static_assert(mdr::UART1::FR::address == MDR_UART1_BASE + offsetof(MDR_UART_TypeDef, FR));
+static_assert(mdr::UART2::FR::address == MDR_UART2_BASE + offsetof(MDR_UART_TypeDef, FR));
+static_assert(mdr::TIMER1::CNTRL::address == MDR_TIMER1_BASE + offsetof(MDR_TIMER_TypeDef, CNTRL));
+static_assert(mdr::PORTC::RXTX::address == MDR_PORTC_BASE);
+
+// Поля
+static_assert(CPU_CLOCK::HCLK_SEL::mask == RST_CLK_CPU_CLOCK_HCLK_SEL_Msk && CPU_CLOCK::HCLK_SEL::pos == RST_CLK_CPU_CLOCK_HCLK_SEL_Pos);
+static_assert(CPU_CLOCK::CPU_C3_SEL::mask == RST_CLK_CPU_CLOCK_CPU_C3_SEL_Msk);
+static_assert(CPU_CLOCK::CPU_C1_SEL::mask == RST_CLK_CPU_CLOCK_CPU_C1_SEL_Msk);
+static_assert(PLL_CONTROL::PLL_CPU_MUL::mask == RST_CLK_PLL_CONTROL_PLL_CPU_MUL_Msk);
+static_assert(RST_CLK::CLOCK_STATUS::HSE_RDY::mask == RST_CLK_CLOCK_STATUS_HSE_RDY);
+static_assert(RST_CLK::HS_CONTROL::HSE_ON::mask == RST_CLK_HS_CONTROL_HSE_ON);
+static_assert(mdr::UART1::FR::RXFE::mask == UART_FR_RXFE);
+static_assert(mdr::TIMER1::CNTRL::CNT_EN::mask == TIMER_CNTRL_CNT_EN);
+
+// Значения полей - как у SPL, value() обрезает лишнее по маске
+static_assert(CPU_CLOCK::CPU_C1_SEL::HSE.bits == RST_CLK_CPU_C1srcHSEdiv1);
+static_assert(CPU_CLOCK::HCLK_SEL::CPU_C3.bits == RST_CLK_CPUclkCPU_C3);
+static_assert(CPU_CLOCK::CPU_C3_SEL::value(0x1F).bits == 0xF0);
+static_assert(PLL_CONTROL::PLL_CPU_MUL::value(15).bits == RST_CLK_PLL_CONTROL_PLL_CPU_MUL_Msk);
+
+// bit-band однобитного поля - слово alias бита регистра
+static_assert(bitband::Bit<RST_CLK::HS_CONTROL::address, RST_CLK::HS_CONTROL::HSE_ON::pos>::address == 0x42000000 + 0x20008 * 32);
+
+// Доступ: чего нет в reg.hpp для данного регистра или поля, того и не вызвать
+template <typename R>
+constexpr bool canWrite = requires { R::write(0u); };
+template <typename R>
+constexpr bool canRead = requires { R::read(); };
+template <typename F>
+constexpr bool canSet = requires { F::set(); };
+template <typename F>
+constexpr bool canModify = requires { F::modify(0u); };
+
+static_assert(canWrite<CPU_CLOCK> && canRead<CPU_CLOCK>);
+static_assert(!canWrite<RST_CLK::CLOCK_STATUS> && canRead<RST_CLK::CLOCK_STATUS>); // read-only регистр
+static_assert(!canModify<RST_CLK::CLOCK_STATUS::HSE_RDY>);                         // и поле
+static_assert(!canRead<mdr::UART1::DR::DATA> && canWrite<mdr::UART1::DR::DATA>);   // write-only поле
+static_assert(canSet<RST_CLK::HS_CONTROL::HSE_ON>);
+static_assert(!canSet<CPU_CLOCK::CPU_C3_SEL>);                                      // больше бита
+static_assert(!canSet<mdr::TIMER1::CH1_CNTRL::WR_CMPL>);                           // read-only бит
@@ -1,28 +1,29 @@
 #include "systick.h"
-uint64_t millis = 0;
+#include "ao.h"
+#include "uptime.h"
+volatile uint64_t millis = 0;
 void initSystick()
 {
-    SysTick->LOAD = 80000 - 1;
-    SysTick->CTRL |= SysTick_CTRL_CLKSOURCE_Msk; // HCLK
-    SysTick->CTRL |= SysTick_CTRL_TICKINT_Msk;
-    NVIC_EnableIRQ(SysTick_IRQn);
-    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+    UPTIME_Start(CLK_CPU_HZ); // HCLK, тик UPTIME_TICK_HZ
 }
 
 volatile void delay(uint32_t ms)
 {
-    uint64_t cur = millis;
-    while (millis - cur < ms)
+    uint64_t cur = GetTick();
+    while (GetTick() - cur < ms)
     {
-        __NOP();
+        __WFI(); // до следующего тика или другого прерывания
     }
 }
 
 uint64_t GetTick(){
-    return millis;
+    return UPTIME_GetTicks();
 }
 
 void SysTick_Handler()
 {
+  UPTIME_Tick(); // первым: таймеры AO_Tick уже видят новое время
   millis++;
+  AO_Tick();
+  UPTIME_TickEnd();
 }
\ No newline at end of file
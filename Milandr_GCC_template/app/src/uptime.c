@@ -0,0 +1,304 @@
+#include "uptime.h"
+
+#define UPTIME_BARRIER() __asm volatile("" ::: "memory")
+#define UPTIME_TICKED    1u // бит seq: SysTick_Handler, в котором сейчас ядро, свой снимок опубликовал
+#define UPTIME_SLOT(n)   (&slots[((n) >> 1) & 1])
+
+// Снимок на начало текущего периода SysTick. Время внутри периода: elapsed * k >> 16,
+// k округлен вниз - к концу периода не больше credit, на тике время не идет назад
+typedef struct
+{
+    uint64_t ticks;
+    uint64_t cycles;
+    uint64_t usQ16;        // мкс << 16
+    uint64_t k;            // usQ16 << 16 за такт текущего периода
+    uint32_t load;         // тактов в периоде, LOAD + 1
+    uint32_t creditCycles; // зачтет ближайший тик - период, на котором SysTick перезагрузился
+    uint32_t creditUsQ16;
+} UPTIME_Slot_t;
+
+typedef struct
+{
+    uint64_t k;
+    uint32_t credit;
+} UPTIME_Rate_t;
+
+static UPTIME_Slot_t slots[2];
+static volatile uint32_t seq;   // слот UPTIME_SLOT(seq) опубликован, пишется другой; шаг 2
+static UPTIME_Rate_t rate;      // для следующих периодов, меняется при запрещенных прерываниях
+static uint32_t coreHz;
+static int32_t ppm;
+static struct
+{
+    uint64_t rtc;
+    uint64_t us;
+} calibration;
+
+static void UPTIME_SetRate(uint32_t load)
+{
+    uint64_t credit = (uint64_t)load * (1000000ULL << 16) / coreHz;
+
+    credit = credit * 1000000 / (uint32_t)(1000000 + ppm);
+    rate.credit = (uint32_t)credit;
+    rate.k = (credit << 16) / load;
+}
+
+// Снимок seq n отстал на период: SysTick перезагрузился, а тик еще не опубликован. Тик
+// ждет маски (PENDSTSET) или SysTick_Handler уже вошел - PENDSTSET снят при входе, - но его
+// до публикации вытеснило прерывание, которое сейчас и читает (SYSTICKACT без UPTIME_TICKED)
+static inline uint32_t UPTIME_Stale(uint32_t n)
+{
+    return (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0 ||
+           ((SCB->SHCSR & SCB_SHCSR_SYSTICKACT_Msk) != 0 && !(n & UPTIME_TICKED));
+}
+
+// Позиция в текущем периоде. Если снимок отстал, счетчик перечитывается уже в новом
+// периоде, а снимок дополняется credit
+static inline uint32_t UPTIME_Elapsed(const UPTIME_Slot_t *s, uint32_t n, uint32_t *pending)
+{
+    uint32_t val = SysTick->VAL;
+
+    *pending = 0;
+    if (s->load == 0)
+    {
+        return 0; // SysTick еще не запущен
+    }
+    if (UPTIME_Stale(n))
+    {
+        *pending = 1;
+        val = SysTick->VAL;
+    }
+    // VAL = 0 - последний такт периода (он весь в credit) или такт после записи VAL
+    return val != 0 ? s->load - val : 0;
+}
+
+uint64_t UPTIME_GetUs(void)
+{
+    uint32_t n, pending, elapsed;
+    uint64_t us;
+
+    do
+    {
+        const UPTIME_Slot_t *s;
+
+        n = seq;
+        UPTIME_BARRIER();
+        s = UPTIME_SLOT(n);
+        elapsed = UPTIME_Elapsed(s, n, &pending);
+        us = s->usQ16 + (pending ? s->creditUsQ16 : 0) + ((elapsed * s->k) >> 16);
+        UPTIME_BARRIER();
+    } while (seq != n);
+    return us >> 16;
+}
+
+uint64_t UPTIME_GetCycles(void)
+{
+    uint32_t n, pending, elapsed;
+    uint64_t cycles;
+
+    do
+    {
+        const UPTIME_Slot_t *s;
+
+        n = seq;
+        UPTIME_BARRIER();
+        s = UPTIME_SLOT(n);
+        elapsed = UPTIME_Elapsed(s, n, &pending);
+        cycles = s->cycles + (pending ? s->creditCycles : 0) + elapsed;
+        UPTIME_BARRIER();
+    } while (seq != n);
+    return cycles;
+}
+
+uint64_t UPTIME_GetTicks(void)
+{
+    uint32_t n, pending;
+    uint64_t ticks;
+
+    do
+    {
+        n = seq;
+        UPTIME_BARRIER();
+        ticks = UPTIME_SLOT(n)->ticks;
+        pending = UPTIME_Stale(n);
+        UPTIME_BARRIER();
+    } while (seq != n);
+    return ticks + pending;
+}
+
+// Слот меняется одной записью seq вместе с UPTIME_TICKED
+static inline void UPTIME_Publish(uint32_t ticked)
+{
+    UPTIME_BARRIER();
+    seq = ((seq + 2) & ~UPTIME_TICKED) | ticked;
+}
+
+void UPTIME_Tick(void)
+{
+    const UPTIME_Slot_t *s = UPTIME_SLOT(seq);
+    UPTIME_Slot_t *next = UPTIME_SLOT(seq + 2);
+
+    next->ticks = s->ticks + 1;
+    next->cycles = s->cycles + s->creditCycles;
+    next->usQ16 = s->usQ16 + s->creditUsQ16;
+    next->load = s->load;
+    next->k = rate.k;
+    next->creditCycles = s->load;
+    next->creditUsQ16 = rate.credit;
+    UPTIME_Publish(UPTIME_TICKED);
+}
+
+// FAULTMASK не пускает прерывания до выхода и снимается самим возвратом из исключения
+void UPTIME_TickEnd(void)
+{
+    __set_FAULTMASK(1);
+    seq &= ~UPTIME_TICKED;
+}
+
+void UPTIME_Start(uint32_t hz)
+{
+    uint32_t load = hz / UPTIME_TICK_HZ;
+    UPTIME_Slot_t *s = UPTIME_SLOT(seq);
+
+    SysTick->CTRL = 0;
+    SysTick->VAL = 0;
+    coreHz = hz;
+    UPTIME_SetRate(load);
+    s->load = load;
+    s->k = rate.k;
+    s->creditCycles = load;
+    s->creditUsQ16 = rate.credit;
+    SysTick->LOAD = load - 1;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+}
+
+void UPTIME_SetPpm(int32_t value)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    ppm = value;
+    UPTIME_SetRate(UPTIME_SLOT(seq)->load);
+    __set_PRIMASK(primask);
+}
+
+// Фронт RTC_DIV и время на нем. RTC_CNT и RTC_DIV сменились вместе, до следующего
+// фронта 1 / UPTIME_RTC_HZ - хватает на оба чтения
+static ErrorStatus UPTIME_RtcEdge(uint64_t *rtc, uint64_t *us)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint32_t div, cnt;
+    uint64_t limit;
+
+    __disable_irq();
+    div = MDR_BKP->RTC_DIV;
+    limit = UPTIME_GetUs() + UPTIME_RTC_EDGE_US;
+    while (MDR_BKP->RTC_DIV == div)
+    {
+        if (UPTIME_GetUs() > limit)
+        {
+            __set_PRIMASK(primask);
+            return ERROR;
+        }
+    }
+    *us = UPTIME_GetUs();
+    div = MDR_BKP->RTC_DIV;
+    cnt = MDR_BKP->RTC_CNT;
+    __set_PRIMASK(primask);
+
+    *rtc = (uint64_t)cnt * MDR_BKP->RTC_PRL + div;
+    return SUCCESS;
+}
+
+ErrorStatus UPTIME_CalibrateStart(void)
+{
+    return UPTIME_RtcEdge(&calibration.rtc, &calibration.us);
+}
+
+ErrorStatus UPTIME_CalibrateFinish(int32_t *result)
+{
+    uint64_t rtc, us, ratio;
+
+    if (UPTIME_RtcEdge(&rtc, &us) == ERROR || rtc - calibration.rtc < UPTIME_RTC_HZ)
+    {
+        return ERROR;
+    }
+    rtc -= calibration.rtc;
+    us -= calibration.us;
+
+    // Мкс по нашим часам на 10^6 мкс по RTC: больше 10^6 - ядро быстрее, чем считали
+    ratio = (us * UPTIME_RTC_HZ + rtc / 2) / rtc;
+    UPTIME_SetPpm((int32_t)(((int64_t)(1000000 + ppm) * (int64_t)ratio + 500000) / 1000000 - 1000000));
+    *result = ppm;
+    return SUCCESS;
+}
+
+#if UPTIME_TORTURE
+static UPTIME_Torture_t torture;
+static volatile uint32_t lastUs;    // младшие 32 бита: пишутся одной записью
+static volatile uint32_t isrLastUs;
+static uint32_t seed = 1;
+
+void Timer3_IRQHandler(void)
+{
+    uint32_t before = lastUs;
+    uint32_t now = (uint32_t)UPTIME_GetUs();
+
+    MDR_TIMER3->STATUS = 0;
+    if ((int32_t)(now - before) < 0 || (int32_t)(now - isrLastUs) < 0)
+    {
+        torture.backwards++;
+    }
+    isrLastUs = now;
+    torture.isrReads++;
+
+    // Период 300..1323 тактов, фаза относительно SysTick все время сдвигается
+    seed = seed * 1664525 + 1013904223;
+    MDR_TIMER3->ARR = 300 + (seed >> 22);
+}
+
+const UPTIME_Torture_t *UPTIME_Torture(uint32_t ms)
+{
+    uint32_t perClock = MDR_RST_CLK->PER_CLOCK;
+    uint32_t timClock = MDR_RST_CLK->TIM_CLOCK;
+    uint64_t end = UPTIME_GetUs() + ms * 1000ULL;
+    uint64_t prev = UPTIME_GetUs();
+
+    MDR_RST_CLK->PER_CLOCK = perClock | RST_CLK_PER_CLOCK_PCLK_EN_TIMER3;
+    MDR_RST_CLK->TIM_CLOCK = (timClock & ~RST_CLK_TIM_CLOCK_TIM3_BRG_Msk) | RST_CLK_TIM_CLOCK_TIM3_CLK_EN;
+    MDR_TIMER3->CNTRL = 0;
+    MDR_TIMER3->CNT = 0;
+    MDR_TIMER3->PSG = 0;
+    MDR_TIMER3->ARR = 1000;
+    MDR_TIMER3->STATUS = 0;
+    MDR_TIMER3->IE = TIMER_IE_CNT_ARR_EVENT_IE;
+    NVIC_SetPriority(Timer3_IRQn, 0);
+    NVIC_EnableIRQ(Timer3_IRQn);
+    MDR_TIMER3->CNTRL = TIMER_CNTRL_CNT_EN;
+
+    while (prev < end)
+    {
+        uint32_t isr = isrLastUs;
+        uint64_t now = UPTIME_GetUs();
+
+        if (now < prev || (int32_t)((uint32_t)now - isr) < 0)
+        {
+            torture.backwards++;
+        }
+        if (now - prev > torture.maxStepUs)
+        {
+            torture.maxStepUs = (uint32_t)(now - prev);
+        }
+        lastUs = (uint32_t)now;
+        prev = now;
+        torture.reads++;
+    }
+
+    MDR_TIMER3->CNTRL = 0;
+    MDR_TIMER3->IE = 0;
+    NVIC_DisableIRQ(Timer3_IRQn);
+    MDR_RST_CLK->TIM_CLOCK = timClock;
+    MDR_RST_CLK->PER_CLOCK = perClock;
+    return &torture;
+}
+#endif
@@ -0,0 +1,21 @@
+# Описания регистров для app/inc/reg.hpp: tools/svd_regs.py генерирует generated/mdr_regs.hpp
+# из SVD при его изменении (или изменении генератора). Заголовок только для C++ кода.
+set(SVD_FILE ${CMAKE_SOURCE_DIR}/MDR32F9Q2I.svd CACHE FILEPATH "SVD-описание микроконтроллера")
+
+function(target_svd_regs target)
+    find_package(Python3 REQUIRED COMPONENTS Interpreter)
+    set(gen_dir ${CMAKE_BINARY_DIR}/generated)
+
+    add_custom_command(
+        OUTPUT ${gen_dir}/mdr_regs.hpp
+        COMMAND Python3::Interpreter ${CMAKE_SOURCE_DIR}/tools/svd_regs.py
+            --svd ${SVD_FILE}
+            --header ${gen_dir}/mdr_regs.hpp
+        DEPENDS ${SVD_FILE} ${CMAKE_SOURCE_DIR}/tools/svd_regs.py
+        COMMENT "Generating register descriptors from SVD"
+        VERBATIM
+    )
+    add_custom_target(${target}_svd_regs DEPENDS ${gen_dir}/mdr_regs.hpp)
+    add_dependencies(${target} ${target}_svd_regs)
+    target_include_directories(${target} PRIVATE ${gen_dir})
+endfunction()
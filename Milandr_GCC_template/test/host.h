@@ -0,0 +1,38 @@
+#pragma once
+// Окружение прошивки для хост-тестов test_*: проверки и итог. Периферия - модели в тесте
+// или память по адресам кристалла, заголовки SPL - настоящие, MDR32FxQI_config.h - stub/
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static int hostFailures;
+
+#define CHECK(cond)                                                          \
+    do                                                                       \
+    {                                                                        \
+        if (!(cond))                                                         \
+        {                                                                    \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            hostFailures++;                                                  \
+        }                                                                    \
+    } while (0)
+
+static int HOST_Result(const char *name)
+{
+    if (hostFailures != 0)
+    {
+        printf("%s: %d failed\n", name, hostFailures);
+        return 1;
+    }
+    printf("%s: ok\n", name);
+    return 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,27 @@
+// reg.hpp: код, который не должен собираться. Каждый случай - REG_FAIL=n, test/CMakeLists.txt
+// компилирует его и ждет ошибку с текстом из REG_FAIL_<n> (комментарии здесь его не
+// повторяют: строку с ошибкой компилятор печатает). REG_FAIL=0 - тот же файл без
+// ошибок: собирается, значит, ошибку дает сам случай, а не окружение
+#include "mdr_regs.hpp"
+
+using CPU_CLOCK = mdr::RST_CLK::CPU_CLOCK;
+
+void REG_Fail(void)
+{
+    CPU_CLOCK::write(CPU_CLOCK::HCLK_SEL::CPU_C3); // правильный вызов
+#if REG_FAIL == 1
+    CPU_CLOCK::write(mdr::RST_CLK::PLL_CONTROL::PLL_CPU_MUL::value(1)); // PLL_CPU_MUL - из PLL_CONTROL
+#elif REG_FAIL == 2
+    CPU_CLOCK::write(CPU_CLOCK::HCLK_SEL::CPU_C3, CPU_CLOCK::HCLK_SEL::LSE); // HCLK_SEL два раза
+#elif REG_FAIL == 3
+    mdr::TIMER1::CH1_CNTRL::modify(reg::Value<mdr::TIMER1::CH1_CNTRL::WR_CMPL>{1u << 14}); // WR_CMPL - read-only
+#elif REG_FAIL == 4
+    (void)reg::Field<CPU_CLOCK, 30, 4, reg::Access::ReadWrite>::mask; // биты 30..33
+#elif REG_FAIL == 5
+    mdr::RST_CLK::CLOCK_STATUS::write(0u); // CLOCK_STATUS - read-only
+#elif REG_FAIL == 6
+    (void)mdr::UART1::DR::DATA::read(); // DATA - write-only
+#elif REG_FAIL == 7
+    CPU_CLOCK::CPU_C3_SEL::set(); // 4 бита, bit-band только для одного
+#endif
+}
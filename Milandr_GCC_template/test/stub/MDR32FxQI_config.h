@@ -0,0 +1,45 @@
+#pragma once
+// MDR32FxQI_config.h для хост-тестов: K1986VE9xI с JTAG на PORTD, как у прошивки, и то
+// из K1986VE9xI.h, что нужно MDR32FxQI_port.h/.c. CMSIS ядра нет
+#include <stdint.h>
+
+#define USE_K1986VE92xI
+#define USE_K1986VE9xI
+#define USE_JTAG_B
+
+#define __IO volatile
+#define __STATIC_INLINE static inline
+
+typedef enum { RESET = 0, SET = !RESET } FlagStatus, ITStatus, BitStatus;
+typedef enum { DISABLE = 0, ENABLE = !DISABLE } FunctionalState;
+typedef enum { ERROR = 0, SUCCESS = !ERROR } ErrorStatus;
+
+#define PERIPH_BASE    ((uint32_t)0x40000000)
+#define PERIPH_BB_BASE ((uint32_t)0x42000000)
+
+typedef struct
+{
+    __IO uint32_t RXTX;
+    __IO uint32_t OE;
+    __IO uint32_t FUNC;
+    __IO uint32_t ANALOG;
+    __IO uint32_t PULL;
+    __IO uint32_t PD;
+    __IO uint32_t PWR;
+    __IO uint32_t GFEN;
+} MDR_PORT_TypeDef;
+
+#define MDR_PORTA_BASE (PERIPH_BASE + (uint32_t)0x000A8000)
+#define MDR_PORTB_BASE (PERIPH_BASE + (uint32_t)0x000B0000)
+#define MDR_PORTC_BASE (PERIPH_BASE + (uint32_t)0x000B8000)
+#define MDR_PORTD_BASE (PERIPH_BASE + (uint32_t)0x000C0000)
+#define MDR_PORTE_BASE (PERIPH_BASE + (uint32_t)0x000C8000)
+#define MDR_PORTF_BASE (PERIPH_BASE + (uint32_t)0x000E8000)
+#define MDR_PORTA ((MDR_PORT_TypeDef *)MDR_PORTA_BASE)
+#define MDR_PORTB ((MDR_PORT_TypeDef *)MDR_PORTB_BASE)
+#define MDR_PORTC ((MDR_PORT_TypeDef *)MDR_PORTC_BASE)
+#define MDR_PORTD ((MDR_PORT_TypeDef *)MDR_PORTD_BASE)
+#define MDR_PORTE ((MDR_PORT_TypeDef *)MDR_PORTE_BASE)
+#define MDR_PORTF ((MDR_PORT_TypeDef *)MDR_PORTF_BASE)
+
+#define assert_param(expr) ((void)0U)
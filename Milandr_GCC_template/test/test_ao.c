@@ -0,0 +1,427 @@
+// ao.c на модели ядра в тактах: SysTick 1 мс при 80 МГц, PRIMASK, WFI, вытеснение
+// обработчиков прерыванием. AO_Run не возвращается - из него выходит WFI модели
+// (longjmp) после заданного числа тиков.
+// Проверяется: порядок событий - старший приоритет первым, внутри объекта FIFO; полная
+// очередь теряет событие и считает его; однократный, периодический, снятый и
+// перевзведенный таймеры; повторный AO_TimerInit не замыкает список; AO_Idle вызывается
+// только при запрещенных прерываниях и пустой маске ready, событие из тика, пришедшего
+// между проверкой и WFI, не теряется; AO_GetStats совпадает с моделью.
+// Такты - оценки MODEL_*_CYCLES по таблицам TRM Cortex-M3 (вход и выход из прерывания)
+// и по числу инструкций, без ожиданий FLASH; выход из WFI на кристалле не измерялся.
+// Замер на плате - AO_Benchmark (AO_BENCHMARK=1), его результатов здесь нет
+#include "host.h"
+
+#include <setjmp.h>
+
+#define _APP_H_ // app.h тянет SPL целиком, ao.c нужно только то, что ниже
+#define AO_BENCHMARK 1
+
+static int hostAsserts;
+#define assert_param(expr) ((expr) ? (void)0 : (void)hostAsserts++)
+
+#define MODEL_HZ 80000000u
+#define MODEL_TICK (MODEL_HZ / 1000)
+#define MODEL_IRQ_ENTRY_CYCLES 12 // вход в прерывание, TRM
+#define MODEL_IRQ_EXIT_CYCLES 10  // выход без tail-chaining
+#define MODEL_WFI_WAKE_CYCLES 4   // оценка: зависит от реализации ядра и тактирования
+#define MODEL_SYSTICK_CYCLES 60   // SysTick_Handler без AO_Tick: UPTIME_Tick, millis, UPTIME_TickEnd
+#define MODEL_TIMER_CYCLES 8      // AO_Tick на таймер в списке
+#define MODEL_POST_CYCLES 30      // AO_Post: PRIMASK, проверка, запись события, ready
+#define MODEL_PICK_CYCLES 28      // AO_Run от __disable_irq до вызова обработчика
+
+typedef struct
+{
+    volatile uint32_t CTRL;
+    volatile uint32_t CYCCNT;
+} HOST_Dwt_t;
+typedef struct
+{
+    volatile uint32_t DEMCR;
+} HOST_CoreDebug_t;
+static HOST_Dwt_t hostDwt;
+static HOST_CoreDebug_t hostCoreDebug;
+#define DWT (&hostDwt)
+#define CoreDebug (&hostCoreDebug)
+#define DWT_CTRL_CYCCNTENA_Msk 1u
+#define CoreDebug_DEMCR_TRCENA_Msk (1u << 24)
+
+static uint64_t now;        // такты модели
+static uint64_t nextTick;   // такт следующего запроса SysTick
+static uint32_t ticks;      // выполненных SysTick_Handler
+static uint32_t tickLimit;  // AO_Idle выходит из AO_Run после стольких тиков
+static int tickPending;
+static int inIsr;
+static uint32_t hostPrimask;
+static uint64_t idleCycles;
+static uint64_t isrCycles;
+static uint32_t idleCalls;
+static jmp_buf runExit;
+
+static void MODEL_Isr(void);
+
+static void MODEL_Set(uint64_t cycles)
+{
+    now = cycles;
+    hostDwt.CYCCNT = (uint32_t)now;
+}
+
+// Код с текущей маской занимает cycles тактов. Тик при снятой маске вытесняет его,
+// при запрещенных прерываниях остается ожидающим до __enable_irq
+static void MODEL_Advance(uint32_t cycles)
+{
+    uint64_t end = now + cycles;
+
+    while (!inIsr && nextTick <= end)
+    {
+        if (hostPrimask)
+        {
+            tickPending = 1;
+            break;
+        }
+        uint64_t start;
+        MODEL_Set(nextTick > now ? nextTick : now);
+        start = now;
+        MODEL_Isr();
+        end += now - start;
+    }
+    MODEL_Set(end);
+}
+
+static uint32_t __get_PRIMASK(void)
+{
+    return hostPrimask;
+}
+
+static void __disable_irq(void)
+{
+    hostPrimask = 1;
+}
+
+static void __set_PRIMASK(uint32_t primask)
+{
+    hostPrimask = primask;
+    if (!primask && tickPending && !inIsr)
+    {
+        MODEL_Isr();
+    }
+}
+
+static void __enable_irq(void)
+{
+    __set_PRIMASK(0);
+}
+
+static void MODEL_Wfi(void);
+
+static void __WFI(void)
+{
+    MODEL_Wfi();
+}
+
+static uint32_t __CLZ(uint32_t x)
+{
+    MODEL_Advance(MODEL_PICK_CYCLES);
+    return (uint32_t)__builtin_clz(x);
+}
+
+static uint64_t UPTIME_GetCycles(void)
+{
+    return now;
+}
+
+#include "../app/src/ao.c"
+
+static uint32_t MODEL_Timers(void)
+{
+    uint32_t n = 0;
+
+    for (AO_Timer_t *t = timers; t != NULL && n < 1000; t = t->next)
+    {
+        n++;
+    }
+    return n;
+}
+
+// SysTick_Handler из systick.c: события таймеров метятся CYCCNT после UPTIME_Tick
+static void MODEL_Isr(void)
+{
+    uint64_t start = now;
+    uint32_t posts = 0;
+    uint32_t primask = hostPrimask;
+
+    tickPending = 0;
+    inIsr = 1;
+    hostPrimask = 0;
+    nextTick += MODEL_TICK;
+    ticks++;
+    MODEL_Set(now + MODEL_IRQ_ENTRY_CYCLES + MODEL_SYSTICK_CYCLES);
+    for (AO_Timer_t *t = timers; t != NULL; t = t->next)
+    {
+        posts += t->left == 1;
+    }
+    AO_Tick();
+    MODEL_Set(now + MODEL_Timers() * MODEL_TIMER_CYCLES + posts * MODEL_POST_CYCLES + MODEL_IRQ_EXIT_CYCLES);
+    isrCycles += now - start;
+    hostPrimask = primask;
+    inIsr = 0;
+}
+
+// WFI из AO_Idle прошивки: сон до тика, ожидающий SysTick выполнится после __enable_irq
+static void MODEL_Wfi(void)
+{
+    CHECK(hostPrimask == 1);
+    CHECK(ready == 0);
+    idleCalls++;
+    if (ticks >= tickLimit)
+    {
+        longjmp(runExit, 1);
+    }
+    if (nextTick > now)
+    {
+        idleCycles += nextTick - now;
+        MODEL_Set(nextTick);
+    }
+    MODEL_Set(now + MODEL_WFI_WAKE_CYCLES);
+    tickPending = 1;
+}
+
+static void TEST_Reset(void)
+{
+    memset(objects, 0, sizeof(objects));
+    ready = 0;
+    timers = NULL;
+    memset(&stats, 0, sizeof(stats));
+    stats.latencyMin = UINT32_MAX;
+    MODEL_Set(0);
+    nextTick = MODEL_TICK;
+    ticks = 0;
+    tickPending = 0;
+    hostPrimask = 0;
+    idleCycles = 0;
+    isrCycles = 0;
+    idleCalls = 0;
+    hostAsserts = 0;
+}
+
+static void TEST_Run(uint32_t limit)
+{
+    tickLimit = limit;
+    if (setjmp(runExit) == 0)
+    {
+        AO_Run();
+    }
+    hostPrimask = 0;
+}
+
+// Журнал диспетчеризации: объект, сигнал, аргумент, тик
+typedef struct
+{
+    uint8_t prio;
+    uint32_t sig;
+    uint32_t arg;
+    uint32_t tick;
+} TEST_Log_t;
+static TEST_Log_t logs[256];
+static uint32_t logCount;
+
+static void TEST_Record(AO_Object_t *me, const AO_Event_t *e)
+{
+    if (logCount < sizeof(logs) / sizeof(logs[0]))
+    {
+        logs[logCount++] = (TEST_Log_t){me->prio, e->sig, e->arg, ticks};
+    }
+}
+
+enum
+{
+    SIG_A = AO_SIG_USER,
+    SIG_B,
+    SIG_TIMER,
+    SIG_ONCE,
+};
+
+static AO_Event_t queues[4][8];
+static AO_Object_t obj[4];
+
+static void TEST_Order(void)
+{
+    TEST_Reset();
+    logCount = 0;
+    AO_Start(&obj[0], 1, queues[0], 8, TEST_Record);
+    AO_Start(&obj[1], 5, queues[1], 8, TEST_Record);
+    AO_Start(&obj[2], 3, queues[2], 8, TEST_Record);
+    AO_Post(&obj[0], SIG_A, 10);
+    AO_Post(&obj[2], SIG_A, 30);
+    AO_Post(&obj[1], SIG_A, 50);
+    AO_Post(&obj[1], SIG_B, 51);
+    AO_Post(&obj[0], SIG_B, 11);
+    TEST_Run(1);
+
+    static const uint8_t prio[] = {5, 5, 5, 3, 3, 1, 1, 1};
+    static const uint32_t sig[] = {AO_SIG_INIT, SIG_A, SIG_B, AO_SIG_INIT, SIG_A, AO_SIG_INIT, SIG_A, SIG_B};
+    CHECK(logCount == 8);
+    for (uint32_t i = 0; i < 8 && i < logCount; i++)
+    {
+        CHECK(logs[i].prio == prio[i] && logs[i].sig == sig[i]);
+    }
+    CHECK(ready == 0 && hostAsserts == 0);
+
+    // Очередь из 4 держит 3 события: INIT и два, четвертое теряется
+    TEST_Reset();
+    AO_Start(&obj[3], 0, queues[3], 4, TEST_Record);
+    CHECK(AO_Post(&obj[3], SIG_A, 0) == 1);
+    CHECK(AO_Post(&obj[3], SIG_A, 1) == 1);
+    CHECK(AO_Post(&obj[3], SIG_A, 2) == 0);
+    CHECK(obj[3].dropped == 1);
+
+    // Занятый приоритет и длина не степень двойки
+    AO_Start(&obj[0], 0, queues[0], 8, TEST_Record);
+    AO_Start(&obj[1], 2, queues[1], 6, TEST_Record);
+    CHECK(hostAsserts == 2);
+}
+
+static AO_Timer_t timer[3];
+
+static void TEST_TimerDispatch(AO_Object_t *me, const AO_Event_t *e)
+{
+    TEST_Record(me, e);
+    if (e->sig == AO_SIG_INIT)
+    {
+        AO_TimerInit(&timer[0], me, SIG_TIMER);
+        AO_TimerArm(&timer[0], 3, 5);
+        AO_TimerInit(&timer[1], me, SIG_ONCE);
+        AO_TimerArm(&timer[1], 7, 0);
+        AO_TimerInit(&timer[2], me, SIG_B);
+        AO_TimerArm(&timer[2], 2, 2);
+    }
+    else if (e->sig == SIG_B && ticks == 6)
+    {
+        AO_TimerDisarm(&timer[2]);
+    }
+}
+
+static uint32_t TEST_Count(uint32_t sig, uint32_t *first)
+{
+    uint32_t n = 0;
+
+    for (uint32_t i = 0; i < logCount; i++)
+    {
+        if (logs[i].sig == sig)
+        {
+            if (n++ == 0 && first != NULL)
+            {
+                *first = logs[i].tick;
+            }
+        }
+    }
+    return n;
+}
+
+static void TEST_Timers(void)
+{
+    uint32_t first = 0;
+
+    TEST_Reset();
+    logCount = 0;
+    AO_Start(&obj[0], 4, queues[0], 8, TEST_TimerDispatch);
+    TEST_Run(30);
+    // Периодический 3, 8, 13, 18, 23, 28
+    CHECK(TEST_Count(SIG_TIMER, &first) == 6 && first == 3);
+    CHECK(TEST_Count(SIG_ONCE, &first) == 1 && first == 7);
+    // 2, 4, 6 - снят в обработчике на тике 6
+    CHECK(TEST_Count(SIG_B, &first) == 3 && first == 2);
+    CHECK(MODEL_Timers() == 3);
+
+    // Повторный INIT: те же таймеры заново, список не замыкается, события не удваиваются.
+    // Кольцо в списке AO_Tick не прошел бы - сначала вызов напрямую
+    AO_TimerInit(&timer[0], &obj[0], SIG_TIMER);
+    CHECK(MODEL_Timers() == 3 && timer[0].left == 0);
+    if (MODEL_Timers() != 3)
+    {
+        return;
+    }
+    logCount = 0;
+    AO_Post(&obj[0], AO_SIG_INIT, 0);
+    TEST_Run(ticks + 30);
+    CHECK(MODEL_Timers() == 3);
+    CHECK(TEST_Count(SIG_TIMER, NULL) == 6);
+    CHECK(TEST_Count(SIG_ONCE, NULL) == 1);
+
+    // Перевзвод взведенного таймера отодвигает срабатывание
+    TEST_Reset();
+    logCount = 0;
+    AO_TimerInit(&timer[0], &obj[1], SIG_ONCE);
+    AO_Start(&obj[1], 2, queues[1], 8, TEST_Record);
+    AO_TimerArm(&timer[0], 5, 0);
+    TEST_Run(3);
+    AO_TimerArm(&timer[0], 5, 0);
+    TEST_Run(20);
+    CHECK(TEST_Count(SIG_ONCE, &first) == 1 && first == 8);
+    CHECK(hostAsserts == 0);
+}
+
+// Нагрузка: объект с тиком 1 мс и длинной работой раз в 10 мс, AO_Benchmark старше.
+// Задержка - от метки AO_Post до входа в обработчик
+static uint32_t workCycles;
+
+static void TEST_Worker(AO_Object_t *me, const AO_Event_t *e)
+{
+    static uint32_t n;
+
+    if (e->sig == AO_SIG_INIT)
+    {
+        AO_TimerInit(&timer[0], me, SIG_TIMER);
+        AO_TimerArm(&timer[0], 1, 1);
+        n = 0;
+    }
+    else if (e->sig == SIG_TIMER)
+    {
+        MODEL_Advance(++n % 10 == 0 ? workCycles : 400);
+    }
+}
+
+static void TEST_Load(uint32_t work, int print)
+{
+    TEST_Reset();
+    workCycles = work;
+    AO_Start(&obj[0], 3, queues[0], 8, TEST_Worker);
+    AO_Benchmark();
+    TEST_Run(1000);
+
+    const AO_Stats_t *s = AO_GetStats();
+    uint64_t busy = now - idleCycles - isrCycles;
+    // Статистика по обоим объектам. Меньшая задержка - у AO_SIG_INIT из main: только выбор
+    // объекта. События тика: остаток SysTick_Handler, выход, выбор; событие младшего
+    // объекта ждет еще и обработчик старшего
+    uint32_t direct = 2 * MODEL_TIMER_CYCLES + 2 * MODEL_POST_CYCLES + MODEL_IRQ_EXIT_CYCLES + MODEL_PICK_CYCLES;
+
+    CHECK(s->dispatched >= 2 * 1000 - 2);
+    CHECK(s->latencyMin == MODEL_PICK_CYCLES);
+    // Работа дольше тика: событие AO_Benchmark ждет конца обработчика (run-to-completion)
+    CHECK(work < MODEL_TICK ? s->latencyMax == direct + MODEL_PICK_CYCLES : s->latencyMax > work - MODEL_TICK);
+    CHECK(s->loadPermille <= 1000 && busy * 1000 / now >= s->loadPermille);
+    CHECK(hostAsserts == 0);
+    if (print)
+    {
+        printf("  работа %6u: задержка %u..%u тактов, обработчики %4.1f%%, SysTick %4.2f%%, "
+               "сон %4.1f%% (%u WFI на 1000 тиков), AO_GetStats %u.%u%%\n",
+               work, s->latencyMin, s->latencyMax, 100.0 * s->busyCycles / now, 100.0 * isrCycles / now,
+               100.0 * idleCycles / now, idleCalls, s->loadPermille / 10, s->loadPermille % 10);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int table = argc > 1 && strcmp(argv[1], "--table") == 0;
+
+    TEST_Order();
+    TEST_Timers();
+    if (table)
+    {
+        printf("модель, %u МГц, тик 1 мс; оценки MODEL_*_CYCLES, не замер:\n", MODEL_HZ / 1000000);
+    }
+    TEST_Load(400, table);
+    TEST_Load(40000, table);
+    TEST_Load(120000, table);
+    return HOST_Result("test_ao");
+}
@@ -0,0 +1,454 @@
+// pin.hpp на памяти по адресам кристалла. Страницы портов A-F отображены по их адресам,
+// запись в них ловится защитой страницы (SIGSEGV, шаг TF, SIGTRAP) и считается по
+// регистрам. Страницы bit-band alias недоступны: обращение к слову alias эмулируется
+// так, как это делает шина, - чтение дает бит, запись меняет один бит RXTX.
+// Проверяется: init совпадает с PORT_Init из SPL (на порту JTAG - кроме пинов JTAG, их
+// init не трогает), пишет каждый регистр порта ровно раз; set/clear/toggle одиночного пина -
+// одна запись в alias и ни одной в RXTX, на порту JTAG - запись RXTX как у PORT_SetBits.
+// Дизассемблер (objdump, код хоста x86-64) подтверждает, что init собран в прямой код без
+// циклов и вызовов: маски - константы. Такты на Cortex-M3 - оценки MODEL_*_CYCLES по TRM,
+// замер на кристалле - PIN_Benchmark в прошивке (pin_bench.h), его результатов здесь нет
+#include "host.h"
+#include "pin.hpp"
+
+#include <signal.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+
+static const uint32_t ports[] = { MDR_PORTA_BASE, MDR_PORTB_BASE, MDR_PORTC_BASE, MDR_PORTD_BASE, MDR_PORTE_BASE, MDR_PORTF_BASE };
+#define PORTS (sizeof(ports) / sizeof(ports[0]))
+#define PAGE 4096u
+#define REGS 8
+
+static uint32_t aliasPage(uint32_t port)
+{
+    return bitband::alias(port, 0) & ~(PAGE - 1);
+}
+
+// Записи в регистры портов и в alias с последнего TEST_Track. Меняются обработчиками
+// сигналов - volatile, иначе -O2 держит нули после сброса
+static volatile uint32_t writes[PORTS][REGS];
+static volatile uint32_t aliasWrites[PORTS];
+
+static volatile int tracking;
+static uint32_t pendingPage;   // страница, открытая на один шаг
+static int pendingAlias;       // это alias: после шага перенести бит в RXTX
+static volatile uint32_t *pendingWord;
+
+static int TEST_Port(uint32_t address)
+{
+    for (uint32_t i = 0; i < PORTS; i++)
+    {
+        if (address >= ports[i] && address < ports[i] + REGS * 4)
+        {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static void TEST_Protect(void)
+{
+    for (uint32_t i = 0; i < PORTS; i++)
+    {
+        mprotect((void *)(uintptr_t)ports[i], PAGE, tracking ? PROT_READ : PROT_READ | PROT_WRITE);
+        mprotect((void *)(uintptr_t)aliasPage(ports[i]), PAGE, PROT_NONE);
+    }
+}
+
+static void TEST_Segv(int, siginfo_t *info, void *context)
+{
+    ucontext_t *uc = (ucontext_t *)context;
+    uint32_t address = (uint32_t)(uintptr_t)info->si_addr;
+    int write = (uc->uc_mcontext.gregs[REG_ERR] & 2) != 0;
+
+    for (uint32_t i = 0; i < PORTS; i++)
+    {
+        uint32_t alias = bitband::alias(ports[i], 0);
+
+        if (address >= alias && address < alias + 32 * 4)
+        {
+            // Слово alias на время шага - значение бита RXTX
+            pendingPage = aliasPage(ports[i]);
+            pendingAlias = write;
+            pendingWord = (volatile uint32_t *)(uintptr_t)address;
+            mprotect((void *)(uintptr_t)pendingPage, PAGE, PROT_READ | PROT_WRITE);
+            *pendingWord = (*(volatile uint32_t *)(uintptr_t)ports[i] >> ((address - alias) / 4)) & 1;
+            uc->uc_mcontext.gregs[REG_EFL] |= 0x100;
+            return;
+        }
+    }
+    int port = TEST_Port(address);
+    if (port < 0 || !write)
+    {
+        signal(SIGSEGV, SIG_DFL);
+        return;
+    }
+    writes[port][(address - ports[port]) / 4] = writes[port][(address - ports[port]) / 4] + 1;
+    pendingPage = ports[port] & ~(PAGE - 1);
+    pendingAlias = 0;
+    mprotect((void *)(uintptr_t)pendingPage, PAGE, PROT_READ | PROT_WRITE);
+    uc->uc_mcontext.gregs[REG_EFL] |= 0x100;
+}
+
+static void TEST_Trap(int, siginfo_t *, void *context)
+{
+    ucontext_t *uc = (ucontext_t *)context;
+
+    uc->uc_mcontext.gregs[REG_EFL] &= ~0x100;
+    if (pendingAlias)
+    {
+        // Запись в alias: шина читает RXTX, меняет один бит и пишет обратно
+        uint32_t address = (uint32_t)(uintptr_t)pendingWord;
+        for (uint32_t i = 0; i < PORTS; i++)
+        {
+            uint32_t alias = bitband::alias(ports[i], 0);
+
+            if (address >= alias && address < alias + 32 * 4)
+            {
+                volatile uint32_t *rxtx = (volatile uint32_t *)(uintptr_t)ports[i];
+                uint32_t bit = 1u << ((address - alias) / 4);
+
+                mprotect((void *)(uintptr_t)ports[i], PAGE, PROT_READ | PROT_WRITE);
+                *rxtx = (*pendingWord & 1) ? (*rxtx | bit) : (*rxtx & ~bit);
+                aliasWrites[i] = aliasWrites[i] + 1;
+            }
+        }
+    }
+    TEST_Protect();
+}
+
+static void TEST_Map(void)
+{
+    struct sigaction sa = {};
+
+    for (uint32_t i = 0; i < PORTS; i++)
+    {
+        CHECK(mmap((void *)(uintptr_t)ports[i], PAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0) ==
+              (void *)(uintptr_t)ports[i]);
+        CHECK(mmap((void *)(uintptr_t)aliasPage(ports[i]), PAGE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0) ==
+              (void *)(uintptr_t)aliasPage(ports[i]));
+    }
+    sa.sa_flags = SA_SIGINFO;
+    sa.sa_sigaction = TEST_Segv;
+    sigaction(SIGSEGV, &sa, NULL);
+    sa.sa_sigaction = TEST_Trap;
+    sigaction(SIGTRAP, &sa, NULL);
+}
+
+// on - сбросить счетчики и начать, 0 - остановить, счетчики остаются
+static void TEST_Track(int on)
+{
+    for (uint32_t i = 0; on && i < PORTS; i++)
+    {
+        for (int r = 0; r < REGS; r++)
+        {
+            writes[i][r] = 0;
+        }
+        aliasWrites[i] = 0;
+    }
+    tracking = on;
+    TEST_Protect();
+}
+
+static uint32_t seed = 1;
+static uint32_t TEST_Random(void)
+{
+    seed = seed * 1103515245u + 12345u;
+    return (seed >> 16) | (seed << 16);
+}
+
+static void TEST_Scramble(MDR_PORT_TypeDef *port)
+{
+    volatile uint32_t *r = &port->RXTX;
+
+    for (int i = 0; i < REGS; i++)
+    {
+        r[i] = TEST_Random();
+    }
+}
+
+static void TEST_Save(const MDR_PORT_TypeDef *port, uint32_t *saved)
+{
+    const volatile uint32_t *r = &port->RXTX;
+
+    for (int i = 0; i < REGS; i++)
+    {
+        saved[i] = r[i];
+    }
+}
+
+static void TEST_Restore(MDR_PORT_TypeDef *port, const uint32_t *saved)
+{
+    volatile uint32_t *r = &port->RXTX;
+
+    for (int i = 0; i < REGS; i++)
+    {
+        r[i] = saved[i];
+    }
+}
+
+// Биты пинов JTAG в каждом регистре (RXTX, OE, FUNC, ANALOG, PULL, PD, PWR, GFEN)
+static const uint32_t jtagBits[REGS] = { 0x1F, 0x1F, 0x3FF, 0x1F, 0x001F001F, 0x001F001F, 0x3FF, 0x1F };
+
+static uint32_t initCases;
+
+// init<C> против PORT_Init с той же маской на случайном состоянии порта
+template <class P, gpio::Config C>
+static void TEST_Init(void)
+{
+    MDR_PORT_TypeDef *port = P::regs();
+    int p = TEST_Port(P::base);
+    const PORT_InitTypeDef init = {
+        .PORT_Pin = (uint16_t)P::mask,
+        .PORT_OE = C.oe,
+        .PORT_PULL_UP = C.pullUp,
+        .PORT_PULL_DOWN = C.pullDown,
+        .PORT_PD_SHM = C.shm,
+        .PORT_PD = C.pd,
+        .PORT_GFEN = C.gfen,
+        .PORT_FUNC = C.func,
+        .PORT_SPEED = C.speed,
+        .PORT_MODE = C.mode,
+    };
+
+    for (int n = 0; n < 200; n++)
+    {
+        uint32_t before[REGS], expected[REGS], actual[REGS];
+
+        TEST_Scramble(port);
+        TEST_Save(port, before);
+        PORT_Init(port, &init);
+        TEST_Save(port, expected);
+        TEST_Restore(port, before);
+
+        TEST_Track(1);
+        P::template init<C>();
+        TEST_Track(0);
+        TEST_Save(port, actual);
+
+        for (int r = 0; r < REGS; r++)
+        {
+            uint32_t jtag = P::base == gpio::jtagPort ? jtagBits[r] : 0;
+
+            CHECK((actual[r] & ~jtag) == (expected[r] & ~jtag));
+            CHECK((actual[r] & jtag) == (before[r] & jtag)); // JTAG не тронут
+            CHECK(writes[p][r] == (r == 0 ? 0u : 1u));        // RXTX не пишется, остальные - раз
+        }
+        initCases++;
+    }
+}
+
+template <class P>
+static void TEST_InitAll(void)
+{
+    constexpr gpio::Config all = {
+        .oe = PORT_OE_OUT,
+        .mode = PORT_MODE_DIGITAL,
+        .func = PORT_FUNC_ALTER,
+        .speed = PORT_SPEED_SLOW,
+        .pullUp = PORT_PULL_UP_ON,
+        .pullDown = PORT_PULL_DOWN_ON,
+        .pd = PORT_PD_OPEN,
+        .shm = PORT_PD_SHM_ON,
+        .gfen = PORT_GFEN_ON,
+    };
+    constexpr gpio::Config main = {.func = PORT_FUNC_MAIN, .speed = PORT_SPEED_FAST, .pullDown = PORT_PULL_DOWN_ON};
+
+    TEST_Init<P, gpio::input>();
+    TEST_Init<P, gpio::output>();
+    TEST_Init<P, gpio::analog>();
+    TEST_Init<P, all>();
+    TEST_Init<P, main>();
+}
+
+// Одиночный пин: bit-band, на порту JTAG - как PORT_SetBits/PORT_ResetBits
+template <class P>
+static void TEST_Pin(void)
+{
+    MDR_PORT_TypeDef *port = P::regs();
+    int p = TEST_Port(P::base);
+    int jtag = P::base == gpio::jtagPort;
+
+    for (int n = 0; n < 200; n++)
+    {
+        uint32_t before, expected;
+        int op = TEST_Random() % 3;
+
+        TEST_Scramble(port);
+        before = port->RXTX;
+        if (op == 0)
+        {
+            PORT_SetBits(port, P::mask);
+        }
+        else if (op == 1)
+        {
+            PORT_ResetBits(port, P::mask);
+        }
+        else
+        {
+            PORT_WriteBit(port, P::mask, (before & P::mask) ? RESET : SET);
+        }
+        expected = port->RXTX;
+        port->RXTX = before;
+
+        TEST_Track(1);
+        if (op == 0)
+        {
+            P::set();
+        }
+        else if (op == 1)
+        {
+            P::clear();
+        }
+        else
+        {
+            P::toggle();
+        }
+        TEST_Track(0);
+
+        if (jtag)
+        {
+            CHECK(port->RXTX == expected);
+            CHECK(writes[p][0] == 1 && aliasWrites[p] == 0);
+        }
+        else
+        {
+            // PORT_SetBits на не-JTAG порту меняет только этот бит
+            CHECK(port->RXTX == expected);
+            CHECK(writes[p][0] == 0 && aliasWrites[p] == 1);
+        }
+        CHECK(P::read() == ((port->RXTX & P::mask) != 0));
+    }
+}
+
+// Группа: по записи в alias на пин, write - одна запись RXTX. На порту JTAG каждый пин
+// пишется через RXTX, биты JTAG сбрасываются как в PORT_SetBits
+template <class G>
+static void TEST_Group(void)
+{
+    MDR_PORT_TypeDef *port = G::regs();
+    int p = TEST_Port(G::base);
+    uint32_t pins = (uint32_t)__builtin_popcount(G::mask);
+    uint32_t jtag = G::base == gpio::jtagPort ? gpio::jtagPins : 0;
+    uint32_t rxtxWrites = jtag ? pins : 0, alias = jtag ? 0 : pins;
+
+    for (int n = 0; n < 100; n++)
+    {
+        uint32_t before, bits = TEST_Random();
+
+        TEST_Scramble(port);
+        before = port->RXTX;
+        TEST_Track(1);
+        G::set();
+        TEST_Track(0);
+        CHECK(port->RXTX == ((before | G::mask) & ~jtag));
+        CHECK(aliasWrites[p] == alias && writes[p][0] == rxtxWrites);
+
+        TEST_Track(1);
+        G::clear();
+        TEST_Track(0);
+        CHECK(port->RXTX == (before & ~G::mask & ~jtag));
+        CHECK(aliasWrites[p] == alias && writes[p][0] == rxtxWrites);
+
+        port->RXTX = before;
+        TEST_Track(1);
+        G::write(bits);
+        TEST_Track(0);
+        CHECK(port->RXTX == (((before & ~G::mask) | (bits & G::mask)) & ~jtag));
+        CHECK(aliasWrites[p] == 0 && writes[p][0] == 1);
+        CHECK(G::read() == (port->RXTX & G::mask));
+    }
+}
+
+using PC0 = gpio::Pin<MDR_PORTC_BASE, 0>;
+using PA15 = gpio::Pin<MDR_PORTA_BASE, 15>;
+using PD7 = gpio::Pin<MDR_PORTD_BASE, 7>; // порт JTAG_B, пин вне JTAG
+using PF3 = gpio::Pin<MDR_PORTF_BASE, 3>;
+using Bus = gpio::PinGroup<gpio::Pin<MDR_PORTA_BASE, 0>, gpio::Pin<MDR_PORTA_BASE, 3>, gpio::Pin<MDR_PORTA_BASE, 7>>;
+using DBus = gpio::PinGroup<gpio::Pin<MDR_PORTD_BASE, 5>, gpio::Pin<MDR_PORTD_BASE, 15>>;
+
+// Для дизассемблера: отдельные функции, которые компилятор не встроит
+extern "C" __attribute__((noinline)) void TEST_InitOutput(void) { PC0::init<gpio::output>(); }
+extern "C" __attribute__((noinline)) void TEST_InitBus(void) { Bus::init<gpio::input>(); }
+
+// Код хоста: сколько записей по адресам порта, есть ли вызовы и переходы
+static void TEST_Disassembly(const char *function, uint32_t base)
+{
+    char command[256], line[512];
+    int stores = 0, calls = 0, jumps = 0, lines = 0;
+    FILE *f;
+
+    snprintf(command, sizeof(command), "objdump -d --no-show-raw-insn --disassemble=%s /proc/%d/exe", function, (int)getpid());
+    f = popen(command, "r");
+    CHECK(f != NULL);
+    if (f == NULL)
+    {
+        return;
+    }
+    while (fgets(line, sizeof(line), f) != NULL)
+    {
+        char *insn = strchr(line, '\t');
+        char *to;
+
+        if (insn == NULL || strstr(line, ":\t") == NULL)
+        {
+            continue;
+        }
+        lines++;
+        // mov %reg,0xADDR - запись по абсолютному адресу регистра порта
+        to = strstr(insn, ",0x");
+        if (strncmp(insn + 1, "mov", 3) == 0 && to != NULL)
+        {
+            uint32_t address = (uint32_t)strtoul(to + 1, NULL, 16);
+            stores += address >= base && address < base + REGS * 4;
+        }
+        calls += strstr(insn, "call") != NULL;
+        jumps += insn[1] == 'j';
+    }
+    pclose(f);
+    printf("  %-16s %2d instructions, %d stores to the port, %d calls, %d jumps\n", function, lines, stores, calls, jumps);
+    CHECK(lines > 0);
+    CHECK(stores == 7); // OE, PULL, PWR, PD, GFEN, ANALOG, FUNC - по разу
+    CHECK(calls == 0 && jumps == 0);
+}
+
+// Такты Cortex-M3 по TRM (оценки, gcc -O2, база порта уже в регистре):
+//   Pin::set      - MOVS + STR в alias: 1 + 2
+//   PORT_SetBits  - загрузка аргументов 2, BL 3, LDR RXTX 2, ORR, BIC 2, STR 2, BX 3
+//   toggle        - LDR alias 2, EOR 1, STR alias 2
+//   PORT_ReadInputDataBit + PORT_WriteBit - два вызова, ~2 * 14
+#define MODEL_PIN_SET_CYCLES      3
+#define MODEL_SPL_SET_CYCLES      14
+#define MODEL_PIN_TOGGLE_CYCLES   5
+#define MODEL_SPL_TOGGLE_CYCLES   28
+
+int main(void)
+{
+    TEST_Map();
+
+    TEST_InitAll<PC0>();
+    TEST_InitAll<PA15>();
+    TEST_InitAll<PD7>();
+    TEST_InitAll<PF3>();
+    TEST_InitAll<Bus>();
+    TEST_InitAll<DBus>();
+
+    TEST_Pin<PC0>();
+    TEST_Pin<PA15>();
+    TEST_Pin<PD7>();
+    TEST_Pin<PF3>();
+    TEST_Group<Bus>();
+    TEST_Group<DBus>();
+
+    printf("init против PORT_Init: %u случаев, каждый регистр порта записан один раз\n"
+           "objdump (код хоста, x86-64):\n", (unsigned)initCases);
+    TEST_Disassembly("TEST_InitOutput", MDR_PORTC_BASE);
+    TEST_Disassembly("TEST_InitBus", MDR_PORTA_BASE);
+    printf("такты Cortex-M3 (оценки MODEL_*_CYCLES, не замер):\n"
+           "               pin.hpp  SPL\n"
+           "  set/clear    %5d  %5d\n"
+           "  toggle       %5d  %5d\n",
+           MODEL_PIN_SET_CYCLES, MODEL_SPL_SET_CYCLES, MODEL_PIN_TOGGLE_CYCLES, MODEL_SPL_TOGGLE_CYCLES);
+    return HOST_Result("test_pin");
+}
@@ -0,0 +1,233 @@
+#!/usr/bin/env python3
+"""
+Генератор описаний регистров из SVD для app/inc/reg.hpp.
+
+Каждая периферия становится шаблоном от базового адреса (экземпляры с derivedFrom
+используют шаблон родителя), регистр - структурой reg::Register с адресом, доступом
+и значением после сброса, поле - reg::Field внутри регистра. Для enumeratedValues
+генерируются готовые значения поля reg::Value. Регистр с derivedFrom (буферы CAN,
+каналы таймеров, точки USB) берет у регистра-родителя в той же периферии все, чего
+не задал сам: поля, доступ, значение после сброса, размер.
+
+Имена берутся из SVD без префикса MDR_ (макросы MDR_xxx из MDR32F9Q2I.h заняты).
+Поле с именем своего регистра получает суффикс _F, значение с именем поля - _V:
+член класса не может называться как сам класс.
+"""
+
+import argparse
+import copy
+import os
+import re
+import sys
+import xml.etree.ElementTree as ET
+
+ACCESS = {
+    "read-write": "reg::Access::ReadWrite",
+    "read-only": "reg::Access::ReadOnly",
+    "write-only": "reg::Access::WriteOnly",
+    "writeOnce": "reg::Access::WriteOnly",
+    "read-writeOnce": "reg::Access::ReadWrite",
+}
+
+# Ошибки SVD: DR у UART и SSP читается (FIFO приема), в файле помечен write-only
+FIXES = {
+    ("MDR_UART1", "DR"): "read-write",
+    ("MDR_SSP1", "DR"): "read-write",
+}
+
+
+def number(text):
+    text = text.strip().lower()
+    if text.startswith("#"):
+        return int(text[1:].replace("x", "0"), 2)
+    if text.startswith("0b"):
+        return int(text[2:], 2)
+    return int(text, 0)
+
+
+def identifier(name):
+    """HSI/2 -> HSI_DIV2, прочие недопустимые символы -> _."""
+    name = name.replace("/", "_DIV")
+    name = re.sub(r"\W", "_", name)
+    if name[0].isdigit():
+        name = "_" + name
+    return name
+
+
+def comment(text):
+    return " ".join((text or "").split())
+
+
+def inherit(node, tag, parent):
+    value = node.findtext(tag)
+    return value if value is not None else parent
+
+
+def derive_registers(periph):
+    """Регистры периферии с разрешенным derivedFrom: копия родителя, поверх - свои теги."""
+    registers = periph.find("registers")
+    registers = list(registers) if registers is not None else []
+    by_name = {r.findtext("name"): r for r in registers}
+    resolved = {}
+
+    def resolve(register, chain):
+        name = register.findtext("name")
+        if name in resolved:
+            return resolved[name]
+        parent_name = register.get("derivedFrom")
+        if not parent_name:
+            resolved[name] = register
+            return register
+        # Имя может быть полным: PERIPHERAL.REGISTER
+        parent_name = parent_name.split(".")[-1]
+        if parent_name not in by_name or parent_name in chain:
+            raise ValueError("%s.%s: derivedFrom %s не найден в периферии"
+                             % (periph.findtext("name"), name, register.get("derivedFrom")))
+        merged = copy.deepcopy(resolve(by_name[parent_name], chain | {name}))
+        for child in register:
+            old = merged.find(child.tag)
+            if old is not None:
+                merged.remove(old)
+            merged.append(copy.deepcopy(child))
+        resolved[name] = merged
+        return merged
+
+    return [resolve(r, set()) for r in registers]
+
+
+def peripheral_struct(periph, template, defaults, out):
+    access_p = inherit(periph, "access", defaults["access"])
+    reset_p = inherit(periph, "resetValue", defaults["resetValue"])
+    size_p = inherit(periph, "size", defaults["size"])
+
+    desc = comment(periph.findtext("description"))
+    if desc:
+        out.append("// " + desc)
+    out += ["template <uint32_t Base>", "struct %s" % template, "{"]
+
+    first = True
+    for register in derive_registers(periph):
+        name = identifier(register.findtext("name"))
+        offset = number(register.findtext("addressOffset"))
+        size = number(inherit(register, "size", size_p))
+        if size != 32:
+            print("svd_regs: пропущен %s.%s, размер %d" % (template, name, size), file=sys.stderr)
+            continue
+        access = FIXES.get((periph.findtext("name"), register.findtext("name")),
+                           inherit(register, "access", access_p))
+        reset = number(inherit(register, "resetValue", reset_p))
+
+        if not first:
+            out.append("")
+        first = False
+        desc = comment(register.findtext("description"))
+        if desc:
+            out.append("    // " + desc)
+        out.append("    struct %s : reg::Register<Base + 0x%03X, %s, 0x%08X>"
+                   % (name, offset, ACCESS[access], reset))
+        out.append("    {")
+
+        fields = register.find("fields")
+        for field in (fields if fields is not None else []):
+            fname = identifier(field.findtext("name"))
+            if fname == name:
+                fname += "_F"
+            pos = number(field.findtext("bitOffset"))
+            width = number(field.findtext("bitWidth"))
+            faccess = ACCESS[inherit(field, "access", access)]
+            base = "reg::Field<%s, %d, %d, %s>" % (name, pos, width, faccess)
+
+            values = []
+            for enum in field.iter("enumeratedValue"):
+                vname = identifier(enum.findtext("name"))
+                if vname == fname:
+                    vname += "_V"
+                value = number(enum.findtext("value"))
+                if value >> width:
+                    raise ValueError("%s.%s.%s: значение %d шире поля" % (name, fname, vname, value))
+                values.append((vname, value << pos, comment(enum.findtext("description"))))
+
+            if not values:
+                out.append("        using %s = %s;" % (fname, base))
+                continue
+            out.append("        struct %s : %s" % (fname, base))
+            out.append("        {")
+            out.append("            using F = %s;" % base)
+            for vname, bits, desc in values:
+                line = "            static constexpr reg::Value<F> %s{0x%Xu};" % (vname, bits)
+                out.append(line + (" // " + desc if desc else ""))
+            out.append("        };")
+        out.append("    };")
+    out += ["};", ""]
+
+
+def generate(svd):
+    device = ET.parse(svd).getroot()
+    defaults = {
+        "access": device.findtext("access") or "read-write",
+        "resetValue": device.findtext("resetValue") or "0",
+        "size": device.findtext("size") or "32",
+    }
+    peripherals = device.find("peripherals")
+    by_name = {p.findtext("name"): p for p in peripherals}
+
+    out = [
+        "/* Сгенерировано tools/svd_regs.py из %s, не редактировать */" % os.path.basename(svd),
+        "#pragma once",
+        '#include "reg.hpp"',
+        "",
+        "namespace mdr",
+        "{",
+        "",
+    ]
+
+    # Шаблон на каждую периферию без derivedFrom, имя - по группе
+    templates = {}
+    used = set()
+    for periph in peripherals:
+        if periph.get("derivedFrom"):
+            continue
+        name = periph.findtext("name")
+        group = periph.findtext("groupName") or re.sub(r"^MDR_", "", name)
+        template = identifier(group) + "_t"
+        if template in used:
+            template = identifier(re.sub(r"^MDR_", "", name)) + "_t"
+        used.add(template)
+        templates[name] = template
+        peripheral_struct(periph, template, defaults, out)
+
+    for periph in peripherals:
+        name = periph.findtext("name")
+        root = name
+        while by_name[root].get("derivedFrom"):
+            root = by_name[root].get("derivedFrom")
+        out.append("using %s = %s<0x%08X>;"
+                   % (identifier(re.sub(r"^MDR_", "", name)), templates[root],
+                      number(periph.findtext("baseAddress"))))
+
+    out += ["", "} // namespace mdr", ""]
+    return "\n".join(out)
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--svd", required=True)
+    ap.add_argument("--header", required=True)
+    args = ap.parse_args()
+
+    text = generate(args.svd)
+
+    os.makedirs(os.path.dirname(os.path.abspath(args.header)), exist_ok=True)
+    old = None
+    if os.path.exists(args.header):
+        with open(args.header, encoding="utf-8") as f:
+            old = f.read()
+    # Не трогаем заголовок без изменений, иначе пересобирается все, что его включает
+    if text != old:
+        with open(args.header, "w", encoding="utf-8") as f:
+            f.write(text)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
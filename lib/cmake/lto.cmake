@@ -0,0 +1,22 @@
+# Сборка с LTO: инлайнинг между единицами трансляции - SPL (milandr_sdk компилируется
+# в составе цели), FreeRTOS, если есть, и приложение. Подключается обоими шаблонами.
+# Символы, на которые ссылается только ассемблерная вставка, должны быть помечены used
+# (portDONT_DISCARD), иначе LTO их выбросит.
+option(LTO "Link-time optimization" OFF)
+
+function(target_lto target)
+    if(NOT LTO)
+        return()
+    endif()
+    if(STACK_USAGE)
+        # -fcallgraph-info пишет граф до межмодульного инлайнинга, размеры стеков будут неверны
+        message(FATAL_ERROR "LTO и STACK_USAGE несовместимы")
+    endif()
+
+    include(CheckIPOSupported)
+    check_ipo_supported(RESULT supported OUTPUT output LANGUAGES C CXX)
+    if(NOT supported)
+        message(FATAL_ERROR "LTO не поддерживается тулчейном: ${output}")
+    endif()
+    set_property(TARGET ${target} PROPERTY INTERPROCEDURAL_OPTIMIZATION ON)
+endfunction()
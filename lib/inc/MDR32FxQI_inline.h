@@ -0,0 +1,213 @@
+/**
+  ******************************************************************************
+  * @file    MDR32FxQI_inline.h
+  * @brief   Static inline fast paths for the most used SPL operations.
+  *          Each function has the semantics of the SPL function of the same
+  *          name without the _Inline suffix, but is expanded at the call site:
+  *          no call, no literal pool reload of the peripheral base when the
+  *          pointer is constant, and assert_param compiles away as usual.
+  *          Peripheral pointer checks (IS_xxx_ALL_PERIPH) are private to the
+  *          SPL sources and are not repeated here.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __MDR32FxQI_INLINE_H
+#define __MDR32FxQI_INLINE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "MDR32FxQI_config.h"
+#include "MDR32FxQI_uart.h"
+#include "MDR32FxQI_ssp.h"
+#include "MDR32FxQI_timer.h"
+#include "MDR32FxQI_port.h"
+#include "MDR32FxQI_dma.h"
+
+/* UART ----------------------------------------------------------------------*/
+
+/**
+  * @brief  Inline UART_SendData.
+  */
+__STATIC_INLINE void UART_SendData_Inline(MDR_UART_TypeDef* UARTx, uint8_t Data)
+{
+    UARTx->DR = (uint32_t)Data;
+}
+
+/**
+  * @brief  Inline UART_ReceiveData.
+  */
+__STATIC_INLINE uint16_t UART_ReceiveData_Inline(MDR_UART_TypeDef* UARTx)
+{
+    return (uint16_t)(UARTx->DR);
+}
+
+/**
+  * @brief  Inline UART_GetFlagStatus.
+  */
+__STATIC_INLINE FlagStatus UART_GetFlagStatus_Inline(MDR_UART_TypeDef* UARTx, UART_Flags_TypeDef UART_FLAG)
+{
+    assert_param(IS_UART_FLAG(UART_FLAG));
+
+    return (UARTx->FR & UART_FLAG) ? SET : RESET;
+}
+
+/* SSP -----------------------------------------------------------------------*/
+
+/**
+  * @brief  Inline SSP_SendData.
+  */
+__STATIC_INLINE void SSP_SendData_Inline(MDR_SSP_TypeDef* SSPx, uint16_t Data)
+{
+    SSPx->DR = Data;
+}
+
+/**
+  * @brief  Inline SSP_ReceiveData.
+  */
+__STATIC_INLINE uint16_t SSP_ReceiveData_Inline(MDR_SSP_TypeDef* SSPx)
+{
+    return (uint16_t)(SSPx->DR);
+}
+
+/**
+  * @brief  Inline SSP_GetFlagStatus.
+  */
+__STATIC_INLINE FlagStatus SSP_GetFlagStatus_Inline(MDR_SSP_TypeDef* SSPx, SSP_Flags_TypeDef SSP_FLAG)
+{
+    assert_param(IS_SSP_FLAG(SSP_FLAG));
+
+    return (SSPx->SR & (uint32_t)SSP_FLAG) ? SET : RESET;
+}
+
+/* TIMER ---------------------------------------------------------------------*/
+
+/**
+  * @brief  Inline TIMER_GetCounter.
+  */
+#if defined (USE_MDR32F1QI)
+__STATIC_INLINE uint32_t TIMER_GetCounter_Inline(MDR_TIMER_TypeDef* TIMERx)
+#elif defined (USE_K1986VE9xI) || defined (USE_MDR32FG16S1QI)
+__STATIC_INLINE uint16_t TIMER_GetCounter_Inline(MDR_TIMER_TypeDef* TIMERx)
+#endif
+{
+    return TIMERx->CNT;
+}
+
+/**
+  * @brief  Inline TIMER_SetCounter.
+  */
+#if defined (USE_MDR32F1QI)
+__STATIC_INLINE void TIMER_SetCounter_Inline(MDR_TIMER_TypeDef* TIMERx, uint32_t Counter)
+#elif defined (USE_K1986VE9xI) || defined (USE_MDR32FG16S1QI)
+__STATIC_INLINE void TIMER_SetCounter_Inline(MDR_TIMER_TypeDef* TIMERx, uint16_t Counter)
+#endif
+{
+    TIMERx->CNT = Counter;
+}
+
+/**
+  * @brief  Inline TIMER_GetFlagStatus.
+  */
+__STATIC_INLINE FlagStatus TIMER_GetFlagStatus_Inline(MDR_TIMER_TypeDef* TIMERx, TIMER_Status_Flags_TypeDef Flag)
+{
+    assert_param(IS_TIMER_STATUS_FLAG(Flag));
+
+    return (TIMERx->STATUS & Flag) ? SET : RESET;
+}
+
+/**
+  * @brief  Inline TIMER_ClearFlag.
+  */
+__STATIC_INLINE void TIMER_ClearFlag_Inline(MDR_TIMER_TypeDef* TIMERx, uint32_t Flags)
+{
+    assert_param(IS_TIMER_STATUS(Flags));
+
+    TIMERx->STATUS = ~Flags;
+}
+
+/* PORT ----------------------------------------------------------------------*/
+
+/**
+  * @brief  Inline PORT_SetBits.
+  */
+__STATIC_INLINE void PORT_SetBits_Inline(MDR_PORT_TypeDef* MDR_PORTx, uint32_t PORT_Pin)
+{
+    assert_param(IS_PORT_PIN(PORT_Pin));
+    assert_param(IS_NOT_JTAG_PIN(MDR_PORTx, PORT_Pin));
+
+#if defined (USE_K1986VE9xI)
+    MDR_PORTx->RXTX = (PORT_Pin | MDR_PORTx->RXTX) & (~JTAG_PINS(MDR_PORTx));
+#elif defined (USE_MDR32FG16S1QI)
+    MDR_PORTx->SETTX = (PORT_Pin & ~JTAG_PINS(MDR_PORTx));
+#elif defined (USE_K1986VE1xI)
+    MDR_PORTx->SETTX = PORT_Pin;
+#endif
+}
+
+/**
+  * @brief  Inline PORT_ResetBits.
+  */
+__STATIC_INLINE void PORT_ResetBits_Inline(MDR_PORT_TypeDef* MDR_PORTx, uint32_t PORT_Pin)
+{
+    assert_param(IS_PORT_PIN(PORT_Pin));
+    assert_param(IS_NOT_JTAG_PIN(MDR_PORTx, PORT_Pin));
+
+#if defined (USE_K1986VE9xI)
+    MDR_PORTx->RXTX = MDR_PORTx->RXTX & ~(PORT_Pin | JTAG_PINS(MDR_PORTx)); /* not &=, deprecated on volatile in C++20 */
+#elif defined (USE_MDR32FG16S1QI)
+    MDR_PORTx->CLRTX = (PORT_Pin & ~JTAG_PINS(MDR_PORTx));
+#elif defined (USE_K1986VE1xI)
+    MDR_PORTx->CLRTX = PORT_Pin;
+#endif
+}
+
+/**
+  * @brief  Inline PORT_ReadInputDataBit.
+  */
+__STATIC_INLINE uint8_t PORT_ReadInputDataBit_Inline(MDR_PORT_TypeDef* MDR_PORTx, PORT_Pin_TypeDef PORT_Pin)
+{
+    assert_param(IS_GET_PORT_PIN(PORT_Pin));
+
+    return (MDR_PORTx->RXTX & (uint32_t)PORT_Pin) ? (uint8_t)SET : (uint8_t)RESET;
+}
+
+/**
+  * @brief  Inline PORT_ReadInputData.
+  */
+__STATIC_INLINE uint32_t PORT_ReadInputData_Inline(MDR_PORT_TypeDef* MDR_PORTx)
+{
+    return MDR_PORTx->RXTX;
+}
+
+/* DMA -----------------------------------------------------------------------*/
+
+/**
+  * @brief  Inline DMA_Cmd. With a constant NewState only one store remains.
+  */
+__STATIC_INLINE void DMA_Cmd_Inline(uint8_t DMA_Channel, FunctionalState NewState)
+{
+    assert_param(IS_DMA_CHANNEL(DMA_Channel));
+    assert_param(IS_FUNCTIONAL_STATE(NewState));
+
+    if (NewState != DISABLE)
+    {
+        MDR_DMA->CHNL_ENABLE_SET = (1 << DMA_Channel);
+    }
+    else
+    {
+        MDR_DMA->CHNL_ENABLE_CLR = (1 << DMA_Channel);
+    }
+}
+
+#ifdef __cplusplus
+} // extern "C" block end
+#endif
+
+#endif /* __MDR32FxQI_INLINE_H */
+
+/*
+* END OF FILE MDR32FxQI_inline.h */
@@ -0,0 +1,120 @@
+#pragma once
+#include "MDR32FxQI_rst_clk.h"
+#include "MDR32FxQI_eeprom.h"
+#include "MDR32FxQI_bkp.h"
+#include "MDR32FxQI_can.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Дерево тактов. Все делители считает clk_tree.hpp при компиляции (clk_config.cpp),
+// несобираемая частота или ошибка бодрейта больше CLK_BAUD_ERROR_PPM - ошибка сборки.
+// Периферия тактируется от HCLK = CLK_CPU_HZ: после CLK_SetFrequency делители уже не точны.
+
+// Кварц платы задает шаблон (CMakeLists.txt), значения по умолчанию нет: HSE_Value
+// из MDR32FxQI_config.h - 8 МГц, а на плате шаблонов стоит 16 МГц, и молча взятая
+// не та частота дает ядро и бодрейты вдвое не те
+#ifndef CLK_HSE_HZ
+#error "clk_config.h: задайте CLK_HSE_HZ - частоту кварца платы, Гц"
+#endif
+#ifndef CLK_CPU_HZ
+#define CLK_CPU_HZ 80000000
+#endif
+
+// 0 - блок не используется, его тактирование не включается
+#ifndef CLK_UART1_BAUD
+#define CLK_UART1_BAUD 0
+#endif
+#ifndef CLK_UART2_BAUD
+#define CLK_UART2_BAUD 0
+#endif
+#ifndef CLK_SSP1_HZ
+#define CLK_SSP1_HZ 0 // SCK не выше заданной
+#endif
+#ifndef CLK_SSP2_HZ
+#define CLK_SSP2_HZ 0
+#endif
+#ifndef CLK_CAN1_BITRATE
+#define CLK_CAN1_BITRATE 0 // только точно
+#endif
+#ifndef CLK_CAN2_BITRATE
+#define CLK_CAN2_BITRATE 0
+#endif
+#ifndef CLK_TIMER1_HZ
+#define CLK_TIMER1_HZ 0 // частота счета CNT, только точно
+#endif
+#ifndef CLK_TIMER2_HZ
+#define CLK_TIMER2_HZ 0
+#endif
+#ifndef CLK_TIMER3_HZ
+#define CLK_TIMER3_HZ 0
+#endif
+
+#define CLK_BAUD_ERROR_PPM 5000 // допустимая ошибка бодрейта UART, 0.5%
+
+// Проверки на ходу в clk.c (бодрейт в CLK_UARTInit). Шаблон с FreeRTOS задает configASSERT
+#ifndef CLK_ASSERT
+#define CLK_ASSERT(expr) assert_param(expr)
+#endif
+
+typedef struct
+{
+    uint32_t hz;
+    uint32_t pllMul;                // 1 - PLL не нужен, иначе 4..16
+    RST_CLK_CPU_C3_Divisor c3Div;
+    EEPROM_Latency_Cycles latency;
+    BKP_DUcc_Mode ducc;
+} CLK_CpuConfig_t;
+
+typedef struct
+{
+    uint32_t baud;     // 0 - не используется
+    uint32_t ibrd;
+    uint32_t fbrd;
+    int32_t errorPpm;  // фактический бодрейт относительно заданного
+} CLK_UartConfig_t;
+
+typedef struct
+{
+    uint32_t hz;       // фактическая частота SCK
+    uint16_t cpsdvsr;  // SSP_InitTypeDef.SSP_CPSDVSR
+    uint16_t scr;      // SSP_InitTypeDef.SSP_SCR
+} CLK_SspConfig_t;
+
+typedef struct
+{
+    uint32_t bitrate;
+    uint16_t brp;      // поля CAN_InitTypeDef
+    CAN_Propagation_Time pseg;
+    CAN_Phase_Seg1_Time seg1;
+    CAN_Phase_Seg2_Time seg2;
+    CAN_SJW_Time sjw;
+    uint32_t samplePoint; // точка выборки, 0.1%
+} CLK_CanConfig_t;
+
+typedef struct
+{
+    uint32_t hz;
+    uint16_t prescaler; // TIMER_CntInitTypeDef.TIMER_Prescaler
+} CLK_TimerConfig_t;
+
+typedef struct
+{
+    CLK_CpuConfig_t cpu;
+    CLK_UartConfig_t uart[2];
+    CLK_SspConfig_t ssp[2];
+    CLK_CanConfig_t can[2];
+    CLK_TimerConfig_t timer[3];
+    // Готовые значения регистров RST_CLK: делители BRG и разрешения тактирования
+    uint32_t uartClock;
+    uint32_t sspClock;
+    uint32_t canClock;
+    uint32_t timClock;
+} CLK_Config_t;
+
+extern const CLK_Config_t CLK_Config;
+
+#ifdef __cplusplus
+}
+#endif
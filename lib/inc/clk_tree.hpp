@@ -0,0 +1,222 @@
+#pragma once
+#include <cstdint>
+#include "clk_config.h"
+
+// Решатель дерева тактов K1986VE9x во время компиляции.
+// Ошибка решения - вызов clk_tree::error из consteval-контекста, компилятор
+// показывает строку с причиной.
+
+namespace clk_tree
+{
+
+// Не определена: вызывается только при вычислении во время компиляции
+void error(const char *reason);
+
+constexpr uint32_t maxHz = 80000000; // предел CPU_CLK и выхода CPU_PLL
+constexpr uint32_t maxBrg = 7;       // делители UART/SSP/CAN/TIM_CLOCK: 2^0..2^7
+
+struct Request
+{
+    uint32_t hse;
+    uint32_t cpu;
+    uint32_t uartBaud[2];
+    uint32_t sspHz[2];
+    uint32_t canBitrate[2];
+    uint32_t timerHz[3];
+    uint32_t baudErrorPpm;
+};
+
+constexpr uint32_t abs(int32_t value)
+{
+    return value < 0 ? -value : value;
+}
+
+// Тот же перебор, что в CLK_SetFrequency: наименьший делитель CPU_C3, множитель PLL 1 или 4..16
+constexpr CLK_CpuConfig_t solveCpu(uint32_t hse, uint32_t hz)
+{
+    if (hz == 0 || hz > maxHz)
+    {
+        error("CPU: частота вне 1..80 МГц");
+    }
+    for (uint32_t div = 0; div <= 8 && hz <= (maxHz >> div); div++)
+    {
+        uint32_t pll = hz << div;
+        uint32_t mul = pll / hse;
+        if (pll % hse == 0 && (mul == 1 || (mul >= 4 && mul <= 16)))
+        {
+            return {
+                .hz = hz,
+                .pllMul = mul,
+                .c3Div = div == 0 ? RST_CLK_CPUclkDIV1 : static_cast<RST_CLK_CPU_C3_Divisor>(RST_CLK_CPUclkDIV2 + div - 1),
+                .latency = hz <= 25000000 ? EEPROM_Latency_0 :
+                           hz <= 50000000 ? EEPROM_Latency_1 :
+                           hz <= 75000000 ? EEPROM_Latency_2 : EEPROM_Latency_3,
+                .ducc = hz <= 10000000 ? BKP_DUcc_upto_10MHz :
+                        hz <= 40000000 ? BKP_DUcc_upto_40MHz :
+                        hz <= 80000000 ? BKP_DUcc_upto_80MHz : BKP_DUcc_over_80MHz,
+            };
+        }
+    }
+    error("CPU: частота не собирается из HSE (множитель PLL 1 или 4..16, делитель 2^n)");
+    return {};
+}
+
+// UART (PL011): BAUDDIV = UART_CLK / (16 * baud) с 6 битами дробной части.
+// Делитель округляется, а не отбрасывается, как в UART_Init
+constexpr CLK_UartConfig_t solveUart(uint32_t hclk, uint32_t baud, uint32_t limitPpm, uint32_t &brgOut)
+{
+    CLK_UartConfig_t best = {};
+    uint32_t bestError = UINT32_MAX;
+
+    for (uint32_t brg = 0; brg <= maxBrg; brg++)
+    {
+        uint64_t den = (uint64_t)baud << brg;
+        uint64_t div64 = ((uint64_t)hclk * 4 + den / 2) / den;
+        if (div64 < 64 || (div64 >> 6) > 0xFFFF || ((div64 >> 6) == 0xFFFF && (div64 & 0x3F) != 0))
+        {
+            continue;
+        }
+        uint64_t real = ((uint64_t)hclk * 4) / (div64 << brg);
+        int32_t ppm = (int32_t)(((int64_t)real - baud) * 1000000 / baud);
+        if (abs(ppm) < bestError)
+        {
+            bestError = abs(ppm);
+            brgOut = brg;
+            best = {.baud = baud, .ibrd = (uint32_t)(div64 >> 6), .fbrd = (uint32_t)(div64 & 0x3F), .errorPpm = ppm};
+        }
+    }
+    if (bestError == UINT32_MAX)
+    {
+        error("UART: бодрейт вне диапазона делителя");
+    }
+    if (bestError > limitPpm)
+    {
+        error("UART: ошибка бодрейта больше CLK_BAUD_ERROR_PPM");
+    }
+    return best;
+}
+
+// SSP: SCK = SSP_CLK / (CPSDVSR * (1 + SCR)), CPSDVSR четный 2..254. Наибольшая SCK не выше заданной
+constexpr CLK_SspConfig_t solveSsp(uint32_t hclk, uint32_t hz, uint32_t &brgOut)
+{
+    CLK_SspConfig_t best = {};
+
+    for (uint32_t brg = 0; brg <= maxBrg; brg++)
+    {
+        uint32_t clk = hclk >> brg;
+        for (uint32_t cps = 2; cps <= 254; cps += 2)
+        {
+            uint32_t scr = (clk + cps * hz - 1) / (cps * hz); // 1 + SCR, округление вверх
+            if (scr == 0 || scr > 256)
+            {
+                continue;
+            }
+            uint32_t real = clk / (cps * scr);
+            if (real > best.hz)
+            {
+                brgOut = brg;
+                best = {.hz = real, .cpsdvsr = (uint16_t)cps, .scr = (uint16_t)(scr - 1)};
+            }
+        }
+    }
+    if (best.hz == 0)
+    {
+        error("SSP: частота SCK вне диапазона делителей");
+    }
+    return best;
+}
+
+// CAN: бит = (1 + PSEG + SEG1 + SEG2) квантов по (BRP + 1) / CAN_CLK, сегменты 1..8 квантов.
+// Бодрейт только точный, квантов как можно больше, точка выборки около 87.5%
+constexpr CLK_CanConfig_t solveCan(uint32_t hclk, uint32_t bitrate, uint32_t &brgOut)
+{
+    for (uint32_t tq = 25; tq >= 4; tq--)
+    {
+        uint32_t seg2 = tq - (tq * 875 + 500) / 1000;
+        seg2 = seg2 < 1 ? 1 : seg2 > 8 ? 8 : seg2;
+        uint32_t rest = tq - 1 - seg2; // PSEG + SEG1
+        if (rest < 2 || rest > 16)
+        {
+            continue;
+        }
+        uint32_t seg1 = rest / 2;
+        uint32_t pseg = rest - seg1;
+        uint32_t sjw = seg2 < 4 ? seg2 : 4;
+
+        for (uint32_t brg = 0; brg <= maxBrg; brg++)
+        {
+            uint32_t clk = hclk >> brg;
+            if (clk << brg != hclk || clk % (bitrate * tq) != 0 || clk / (bitrate * tq) > 0x10000)
+            {
+                continue;
+            }
+            brgOut = brg;
+            return {
+                .bitrate = bitrate,
+                .brp = (uint16_t)(clk / (bitrate * tq) - 1),
+                .pseg = static_cast<CAN_Propagation_Time>((pseg - 1) << CAN_BITTMNG_PSEG_Pos),
+                .seg1 = static_cast<CAN_Phase_Seg1_Time>((seg1 - 1) << CAN_BITTMNG_SEG1_Pos),
+                .seg2 = static_cast<CAN_Phase_Seg2_Time>((seg2 - 1) << CAN_BITTMNG_SEG2_Pos),
+                .sjw = static_cast<CAN_SJW_Time>((sjw - 1) << CAN_BITTMNG_SJW_Pos),
+                .samplePoint = (tq - seg2) * 1000 / tq,
+            };
+        }
+    }
+    error("CAN: бодрейт не делится из HCLK точно");
+    return {};
+}
+
+// TIMER: CNT считает с частотой TIM_CLK / (PSG + 1), только точно
+constexpr CLK_TimerConfig_t solveTimer(uint32_t hclk, uint32_t hz, uint32_t &brgOut)
+{
+    for (uint32_t brg = 0; brg <= maxBrg; brg++)
+    {
+        uint32_t clk = hclk >> brg;
+        if (clk << brg == hclk && clk % hz == 0 && clk / hz <= 0x10000)
+        {
+            brgOut = brg;
+            return {.hz = hz, .prescaler = (uint16_t)(clk / hz - 1)};
+        }
+    }
+    error("TIMER: частота счета не делится из HCLK точно");
+    return {};
+}
+
+consteval CLK_Config_t solve(const Request &request)
+{
+    CLK_Config_t config = {};
+    uint32_t brg = 0;
+
+    config.cpu = solveCpu(request.hse, request.cpu);
+    uint32_t hclk = config.cpu.hz;
+
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        if (request.uartBaud[i] != 0)
+        {
+            config.uart[i] = solveUart(hclk, request.uartBaud[i], request.baudErrorPpm, brg);
+            config.uartClock |= (brg << (RST_CLK_UART_CLOCK_UART2_BRG_Pos * i)) | (1UL << (RST_CLK_UART_CLOCK_UART1_CLK_EN_Pos + i));
+        }
+        if (request.sspHz[i] != 0)
+        {
+            config.ssp[i] = solveSsp(hclk, request.sspHz[i], brg);
+            config.sspClock |= (brg << (RST_CLK_SSP_CLOCK_SSP2_BRG_Pos * i)) | (1UL << (RST_CLK_SSP_CLOCK_SSP1_CLK_EN_Pos + i));
+        }
+        if (request.canBitrate[i] != 0)
+        {
+            config.can[i] = solveCan(hclk, request.canBitrate[i], brg);
+            config.canClock |= (brg << (RST_CLK_CAN_CLOCK_CAN2_BRG_Pos * i)) | (1UL << (RST_CLK_CAN_CLOCK_CAN1_CLK_EN_Pos + i));
+        }
+    }
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        if (request.timerHz[i] != 0)
+        {
+            config.timer[i] = solveTimer(hclk, request.timerHz[i], brg);
+            config.timClock |= (brg << (RST_CLK_TIM_CLOCK_TIM2_BRG_Pos * i)) | (1UL << (RST_CLK_TIM_CLOCK_TIM1_CLK_EN_Pos + i));
+        }
+    }
+    return config;
+}
+
+} // namespace clk_tree
@@ -0,0 +1,28 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// CRC таблицами по CRC_SLICES байт за шаг (slicing-by-N). Таблицы считаются при
+// компиляции (crc.cpp) и лежат во FLASH: 1 - 1 КиБ на CRC32, 4 - 4 КиБ, 8 - 8 КиБ,
+// у CRC16 вдвое меньше. На M3 1 -> 4 ускоряет примерно вдвое, 4 -> 8 - еще на ~20%.
+#ifndef CRC_SLICES
+#define CRC_SLICES 4
+#endif
+
+// CRC-32 (IEEE 802.3, zlib): полином 0x04C11DB7 отраженный, инверсия на входе и выходе.
+// Первый вызов с crc = 0, продолжение - с результатом предыдущего:
+// CRC_Crc32(CRC_Crc32(0, a, n), b, m) == CRC_Crc32(0, ab, n + m). "123456789" -> 0xCBF43926
+uint32_t CRC_Crc32(uint32_t crc, const void *data, size_t size);
+
+// CRC-16/CCITT-FALSE: полином 0x1021 без отражения, начальное 0xFFFF, без инверсии.
+// Первый вызов с crc = 0xFFFF (CRC16_INIT). "123456789" -> 0x29B1
+#define CRC16_INIT 0xFFFF
+uint16_t CRC_Crc16(uint16_t crc, const void *data, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
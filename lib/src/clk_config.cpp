@@ -0,0 +1,12 @@
+#include "clk_tree.hpp"
+
+// Решение дерева тактов для настроек clk_config.h, считается при компиляции
+extern "C" constinit const CLK_Config_t CLK_Config = clk_tree::solve({
+    .hse = CLK_HSE_HZ,
+    .cpu = CLK_CPU_HZ,
+    .uartBaud = {CLK_UART1_BAUD, CLK_UART2_BAUD},
+    .sspHz = {CLK_SSP1_HZ, CLK_SSP2_HZ},
+    .canBitrate = {CLK_CAN1_BITRATE, CLK_CAN2_BITRATE},
+    .timerHz = {CLK_TIMER1_HZ, CLK_TIMER2_HZ, CLK_TIMER3_HZ},
+    .baudErrorPpm = CLK_BAUD_ERROR_PPM,
+});
@@ -0,0 +1,122 @@
+#include "crc.h"
+#include <array>
+#include <cstring>
+
+#if (CRC_SLICES != 1) && (CRC_SLICES != 4) && (CRC_SLICES != 8)
+#error "crc.cpp: CRC_SLICES - 1, 4 или 8"
+#endif
+
+namespace
+{
+
+// table[k][b] - CRC байта b, за которым еще k нулевых байт. step - один нулевой байт
+// через регистр, байт b стоит в регистре на месте входного (shift)
+template <typename T, typename Step>
+consteval std::array<std::array<T, 256>, CRC_SLICES> slices(Step step, uint32_t shift)
+{
+    std::array<std::array<T, 256>, CRC_SLICES> table{};
+    for (uint32_t b = 0; b < 256; b++)
+    {
+        table[0][b] = step(b << shift);
+    }
+    for (uint32_t k = 1; k < CRC_SLICES; k++)
+    {
+        for (uint32_t b = 0; b < 256; b++)
+        {
+            T prev = table[k - 1][b];
+            table[k][b] = step(prev);
+        }
+    }
+    return table;
+}
+
+// Отраженный CRC-32: сдвиг вправо, байт входит в младшие разряды
+constexpr uint32_t crc32Step(uint32_t crc)
+{
+    uint32_t c = crc & 0xFF;
+    for (int i = 0; i < 8; i++)
+    {
+        c = (c & 1) ? (c >> 1) ^ 0xEDB88320u : c >> 1;
+    }
+    return c ^ (crc >> 8);
+}
+
+// CRC-16 без отражения: сдвиг влево, байт входит в старшие разряды
+constexpr uint16_t crc16Step(uint32_t crc)
+{
+    uint32_t c = (crc >> 8) << 8;
+    for (int i = 0; i < 8; i++)
+    {
+        c = (c & 0x8000) ? (c << 1) ^ 0x1021 : c << 1;
+    }
+    return static_cast<uint16_t>(c ^ (crc << 8));
+}
+
+constexpr auto crc32Table = slices<uint32_t>(crc32Step, 0);
+constexpr auto crc16Table = slices<uint16_t>(crc16Step, 8);
+
+static_assert(crc32Table[0][1] == 0x77073096u);
+static_assert(crc16Table[0][1] == 0x1021);
+
+// Слово из потока байт в порядке памяти (little-endian), адрес любой -
+// LDR на M3 читает невыровненное слово сам
+inline uint32_t load32(const uint8_t *p)
+{
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+} // namespace
+
+extern "C" uint32_t CRC_Crc32(uint32_t crc, const void *data, size_t size)
+{
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    const auto &t = crc32Table;
+
+    crc = ~crc;
+#if CRC_SLICES >= 4
+    for (; size >= CRC_SLICES; size -= CRC_SLICES, p += CRC_SLICES)
+    {
+        uint32_t a = load32(p) ^ crc;
+#if CRC_SLICES == 8
+        uint32_t b = load32(p + 4);
+        crc = t[7][a & 0xFF] ^ t[6][(a >> 8) & 0xFF] ^ t[5][(a >> 16) & 0xFF] ^ t[4][a >> 24] ^
+              t[3][b & 0xFF] ^ t[2][(b >> 8) & 0xFF] ^ t[1][(b >> 16) & 0xFF] ^ t[0][b >> 24];
+#else
+        crc = t[3][a & 0xFF] ^ t[2][(a >> 8) & 0xFF] ^ t[1][(a >> 16) & 0xFF] ^ t[0][a >> 24];
+#endif
+    }
+#endif
+    while (size--)
+    {
+        crc = t[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+extern "C" uint16_t CRC_Crc16(uint16_t crc16, const void *data, size_t size)
+{
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    const auto &t = crc16Table;
+    uint32_t crc = crc16;
+
+#if CRC_SLICES >= 4
+    // Регистр 16 бит: в первые два байта порции входит crc, остальные - как есть
+    for (; size >= CRC_SLICES; size -= CRC_SLICES, p += CRC_SLICES)
+    {
+        uint32_t c = crc ^ ((uint32_t)p[0] << 8 | p[1]);
+#if CRC_SLICES == 8
+        crc = t[7][c >> 8] ^ t[6][c & 0xFF] ^ t[5][p[2]] ^ t[4][p[3]] ^
+              t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+#else
+        crc = t[3][c >> 8] ^ t[2][c & 0xFF] ^ t[1][p[2]] ^ t[0][p[3]];
+#endif
+    }
+#endif
+    while (size--)
+    {
+        crc = t[0][((crc >> 8) ^ *p++) & 0xFF] ^ ((crc << 8) & 0xFFFF);
+    }
+    return static_cast<uint16_t>(crc);
+}
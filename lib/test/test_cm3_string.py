@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+"""
+Случайная проверка src/cm3_string.S в модели thumb_model.py (QEMU и МК недоступны).
+
+memcpy, memmove (оба направления перекрытия), memset, memcmp и __aeabi_memset/
+__aeabi_memclr со случайными длинами и выравниваниями против эталона на Python:
+содержимое, возвращаемое значение, ни байта за границами буферов (память модели -
+только выданные байты), r4-r11 и sp после возврата.
+
+--table - таблица байт за такт из комментария cm3_string.S. Это модель тактов, не
+замер на кристалле.
+"""
+
+import argparse
+import os
+import random
+import subprocess
+import sys
+import tempfile
+
+from thumb_model import CPU, Fault, load
+
+BASE = 0x20000000
+STACK = 0x20100000
+SAVED = [0x1111 * (i + 1) for i in range(8)]  # r4-r11 до вызова
+
+
+def memory(size):
+    mem = {BASE + i: random.randrange(256) for i in range(size)}
+    mem.update({STACK - 256 + i: 0 for i in range(256)})
+    return mem
+
+
+def case(code, symbols):
+    """Один случайный вызов; строка с описанием ошибки или None."""
+    n = random.choice([random.randrange(0, 40), random.randrange(0, 300)])
+    name = random.choice(["memcpy", "memmove", "memset", "memcmp", "__aeabi_memset", "__aeabi_memclr"])
+    mem = memory(2 * n + 48)
+    dst = BASE + random.randrange(0, 8)
+    ret = dst
+    if name == "memcpy":
+        src = BASE + n + 16 + random.randrange(0, 8)
+        expected = dict(mem)
+        for i in range(n):
+            expected[dst + i] = mem[src + i]
+        args = [dst, src, n]
+    elif name == "memmove":
+        src, dst = BASE + random.randrange(0, 16), BASE + random.randrange(0, 16)
+        ret = dst
+        expected = dict(mem)
+        for i in range(n):
+            expected[dst + i] = mem[src + i]
+        args = [dst, src, n]
+    elif name == "memcmp":
+        a, b = dst, BASE + n + 16 + random.randrange(0, 8)
+        for i in range(n):
+            mem[b + i] = mem[a + i]
+        if n and random.random() < 0.7:
+            mem[b + random.randrange(n)] = random.randrange(256)
+        left, right = bytes(mem[a + i] for i in range(n)), bytes(mem[b + i] for i in range(n))
+        expected = dict(mem)
+        args = [a, b, n]
+        ret = (left > right) - (left < right)
+    else:
+        value = 0 if name == "__aeabi_memclr" else random.randrange(-300, 300)
+        expected = dict(mem)
+        for i in range(n):
+            expected[dst + i] = value & 0xFF
+        args = {"memset": [dst, value, n], "__aeabi_memset": [dst, n, value], "__aeabi_memclr": [dst, n]}[name]
+        ret = dst if name == "memset" else None
+
+    cpu = CPU(code, symbols, mem)
+    cpu.r[4:12] = list(SAVED)
+    described = "%s(%s)" % (name, ", ".join("0x%x" % (x & 0xFFFFFFFF) for x in args))
+    try:
+        result = cpu.run(name, args, STACK)
+    except Fault as e:
+        return "%s: %s" % (described, e)
+    wrong = [hex(k) for k in expected if k < STACK - 256 and mem[k] != expected[k]]
+    if wrong:
+        return "%s: байты %s" % (described, ", ".join(wrong[:4]))
+    if name == "memcmp":
+        signed = result - (1 << 32) if result >> 31 else result
+        if (signed > 0) - (signed < 0) != ret:
+            return "%s: вернула %d, ожидалось %d" % (described, signed, ret)
+    elif ret is not None and result != ret:
+        return "%s: вернула 0x%x" % (described, result)
+    if cpu.r[4:12] != SAVED or cpu.r[13] != STACK:
+        return "%s: испорчены r4-r11 или sp" % described
+    return None
+
+
+def table(code, symbols):
+    def cycles(name, args):
+        mem = {BASE + i: 0 for i in range(8192)}
+        mem.update({STACK - 256 + i: 0 for i in range(256)})
+        cpu = CPU(code, symbols, mem)
+        cpu.run(name, args, STACK)
+        return cpu.cycles
+
+    print("Модель тактов M3 без ожиданий памяти, байт за такт:")
+    print("  байт   memcpy   memcpy src+1   memmove назад   memset   memcmp")
+    for n in (16, 64, 256, 1024):
+        runs = [cycles("memcpy", [BASE, BASE + 4096, n]),
+                cycles("memcpy", [BASE, BASE + 4096 + 1, n]),
+                cycles("memmove", [BASE + 8, BASE, n]),
+                cycles("memset", [BASE, 0x55, n]),
+                cycles("memcmp", [BASE, BASE + 4096, n])]
+        print("  %4d     %.2f       %.2f            %.2f         %.2f     %.2f" % ((n,) + tuple(n / c for c in runs)))
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--mc", default="llvm-mc")
+    ap.add_argument("--objdump", default="llvm-objdump")
+    ap.add_argument("--cases", type=int, default=4000)
+    ap.add_argument("--seed", type=int, default=1)
+    ap.add_argument("--table", action="store_true", help="напечатать таблицу байт за такт")
+    args = ap.parse_args()
+
+    with tempfile.TemporaryDirectory() as tmp:
+        obj = os.path.join(tmp, "cm3_string.o")
+        subprocess.run([args.mc, "-triple=thumbv7m-none-eabi", "-mcpu=cortex-m3", "-filetype=obj",
+                        os.path.join(here, "..", "src", "cm3_string.S"), "-o", obj], check=True)
+        code, symbols = load(obj, args.objdump)
+
+    if args.table:
+        table(code, symbols)
+        return 0
+
+    random.seed(args.seed)
+    failures = 0
+    for _ in range(args.cases):
+        error = case(code, symbols)
+        if error:
+            failures += 1
+            if failures <= 20:
+                print(error)
+    print("test_cm3_string: %s" % ("ok" if failures == 0 else "%d of %d failed" % (failures, args.cases)))
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,86 @@
+// CRC_Crc32 и CRC_Crc16 (src/crc.cpp) с CRC_SLICES из CMakeLists.txt против побитового
+// расчета: контрольные значения "123456789", случайные длины и смещения начала (хвосты
+// и невыровненные слова slicing) и продолжение с разбиением на два вызова
+#include "crc.h"
+#include <cstdio>
+#include <cstdlib>
+
+static int failures;
+
+#define CHECK(cond)                                                          \
+    do                                                                       \
+    {                                                                        \
+        if (!(cond))                                                         \
+        {                                                                    \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                      \
+        }                                                                    \
+    } while (0)
+
+static uint32_t Crc32Bitwise(const uint8_t *data, size_t size)
+{
+    uint32_t crc = 0xFFFFFFFF;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        crc ^= data[i];
+        for (int k = 0; k < 8; k++)
+        {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+        }
+    }
+    return ~crc;
+}
+
+static uint16_t Crc16Bitwise(const uint8_t *data, size_t size)
+{
+    uint16_t crc = CRC16_INIT;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        crc ^= (uint16_t)(data[i] << 8);
+        for (int k = 0; k < 8; k++)
+        {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+int main()
+{
+    static uint8_t buffer[4096 + 8];
+
+    CHECK(CRC_Crc32(0, "123456789", 9) == 0xCBF43926);
+    CHECK(CRC_Crc16(CRC16_INIT, "123456789", 9) == 0x29B1);
+    CHECK(CRC_Crc32(0, buffer, 0) == 0);
+    CHECK(CRC_Crc16(CRC16_INIT, buffer, 0) == CRC16_INIT);
+
+    srand(CRC_SLICES);
+    for (auto &b : buffer)
+    {
+        b = (uint8_t)rand();
+    }
+    for (int i = 0; i < 2000; i++)
+    {
+        size_t size = (size_t)(rand() % 2 ? rand() % 40 : rand() % 4096);
+        size_t offset = (size_t)(rand() % 8);
+        size_t split = size != 0 ? (size_t)rand() % (size + 1) : 0;
+        const uint8_t *data = buffer + offset;
+        uint32_t crc32 = CRC_Crc32(CRC_Crc32(0, data, split), data + split, size - split);
+        uint16_t crc16 = CRC_Crc16(CRC_Crc16(CRC16_INIT, data, split), data + split, size - split);
+
+        CHECK(CRC_Crc32(0, data, size) == Crc32Bitwise(data, size));
+        CHECK(CRC_Crc16(CRC16_INIT, data, size) == Crc16Bitwise(data, size));
+        CHECK(crc32 == Crc32Bitwise(data, size));
+        CHECK(crc16 == Crc16Bitwise(data, size));
+        if (failures != 0)
+        {
+            printf("size %zu, offset %zu, split %zu\n", size, offset, split);
+            break;
+        }
+    }
+
+    printf("test_crc (CRC_SLICES %d): %s\n", CRC_SLICES, failures == 0 ? "ok" : "failed");
+    return failures != 0;
+}
@@ -0,0 +1,216 @@
+#!/usr/bin/env python3
+"""
+Сжатый образ .data шаблона FreeRTOS: распаковщик Startup/data_lz4.s в модели
+thumb_model.py против упаковщика tools/data_pack.py (lz4_compress).
+
+Случайные образы, похожие на .data: нули, малые целые, указатели в ОЗУ и FLASH,
+строки, повторы уже бывших кусков, случайные байты. Каждый упаковывается как в
+data_pack ("LZ4D" + блок, выравнивание на слово) и разворачивается CopyData:
+результат байт в байт, ни чтения за блоком, ни записи за _edata (память модели -
+только выданные байты), r8-r11 и sp не тронуты, r0 = _edata. Образ без "LZ4D"
+копирует CopySection из startup - тот же код, что в прошивке (пустую .data он не
+проверяет: CopyData читает слово _sidata в любом случае, на кристалле это FLASH).
+pack() проверяется на собранном здесь ELF32: сегменты PT_LOAD по возрастанию
+p_vaddr, .data без содержимого в файле, .data_lz разворачивается в прежний образ.
+
+--table - сжатие и такты на байт распаковки против копирования. Модель тактов без
+ожиданий FLASH, не замер на кристалле.
+"""
+
+import argparse
+import contextlib
+import importlib.util
+import io
+import os
+import random
+import re
+import struct
+import subprocess
+import sys
+import tempfile
+
+from thumb_model import CPU, Fault, load
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+TEMPLATE = os.path.join(HERE, "..", "..", "FREERTOS_Milandr_template")
+RAM = 0x20000000
+FLASH = 0x08000000
+SAVED = [0x1111 * (i + 1) for i in range(4)]  # r8-r11 до вызова
+STACK = 0x20008000
+
+
+def load_pack():
+    spec = importlib.util.spec_from_file_location("data_pack", os.path.join(TEMPLATE, "tools", "data_pack.py"))
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    return module
+
+
+def build(mc, objdump, tmp):
+    """data_lz4.s и CopySection из startup шаблона - одним объектным файлом."""
+    with open(os.path.join(TEMPLATE, "Startup", "data_lz4.s")) as f:
+        source = f.read()
+    with open(os.path.join(TEMPLATE, "Startup", "startup_gcc_MDR32F9Q2I.s")) as f:
+        startup = f.read()
+    copy = re.search(r"\s*\.section \.text\.CopySection.*?\.size CopySection, \.-CopySection\n", startup, re.S)
+    path = os.path.join(tmp, "data_lz4.s")
+    with open(path, "w") as f:
+        f.write(source + copy.group(0))
+    obj = os.path.join(tmp, "data_lz4.o")
+    subprocess.run([mc, "-triple=thumbv7m-none-eabi", "-mcpu=cortex-m3", "-filetype=obj", path, "-o", obj],
+                   check=True)
+    return load(obj, objdump)
+
+
+def image(rng):
+    size = rng.choice([rng.randrange(0, 64), rng.randrange(0, 1024), rng.randrange(0, 4096)])
+    if rng.random() < 0.8:
+        size &= ~3  # _sdata и _edata выровнены
+    data = bytearray()
+    while len(data) < size:
+        kind = rng.randrange(7)
+        if kind == 0:
+            data += bytes(rng.randrange(1, 200))
+        elif kind == 1:
+            data += struct.pack("<I", rng.randrange(300))
+        elif kind == 2:
+            data += struct.pack("<I", rng.choice([RAM, FLASH]) + (rng.randrange(0x8000) & ~3))
+        elif kind == 3:
+            data += rng.choice([b"motor\0", b"error %d\0", b"uart", b"\0\0\0", b"abcabcabc"])
+        elif kind == 4 and data:
+            start = rng.randrange(len(data))
+            data += data[start:start + rng.randrange(1, 100)]
+        elif kind == 5:
+            data += bytes([rng.randrange(256)]) * rng.randrange(1, 40)
+        else:
+            data += bytes(rng.randrange(256) for _ in range(rng.randrange(1, 32)))
+    return bytes(data[:size])
+
+
+def blob(pack, data):
+    result = pack.MAGIC + pack.lz4_compress(data)
+    return result + bytes(-len(result) % 4)
+
+
+def expand(code, symbols, source, size, rng, align=0):
+    """CopyData в модели: (байты в ОЗУ, такты) или строка с ошибкой."""
+    dst = RAM + 0x400
+    src = FLASH + 0x1000 + align
+    mem = {dst + i: rng.randrange(256) for i in range(size)}
+    mem.update({src + i: b for i, b in enumerate(source)})
+    cpu = CPU(code, symbols, mem)
+    cpu.r[8:12] = list(SAVED)
+    try:
+        result = cpu.run("CopyData", [dst, dst + size, src], STACK)
+    except Fault as e:
+        return "%s" % e
+    if cpu.r[8:12] != SAVED or cpu.r[13] != STACK:
+        return "испорчены r8-r11 или sp"
+    if result != dst + size:
+        return "r0 0x%x, ожидалось 0x%x" % (result, dst + size)
+    return bytes(mem[dst + i] for i in range(size)), cpu.cycles
+
+
+def elf32(text, data):
+    """ELF32 как у прошивки: .text во FLASH, .data в ОЗУ с образом во FLASH за .text."""
+    shstrtab = b"\0.text\0.data\0.shstrtab\0"
+    text_off = 0x100
+    data_off = text_off + len(text)
+    lma = FLASH + len(text)
+    sh_off = (data_off + len(data) + len(shstrtab) + 3) & ~3
+    segments = [
+        [1, text_off, FLASH, FLASH, len(text), len(text), 5, 4],
+        [1, data_off, RAM + 0x400, lma, len(data), len(data), 6, 4],
+        [0x6474E551, 0, 0, 0, 0, 0, 6, 16],  # PT_GNU_STACK
+    ]
+    sections = [
+        [0] * 10,
+        [1, 1, 0x6, FLASH, text_off, len(text), 0, 0, 4, 0],
+        [7, 1, 0x3, RAM + 0x400, data_off, len(data), 0, 0, 4, 0],
+        [13, 3, 0, 0, data_off + len(data), len(shstrtab), 0, 0, 1, 0],
+    ]
+    out = bytearray(b"\x7fELF\x01\x01\x01" + bytes(9))
+    out += struct.pack("<HHIIIIIHHHHHH", 2, 40, 1, FLASH, 0x34, sh_off, 0x5000200, 52, 32, len(segments), 40,
+                       len(sections), 3)
+    for p in segments:
+        out += struct.pack("<8I", *p)
+    out += bytes(text_off - len(out)) + text + data + shstrtab
+    out += bytes(sh_off - len(out))
+    for s in sections:
+        out += struct.pack("<10I", *s)
+    return bytes(out)
+
+
+def pack_case(pack, rng, tmp):
+    data = image(rng) or b"\0\0\0\0"
+    data += bytes(4096)  # .data с нулями сжимается всегда
+    path = os.path.join(tmp, "firmware.elf")
+    with open(path, "wb") as f:
+        f.write(elf32(bytes(rng.randrange(256) for _ in range(256)), data))
+    with contextlib.redirect_stdout(io.StringIO()):
+        pack.pack(path)
+    with open(path, "rb") as f:
+        elf = pack.Elf(f.read())
+    loads = [p for p in elf.segments if p[0] == pack.PT_LOAD]
+    if [p[2] for p in loads] != sorted(p[2] for p in loads) or len(loads) != 3:
+        return "PT_LOAD не по p_vaddr: %s" % [hex(p[2]) for p in loads]
+    section, packed = elf.find(".data"), elf.find(".data_lz")
+    if section[1] != pack.SHT_NOBITS or packed is None or packed[3] != FLASH + 256:
+        return ".data или .data_lz не те"
+    block = bytes(elf.data[packed[4]:packed[4] + packed[5]])
+    if block[:4] != pack.MAGIC or pack.lz4_decompress(block[4:], len(data)) != data:
+        return ".data_lz не разворачивается в образ"
+    return None
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--mc", default="llvm-mc")
+    ap.add_argument("--objdump", default="llvm-objdump")
+    ap.add_argument("--cases", type=int, default=300)
+    ap.add_argument("--seed", type=int, default=1)
+    ap.add_argument("--table", action="store_true", help="сжатие и такты на байт")
+    args = ap.parse_args()
+
+    pack = load_pack()
+    rng = random.Random(args.seed)
+    failures = []
+    raw = packed = lz4Cycles = copyCycles = copied = 0
+    with tempfile.TemporaryDirectory() as tmp:
+        code, symbols = build(args.mc, args.objdump, tmp)
+        for i in range(args.cases):
+            data = image(rng)
+            source = blob(pack, data)
+            result = expand(code, symbols, source, len(data), rng, align=rng.choice([0, 0, 0, 1, 2, 3]))
+            if isinstance(result, str) or result[0] != data:
+                failures.append("образ %d, %d байт: %s" % (i, len(data), result if isinstance(result, str) else
+                                                            "не совпал"))
+                continue
+            raw += len(data)
+            packed += len(source)
+            lz4Cycles += result[1]
+            # Без "LZ4D" - копирование CopySection, как у несжатой прошивки
+            if data and len(data) % 4 == 0 and data[:4] != pack.MAGIC:
+                plain = expand(code, symbols, data, len(data), rng)
+                if isinstance(plain, str) or plain[0] != data:
+                    failures.append("копия %d: %s" % (i, plain if isinstance(plain, str) else "не совпала"))
+                    continue
+                copied += len(data)
+                copyCycles += plain[1]
+        for i in range(20):
+            error = pack_case(pack, rng, tmp)
+            if error:
+                failures.append("pack %d: %s" % (i, error))
+
+    for line in failures[:20]:
+        print(line)
+    if args.table or not failures:
+        print("%d образов, %d -> %d байт во FLASH (%.0f%%); такты модели на байт: распаковка %.2f, "
+              "копирование %.2f" % (args.cases, raw, packed, 100.0 * packed / raw, lz4Cycles / raw,
+                                    copyCycles / copied))
+    print("test_data_lz4: %s" % ("ok" if not failures else "%d failed" % len(failures)))
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
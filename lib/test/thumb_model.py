@@ -0,0 +1,291 @@
+"""
+Модель Cortex-M3 для проверки src/cm3_string.S на хосте, без МК и QEMU.
+
+Объектный файл (llvm-mc) разбирается по выводу llvm-objdump, инструкции
+исполняются по мнемонике. Поддержано ровно то, что нужно cm3_string.S и
+Startup/data_lz4.s шаблона: обработка данных, LDR/STR всех размеров с пред- и
+постиндексом, LDR из пула литералов, LDM/STM/PUSH/POP, IT, переходы с релокациями
+между секциями. Незнакомая инструкция - Fault.
+
+Память - словарь байт: обращение мимо выданных байт - Fault, так ловится выход
+за границы буферов. LDM/STM по невыровненному адресу - Fault, как на кристалле.
+
+Такты - по TRM Cortex-M3 без ожиданий памяти: обработка данных 1, LDR/STR 2
+(подряд идущие - 1, невыровненные +1), LDM/STM 1 + N, переход 3, POP с PC +2.
+Это модель для сравнения вариантов, не замер: на кристалле FLASH на 80 МГц
+добавляет ожидания.
+"""
+
+import re
+import subprocess
+
+CONDS = {"eq", "ne", "cs", "hs", "cc", "lo", "mi", "pl", "vs", "vc", "hi", "ls", "ge", "lt", "gt", "le"}
+INVERSE = {"eq": "ne", "ne": "eq", "cs": "cc", "hs": "lo", "cc": "cs", "lo": "hs", "mi": "pl", "pl": "mi",
+           "hi": "ls", "ls": "hi", "ge": "lt", "lt": "ge", "gt": "le", "le": "gt", "vs": "vc", "vc": "vs"}
+ALU = {"adds", "add", "subs", "sub", "rsb", "ands", "and", "orr", "orrs", "eor", "eors",
+       "lsls", "lsl", "lsrs", "lsr", "cmp", "tst", "mov", "movs", "mvn", "rev"}
+MEMORY = {"ldr", "ldrb", "ldrh", "str", "strb", "strh"}
+MULTIPLE = {"ldm", "ldmia", "ldmdb", "stm", "stmia", "stmdb", "push", "pop"}
+BRANCH = {"b", "bx", "cbz", "cbnz"}
+REGS = {"r%d" % i: i for i in range(13)}
+REGS.update({"ip": 12, "sp": 13, "lr": 14, "pc": 15})
+RETURN = 0xDEAD0000  # LR при вызове: возврат сюда завершает run
+
+
+class Fault(Exception):
+    pass
+
+
+def load(obj, objdump="llvm-objdump"):
+    """(секции {имя: {адрес: [мнемоника, операнды, длина, символ релокации]}}, символы {имя: (секция, адрес)})."""
+    text = subprocess.run([objdump, "-d", "-r", "--triple=thumbv7m-none-eabi", obj],
+                          capture_output=True, text=True, check=True).stdout
+    sections = {}
+    symbols = {}
+    section = None
+    last = None
+    for line in text.splitlines():
+        m = re.match(r"Disassembly of section (\S+):", line)
+        if m:
+            section = sections.setdefault(m.group(1), {})
+            continue
+        m = re.match(r"([0-9a-f]{8}) <([^>]+)>:", line)
+        if m:
+            symbols[m.group(2)] = (section, int(m.group(1), 16))
+            continue
+        m = re.match(r"\s+([0-9a-f]+):\s+(?:[0-9a-f]{2} ){3}[0-9a-f]{2}\s+\.word\s+0x([0-9a-f]+)", line)
+        if m:
+            last = [".word", int(m.group(2), 16), 4, None]  # пул литералов
+            section[int(m.group(1), 16)] = last
+            continue
+        m = re.match(r"\s+([0-9a-f]+):\s+((?:[0-9a-f]{2} )+)\s*(\S+)\s*(.*)$", line)
+        if m:
+            last = [m.group(3), m.group(4).split("@")[0].strip(), len(m.group(2).split()), None]
+            section[int(m.group(1), 16)] = last
+            continue
+        m = re.match(r"\s+[0-9a-f]+:\s+R_ARM_\S+\s+(\S+)", line)
+        if m and last is not None:
+            last[3] = m.group(1)
+    # Глобальные символы, в том числе псевдонимы __aeabi_* на том же адресе
+    table = subprocess.run([objdump, "-t", obj], capture_output=True, text=True, check=True).stdout
+    for line in table.splitlines():
+        p = line.split()
+        if len(p) >= 5 and p[-3] in sections and re.match(r"[0-9a-f]{8}$", p[0]):
+            symbols[p[-1]] = (sections[p[-3]], int(p[0], 16))
+    return sections, symbols
+
+
+class CPU:
+    def __init__(self, sections, symbols, memory):
+        self.symbols = symbols
+        self.memory = memory
+        self.r = [0] * 16
+        self.N = self.Z = self.C = self.V = False
+        self.cycles = 0
+        self.it = []           # условия оставшихся инструкций блока IT
+        self.afterMemory = False
+
+    def cond(self, c):
+        N, Z, C, V = self.N, self.Z, self.C, self.V
+        return {"eq": Z, "ne": not Z, "cs": C, "hs": C, "cc": not C, "lo": not C, "mi": N, "pl": not N,
+                "vs": V, "vc": not V, "hi": C and not Z, "ls": (not C) or Z, "ge": N == V, "lt": N != V,
+                "gt": (not Z) and N == V, "le": Z or N != V, "al": True}[c]
+
+    def read(self, address, size, aligned=False):
+        if aligned and address % 4:
+            raise Fault("LDM по невыровненному 0x%x" % address)
+        value = 0
+        for i in range(size):
+            if address + i not in self.memory:
+                raise Fault("чтение за границей 0x%x" % (address + i))
+            value |= self.memory[address + i] << (8 * i)
+        return value
+
+    def write(self, address, size, value, aligned=False):
+        if aligned and address % 4:
+            raise Fault("STM по невыровненному 0x%x" % address)
+        for i in range(size):
+            if address + i not in self.memory:
+                raise Fault("запись за границей 0x%x" % (address + i))
+            self.memory[address + i] = (value >> (8 * i)) & 0xFF
+
+    def flags(self, value):
+        self.N = bool(value >> 31)
+        self.Z = value == 0
+
+    def add(self, a, b, carry):
+        full = a + b + carry
+        value = full & 0xFFFFFFFF
+        self.C = full > 0xFFFFFFFF
+        self.V = (a >> 31) == (b >> 31) and (value >> 31) != (a >> 31)
+        self.flags(value)
+        return value
+
+    def operand(self, text):
+        text = text.strip()
+        if text.startswith("#"):
+            return int(text[1:], 0) & 0xFFFFFFFF
+        m = re.match(r"(\w+), (lsl|lsr) #(\d+)", text)
+        if m:
+            value, n = self.r[REGS[m.group(1)]], int(m.group(3))
+            return (value << n) & 0xFFFFFFFF if m.group(2) == "lsl" else value >> n
+        return self.r[REGS[text]]
+
+    def run(self, name, args, sp):
+        """Вызов функции по AAPCS: r0..r3 - args, возврат - r0."""
+        self.code, pc = self.symbols[name]
+        for i, a in enumerate(args):
+            self.r[i] = a & 0xFFFFFFFF
+        self.r[13] = sp
+        self.r[14] = RETURN
+        for _ in range(2000000):
+            if pc == RETURN:
+                return self.r[0]
+            if pc not in self.code:
+                raise Fault("переход вне секции 0x%x" % pc)
+            pc = self.step(self.code, pc)
+        raise Fault("не вернулась")
+
+    def step(self, code, pc):
+        mnemonic, ops, size, reloc = code[pc]
+        nextPc = pc + size
+        m = mnemonic.split(".")[0]
+        c = self.it.pop(0) if self.it else "al"
+
+        if re.fullmatch(r"it[te]{0,3}", m):
+            first = ops.strip()
+            self.it = [first] + [first if x == "t" else INVERSE[first] for x in m[2:]]
+            return nextPc
+        if m not in ALU | MEMORY | MULTIPLE | BRANCH and m[-2:] in CONDS:
+            m, c = m[:-2], (m[-2:] if c == "al" else c)
+        if m not in ALU | MEMORY | MULTIPLE | BRANCH:
+            raise Fault("нет в модели: %s %s" % (mnemonic, ops))
+
+        if not self.cond(c):
+            self.cycles += 1
+            self.afterMemory = False
+            return nextPc
+
+        parts = [p.strip() for p in re.split(r",(?![^\[]*\])(?![^{]*\})", ops)] if ops else []
+        r = self.r
+        cycles = 1
+        if m == "b":
+            if reloc:
+                self.code, nextPc = self.symbols[reloc]  # в другую секцию
+            else:
+                nextPc = int(ops.split()[0], 16)
+            cycles = 3
+        elif m == "bx":
+            nextPc = r[REGS[parts[0]]]
+            cycles = 3
+        elif m in ("cbz", "cbnz"):
+            if (r[REGS[parts[0]]] == 0) == (m == "cbz"):
+                nextPc = int(parts[1].split()[0], 16)
+                cycles = 3
+        elif m in ALU:
+            self.alu(m, parts)
+        elif m in MEMORY:
+            cycles = self.transfer(m, parts, pc)
+        else:
+            nextPc, cycles = self.multiple(m, ops, nextPc)
+        self.cycles += cycles
+        self.afterMemory = m in MEMORY
+        return nextPc
+
+    def alu(self, m, parts):
+        r = self.r
+        if m in ("cmp", "tst"):
+            a, b = r[REGS[parts[0]]], self.operand(", ".join(parts[1:]))
+            if m == "cmp":
+                self.add(a, (~b) & 0xFFFFFFFF, 1)
+            else:
+                self.flags(a & b)
+            return
+        if m in ("mov", "movs", "mvn"):
+            value = self.operand(", ".join(parts[1:]))
+            if m == "mvn":
+                value = (~value) & 0xFFFFFFFF
+            r[REGS[parts[0]]] = value
+            if m == "movs":
+                self.flags(value)
+            return
+        if m == "rev":
+            r[REGS[parts[0]]] = int.from_bytes(r[REGS[parts[1]]].to_bytes(4, "little"), "big")
+            return
+        if len(parts) == 2 and m not in ("lsls", "lsl", "lsrs", "lsr"):
+            parts = [parts[0]] + parts  # add r0, r2 == add r0, r0, r2
+        d, a = REGS[parts[0]], r[REGS[parts[1]]]
+        b = self.operand(", ".join(parts[2:]))
+        setFlags = m.endswith("s")
+        if m in ("subs", "sub"):
+            value = self.add(a, (~b) & 0xFFFFFFFF, 1) if setFlags else (a - b) & 0xFFFFFFFF
+        elif m == "rsb":
+            value = (b - a) & 0xFFFFFFFF
+        elif m in ("adds", "add"):
+            value = self.add(a, b, 0) if setFlags else (a + b) & 0xFFFFFFFF
+        elif m in ("lsls", "lsl"):
+            if b:
+                self.C = bool((a >> (32 - b)) & 1)
+            value = (a << b) & 0xFFFFFFFF
+        elif m in ("lsrs", "lsr"):
+            if b:
+                self.C = bool((a >> (b - 1)) & 1)
+            value = a >> b
+        else:
+            value = {"and": a & b, "orr": a | b, "eor": a ^ b}[m.rstrip("s")]
+        if setFlags and m not in ("subs", "adds"):
+            self.flags(value)
+        r[d] = value
+
+    def transfer(self, m, parts, pc):
+        r = self.r
+        size = {"": 4, "b": 1, "h": 2}[m[3:]]
+        rt = REGS[parts[0]]
+        a = re.match(r"\[(\w+)(?:, #(-?\w+))?\](!?)", parts[1])
+        base = REGS[a.group(1)]
+        offset = int(a.group(2), 0) if a.group(2) else 0
+        post = int(parts[2][1:], 0) if len(parts) > 2 else None
+        if base == 15:
+            address = ((pc + 4) & ~3) + offset
+        else:
+            address = (r[base] + (offset if post is None else 0)) & 0xFFFFFFFF
+        if base == 15:
+            word = self.code.get(address)
+            if m != "ldr" or word is None or word[0] != ".word":
+                raise Fault("не литерал 0x%x" % address)
+            r[rt] = word[1]
+        elif m.startswith("ldr"):
+            r[rt] = self.read(address, size)
+        else:
+            self.write(address, size, r[rt])
+        if post is not None:
+            r[base] = (r[base] + post) & 0xFFFFFFFF
+        elif a.group(3) == "!":
+            r[base] = address
+        return (1 if self.afterMemory else 2) + (1 if address % size else 0)
+
+    def multiple(self, m, ops, nextPc):
+        r = self.r
+        if m in ("push", "pop"):
+            base, regList, writeback = 13, ops, True
+            kind = "stmdb" if m == "push" else "ldmia"
+        else:
+            b, regList = ops.split(",", 1)
+            writeback = b.strip().endswith("!")
+            base = REGS[b.strip().rstrip("!")]
+            kind = m if m.endswith(("ia", "db")) else m + "ia"
+        regs = [REGS[x.strip()] for x in regList.strip().strip("{}").split(",")]
+        n = len(regs)
+        address = r[base] if kind.endswith("ia") else r[base] - 4 * n
+        for i, reg in enumerate(regs):
+            if kind.startswith("ldm"):
+                value = self.read(address + 4 * i, 4, True)
+                if reg == 15:
+                    nextPc = value
+                else:
+                    r[reg] = value
+            else:
+                self.write(address + 4 * i, 4, r[reg], True)
+        if writeback:
+            r[base] = r[base] + 4 * n if kind.endswith("ia") else r[base] - 4 * n
+        return nextPc, 1 + n + (2 if 15 in regs and kind.startswith("ldm") else 0)